@@ -0,0 +1,136 @@
+// ============================================================================
+// Copyright (c) 2026 Faustino Frechilla
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+/// @file  backoff.h
+/// @brief Exponential backoff for spin loops and CAS retry loops
+///
+/// A thread which retries a failed CAS straight away, or spins reading a
+/// flag, keeps pulling the cache line away from the thread which is about to
+/// make progress. Backoff::Wait is meant to be called every time such a loop
+/// goes round again:
+///   - it first executes a few pause instructions (CpuRelax), doubling how
+///     many every call up to BACKOFF_MAX_SPINS. Each wait is picked at
+///     random between half and all of the current limit, so threads which
+///     failed at the same time don't retry at the same time again
+///   - once the limit is reached it yields the CPU instead, since whoever
+///     it is waiting for might not even be running
+///
+/// A Backoff is a local variable of the loop. Building it costs nothing
+/// until the first call to Wait, so it can sit in fast paths which rarely
+/// loop. Example of usage:
+///
+/// Backoff backoff;
+/// while (!CAS(m_value, expected, desired))
+/// {
+///     backoff.Wait();
+///     expected = ...;
+/// }
+///
+/// Define BACKOFF_DISABLE to turn Wait into a no-op (loops then retry
+/// straight away, as they did before), to measure what it buys
+///
+/// @author Faustino Frechilla
+/// @history
+/// Ref        Who                When        What
+///            Faustino Frechilla 17-Oct-2026 Original development
+/// @endhistory
+///
+// ============================================================================
+
+#ifndef _BACKOFF_H_
+#define _BACKOFF_H_
+
+#include <stdint.h>     // types (uint32_t...)
+#include <thread>       // std::this_thread::yield
+#include "lock_free_atomic_ops.h"
+
+/// pause instructions of the longest wait before Backoff starts yielding
+#ifndef BACKOFF_MAX_SPINS
+#define BACKOFF_MAX_SPINS 1024
+#endif
+
+class Backoff
+{
+public:
+    /// @param a_maxSpins pause instructions of the longest wait before it
+    ///        starts yielding the CPU. 0 to yield straight away
+    explicit Backoff(uint32_t a_maxSpins = BACKOFF_MAX_SPINS):
+        m_limit(1),
+        m_maxSpins(a_maxSpins),
+        m_random(0)
+    {}
+
+    /// @brief waits a bit longer than the previous call
+    inline void Wait()
+    {
+#ifndef BACKOFF_DISABLE
+        if (m_limit > m_maxSpins)
+        {
+            std::this_thread::yield();
+            return;
+        }
+
+        uint32_t spins = (m_limit >> 1) + (NextRandom() % ((m_limit >> 1) + 1));
+        for (uint32_t i = 0; i < spins; i++)
+        {
+            CpuRelax();
+        }
+        m_limit <<= 1;
+#endif
+    }
+
+    /// @brief the next call to Wait will be as short as the first one. For
+    /// loops which made some progress and keep on going
+    inline void Reset()
+    {
+        m_limit = 1;
+    }
+
+    /// @return true once Wait yields the CPU instead of spinning
+    inline bool IsYielding() const
+    {
+        return m_limit > m_maxSpins;
+    }
+
+private:
+    /// current maximum number of pauses
+    uint32_t m_limit;
+    uint32_t m_maxSpins;
+    /// state of the random number generator. 0 until it is first needed
+    uint32_t m_random;
+
+    /// @brief xorshift32. Seeded from the address of the Backoff, which
+    /// lives in the stack of its thread, so threads get different sequences
+    inline uint32_t NextRandom()
+    {
+        if (m_random == 0)
+        {
+            uint64_t address = reinterpret_cast<uintptr_t>(this);
+            m_random = static_cast<uint32_t>((address * 0x9e3779b97f4a7c15ULL) >> 32) | 1;
+        }
+        m_random ^= m_random << 13;
+        m_random ^= m_random >> 17;
+        m_random ^= m_random << 5;
+        return m_random;
+    }
+};
+
+#endif /* _BACKOFF_H_ */
@@ -0,0 +1,154 @@
+// ============================================================================
+/// @file  backoff_bench.cpp
+/// @brief Nanoseconds per operation of heavily contended CAS loops, retrying
+///        straight away and calling Backoff::Wait between retries
+/// Two cases:
+///   - counter: every thread increments the same counter with a load+CAS
+///     loop. The retry policy is picked at run time
+///   - mpqueue: as many producers as consumers go through an
+///     ArrayLockFreeQueueMultipleProducers. The backoff lives inside the
+///     queue, so build once more with -DBACKOFF_DISABLE to get the numbers
+///     without it
+/// Contention only shows with as many cores as threads. On a machine with
+/// fewer cores, threads mostly fight over the CPU instead of the cache line
+/// Compiling procedure:
+///   $ g++ -g -O2 -Wall -DNDEBUG -std=c++11 -D_REENTRANT -c backoff_bench.cpp
+///   $ g++ backoff_bench.o -o backoff_bench -pthread
+///
+/// Output is one line per case:
+///   case=counter/backoff threads=4 ops=4000000 nsecs/op=...
+// ============================================================================
+
+#include <iostream>
+#include <iomanip> // std::setprecision
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "clock.h"
+#include "backoff.h"
+#include "lock_free_queue.h"
+
+#define BENCH_OPS_PER_THREAD 1000000
+#define BENCH_QUEUE_SIZE     1024
+
+static void report(const char* a_name, uint32_t a_threads, uint64_t a_ops, uint64_t a_elapsed)
+{
+    std::cout << "case=" << a_name
+              << " threads=" << a_threads
+              << " ops=" << a_ops
+              << " nsecs/op=" << std::fixed << std::setprecision(2)
+              << (static_cast<double>(a_elapsed) / a_ops)
+              << std::endl;
+}
+
+void runCounter(uint32_t a_threads, bool a_backoff)
+{
+    std::atomic<uint64_t> counter(0);
+    std::atomic<bool> go(false);
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < a_threads; i++)
+    {
+        threads.push_back(std::thread([&counter, &go, a_backoff]() {
+            while (!go.load(std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+            for (int j = 0; j < BENCH_OPS_PER_THREAD; j++)
+            {
+                Backoff backoff;
+                uint64_t expected = counter.load(std::memory_order_relaxed);
+                while (!counter.compare_exchange_weak(expected, expected + 1))
+                {
+                    if (a_backoff)
+                    {
+                        backoff.Wait();
+                    }
+                }
+            }
+        }));
+    }
+
+    uint64_t start = RealClock::Now();
+    go.store(true, std::memory_order_release);
+    for (uint32_t i = 0; i < a_threads; i++)
+    {
+        threads[i].join();
+    }
+    uint64_t elapsed = RealClock::Now() - start;
+
+    report(a_backoff ? "counter/backoff" : "counter/retry", a_threads, counter.load(), elapsed);
+}
+
+void runQueue(uint32_t a_producers)
+{
+    ArrayLockFreeQueue<uint64_t, BENCH_QUEUE_SIZE, ArrayLockFreeQueueMultipleProducers> queue;
+    std::atomic<bool> go(false);
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < a_producers; i++)
+    {
+        threads.push_back(std::thread([&queue, &go]() {
+            while (!go.load(std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+            for (uint64_t j = 0; j < BENCH_OPS_PER_THREAD; j++)
+            {
+                while (!queue.push(j))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }));
+        threads.push_back(std::thread([&queue, &go]() {
+            while (!go.load(std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+            uint64_t value;
+            for (int j = 0; j < BENCH_OPS_PER_THREAD; j++)
+            {
+                while (!queue.pop(value))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }));
+    }
+
+    uint64_t start = RealClock::Now();
+    go.store(true, std::memory_order_release);
+    for (std::size_t i = 0; i < threads.size(); i++)
+    {
+        threads[i].join();
+    }
+    uint64_t elapsed = RealClock::Now() - start;
+
+#ifdef BACKOFF_DISABLE
+    const char* name = "mpqueue/retry";
+#else
+    const char* name = "mpqueue/backoff";
+#endif
+    report(name, a_producers * 2,
+           static_cast<uint64_t>(a_producers) * BENCH_OPS_PER_THREAD, elapsed);
+}
+
+int main()
+{
+    uint32_t cores = std::thread::hardware_concurrency();
+    std::cout << "cores=" << cores << std::endl;
+
+    uint32_t threads[] = {1, 2, 4, 8};
+    for (std::size_t i = 0; i < (sizeof(threads) / sizeof(threads[0])); i++)
+    {
+        runCounter(threads[i], false);
+        runCounter(threads[i], true);
+    }
+    for (std::size_t i = 0; i < 3; i++)
+    {
+        runQueue(threads[i]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,60 @@
+// ============================================================================
+/// @file  clock_bench.cpp
+/// @brief Nanoseconds per call of every way of reading the time
+/// Compiling procedure:
+///   $ g++ -g -O2 -Wall -DNDEBUG -std=c++11 -D_REENTRANT -c clock_bench.cpp
+///   $ g++ clock_bench.o -o clock_bench
+///
+/// Output is one line per clock:
+///   clock=TscClock::Now calls=10000000 nsecs/call=...
+// ============================================================================
+
+#include <iostream>
+#include <iomanip> // std::setprecision
+#include <chrono>
+#include "clock.h"
+#include "tsc_clock.h"
+
+#define BENCH_CALLS 10000000
+
+// keeps the compiler from optimising the calls away
+static volatile uint64_t g_sink;
+
+template <typename FUNCTION_T>
+void run(const char* a_name, FUNCTION_T a_function)
+{
+    uint64_t sum = 0;
+    uint64_t start = RealClock::Now();
+    for (int i = 0; i < BENCH_CALLS; i++)
+    {
+        sum += a_function();
+    }
+    uint64_t elapsed = RealClock::Now() - start;
+    g_sink = sum;
+
+    std::cout << "clock=" << a_name
+              << " calls=" << BENCH_CALLS
+              << " nsecs/call=" << std::fixed << std::setprecision(2)
+              << (static_cast<double>(elapsed) / BENCH_CALLS)
+              << std::endl;
+}
+
+int main()
+{
+    TscClock::Init();
+    std::cout << "TSC " << (TscClock::IsStable() ? "stable" : "unstable")
+              << ", " << TscClock::GetFrequency() << " ticks/sec" << std::endl;
+
+    run("std::chrono::steady_clock::now", []() -> uint64_t {
+        return std::chrono::steady_clock::now().time_since_epoch().count(); });
+    run("RealClock::Now", []() -> uint64_t {
+        return RealClock::Now(); });
+    run("TscClock::ReadTicks", []() -> uint64_t {
+        return TscClock::ReadTicks(); });
+    run("TscClock::Now", []() -> uint64_t {
+        return TscClock::Now(); });
+    run("TscClock::NowSerialized", []() -> uint64_t {
+        return TscClock::NowSerialized(); });
+
+    return 0;
+}
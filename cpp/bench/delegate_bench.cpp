@@ -0,0 +1,133 @@
+// ============================================================================
+/// @file  delegate_bench.cpp
+/// @brief Nanoseconds per call and per copy of Delegate, InplaceDelegate
+///        and std::function
+/// Compiling procedure:
+///   $ g++ -g -O2 -Wall -DNDEBUG -std=c++11 -D_REENTRANT -c delegate_bench.cpp
+///   $ g++ delegate_bench.o -o delegate_bench
+///
+/// Output is one line per case:
+///   case=call/method/Delegate ops=10000000 nsecs/op=...
+// ============================================================================
+
+#include <iostream>
+#include <iomanip> // std::setprecision
+#include <functional>
+#include "clock.h"
+#include "delegate/Delegate.h"
+#include "delegate/InplaceDelegate.h"
+
+#define BENCH_OPS 10000000
+
+// keeps the compiler from optimising the calls away
+static volatile int g_sink;
+
+class Counter
+{
+public:
+    Counter():
+        m_total(0)
+    {}
+
+    int Add(int a_value)
+    {
+        m_total += a_value;
+        return m_total;
+    }
+
+private:
+    int m_total;
+};
+
+// the delegate is called through a function the compiler can't inline, so
+// it can't see the target either
+template <typename DELEGATE_T>
+__attribute__((noinline)) int callMany(const DELEGATE_T &a_delegate)
+{
+    int sum = 0;
+    for (int i = 0; i < BENCH_OPS; i++)
+    {
+        sum += a_delegate(i);
+    }
+    return sum;
+}
+
+// copies the delegate around, as code storing callbacks does
+template <typename DELEGATE_T>
+__attribute__((noinline)) int copyMany(const DELEGATE_T &a_delegate)
+{
+    int sum = 0;
+    for (int i = 0; i < BENCH_OPS; i++)
+    {
+        DELEGATE_T copy(a_delegate);
+        sum += copy(i);
+    }
+    return sum;
+}
+
+template <typename DELEGATE_T>
+void runCall(const char* a_name, const DELEGATE_T &a_delegate)
+{
+    uint64_t start = RealClock::Now();
+    g_sink = callMany(a_delegate);
+    uint64_t elapsed = RealClock::Now() - start;
+
+    std::cout << "case=call/" << a_name
+              << " ops=" << BENCH_OPS
+              << " nsecs/op=" << std::fixed << std::setprecision(2)
+              << (static_cast<double>(elapsed) / BENCH_OPS)
+              << std::endl;
+}
+
+template <typename DELEGATE_T>
+void runCopy(const char* a_name, const DELEGATE_T &a_delegate)
+{
+    uint64_t start = RealClock::Now();
+    g_sink = copyMany(a_delegate);
+    uint64_t elapsed = RealClock::Now() - start;
+
+    std::cout << "case=copy/" << a_name
+              << " ops=" << BENCH_OPS
+              << " nsecs/op=" << std::fixed << std::setprecision(2)
+              << (static_cast<double>(elapsed) / BENCH_OPS)
+              << std::endl;
+}
+
+int main()
+{
+    Counter counter;
+    Delegate<int(int)> delegate = MakeDelegate(&counter, &Counter::Add);
+    InplaceDelegate<int(int)> inplace = MakeInplaceDelegate(&counter, &Counter::Add);
+    InplaceDelegate<int(int)> inplaceBound =
+        InplaceDelegate<int(int)>::Bind<Counter, &Counter::Add>(&counter);
+    std::function<int(int)> function =
+        std::bind(&Counter::Add, &counter, std::placeholders::_1);
+
+    runCall("method/Delegate", delegate);
+    runCall("method/InplaceDelegate", inplace);
+    runCall("bound/InplaceDelegate", inplaceBound);
+    runCall("method/std::function", function);
+
+    // 24 bytes of captures. Too big for the small buffer of std::function
+    int total = 0;
+    int* totalPtr = &total;
+    long offset = 1;
+    long scale = 1;
+    auto lambda = [totalPtr, offset, scale](int a_value) -> int {
+        *totalPtr += static_cast<int>((a_value * scale) + offset);
+        return *totalPtr; };
+    InplaceDelegate<int(int)> inplaceLambda = lambda;
+    std::function<int(int)> functionLambda = lambda;
+
+    runCall("lambda/InplaceDelegate", inplaceLambda);
+    runCall("lambda/std::function", functionLambda);
+
+    runCopy("method/Delegate", delegate);
+    runCopy("method/InplaceDelegate", inplace);
+    runCopy("bound/InplaceDelegate", inplaceBound);
+    runCopy("method/std::function", function);
+    runCopy("lambda/InplaceDelegate", inplaceLambda);
+    runCopy("lambda/std::function", functionLambda);
+
+    return 0;
+}
@@ -0,0 +1,119 @@
+// ============================================================================
+/// @file  dummylog_merger_bench.cpp
+/// @brief Throughput of the log merger (dummylog_merger.h)
+/// A few text (or binary) logs with interleaved timestamps are written into
+/// /tmp, merged into /dev/null and removed
+/// Compiling procedure:
+///   $ g++ -g -O2 -Wall -DNDEBUG -std=c++11 -D_REENTRANT -c dummylog_merger_bench.cpp
+///   $ g++ dummylog_merger_bench.o -o dummylog_merger_bench -pthread
+///
+/// Output is one line per kind and number of inputs:
+///   text inputs=8 bytes=... lines=... MB/s=...
+///   binary inputs=8 bytes=... lines=... MB/s=...
+// ============================================================================
+
+#include <iostream>
+#include <iomanip> // std::setprecision
+#include <string>
+#include <vector>
+#include <stdio.h> // snprintf
+#include "clock.h"
+#include "dummylog_merger.h"
+
+#define BENCH_FILE_SIZE (16 * 1024 * 1024)
+
+// writes a log of about BENCH_FILE_SIZE bytes. Input a_index of a_inputs has
+// the lines a_index, a_index + a_inputs... of the merged log
+static std::string writeLog(int a_index, int a_inputs, bool a_binary)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/dummylog_merger_bench.%d", a_index);
+
+    std::string contents;
+    contents.reserve(BENCH_FILE_SIZE + DUMMYLOG_BINARY_MAX_ENTRY);
+    if (a_binary)
+    {
+        // the same line as the text logs, decoded by the merger
+        char entry[DUMMYLOG_BINARY_MAX_ENTRY];
+        contents.append(DUMMYLOG_BINARY_MAGIC, DUMMYLOG_BINARY_MAGIC_SIZE);
+        std::size_t size = DummyLogBinaryEncoder::EncodeFormat(
+            entry, 1, "INFO order {} from input {} filled at {}",
+            DummyLogBinaryEncoder::Signature<uint64_t, int, double>(), "bench.cpp", 1);
+        contents.append(entry, size);
+        for (uint64_t i = a_index; contents.size() < BENCH_FILE_SIZE; i += a_inputs)
+        {
+            // a millisecond per entry
+            size = DummyLogBinaryEncoder::EncodeLog(
+                entry, 1, i * 1000000ULL, i, a_index, 101.25);
+            contents.append(entry, size);
+        }
+    }
+
+    char line[256];
+    for (uint64_t i = a_index; contents.size() < BENCH_FILE_SIZE; i += a_inputs)
+    {
+        // a millisecond per line
+        uint64_t msecs = i % 1000;
+        uint64_t secs = i / 1000;
+        int size = snprintf(line, sizeof(line),
+            "[01/Jun/2012 %02d:%02d:%02d.%03d] INFO order %llu from input %d filled at 101.25\n",
+            static_cast<int>((secs / 3600) % 24), static_cast<int>((secs / 60) % 60),
+            static_cast<int>(secs % 60), static_cast<int>(msecs),
+            static_cast<unsigned long long>(i), a_index);
+        contents.append(line, size);
+    }
+
+    FILE* file = fopen(path, "w");
+    fwrite(contents.data(), 1, contents.size(), file);
+    fclose(file);
+    return path;
+}
+
+int main()
+{
+    const int INPUTS[] = {1, 2, 8, 32};
+    for (std::size_t i = 0; i < (2 * (sizeof(INPUTS) / sizeof(INPUTS[0]))); i++)
+    {
+        int inputs = INPUTS[i % (sizeof(INPUTS) / sizeof(INPUTS[0]))];
+        bool binary = (i >= (sizeof(INPUTS) / sizeof(INPUTS[0])));
+        std::vector<std::string> paths;
+        for (int j = 0; j < inputs; j++)
+        {
+            paths.push_back(writeLog(j, inputs, binary));
+        }
+
+        uint64_t bytes = 0;
+        uint64_t lines = 0;
+        uint64_t elapsed;
+        {
+            uint64_t start = RealClock::Now();
+            DummyLogMerger merger;
+            for (int j = 0; j < inputs; j++)
+            {
+                merger.AddFile(paths[j]);
+            }
+
+            int fd = open("/dev/null", O_WRONLY);
+            DummyLogMergerOutput output(fd);
+            lines = merger.Merge(output);
+            elapsed = RealClock::Now() - start;
+            close(fd);
+        }
+
+        for (int j = 0; j < inputs; j++)
+        {
+            struct stat info;
+            stat(paths[j].c_str(), &info);
+            bytes += info.st_size;
+            unlink(paths[j].c_str());
+        }
+
+        std::cerr << (binary ? "binary" : "text")
+                  << " inputs=" << inputs << " bytes=" << bytes << " lines=" << lines
+                  << " MB/s=" << std::fixed << std::setprecision(1)
+                  << (static_cast<double>(bytes) / (1024.0 * 1024.0) /
+                      (static_cast<double>(elapsed) / 1000000000.0))
+                  << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,115 @@
+// ============================================================================
+/// @file  dummylogger_bench.cpp
+/// @brief Nanoseconds spent by the calling thread per log statement
+/// Output goes to /dev/null. Statements are logged in bursts that fit in the
+/// ring, so the asynchronous modes measure the cost on the calling thread
+/// only; the background thread catches up between bursts
+/// Compiling procedure:
+///   $ g++ -g -O2 -Wall -DNDEBUG -std=c++11 -D_REENTRANT -c dummylogger_bench.cpp
+///   $ g++ dummylogger_bench.o -o dummylogger_bench -pthread
+///
+/// Output is one line per mode:
+///   mode=binary statements=100000 nsecs/statement=...
+// ============================================================================
+
+// big enough for a whole burst of text statements
+#define DUMMYLOGGER_RING_SIZE 65536
+
+#include <iostream>
+#include <iomanip> // std::setprecision
+#include <fstream>
+#include <stdio.h>  // snprintf
+#include <unistd.h> // unlink
+#include "dummylogger.h"
+#include "dummylogger_mmap_sink.h"
+
+#define BENCH_BURST  5000
+#define BENCH_BURSTS 20
+
+template <typename FUNCTION_T>
+void run(const char* a_name, FUNCTION_T a_logStatement)
+{
+    uint64_t elapsed = 0;
+    for (int burst = 0; burst < BENCH_BURSTS; burst++)
+    {
+        uint64_t start = TscClock::Now();
+        for (int i = 0; i < BENCH_BURST; i++)
+        {
+            a_logStatement(i);
+        }
+        elapsed += TscClock::Now() - start;
+
+        DummyLogger::Instance().flush();
+    }
+
+    std::cerr << "mode=" << a_name
+              << " statements=" << (BENCH_BURST * BENCH_BURSTS)
+              << " nsecs/statement=" << std::fixed << std::setprecision(1)
+              << (static_cast<double>(elapsed) / (BENCH_BURST * BENCH_BURSTS))
+              << std::endl;
+}
+
+int main()
+{
+    TscClock::Init();
+
+    // text goes to std::cout, which is sent to /dev/null
+    std::ofstream devNull("/dev/null", std::ios::out | std::ios::binary);
+    std::streambuf* coutBuffer = std::cout.rdbuf(devNull.rdbuf());
+    DummyLogger::Instance().setBinaryStream(devNull);
+
+    double price = 101.25;
+    const char* symbol = "ABCD";
+
+    run("text/sync", [&](int a_i) {
+        DummyLogger::Instance() << "order " << a_i << " " << symbol
+                                << " filled at " << price << std::endl; });
+
+    DummyLogger::Instance().startAsync();
+    run("text/async", [&](int a_i) {
+        DummyLogger::Instance() << "order " << a_i << " " << symbol
+                                << " filled at " << price << std::endl; });
+    run("binary/async", [&](int a_i) {
+        DUMMYLOG_BINARY("order {} {} filled at {}", a_i, symbol, price); });
+    DummyLogger::Instance().stopAsync();
+
+    run("binary/sync", [&](int a_i) {
+        DUMMYLOG_BINARY("order {} {} filled at {}", a_i, symbol, price); });
+
+    // into memory mapped files (/tmp/dummylogger_bench.*), removed afterwards
+    uint32_t files;
+    {
+        DummyLoggerMmapSink sink("/tmp/dummylogger_bench", 16 * 1024 * 1024);
+        DummyLogger::Instance().setSink(&sink);
+        run("text/sync/mmap", [&](int a_i) {
+            DummyLogger::Instance() << "order " << a_i << " " << symbol
+                                    << " filled at " << price << std::endl; });
+        DummyLogger::Instance().setSink(0);
+        files = sink.FileCount();
+    }
+    for (uint32_t i = 1; i <= files; i++)
+    {
+        char path[64];
+        snprintf(path, sizeof(path), "/tmp/dummylogger_bench.%06u", i);
+        unlink(path);
+    }
+
+    // under the runtime threshold: a load and a branch
+    DummyLogger::Instance().setLevel(DUMMYLOG_LEVEL_INFO);
+    run("text/disabled", [&](int a_i) {
+        DLOG(DEBUG) << "order " << a_i << " " << symbol
+                    << " filled at " << price << std::endl; });
+    run("binary/disabled", [&](int a_i) {
+        DLOG_BINARY(DEBUG, "order {} {} filled at {}", a_i, symbol, price); });
+
+    // suppressed by their call site: a relaxed fetch-and-add
+    run("text/sampled", [&](int a_i) {
+        DLOG_EVERY_N(INFO, 1000000) << "order " << a_i << " " << symbol
+                                    << " filled at " << price << std::endl; });
+    run("text/rate-limited", [&](int a_i) {
+        DLOG_RATE_LIMITED(INFO, 1) << "order " << a_i << " " << symbol
+                                   << " filled at " << price << std::endl; });
+
+    std::cout.rdbuf(coutBuffer);
+    return 0;
+}
@@ -0,0 +1,161 @@
+// ============================================================================
+/// @file  event_bus_bench.cpp
+/// @brief Nanoseconds per event published to one handler by EventBus and by
+///        a std::map keyed by the name of the event type
+/// Compiling procedure:
+///   $ g++ -g -O2 -Wall -DNDEBUG -std=c++11 -D_REENTRANT -c event_bus_bench.cpp
+///   $ g++ event_bus_bench.o -o event_bus_bench -pthread
+///
+/// Output is one line per case:
+///   case=EventBus events=10000000 nsecs/event=...
+// ============================================================================
+
+#include <iostream>
+#include <iomanip> // std::setprecision
+#include <map>
+#include <string>
+#include <vector>
+#include "clock.h"
+#include "event_bus.h"
+
+#define BENCH_EVENTS 10000000
+
+// other event types, so neither router has a single entry
+template <int N>
+struct OtherEvent
+{
+    int value;
+};
+
+struct PriceUpdate
+{
+    uint32_t instrument;
+    double price;
+};
+
+class Listener
+{
+public:
+    Listener():
+        m_total(0)
+    {}
+
+    void OnPrice(const PriceUpdate &a_update)
+    {
+        m_total += a_update.price;
+    }
+
+    template <int N>
+    void OnOther(const OtherEvent<N> &a_event)
+    {
+        m_total += a_event.value;
+    }
+
+    double Total() const
+    {
+        return m_total;
+    }
+
+private:
+    double m_total;
+};
+
+/// @brief what EventBus replaces
+class MapRouter
+{
+public:
+    typedef Delegate<void (const void*)> Handler_t;
+
+    void Subscribe(const std::string &a_type, const Handler_t &a_handler)
+    {
+        m_handlers[a_type].push_back(a_handler);
+    }
+
+    void Publish(const std::string &a_type, const void* a_event) const
+    {
+        std::map<std::string, std::vector<Handler_t> >::const_iterator it = m_handlers.find(a_type);
+        if (it != m_handlers.end())
+        {
+            for (std::size_t i = 0; i < it->second.size(); i++)
+            {
+                it->second[i](a_event);
+            }
+        }
+    }
+
+private:
+    std::map<std::string, std::vector<Handler_t> > m_handlers;
+};
+
+/// @brief adapts Listener to MapRouter
+class UntypedListener
+{
+public:
+    explicit UntypedListener(Listener &a_listener):
+        m_listener(a_listener)
+    {}
+
+    void OnPrice(const void* a_event)
+    {
+        m_listener.OnPrice(*static_cast<const PriceUpdate*>(a_event));
+    }
+
+    void OnOther(const void* a_event)
+    {
+        m_listener.OnOther(*static_cast<const OtherEvent<0>*>(a_event));
+    }
+
+private:
+    Listener &m_listener;
+};
+
+template <typename FUNCTION_T>
+void run(const char* a_name, FUNCTION_T a_publish)
+{
+    uint64_t start = RealClock::Now();
+    for (int i = 0; i < BENCH_EVENTS; i++)
+    {
+        a_publish(i);
+    }
+    uint64_t elapsed = RealClock::Now() - start;
+
+    std::cout << "case=" << a_name
+              << " events=" << BENCH_EVENTS
+              << " nsecs/event=" << std::fixed << std::setprecision(2)
+              << (static_cast<double>(elapsed) / BENCH_EVENTS)
+              << std::endl;
+}
+
+int main()
+{
+    Listener listener;
+
+    EventBus bus;
+    bus.Subscribe(MakeDelegate(&listener, &Listener::OnOther<1>));
+    bus.Subscribe(MakeDelegate(&listener, &Listener::OnOther<2>));
+    bus.Subscribe(MakeDelegate(&listener, &Listener::OnOther<3>));
+    bus.Subscribe(MakeDelegate(&listener, &Listener::OnPrice));
+    bus.Subscribe(MakeDelegate(&listener, &Listener::OnOther<4>));
+    bus.Subscribe(MakeDelegate(&listener, &Listener::OnOther<5>));
+
+    UntypedListener untyped(listener);
+    MapRouter router;
+    const char* others[] = {"OrderFilled", "OrderRejected", "OrderSent",
+                            "SessionUp", "SessionDown"};
+    for (int i = 0; i < 5; i++)
+    {
+        router.Subscribe(others[i], MakeDelegate(&untyped, &UntypedListener::OnOther));
+    }
+    router.Subscribe("PriceUpdate", MakeDelegate(&untyped, &UntypedListener::OnPrice));
+
+    const std::string priceName("PriceUpdate");
+    run("std::map", [&router, &priceName](int a_i) {
+        PriceUpdate update = {7, static_cast<double>(a_i)};
+        router.Publish(priceName, &update); });
+    run("EventBus", [&bus](int a_i) {
+        PriceUpdate update = {7, static_cast<double>(a_i)};
+        bus.Publish(update); });
+
+    std::cout << "total=" << listener.Total() << std::endl;
+    return 0;
+}
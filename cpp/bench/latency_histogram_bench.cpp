@@ -0,0 +1,77 @@
+// ============================================================================
+/// @file  latency_histogram_bench.cpp
+/// @brief Nanoseconds per value recorded by the histograms in
+///        latency_histogram.h, and by pushing it into a std::vector (to be
+///        sorted later), which is what they replace
+/// Values are spread over the range of real latencies (10ns to 1ms), so the
+/// counters written aren't always the same few
+/// Compiling procedure:
+///   $ g++ -g -O2 -Wall -DNDEBUG -std=c++11 -D_REENTRANT -c latency_histogram_bench.cpp
+///   $ g++ latency_histogram_bench.o -o latency_histogram_bench -pthread
+///
+/// Output is one line per case:
+///   case=sharded values=20000000 nsecs/value=...
+// ============================================================================
+
+#include <iostream>
+#include <iomanip> // std::setprecision
+#include <vector>
+#include "clock.h"
+#include "latency_histogram.h"
+
+#define BENCH_VALUES 20000000
+#define BENCH_RANDOM 4096
+
+template <typename FUNCTION_T>
+void run(const char* a_name, const std::vector<uint64_t> &a_values, FUNCTION_T a_record)
+{
+    uint64_t start = RealClock::Now();
+    for (int i = 0; i < BENCH_VALUES; i++)
+    {
+        a_record(a_values[i & (BENCH_RANDOM - 1)]);
+    }
+    uint64_t elapsed = RealClock::Now() - start;
+
+    std::cout << "case=" << a_name
+              << " values=" << BENCH_VALUES
+              << " nsecs/value=" << std::fixed << std::setprecision(2)
+              << (static_cast<double>(elapsed) / BENCH_VALUES)
+              << std::endl;
+}
+
+int main()
+{
+    // log-uniform between 10ns and 1ms
+    std::vector<uint64_t> values(BENCH_RANDOM);
+    uint32_t random = 2463534242U;
+    for (int i = 0; i < BENCH_RANDOM; i++)
+    {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        values[i] = 10ULL << (random % 17);
+        values[i] += random % values[i];
+    }
+
+    LatencyHistogram histogram;
+    run("single-writer", values, [&histogram](uint64_t a_value) {
+        histogram.Record(a_value); });
+
+    LatencyHistogram concurrent;
+    run("concurrent", values, [&concurrent](uint64_t a_value) {
+        concurrent.RecordConcurrent(a_value); });
+
+    ShardedLatencyHistogram sharded;
+    run("sharded", values, [&sharded](uint64_t a_value) {
+        sharded.Record(a_value); });
+
+    std::vector<uint64_t> samples;
+    samples.reserve(BENCH_VALUES);
+    run("std::vector", values, [&samples](uint64_t a_value) {
+        samples.push_back(a_value); });
+
+    LatencyHistogram snapshot;
+    sharded.Snapshot(snapshot);
+    snapshot.Print(std::cout);
+    return 0;
+}
@@ -0,0 +1,639 @@
+// ============================================================================
+/// @file  queue_bench.cpp
+/// @brief Throughput and latency percentiles of every queue in the tree:
+///        ArrayLockFreeQueue (single and multiple producers), SafeQueue and
+///        ConsumerThread
+/// Every case moves a number of elements from some producer threads to
+/// some consumer threads. Each element carries the time it was pushed, so
+/// consumers measure how long it sat in the queue. The sweep covers:
+///   - producers: 1, 2, 4 (1 for the single producer queue)
+///   - consumers: 1, 2, 4 (1 for ConsumerThread, which has one thread)
+///   - element size: 8, 64, 256 bytes
+///   - capacity: 64, 1024, 16384 elements
+/// A full queue makes producers retry (lock-free queues) or block (SafeQueue
+/// and ConsumerThread), so throughput is the one of the whole pipeline.
+/// When every producer is done, the main thread pushes one empty element
+/// per consumer to tell them to finish
+///
+/// Threads aren't pinned. With fewer cores than threads the results say
+/// more about the scheduler than about the queue
+/// Compiling procedure:
+///   $ g++ -g -O2 -Wall -DNDEBUG -std=c++11 -D_REENTRANT -c queue_bench.cpp
+///   $ g++ queue_bench.o -o queue_bench -pthread
+///
+/// Usage:
+///   $ ./queue_bench [--csv|--json] [--elements N] [--queue NAME] [--perf]
+///                   [--trace FILE]
+/// NAME is one of lfq-sp, lfq-mp, safe-queue and consumer-thread
+/// --perf adds the hardware counters (perf_counters.h) of the producers and
+/// consumers per element: cycles, instructions, cache misses... The thread
+/// of a ConsumerThread isn't counted, only its producers
+/// --trace writes a Chrome trace (tracer.h) of every case to FILE: a slice
+/// per push and per consume, linked by a flow (its id is the push time),
+/// and the depth of the queue after every push. The buffers of the threads
+/// are written at the end, so combine it with --queue and a few thousand
+/// elements. What doesn't fit is dropped (the count is printed to stderr)
+///
+/// Output is one line per case (or CSV with a header, or a JSON array):
+///   queue=lfq-mp producers=2 consumers=2 elem-size=64 capacity=1024
+///   elements=100000 nsecs/elem=... mops/sec=... p50=... p90=... p99=...
+///   p999=... max=...
+/// Percentiles are in nanoseconds, with the 3 significant digits of
+/// ShardedLatencyHistogram (latency_histogram.h)
+// ============================================================================
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>   // std::setprecision
+#include <atomic>
+#include <memory>    // std::unique_ptr
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdlib.h>  // strtoul
+#include <string.h>  // strcmp
+#include "tsc_clock.h"
+#include "latency_histogram.h"
+#include "perf_counters.h"
+#include "tracer.h"
+#include "backoff.h"
+#include "lock_free_queue.h"
+#include "safe_queue.h"
+#include "consumer_thread.h"
+
+#define BENCH_DEFAULT_ELEMENTS 100000
+
+/// @brief what travels through the queues. m_words[0] is the time it was
+/// pushed. 0 means there is nothing else to consume
+template <uint32_t SIZE>
+struct BenchElement
+{
+    uint64_t m_words[SIZE / sizeof(uint64_t)];
+};
+
+struct BenchConfig
+{
+    const char* queue;
+    uint32_t producers;
+    uint32_t consumers;
+    uint32_t elemSize;
+    uint32_t capacity;
+    uint32_t elements;
+    /// count the hardware counters of every thread
+    bool perf;
+};
+
+struct BenchResult
+{
+    BenchConfig config;
+    uint64_t elapsed;
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t p999;
+    uint64_t max;
+    /// added up for every thread
+    PerfCounterSample perf;
+};
+
+/// @brief ArrayLockFreeQueue behind the interface the producers and
+/// consumers of runQueue use
+template <typename ELEM_T, uint32_t Q_SIZE, template <typename T, uint32_t S> class Q_TYPE>
+class LockFreeAdapter
+{
+public:
+    explicit LockFreeAdapter(uint32_t /*a_capacity*/)
+    {}
+
+    inline void Push(const ELEM_T &a_elem)
+    {
+        Backoff backoff;
+        while (!m_queue.push(a_elem))
+        {
+            backoff.Wait();
+        }
+        TRACE_COUNTER("queue depth", 0, m_queue.size());
+    }
+
+    inline void Pop(ELEM_T &out_elem)
+    {
+        Backoff backoff;
+        while (!m_queue.pop(out_elem))
+        {
+            backoff.Wait();
+        }
+    }
+
+private:
+    ArrayLockFreeQueue<ELEM_T, Q_SIZE, Q_TYPE> m_queue;
+};
+
+template <typename ELEM_T>
+class SafeQueueAdapter
+{
+public:
+    explicit SafeQueueAdapter(uint32_t a_capacity):
+        m_queue(a_capacity)
+    {}
+
+    inline void Push(const ELEM_T &a_elem)
+    {
+        m_queue.Push(a_elem);
+        TRACE_COUNTER("queue depth", 0, m_queue.Size());
+    }
+
+    inline void Pop(ELEM_T &out_elem)
+    {
+        m_queue.Pop(out_elem);
+    }
+
+private:
+    SafeQueue<ELEM_T> m_queue;
+};
+
+/// @brief pushes a_elements elements (the caller adds the end markers)
+/// @param a_perf where the counters of the thread are added. 0 not to count
+template <typename ELEM_T, typename PUSH_T>
+void produce(uint32_t a_elements, const std::atomic<bool> &a_go,
+             PerfCounterSample* a_perf, PUSH_T a_push)
+{
+    while (!a_go.load(std::memory_order_acquire))
+    {
+        std::this_thread::yield();
+    }
+
+    std::unique_ptr<PerfScope> scope;
+    if (a_perf != 0)
+    {
+        scope.reset(new PerfScope(*a_perf));
+    }
+
+    ELEM_T elem;
+    memset(&elem, 0, sizeof(elem));
+    for (uint32_t i = 0; i < a_elements; i++)
+    {
+        elem.m_words[0] = TscClock::Now();
+        TRACE_SCOPE("push");
+        TRACE_FLOW_BEGIN("element", elem.m_words[0]);
+        a_push(elem);
+    }
+}
+
+static BenchResult summarise(const BenchConfig &a_config, uint64_t a_elapsed,
+                             const ShardedLatencyHistogram &a_latencies,
+                             const std::vector<PerfCounterSample> &a_perf)
+{
+    LatencyHistogram all;
+    a_latencies.Snapshot(all);
+
+    BenchResult result;
+    result.config  = a_config;
+    result.elapsed = a_elapsed;
+    result.p50     = all.Percentile(50.0);
+    result.p90     = all.Percentile(90.0);
+    result.p99     = all.Percentile(99.0);
+    result.p999    = all.Percentile(99.9);
+    result.max     = all.Max();
+    for (std::size_t i = 0; i < a_perf.size(); i++)
+    {
+        result.perf.Add(a_perf[i]);
+    }
+    return result;
+}
+
+/// @brief producers and consumers are threads of their own
+template <typename ADAPTER_T, typename ELEM_T>
+BenchResult runQueue(const BenchConfig &a_config)
+{
+    // big queues (16384 * 256 bytes) don't belong in the stack
+    std::unique_ptr<ADAPTER_T> queue(new ADAPTER_T(a_config.capacity));
+    uint32_t perProducer = a_config.elements / a_config.producers;
+    std::atomic<bool> go(false);
+
+    // every consumer records in a shard of its own
+    ShardedLatencyHistogram latencies;
+    std::vector<PerfCounterSample> perf(a_config.producers + a_config.consumers);
+    std::vector<std::thread> consumers;
+    for (uint32_t i = 0; i < a_config.consumers; i++)
+    {
+        PerfCounterSample* threadPerf = a_config.perf ? &perf[a_config.producers + i] : 0;
+        consumers.push_back(std::thread([&queue, &latencies, threadPerf]() {
+            std::unique_ptr<PerfScope> scope;
+            if (threadPerf != 0)
+            {
+                scope.reset(new PerfScope(*threadPerf));
+            }
+
+            ELEM_T elem;
+            while (true)
+            {
+                queue->Pop(elem);
+                if (elem.m_words[0] == 0)
+                {
+                    break;
+                }
+                latencies.Record(TscClock::Now() - elem.m_words[0]);
+                TRACE_SCOPE("consume");
+                TRACE_FLOW_END("element", elem.m_words[0]);
+            }
+        }));
+    }
+
+    std::vector<std::thread> producers;
+    for (uint32_t i = 0; i < a_config.producers; i++)
+    {
+        PerfCounterSample* threadPerf = a_config.perf ? &perf[i] : 0;
+        producers.push_back(std::thread([&queue, &go, perProducer, threadPerf]() {
+            produce<ELEM_T>(perProducer, go, threadPerf, [&queue](const ELEM_T &a_elem) {
+                queue->Push(a_elem); });
+        }));
+    }
+
+    uint64_t start = TscClock::Now();
+    go.store(true, std::memory_order_release);
+    for (uint32_t i = 0; i < a_config.producers; i++)
+    {
+        producers[i].join();
+    }
+
+    // every element is already in the queue, so the end markers come last
+    ELEM_T end;
+    memset(&end, 0, sizeof(end));
+    for (uint32_t i = 0; i < a_config.consumers; i++)
+    {
+        queue->Push(end);
+    }
+    for (uint32_t i = 0; i < a_config.consumers; i++)
+    {
+        consumers[i].join();
+    }
+    uint64_t elapsed = TscClock::Now() - start;
+
+    BenchConfig config = a_config;
+    config.elements = perProducer * a_config.producers;
+    return summarise(config, elapsed, latencies, perf);
+}
+
+/// @brief the consumer is the thread of the ConsumerThread
+template <typename ELEM_T>
+BenchResult runConsumerThread(const BenchConfig &a_config)
+{
+    uint32_t perProducer = a_config.elements / a_config.producers;
+    uint32_t total = perProducer * a_config.producers;
+    std::atomic<bool> go(false);
+    std::atomic<uint32_t> consumed(0);
+
+    ShardedLatencyHistogram latencies;
+    std::vector<PerfCounterSample> perf(a_config.producers);
+    ConsumerThread<ELEM_T> consumer(a_config.capacity, [&latencies, &consumed](ELEM_T a_elem) {
+        latencies.Record(TscClock::Now() - a_elem.m_words[0]);
+        TRACE_FLOW_END("element", a_elem.m_words[0]);
+        consumed.store(consumed.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    });
+
+    std::vector<std::thread> producers;
+    for (uint32_t i = 0; i < a_config.producers; i++)
+    {
+        PerfCounterSample* threadPerf = a_config.perf ? &perf[i] : 0;
+        producers.push_back(std::thread([&consumer, &go, perProducer, threadPerf]() {
+            produce<ELEM_T>(perProducer, go, threadPerf, [&consumer](const ELEM_T &a_elem) {
+                consumer.ProduceOrBlock(a_elem); });
+        }));
+    }
+
+    uint64_t start = TscClock::Now();
+    go.store(true, std::memory_order_release);
+    for (uint32_t i = 0; i < a_config.producers; i++)
+    {
+        producers[i].join();
+    }
+
+    // ConsumerThread::Join doesn't drain the queue
+    Backoff backoff;
+    while (consumed.load(std::memory_order_acquire) < total)
+    {
+        backoff.Wait();
+    }
+    uint64_t elapsed = TscClock::Now() - start;
+    consumer.Join();
+
+    BenchConfig config = a_config;
+    config.elements = total;
+    return summarise(config, elapsed, latencies, perf);
+}
+
+template <uint32_t ELEM_SIZE, uint32_t Q_SIZE>
+BenchResult runCase(const BenchConfig &a_config)
+{
+    typedef BenchElement<ELEM_SIZE> Elem_t;
+
+    std::string queue(a_config.queue);
+    if (queue == "lfq-sp")
+    {
+        return runQueue<LockFreeAdapter<Elem_t, Q_SIZE, ArrayLockFreeQueueSingleProducer>,
+                        Elem_t>(a_config);
+    }
+    else if (queue == "lfq-mp")
+    {
+        return runQueue<LockFreeAdapter<Elem_t, Q_SIZE, ArrayLockFreeQueueMultipleProducers>,
+                        Elem_t>(a_config);
+    }
+    else if (queue == "safe-queue")
+    {
+        return runQueue<SafeQueueAdapter<Elem_t>, Elem_t>(a_config);
+    }
+    return runConsumerThread<Elem_t>(a_config);
+}
+
+/// @brief the lock-free queues take their capacity as a template parameter
+template <uint32_t ELEM_SIZE>
+BenchResult runCapacity(const BenchConfig &a_config)
+{
+    switch (a_config.capacity)
+    {
+    case 64:
+        return runCase<ELEM_SIZE, 64>(a_config);
+    case 1024:
+        return runCase<ELEM_SIZE, 1024>(a_config);
+    default:
+        return runCase<ELEM_SIZE, 16384>(a_config);
+    }
+}
+
+static BenchResult run(const BenchConfig &a_config)
+{
+    switch (a_config.elemSize)
+    {
+    case 8:
+        return runCapacity<8>(a_config);
+    case 64:
+        return runCapacity<64>(a_config);
+    default:
+        return runCapacity<256>(a_config);
+    }
+}
+
+enum OutputFormat_t
+{
+    OUTPUT_TEXT,
+    OUTPUT_CSV,
+    OUTPUT_JSON
+};
+
+/// @brief appends the counters per element to the line of a case
+static void printPerf(const BenchResult &a_result, OutputFormat_t a_format, bool a_header)
+{
+    const char* separator = "";
+    for (int i = 0; i < PERF_EVENT_COUNT; i++)
+    {
+        PerfEvent_t event = static_cast<PerfEvent_t>(i);
+        std::string name(PerfCounterSample::EventName(event));
+        double perElem = a_result.perf.PerOperation(event, a_result.config.elements);
+
+        switch (a_format)
+        {
+        case OUTPUT_CSV:
+            // a column per event, empty if it wasn't counted
+            for (std::size_t j = 0; j < name.size(); j++)
+            {
+                name[j] = (name[j] == '-') ? '_' : name[j];
+            }
+            if (a_header)
+            {
+                std::cout << ',' << name << "_per_elem";
+            }
+            else
+            {
+                std::cout << ',';
+                if (perElem >= 0.0)
+                {
+                    std::cout << perElem;
+                }
+            }
+            break;
+
+        case OUTPUT_JSON:
+            if (perElem >= 0.0)
+            {
+                std::cout << (*separator ? separator : ", \"perf_per_elem\": {")
+                          << '"' << name << "\": " << perElem;
+                separator = ", ";
+            }
+            break;
+
+        default:
+            if (perElem >= 0.0)
+            {
+                std::cout << ' ' << name << "/elem=" << perElem;
+            }
+            break;
+        }
+    }
+
+    if ((a_format == OUTPUT_JSON) && *separator)
+    {
+        std::cout << '}';
+    }
+}
+
+static void print(const BenchResult &a_result, OutputFormat_t a_format, bool a_first)
+{
+    const BenchConfig &config = a_result.config;
+    double nsecsPerElem = static_cast<double>(a_result.elapsed) / config.elements;
+    double mops = 1000.0 / nsecsPerElem;
+
+    std::cout << std::fixed << std::setprecision(2);
+    switch (a_format)
+    {
+    case OUTPUT_CSV:
+        if (a_first)
+        {
+            std::cout << "queue,producers,consumers,elem_size,capacity,elements,"
+                      << "nsecs_per_elem,mops_per_sec,p50,p90,p99,p999,max";
+            if (config.perf)
+            {
+                printPerf(a_result, a_format, true);
+            }
+            std::cout << std::endl;
+        }
+        std::cout << config.queue << ',' << config.producers << ',' << config.consumers
+                  << ',' << config.elemSize << ',' << config.capacity << ',' << config.elements
+                  << ',' << nsecsPerElem << ',' << mops
+                  << ',' << a_result.p50 << ',' << a_result.p90 << ',' << a_result.p99
+                  << ',' << a_result.p999 << ',' << a_result.max;
+        if (config.perf)
+        {
+            printPerf(a_result, a_format, false);
+        }
+        std::cout << std::endl;
+        break;
+
+    case OUTPUT_JSON:
+        std::cout << (a_first ? "[\n" : ",\n")
+                  << "  {\"queue\": \"" << config.queue << "\""
+                  << ", \"producers\": " << config.producers
+                  << ", \"consumers\": " << config.consumers
+                  << ", \"elem_size\": " << config.elemSize
+                  << ", \"capacity\": " << config.capacity
+                  << ", \"elements\": " << config.elements
+                  << ", \"nsecs_per_elem\": " << nsecsPerElem
+                  << ", \"mops_per_sec\": " << mops
+                  << ", \"latency_nsecs\": {\"p50\": " << a_result.p50
+                  << ", \"p90\": " << a_result.p90
+                  << ", \"p99\": " << a_result.p99
+                  << ", \"p999\": " << a_result.p999
+                  << ", \"max\": " << a_result.max << "}";
+        if (config.perf)
+        {
+            printPerf(a_result, a_format, false);
+        }
+        std::cout << "}";
+        break;
+
+    default:
+        std::cout << "queue=" << config.queue
+                  << " producers=" << config.producers
+                  << " consumers=" << config.consumers
+                  << " elem-size=" << config.elemSize
+                  << " capacity=" << config.capacity
+                  << " elements=" << config.elements
+                  << " nsecs/elem=" << nsecsPerElem
+                  << " mops/sec=" << mops
+                  << " p50=" << a_result.p50
+                  << " p90=" << a_result.p90
+                  << " p99=" << a_result.p99
+                  << " p999=" << a_result.p999
+                  << " max=" << a_result.max;
+        if (config.perf)
+        {
+            printPerf(a_result, a_format, false);
+        }
+        std::cout << std::endl;
+        break;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    OutputFormat_t format = OUTPUT_TEXT;
+    uint32_t elements = BENCH_DEFAULT_ELEMENTS;
+    const char* only = 0;
+    bool perf = false;
+    const char* trace = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--csv") == 0)
+        {
+            format = OUTPUT_CSV;
+        }
+        else if (strcmp(argv[i], "--json") == 0)
+        {
+            format = OUTPUT_JSON;
+        }
+        else if ((strcmp(argv[i], "--elements") == 0) && (i + 1 < argc))
+        {
+            elements = static_cast<uint32_t>(strtoul(argv[++i], 0, 10));
+        }
+        else if ((strcmp(argv[i], "--queue") == 0) && (i + 1 < argc))
+        {
+            only = argv[++i];
+        }
+        else if (strcmp(argv[i], "--perf") == 0)
+        {
+            perf = true;
+        }
+        else if ((strcmp(argv[i], "--trace") == 0) && (i + 1 < argc))
+        {
+            trace = argv[++i];
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--csv|--json] [--elements N] [--queue NAME] [--perf]"
+                      << " [--trace FILE]" << std::endl;
+            return 1;
+        }
+    }
+    if (elements == 0)
+    {
+        std::cerr << "--elements must be greater than 0" << std::endl;
+        return 1;
+    }
+
+    TscClock::Init();
+
+    std::ofstream traceFile;
+    if (trace != 0)
+    {
+        traceFile.open(trace);
+        if (!traceFile)
+        {
+            std::cerr << "can't open " << trace << std::endl;
+            return 1;
+        }
+        Tracer::Enable();
+    }
+
+    const char* queues[] = {"lfq-sp", "lfq-mp", "safe-queue", "consumer-thread"};
+    const uint32_t threads[] = {1, 2, 4};
+    const uint32_t elemSizes[] = {8, 64, 256};
+    const uint32_t capacities[] = {64, 1024, 16384};
+
+    bool first = true;
+    for (std::size_t q = 0; q < (sizeof(queues) / sizeof(queues[0])); q++)
+    {
+        if ((only != 0) && (strcmp(only, queues[q]) != 0))
+        {
+            continue;
+        }
+
+        for (std::size_t p = 0; p < (sizeof(threads) / sizeof(threads[0])); p++)
+        {
+            if ((q == 0) && (threads[p] > 1))
+            {
+                continue; // single producer
+            }
+
+            for (std::size_t c = 0; c < (sizeof(threads) / sizeof(threads[0])); c++)
+            {
+                if ((q == 3) && (threads[c] > 1))
+                {
+                    continue; // ConsumerThread has one thread
+                }
+
+                for (std::size_t s = 0; s < (sizeof(elemSizes) / sizeof(elemSizes[0])); s++)
+                {
+                    for (std::size_t k = 0; k < (sizeof(capacities) / sizeof(capacities[0])); k++)
+                    {
+                        BenchConfig config = {queues[q], threads[p], threads[c],
+                                              elemSizes[s], capacities[k], elements, perf};
+                        print(run(config), format, first);
+                        first = false;
+                    }
+                }
+            }
+        }
+    }
+
+    if ((format == OUTPUT_JSON) && !first)
+    {
+        std::cout << "\n]" << std::endl;
+    }
+    else if (format == OUTPUT_JSON)
+    {
+        std::cout << "[]" << std::endl;
+    }
+
+    if (trace != 0)
+    {
+        Tracer::Disable();
+        Tracer::Write(traceFile);
+        if (Tracer::Dropped() != 0)
+        {
+            std::cerr << "trace: " << Tracer::Dropped() << " events dropped" << std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,75 @@
+// ============================================================================
+/// @file  sampling_profiler_bench.cpp
+/// @brief What the sampling profiler costs the program it samples
+/// The same amount of work is timed with the profiler stopped, sampling at
+/// its default rate (99Hz) and at 1000Hz (the kernel might deliver fewer
+/// signals: ITIMER_PROF has the resolution of the scheduler tick)
+/// Compiling procedure:
+///   $ g++ -g -O2 -Wall -DNDEBUG -std=c++11 -D_REENTRANT -c sampling_profiler_bench.cpp
+///   $ g++ sampling_profiler_bench.o -o sampling_profiler_bench -pthread
+///
+/// Output is one line per case:
+///   case=99Hz samples=... msecs=... overhead=...%
+// ============================================================================
+
+#include <iostream>
+#include <iomanip> // std::setprecision
+#include "clock.h"
+#include "sampling_profiler.h"
+
+#define BENCH_ROUNDS     5
+#define BENCH_ITERATIONS 200000000
+
+__attribute__((noinline)) uint64_t work(uint64_t a_seed)
+{
+    uint64_t value = a_seed;
+    for (int i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        value ^= value << 13;
+        value ^= value >> 7;
+        value ^= value << 17;
+    }
+    return value;
+}
+
+/// @return the fastest of BENCH_ROUNDS rounds, in nanoseconds
+uint64_t run(uint32_t a_hz, uint64_t &out_sink)
+{
+    uint64_t best = 0;
+    SamplingProfiler::Reset();
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+    {
+        if (a_hz != 0)
+        {
+            SamplingProfiler::Start(a_hz);
+        }
+        uint64_t start = RealClock::Now();
+        out_sink += work(out_sink + round);
+        uint64_t elapsed = RealClock::Now() - start;
+        SamplingProfiler::Stop();
+
+        best = ((best == 0) || (elapsed < best)) ? elapsed : best;
+    }
+    return best;
+}
+
+int main()
+{
+    uint64_t sink = 1;
+    uint64_t baseline = run(0, sink);
+
+    uint32_t rates[] = {0, 99, 1000};
+    for (int i = 0; i < 3; i++)
+    {
+        uint64_t elapsed = (rates[i] == 0) ? baseline : run(rates[i], sink);
+        std::cout << "case=" << ((rates[i] == 0) ? "stopped" : (rates[i] == 99) ? "99Hz" : "1000Hz")
+                  << " samples=" << ((rates[i] == 0) ? 0 : SamplingProfiler::Samples())
+                  << " msecs=" << (elapsed / 1000000)
+                  << " overhead=" << std::fixed << std::setprecision(2)
+                  << (100.0 * (static_cast<double>(elapsed) - baseline) / baseline) << "%"
+                  << std::endl;
+    }
+
+    std::cout << "sink=" << sink << std::endl;
+    return 0;
+}
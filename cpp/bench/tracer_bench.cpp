@@ -0,0 +1,98 @@
+// ============================================================================
+/// @file  tracer_bench.cpp
+/// @brief Nanoseconds per trace event recorded by tracer.h, and what the
+///        macros cost while tracing is disabled
+/// Events are recorded in batches that fit in the buffer of the thread.
+/// The buffer is written (to a null stream) between batches, out of the
+/// time measured. Building with -DTRACER_DISABLE shows the cost of the
+/// macros compiled out: the same as "none"
+/// Compiling procedure:
+///   $ g++ -g -O2 -Wall -DNDEBUG -std=c++11 -D_REENTRANT -c tracer_bench.cpp
+///   $ g++ tracer_bench.o -o tracer_bench -pthread
+///
+/// Output is one line per case:
+///   case=scope/enabled ops=10000000 nsecs/op=...
+// ============================================================================
+
+#include <iostream>
+#include <iomanip> // std::setprecision
+#include <ostream>
+#include "clock.h"
+#include "tracer.h"
+
+#define BENCH_OPERATIONS 10000000
+/// scopes are two events each
+#define BENCH_BATCH      ((TRACER_BUFFER_SIZE / 2) - 1)
+
+/// @brief discards whatever it is written
+class NullBuffer : public std::streambuf
+{
+protected:
+    int overflow(int a_c)
+    {
+        return a_c;
+    }
+};
+
+static volatile uint64_t g_sink = 0;
+
+template <typename FUNCTION_T>
+void run(const char* a_name, FUNCTION_T a_operation)
+{
+    NullBuffer nullBuffer;
+    std::ostream null(&nullBuffer);
+
+    uint64_t elapsed = 0;
+    for (uint32_t done = 0; done < BENCH_OPERATIONS; done += BENCH_BATCH)
+    {
+        uint64_t start = RealClock::Now();
+        for (uint32_t i = 0; i < BENCH_BATCH; i++)
+        {
+            a_operation(i);
+        }
+        elapsed += RealClock::Now() - start;
+
+        Tracer::Write(null);
+    }
+
+    std::cout << "case=" << a_name
+              << " ops=" << BENCH_OPERATIONS
+              << " nsecs/op=" << std::fixed << std::setprecision(2)
+              << (static_cast<double>(elapsed) / BENCH_OPERATIONS)
+              << std::endl;
+}
+
+int main()
+{
+    run("none", [](uint32_t a_i) {
+        g_sink = g_sink + a_i;
+    });
+
+    run("scope/disabled", [](uint32_t a_i) {
+        TRACE_SCOPE("scope");
+        g_sink = g_sink + a_i;
+    });
+
+    Tracer::Enable();
+    run("scope/enabled", [](uint32_t a_i) {
+        TRACE_SCOPE("scope");
+        g_sink = g_sink + a_i;
+    });
+
+    run("counter/enabled", [](uint32_t a_i) {
+        TRACE_COUNTER("counter", 0, a_i);
+        g_sink = g_sink + a_i;
+    });
+
+    run("flow/enabled", [](uint32_t a_i) {
+        TRACE_FLOW_BEGIN("flow", a_i);
+        g_sink = g_sink + a_i;
+    });
+    Tracer::Disable();
+
+    if (Tracer::Dropped() != 0)
+    {
+        std::cout << "dropped=" << Tracer::Dropped() << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,125 @@
+// ============================================================================
+/// @file  vtimer_set_bench.cpp
+/// @brief Cycles per timer per tick of a std::vector of VTimer objects
+///        against VTimerSet (every scan implementation)
+/// Compiling procedure:
+///   $ g++ -g -O2 -Wall -DNDEBUG -std=c++11 -D_REENTRANT -c vtimer_set_bench.cpp
+///   $ g++ vtimer_set_bench.o -o vtimer_set_bench
+///
+/// Periods are picked randomly between 100 and 1000 ticks, so about 0.2% of
+/// the timers expire per tick. Output is one line per run:
+///   timers=10000 ticks=2000 impl=vector<VTimer> cycles/timer/tick=...
+// ============================================================================
+
+#include <iostream>
+#include <iomanip> // std::setprecision
+#include <vector>
+#include <memory>
+#include <functional> // std::bind
+#include <stdlib.h>   // rand
+#include <x86intrin.h> // __rdtsc
+#include "vtimer.h"
+#include "vtimer_set.h"
+
+#define BENCH_TICKS      2000
+#define BENCH_MIN_PERIOD 100
+#define BENCH_MAX_PERIOD 1000
+
+class VTimerSetBench
+{
+public:
+    VTimerSetBench():
+        m_expirations(0)
+    {}
+
+    void Callback(const uint64_t& /*a_currentTime*/)
+    {
+        m_expirations++;
+    }
+
+    void runVector(std::size_t a_timers);
+    void runSet(std::size_t a_timers, VTimerSet::ScanType_t a_scanType, const char* a_name);
+
+private:
+    uint64_t m_expirations;
+
+    void report(std::size_t a_timers, const char* a_name, uint64_t a_cycles)
+    {
+        std::cout << "timers=" << a_timers
+                  << " ticks=" << BENCH_TICKS
+                  << " impl=" << a_name
+                  << " expirations=" << m_expirations
+                  << " cycles/timer/tick=" << std::fixed << std::setprecision(3)
+                  << (static_cast<double>(a_cycles) / (a_timers * BENCH_TICKS))
+                  << std::endl;
+    }
+};
+
+void VTimerSetBench::runVector(std::size_t a_timers)
+{
+    std::vector< VTimer<uint64_t> > timers;
+    timers.reserve(a_timers);
+
+    srand(1);
+    for (std::size_t i = 0; i < a_timers; i++)
+    {
+        timers.push_back(VTimer<uint64_t>(
+            std::bind(&VTimerSetBench::Callback, this, std::placeholders::_1),
+            BENCH_MIN_PERIOD + (rand() % (BENCH_MAX_PERIOD - BENCH_MIN_PERIOD))));
+    }
+
+    m_expirations = 0;
+    uint64_t start = __rdtsc();
+    for (uint64_t tick = 1; tick <= BENCH_TICKS; tick++)
+    {
+        for (std::size_t i = 0; i < a_timers; i++)
+        {
+            timers[i].Update(tick);
+        }
+    }
+    report(a_timers, "vector<VTimer>", __rdtsc() - start);
+}
+
+void VTimerSetBench::runSet(
+    std::size_t a_timers, VTimerSet::ScanType_t a_scanType, const char* a_name)
+{
+    VTimerSet timers;
+    if (!timers.SetScanType(a_scanType))
+    {
+        std::cout << "timers=" << a_timers << " impl=" << a_name
+                  << " not supported by this CPU" << std::endl;
+        return;
+    }
+
+    srand(1);
+    for (std::size_t i = 0; i < a_timers; i++)
+    {
+        timers.Add(
+            std::bind(&VTimerSetBench::Callback, this, std::placeholders::_1),
+            BENCH_MIN_PERIOD + (rand() % (BENCH_MAX_PERIOD - BENCH_MIN_PERIOD)));
+    }
+
+    m_expirations = 0;
+    uint64_t start = __rdtsc();
+    for (uint64_t tick = 1; tick <= BENCH_TICKS; tick++)
+    {
+        timers.Update(tick);
+    }
+    report(a_timers, a_name, __rdtsc() - start);
+}
+
+int main()
+{
+    VTimerSetBench theBench;
+    std::size_t sizes[] = {10000, 100000};
+
+    for (std::size_t i = 0; i < (sizeof(sizes) / sizeof(sizes[0])); i++)
+    {
+        theBench.runVector(sizes[i]);
+        theBench.runSet(sizes[i], VTimerSet::SCAN_SCALAR, "VTimerSet/scalar");
+        theBench.runSet(sizes[i], VTimerSet::SCAN_SSE42,  "VTimerSet/sse4.2");
+        theBench.runSet(sizes[i], VTimerSet::SCAN_AVX2,   "VTimerSet/avx2");
+    }
+
+    return 0;
+}
@@ -0,0 +1,267 @@
+// ============================================================================
+// Copyright (c) 2026 Faustino Frechilla
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+/// @file  clock.h
+/// @brief This file contains the clocks that can be plugged into the timers
+///
+/// A clock is a class with static members only, so the clock used by a
+/// template (for instance BasicTimerService) is chosen at compile time and
+/// reading it costs the same as calling the underlying function directly.
+/// Every clock must provide:
+///
+///   /// true if time only moves forward when told to (see VirtualClock)
+///   static const bool IS_VIRTUAL;
+///   /// current time in nanoseconds. It never goes backwards
+///   static uint64_t Now();
+///
+/// Clocks defined in this file:
+///   - RealClock: CLOCK_MONOTONIC
+///   - VirtualClock: time only advances when a driver says so. Used to
+///     replay captured traffic as fast as possible or to benchmark
+///     deterministically
+/// TscClock, based on the CPU time stamp counter, is defined in tsc_clock.h
+///
+/// Your compiler must have support for c++11
+///
+/// @author Faustino Frechilla
+/// @history
+/// Ref        Who                When        What
+///            Faustino Frechilla 17-Oct-2026 Original development
+///            Faustino Frechilla 17-Oct-2026 Listeners told without the lock held
+/// @endhistory
+///
+// ============================================================================
+
+#ifndef _CLOCK_H_
+#define _CLOCK_H_
+
+#include <stdint.h>   // types (uint64_t...)
+#include <time.h>     // clock_gettime
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <algorithm>  // std::find
+#include <assert.h>
+
+/// @brief CLOCK_MONOTONIC in nanoseconds
+class RealClock
+{
+public:
+    static const bool IS_VIRTUAL = false;
+
+    /// @return nanoseconds since some unspecified starting point
+    static inline uint64_t Now()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+
+        return (static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL) +
+                static_cast<uint64_t>(ts.tv_nsec);
+    }
+
+private:
+    RealClock();
+};
+
+/// @brief interface of objects which need to know when the virtual time moves
+/// forward (for instance a BasicTimerService<VirtualClock> which has to
+/// process the timers that expired)
+class VirtualClockListener
+{
+public:
+    virtual ~VirtualClockListener()
+    {}
+
+    /// @brief called by the thread advancing the virtual time
+    /// It must not return until the listener is done processing whatever
+    /// was due by a_now, so replays are deterministic
+    /// @param a_now the new virtual time
+    virtual void OnVirtualTimeAdvanced(uint64_t a_now) = 0;
+};
+
+/// @brief a clock whose time is set by the user
+/// The time starts at 0 and only moves when AdvanceTo or Advance are called,
+/// usually by a replay driver that reads timestamps from captured traffic.
+/// There is one virtual time per process. Example of usage:
+///
+/// BasicTimerService<VirtualClock> service;
+/// service.Schedule(std::bind(&MyCallback, std::placeholders::_1), 1000);
+/// // MyCallback is called before AdvanceTo returns
+/// VirtualClock::AdvanceTo(1000);
+class VirtualClock
+{
+public:
+    static const bool IS_VIRTUAL = true;
+
+    /// @return the current virtual time in nanoseconds
+    static inline uint64_t Now()
+    {
+        return Time().load(std::memory_order_acquire);
+    }
+
+    /// @brief moves the virtual time forward
+    /// Listeners are told about the new time, and this call only returns
+    /// once all of them are done with it. It must not be called from two
+    /// threads at the same time, nor by a listener while it is being told
+    /// (for instance, a timer callback run inline by a
+    /// BasicTimerService<VirtualClock>): the listener would wait for itself.
+    /// Listeners are told without the lock held, so they can add or remove
+    /// listeners meanwhile (creating or joining other timer services).
+    /// Listeners added meanwhile are told next time
+    /// @param a_now new virtual time. It can't be earlier than Now()
+    static void AdvanceTo(uint64_t a_now)
+    {
+        assert(a_now >= Now());
+        bool advancing = Advancing().exchange(true);
+        assert(!advancing);
+        (void) advancing;
+
+        Time().store(a_now, std::memory_order_release);
+
+        // only the thread advancing the time uses the copy, so it is
+        // allocated once
+        std::vector<VirtualClockListener*> &snapshot = Snapshot();
+        {
+            std::lock_guard<std::mutex> lk(ListenersMutex());
+            snapshot = Listeners();
+        }
+
+        for (std::size_t i = 0; i < snapshot.size(); i++)
+        {
+            {
+                // it might have been removed since the copy was made
+                std::lock_guard<std::mutex> lk(ListenersMutex());
+                std::vector<VirtualClockListener*> &listeners = Listeners();
+                if (std::find(listeners.begin(), listeners.end(), snapshot[i]) == listeners.end())
+                {
+                    continue;
+                }
+                Notifying() = snapshot[i];
+            }
+
+            snapshot[i]->OnVirtualTimeAdvanced(a_now);
+
+            {
+                std::lock_guard<std::mutex> lk(ListenersMutex());
+                Notifying() = 0;
+            }
+            NotifyingDone().notify_all();
+        }
+
+        Advancing().store(false);
+    }
+
+    /// @brief moves the virtual time forward by a_delta nanoseconds
+    static inline void Advance(uint64_t a_delta)
+    {
+        AdvanceTo(Now() + a_delta);
+    }
+
+    /// @brief sets the virtual time without telling the listeners
+    /// Meant to set the starting point of a replay before anything is
+    /// scheduled. It might go backwards
+    static inline void Reset(uint64_t a_now = 0)
+    {
+        Time().store(a_now, std::memory_order_release);
+    }
+
+    /// @brief registers a listener. It will be told every time the virtual
+    /// time moves forward until it is unregistered
+    static void AddListener(VirtualClockListener* a_listener)
+    {
+        std::lock_guard<std::mutex> lk(ListenersMutex());
+        Listeners().push_back(a_listener);
+    }
+
+    /// @brief unregisters a listener
+    /// If the listener is being told about a new time it waits until it is
+    /// done, so a_listener can be destroyed as soon as this returns
+    static void RemoveListener(VirtualClockListener* a_listener)
+    {
+        std::unique_lock<std::mutex> lk(ListenersMutex());
+        std::vector<VirtualClockListener*> &listeners = Listeners();
+        std::vector<VirtualClockListener*>::iterator it =
+            std::find(listeners.begin(), listeners.end(), a_listener);
+        if (it != listeners.end())
+        {
+            listeners.erase(it);
+        }
+
+        while (Notifying() == a_listener)
+        {
+            NotifyingDone().wait(lk);
+        }
+    }
+
+private:
+    VirtualClock();
+
+    // function-local statics so this class can live in a header file
+    static inline std::atomic<uint64_t>& Time()
+    {
+        static std::atomic<uint64_t> s_time(0);
+        return s_time;
+    }
+
+    static inline std::mutex& ListenersMutex()
+    {
+        static std::mutex s_mutex;
+        return s_mutex;
+    }
+
+    static inline std::vector<VirtualClockListener*>& Listeners()
+    {
+        static std::vector<VirtualClockListener*> s_listeners;
+        return s_listeners;
+    }
+
+    /// copy of Listeners() being told about a new time
+    static inline std::vector<VirtualClockListener*>& Snapshot()
+    {
+        static std::vector<VirtualClockListener*> s_snapshot;
+        return s_snapshot;
+    }
+
+    /// listener being told about a new time (0 if none). Protected by
+    /// ListenersMutex
+    static inline VirtualClockListener*& Notifying()
+    {
+        static VirtualClockListener* s_notifying = 0;
+        return s_notifying;
+    }
+
+    /// signalled every time a listener is done with a new time
+    static inline std::condition_variable& NotifyingDone()
+    {
+        static std::condition_variable s_notifyingDone;
+        return s_notifyingDone;
+    }
+
+    /// true while AdvanceTo is running
+    static inline std::atomic<bool>& Advancing()
+    {
+        static std::atomic<bool> s_advancing(false);
+        return s_advancing;
+    }
+};
+
+#endif /* _CLOCK_H_ */
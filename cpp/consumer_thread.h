@@ -22,6 +22,13 @@
 /// @file  consumer_thread.h
 /// @brief This file contains the Consumer Thread class.
 ///
+/// When tracing is enabled (tracer.h) every call to the consume delegate is
+/// a "consume" slice of the consumer thread, preceded by a sample of the
+/// "consumer queue" counter track: the elements left in the queue. The
+/// track of each ConsumerThread has its own id (its address). A delegate
+/// can link the slice to the one that produced the element with
+/// TRACE_FLOW_END, if the element carries an id for TRACE_FLOW_BEGIN
+///
 /// Your compiler must have support for c++11. This is an example of how to 
 /// compile an application that makes use of this consumer thread with gcc 4.8:
 ///   $ g++ -g -O0 -Wall -std=c++11 -D_REENTRANT -c app.cpp
@@ -32,6 +39,8 @@
 /// Ref        Who                When        What
 ///            Faustino Frechilla 04-May-2009 Original development
 ///            Faustino Frechilla 06-Jun-2013 Ported to c++11
+///            Faustino Frechilla 17-Oct-2026 Histogram of the consume delegate time
+///            Faustino Frechilla 17-Oct-2026 Trace events (tracer.h)
 /// @endhistory
 ///
 // ============================================================================
@@ -43,6 +52,8 @@
 #include <atomic>
 #include <functional>
 #include "safe_queue.h"
+#include "latency_histogram.h"
+#include "tracer.h"
 
 template <typename T>
 class ConsumerThread
@@ -85,6 +96,15 @@ public:
     /// @param a const reference to the element to insert into the queue
     void ProduceOrBlock(const T &a_data);
 
+    /// @brief the consumer thread records in a_histogram how long each call
+    /// to the consume delegate takes (in nanoseconds). Only the consumer
+    /// thread writes to it, so it can't be shared with other writers. Any
+    /// thread can read it meanwhile. 0 (the default) stops recording.
+    /// It returns once the consumer thread is done with the previous
+    /// histogram, so that one can be freed straight away
+    /// @param a_histogram it must outlive this object or be replaced first
+    void SetLatencyHistogram(LatencyHistogram* a_histogram);
+
 private:
     /// the worker thread
     std::unique_ptr<std::thread> m_producerThread;
@@ -101,12 +121,23 @@ private:
     /// The queue with the data to be processed
     SafeQueue<T> m_consumableQueue;
 
+    /// where the time spent in m_consumeDelegate is recorded (if not 0)
+    std::atomic<LatencyHistogram*> m_latencyHistogram;
+
+    /// the histogram the consumer thread is writing to right now (0 if none)
+    /// SetLatencyHistogram waits until it is not the one being replaced
+    std::atomic<LatencyHistogram*> m_latencyHistogramInUse;
+
     /// Creates the consumer thread calling to the necessary system functions
     void SpawnThread();
 
     /// brief the routine that will be run by the consumer thread
     void ThreadRoutine();
 
+    /// @brief records a_nsecs in the current histogram (if any) while it is
+    /// published in m_latencyHistogramInUse. Called by the consumer thread
+    void RecordLatency(uint64_t a_nsecs);
+
     /// @brief dummy function 
     /// To be used when the user doesn't specify the init function
     static void DoNothing() {};
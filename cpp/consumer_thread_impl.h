@@ -27,6 +27,8 @@
 /// Ref        Who                When        What
 ///            Faustino Frechilla 04-May-2009 Original development
 ///            Faustino Frechilla 06-Jun-2013 Ported to c++11
+///            Faustino Frechilla 17-Oct-2026 Histogram of the consume delegate time
+///            Faustino Frechilla 17-Oct-2026 Trace events (tracer.h)
 /// @endhistory
 ///
 // ============================================================================
@@ -35,6 +37,8 @@
 #define _CONSUMERTHREADIMPL_H_
 
 #include <assert.h>
+#include "backoff.h"
+#include "tsc_clock.h"
 
 // wake up timeout. The consumer thread will wake up when the timeout is hit
 // when there is no data to consume to check if it has been told to finish
@@ -45,7 +49,9 @@ ConsumerThread<T>::ConsumerThread(std::function<void(T)> a_consumeDelegate, std:
     m_terminate(false),
     m_consumeDelegate(a_consumeDelegate),
     m_initDelegate(a_initDelegate),
-    m_consumableQueue()
+    m_consumableQueue(),
+    m_latencyHistogram(0),
+    m_latencyHistogramInUse(0)
 {
     SpawnThread();
 }
@@ -55,7 +61,9 @@ ConsumerThread<T>::ConsumerThread(std::size_t a_queueSize, std::function<void(T)
     m_terminate(false),
     m_consumeDelegate(a_consumeDelegate),
     m_initDelegate(a_initDelegate),
-    m_consumableQueue(a_queueSize)
+    m_consumableQueue(a_queueSize),
+    m_latencyHistogram(0),
+    m_latencyHistogramInUse(0)
 {
     SpawnThread();
 }
@@ -103,9 +111,50 @@ void ConsumerThread<T>::ProduceOrBlock(const T &a_data)
     m_consumableQueue.Push(a_data);
 }
 
+template <typename T>
+void ConsumerThread<T>::SetLatencyHistogram(LatencyHistogram* a_histogram)
+{
+    LatencyHistogram* old = m_latencyHistogram.exchange(a_histogram);
+    if (old == 0)
+    {
+        return;
+    }
+
+    // the consumer thread publishes the histogram in use before checking
+    // again which one is current (both seq_cst), so either it already sees
+    // a_histogram or this load sees it still writing to the old one
+    Backoff backoff;
+    while (m_latencyHistogramInUse.load() == old)
+    {
+        backoff.Wait();
+    }
+}
+
+template <typename T>
+void ConsumerThread<T>::RecordLatency(uint64_t a_nsecs)
+{
+    LatencyHistogram* histogram = m_latencyHistogram.load();
+    LatencyHistogram* current;
+    do
+    {
+        m_latencyHistogramInUse.store(histogram);
+        current = histogram;
+        histogram = m_latencyHistogram.load();
+    } while (histogram != current);
+
+    if (histogram != 0)
+    {
+        histogram->Record(a_nsecs);
+    }
+
+    m_latencyHistogramInUse.store(0, std::memory_order_release);
+}
+
 template <typename T>
 void ConsumerThread<T>::ThreadRoutine()
 {
+    TRACE_THREAD_NAME("ConsumerThread");
+
     // init function
     this->m_initDelegate();
 
@@ -116,7 +165,22 @@ void ConsumerThread<T>::ThreadRoutine()
         if (this->m_consumableQueue.TimedWaitPop(
             thisElem, std::chrono::microseconds(CONSUMER_THREAD_TIMEOUT_USEC)))
         {
-            this->m_consumeDelegate(thisElem);
+            TRACE_COUNTER("consumer queue", reinterpret_cast<uintptr_t>(this),
+                          this->m_consumableQueue.Size());
+            TRACE_SCOPE("consume");
+
+            if (this->m_latencyHistogram.load(std::memory_order_relaxed) == 0)
+            {
+                this->m_consumeDelegate(thisElem);
+            }
+            else
+            {
+                // the histogram is loaded again once the delegate returns:
+                // it may have been replaced (even by the delegate itself)
+                uint64_t start = TscClock::Now();
+                this->m_consumeDelegate(thisElem);
+                this->RecordLatency(TscClock::Now() - start);
+            }
         }
     }
 }
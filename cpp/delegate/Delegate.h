@@ -16,6 +16,8 @@
 /// delegateFunction = MakeDelegate(&obj, &A::f);
 /// // Actual call to the delegate
 /// delegateFunction(0, std::string("Hello world"));
+///
+/// Delegate can't hold lambdas which capture variables. See InplaceDelegate.h
 
 
 #ifndef DELEGATE_H_
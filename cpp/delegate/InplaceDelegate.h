@@ -0,0 +1,347 @@
+/// @file    InplaceDelegate.h
+/// @brief   This file contains the definition of the InplaceDelegate class
+///
+/// InplaceDelegate is a Delegate (see Delegate.h) for any number of arguments
+/// which can also hold callable objects (capturing lambdas, functors...)
+/// The target is stored inside the delegate, in a buffer of STORAGE_SIZE
+/// bytes, so it never allocates memory. A target which doesn't fit in there
+/// is a compile time error. Calling it costs one indirect call, like a
+/// FastDelegate
+///
+/// Example of use
+///
+/// // A delegate that returns void and receives an UInt16 and a std::string
+/// InplaceDelegate<void(UInt16, std::string)> delegateFunction;
+/// // Method f defined in the class A, called in the context of 'obj'
+/// delegateFunction = MakeInplaceDelegate(&obj, &A::f);
+/// // The same, but the method is known at compile time: it is called
+/// // directly (as fast as a FastDelegate) instead of through a pointer to
+/// // member function
+/// delegateFunction = InplaceDelegate<void(UInt16, std::string)>::Bind<A, &A::f>(&obj);
+/// // Free functions and lambdas, captures included
+/// delegateFunction = [&counter](UInt16 a, std::string b) { counter += a; };
+/// // Actual call to the delegate
+/// delegateFunction(0, std::string("Hello world"));
+///
+/// // Up to 64 bytes of captures
+/// InplaceDelegate<int(int), 64> bigDelegate;
+
+
+#ifndef INPLACEDELEGATE_H_
+#define INPLACEDELEGATE_H_
+
+#include <cstddef>     // std::size_t
+#include <string.h>    // memcpy
+#include <new>         // placement new
+#include <type_traits>
+#include <utility>     // std::forward
+
+// size of the buffer of an InplaceDelegate by default. Big enough for a
+// member function pointer plus the object, or a lambda capturing up to 4
+// pointers
+#define INPLACE_DELEGATE_DEFAULT_STORAGE 32
+
+template <typename SIGNATURE_T, std::size_t STORAGE_SIZE = INPLACE_DELEGATE_DEFAULT_STORAGE>
+class InplaceDelegate;
+
+/// @brief a delegate to functions returning RETURN_TYPE and receiving ARGS
+template <typename RETURN_TYPE, typename... ARGS, std::size_t STORAGE_SIZE>
+class InplaceDelegate<RETURN_TYPE (ARGS...), STORAGE_SIZE>
+{
+public:
+    // default constructor. An empty delegate
+    InplaceDelegate():
+        m_invoke(0),
+        m_manage(0)
+    {}
+
+    ~InplaceDelegate()
+    {
+        Reset();
+    }
+
+    InplaceDelegate(const InplaceDelegate &a_source):
+        m_invoke(0),
+        m_manage(0)
+    {
+        CopyFrom(a_source);
+    }
+
+    InplaceDelegate& operator=(const InplaceDelegate &a_source)
+    {
+        if (this != &a_source)
+        {
+            Reset();
+            CopyFrom(a_source);
+        }
+        return *this;
+    }
+
+    // functions that are not part of any class
+    InplaceDelegate(RETURN_TYPE (*a_function)(ARGS...)):
+        m_invoke(0),
+        m_manage(0)
+    {
+        if (a_function != 0)
+        {
+            Store(FunctionTarget(a_function));
+        }
+    }
+
+    // RETURN_TYPE (X::*a_method)(ARGS...) is a pointer to the method a_method
+    // of the class X, which is called in the context of a_object
+    template <class X, class Y>
+    InplaceDelegate(Y* a_object, RETURN_TYPE (X::*a_method)(ARGS...)):
+        m_invoke(0),
+        m_manage(0)
+    {
+        Store(MethodTarget<X>(static_cast<X*>(a_object), a_method));
+    }
+
+    // The same as above but for const members
+    template <class X, class Y>
+    InplaceDelegate(const Y* a_object, RETURN_TYPE (X::*a_method)(ARGS...) const):
+        m_invoke(0),
+        m_manage(0)
+    {
+        Store(ConstMethodTarget<X>(static_cast<const X*>(a_object), a_method));
+    }
+
+    // callable objects (lambdas, functors...). They are copied into the
+    // delegate. Delegates and function pointers are dealt with above
+    template <typename CALLABLE_T, typename = typename std::enable_if<
+        !std::is_same<typename std::decay<CALLABLE_T>::type, InplaceDelegate>::value &&
+        !std::is_pointer<typename std::decay<CALLABLE_T>::type>::value>::type>
+    InplaceDelegate(CALLABLE_T &&a_callable):
+        m_invoke(0),
+        m_manage(0)
+    {
+        Store(std::forward<CALLABLE_T>(a_callable));
+    }
+
+    template <typename CALLABLE_T, typename = typename std::enable_if<
+        !std::is_same<typename std::decay<CALLABLE_T>::type, InplaceDelegate>::value>::type>
+    InplaceDelegate& operator=(CALLABLE_T &&a_callable)
+    {
+        // built first, in case a_callable lives in this delegate
+        InplaceDelegate other(std::forward<CALLABLE_T>(a_callable));
+        *this = other;
+        return *this;
+    }
+
+    // a delegate to the method METHOD of the class X, called in the context
+    // of a_object. The method is part of the type of the target, so the call
+    // to it is direct (and can be inlined) instead of going through a pointer
+    // to member function
+    template <class X, RETURN_TYPE (X::*METHOD)(ARGS...)>
+    static InplaceDelegate Bind(X* a_object)
+    {
+        InplaceDelegate delegate;
+        delegate.Store(BoundMethodTarget<X, METHOD>(a_object));
+        return delegate;
+    }
+
+    // The same as above but for const members
+    template <class X, RETURN_TYPE (X::*METHOD)(ARGS...) const>
+    static InplaceDelegate Bind(const X* a_object)
+    {
+        InplaceDelegate delegate;
+        delegate.Store(BoundConstMethodTarget<X, METHOD>(a_object));
+        return delegate;
+    }
+
+    // the actual call. The delegate must not be empty
+    inline RETURN_TYPE operator()(ARGS... a_args) const
+    {
+        return m_invoke(const_cast<void*>(static_cast<const void*>(&m_storage)),
+                        std::forward<ARGS>(a_args)...);
+    }
+
+    // operator to check if the Delegate is valid
+    inline operator bool() const
+    {
+        return m_invoke != 0;
+    }
+
+    // empties the delegate
+    void Reset()
+    {
+        if (m_manage != 0)
+        {
+            m_manage(&m_storage, 0);
+        }
+        m_invoke = 0;
+        m_manage = 0;
+    }
+
+private:
+    typedef RETURN_TYPE (*Invoke_t)(void* a_storage, ARGS&&... a_args);
+    // copies a_source into a_destination. It destroys a_destination if
+    // a_source is 0
+    typedef void (*Manage_t)(void* a_destination, const void* a_source);
+
+    /// @brief a free function
+    struct FunctionTarget
+    {
+        explicit FunctionTarget(RETURN_TYPE (*a_function)(ARGS...)):
+            function(a_function)
+        {}
+
+        inline RETURN_TYPE operator()(ARGS... a_args) const
+        {
+            return function(std::forward<ARGS>(a_args)...);
+        }
+
+        RETURN_TYPE (*function)(ARGS...);
+    };
+
+    /// @brief a method and the object it is called on
+    template <class X>
+    struct MethodTarget
+    {
+        MethodTarget(X* a_object, RETURN_TYPE (X::*a_method)(ARGS...)):
+            object(a_object),
+            method(a_method)
+        {}
+
+        inline RETURN_TYPE operator()(ARGS... a_args) const
+        {
+            return (object->*method)(std::forward<ARGS>(a_args)...);
+        }
+
+        X* object;
+        RETURN_TYPE (X::*method)(ARGS...);
+    };
+
+    template <class X>
+    struct ConstMethodTarget
+    {
+        ConstMethodTarget(const X* a_object, RETURN_TYPE (X::*a_method)(ARGS...) const):
+            object(a_object),
+            method(a_method)
+        {}
+
+        inline RETURN_TYPE operator()(ARGS... a_args) const
+        {
+            return (object->*method)(std::forward<ARGS>(a_args)...);
+        }
+
+        const X* object;
+        RETURN_TYPE (X::*method)(ARGS...) const;
+    };
+
+    /// @brief the object a method known at compile time is called on
+    template <class X, RETURN_TYPE (X::*METHOD)(ARGS...)>
+    struct BoundMethodTarget
+    {
+        explicit BoundMethodTarget(X* a_object):
+            object(a_object)
+        {}
+
+        inline RETURN_TYPE operator()(ARGS... a_args) const
+        {
+            return (object->*METHOD)(std::forward<ARGS>(a_args)...);
+        }
+
+        X* object;
+    };
+
+    template <class X, RETURN_TYPE (X::*METHOD)(ARGS...) const>
+    struct BoundConstMethodTarget
+    {
+        explicit BoundConstMethodTarget(const X* a_object):
+            object(a_object)
+        {}
+
+        inline RETURN_TYPE operator()(ARGS... a_args) const
+        {
+            return (object->*METHOD)(std::forward<ARGS>(a_args)...);
+        }
+
+        const X* object;
+    };
+
+    typename std::aligned_storage<STORAGE_SIZE>::type m_storage;
+    Invoke_t m_invoke;
+    // 0 if the target can be copied with memcpy and needs no destructor
+    Manage_t m_manage;
+
+    template <typename TARGET_T>
+    static RETURN_TYPE Invoke(void* a_storage, ARGS&&... a_args)
+    {
+        return (*static_cast<TARGET_T*>(a_storage))(std::forward<ARGS>(a_args)...);
+    }
+
+    template <typename TARGET_T>
+    static void Manage(void* a_destination, const void* a_source)
+    {
+        if (a_source != 0)
+        {
+            new (a_destination) TARGET_T(*static_cast<const TARGET_T*>(a_source));
+        }
+        else
+        {
+            static_cast<TARGET_T*>(a_destination)->~TARGET_T();
+        }
+    }
+
+    template <typename CALLABLE_T>
+    void Store(CALLABLE_T &&a_callable)
+    {
+        typedef typename std::decay<CALLABLE_T>::type Target_t;
+        static_assert(sizeof(Target_t) <= STORAGE_SIZE,
+            "the target does not fit in the InplaceDelegate. Use a bigger STORAGE_SIZE");
+        static_assert(std::alignment_of<Target_t>::value <=
+                      std::alignment_of<typename std::aligned_storage<STORAGE_SIZE>::type>::value,
+            "the target is over-aligned for the InplaceDelegate");
+
+        new (&m_storage) Target_t(std::forward<CALLABLE_T>(a_callable));
+        m_invoke = &Invoke<Target_t>;
+        // most targets (pointers, lambdas capturing by reference) are copied
+        // with a memcpy
+        m_manage = (std::is_trivially_copyable<Target_t>::value &&
+                    std::is_trivially_destructible<Target_t>::value) ? 0 : &Manage<Target_t>;
+    }
+
+    void CopyFrom(const InplaceDelegate &a_source)
+    {
+        if (a_source.m_manage != 0)
+        {
+            a_source.m_manage(&m_storage, &a_source.m_storage);
+        }
+        else
+        {
+            memcpy(&m_storage, &a_source.m_storage, STORAGE_SIZE);
+        }
+        m_invoke = a_source.m_invoke;
+        m_manage = a_source.m_manage;
+    }
+};
+
+///////////////////////////////////////
+// Global functions to create delegates
+
+// create a delegate to a non-const method
+template <class X, class Y, typename RETURN_TYPE, typename... ARGS>
+InplaceDelegate<RETURN_TYPE (ARGS...)> MakeInplaceDelegate(
+    Y* a_object, RETURN_TYPE (X::*a_method)(ARGS...))
+{
+    return InplaceDelegate<RETURN_TYPE (ARGS...)>(a_object, a_method);
+}
+
+// create a delegate to a const method
+template <class X, class Y, typename RETURN_TYPE, typename... ARGS>
+InplaceDelegate<RETURN_TYPE (ARGS...)> MakeInplaceDelegate(
+    const Y* a_object, RETURN_TYPE (X::*a_method)(ARGS...) const)
+{
+    return InplaceDelegate<RETURN_TYPE (ARGS...)>(a_object, a_method);
+}
+
+// create a delegate to a static function (without object)
+template <typename RETURN_TYPE, typename... ARGS>
+InplaceDelegate<RETURN_TYPE (ARGS...)> MakeInplaceDelegate(RETURN_TYPE (*a_function)(ARGS...))
+{
+    return InplaceDelegate<RETURN_TYPE (ARGS...)>(a_function);
+}
+
+#endif /* INPLACEDELEGATE_H_ */
@@ -0,0 +1,278 @@
+/// @file    MulticastDelegate.h
+/// @brief   This file contains the definition of the MulticastDelegate class
+///
+/// A MulticastDelegate calls every Delegate subscribed to it. Dispatching an
+/// event takes no locks: the subscribers are kept in an immutable snapshot
+/// which is replaced (read-copy-update) every time a delegate subscribes or
+/// unsubscribes. Dispatch costs two atomic increments plus the calls, no
+/// matter how often the subscribers change.
+///
+/// Old snapshots are deleted once no dispatch can be reading them. Readers
+/// announce themselves in one of two counters; new readers use the counter
+/// chosen by m_epoch, which is switched only once the other one is seen
+/// empty, so the counter which is not in use always drains. A snapshot is
+/// safe to delete when both counters have been seen empty since it was
+/// replaced. That is checked by Subscribe and Unsubscribe, which never wait
+/// for dispatches to finish, so a delegate can unsubscribe itself while it
+/// is being called. The last few replaced snapshots are deleted by the
+/// destructor.
+///
+/// Example of use
+///
+/// MulticastDelegate<void(UInt16, std::string)> onMessage;
+/// onMessage.Subscribe(MakeDelegate(&obj, &A::f));
+/// onMessage.Subscribe(MakeDelegate(&freeFunction));
+/// // calls A::f on obj and freeFunction
+/// onMessage(0, std::string("Hello world"));
+/// onMessage.Unsubscribe(MakeDelegate(&obj, &A::f));
+
+
+#ifndef MULTICASTDELEGATE_H_
+#define MULTICASTDELEGATE_H_
+
+#include <stdint.h>
+#include <stdlib.h>    // posix_memalign, free
+#include <cstddef>     // std::size_t
+#include <atomic>
+#include <new>         // std::bad_alloc
+#include <mutex>
+#include <vector>
+#include "Delegate.h"
+
+// reader counters are aligned to this size so they don't share a cache line,
+// with each other or with the rest of the members
+#define MULTICAST_DELEGATE_CACHE_LINE_SIZE 64
+
+template <typename SIGNATURE_T>
+class MulticastDelegate;
+
+/// @brief calls every Delegate<void(ARGS...)> subscribed to it
+template <typename... ARGS>
+class MulticastDelegate<void (ARGS...)>
+{
+public:
+    typedef Delegate<void (ARGS...)> Delegate_t;
+
+    MulticastDelegate():
+        m_snapshot(new Snapshot),
+        m_epoch(0),
+        m_writeMutex(),
+        m_retired(0)
+    {
+        m_readers[0].count.store(0, std::memory_order_relaxed);
+        m_readers[1].count.store(0, std::memory_order_relaxed);
+    }
+
+    /// @brief nothing can be dispatching events when it is destroyed
+    ~MulticastDelegate()
+    {
+        delete m_snapshot.load(std::memory_order_relaxed);
+        while (m_retired != 0)
+        {
+            Snapshot* next = m_retired->next;
+            delete m_retired;
+            m_retired = next;
+        }
+    }
+
+    // operator new doesn't honour the alignment of the reader counters
+    // before C++17, so it is done here
+    static void* operator new(std::size_t a_size)
+    {
+        void* memory = 0;
+        if (posix_memalign(&memory, MULTICAST_DELEGATE_CACHE_LINE_SIZE, a_size) != 0)
+        {
+            throw std::bad_alloc();
+        }
+        return memory;
+    }
+
+    static void operator delete(void* a_memory)
+    {
+        free(a_memory);
+    }
+
+    /// @brief adds a_delegate to the subscribers. A delegate subscribed
+    /// twice is called twice
+    void Subscribe(const Delegate_t &a_delegate)
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+
+        Snapshot* snapshot = new Snapshot(*m_snapshot.load(std::memory_order_relaxed));
+        snapshot->subscribers.push_back(a_delegate);
+        Publish(snapshot);
+    }
+
+    /// @brief removes a_delegate from the subscribers. Dispatches which are
+    /// already running may still call it
+    /// @return false if a_delegate was not subscribed
+    bool Unsubscribe(const Delegate_t &a_delegate)
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+
+        const Snapshot* current = m_snapshot.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < current->subscribers.size(); i++)
+        {
+            if (current->subscribers[i] == a_delegate)
+            {
+                Snapshot* snapshot = new Snapshot(*current);
+                snapshot->subscribers.erase(snapshot->subscribers.begin() + i);
+                Publish(snapshot);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /// @brief removes every subscriber
+    void Clear()
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        Publish(new Snapshot);
+    }
+
+    /// @return number of subscribers
+    std::size_t Size() const
+    {
+        ReadGuard guard(*this);
+        return guard.Subscribers().size();
+    }
+
+    /// @brief calls every subscriber, in the order they subscribed
+    void operator()(ARGS... a_args) const
+    {
+        ReadGuard guard(*this);
+        const std::vector<Delegate_t> &subscribers = guard.Subscribers();
+        for (std::size_t i = 0; i < subscribers.size(); i++)
+        {
+            subscribers[i](a_args...);
+        }
+    }
+
+    /// @return number of replaced snapshots which are not deleted yet
+    std::size_t RetiredSnapshots() const
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+
+        std::size_t count = 0;
+        for (const Snapshot* retired = m_retired; retired != 0; retired = retired->next)
+        {
+            count++;
+        }
+        return count;
+    }
+
+private:
+    /// @brief an immutable list of subscribers. next and quiescent are only
+    /// used once it is replaced, under m_writeMutex
+    struct Snapshot
+    {
+        Snapshot():
+            subscribers(),
+            next(0)
+        {
+            quiescent[0] = quiescent[1] = false;
+        }
+
+        Snapshot(const Snapshot &a_source):
+            subscribers(a_source.subscribers),
+            next(0)
+        {
+            quiescent[0] = quiescent[1] = false;
+        }
+
+        std::vector<Delegate_t> subscribers;
+        Snapshot* next;
+        // the reader counter has been seen empty since it was replaced
+        bool quiescent[2];
+    };
+
+    struct alignas(MULTICAST_DELEGATE_CACHE_LINE_SIZE) ReaderCount
+    {
+        std::atomic<uint32_t> count;
+    };
+
+    /// @brief a dispatch in progress. The snapshot it reads is not deleted
+    /// until it is destroyed
+    class ReadGuard
+    {
+    public:
+        explicit ReadGuard(const MulticastDelegate &a_parent):
+            m_count(a_parent.m_readers[a_parent.m_epoch.load(std::memory_order_relaxed) & 1].count)
+        {
+            // seq_cst. A writer which doesn't see this increment replaced
+            // its snapshot before it, so the load below gets a newer one
+            m_count.fetch_add(1);
+            m_snapshot = a_parent.m_snapshot.load();
+        }
+
+        ~ReadGuard()
+        {
+            m_count.fetch_sub(1, std::memory_order_release);
+        }
+
+        inline const std::vector<Delegate_t>& Subscribers() const
+        {
+            return m_snapshot->subscribers;
+        }
+
+    private:
+        std::atomic<uint32_t> &m_count;
+        const Snapshot* m_snapshot;
+
+        // prevent copying
+        ReadGuard(const ReadGuard&);
+        ReadGuard& operator=(const ReadGuard&);
+    };
+
+    std::atomic<Snapshot*> m_snapshot;
+    mutable ReaderCount m_readers[2];
+    std::atomic<uint32_t> m_epoch;
+
+    // protects everything below and serialises writers
+    mutable std::mutex m_writeMutex;
+    Snapshot* m_retired;
+
+    /// @brief replaces the current snapshot with a_snapshot, and deletes the
+    /// old snapshots no dispatch can be reading. Called under m_writeMutex
+    void Publish(Snapshot* a_snapshot)
+    {
+        Snapshot* old = m_snapshot.exchange(a_snapshot);
+        old->next = m_retired;
+        m_retired = old;
+
+        uint32_t current = m_epoch.load(std::memory_order_relaxed) & 1;
+        bool drained[2];
+        drained[current] = (m_readers[current].count.load() == 0);
+        drained[current ^ 1] = (m_readers[current ^ 1].count.load() == 0);
+        if (drained[current ^ 1])
+        {
+            // new readers move to the other counter so this one can drain
+            m_epoch.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        Snapshot** link = &m_retired;
+        while (*link != 0)
+        {
+            Snapshot* retired = *link;
+            retired->quiescent[0] = retired->quiescent[0] || drained[0];
+            retired->quiescent[1] = retired->quiescent[1] || drained[1];
+            if (retired->quiescent[0] && retired->quiescent[1])
+            {
+                *link = retired->next;
+                delete retired;
+            }
+            else
+            {
+                link = &retired->next;
+            }
+        }
+    }
+
+    // prevent copying
+    MulticastDelegate(const MulticastDelegate&);
+    MulticastDelegate& operator=(const MulticastDelegate&);
+};
+
+#endif /* MULTICASTDELEGATE_H_ */
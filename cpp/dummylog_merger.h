@@ -0,0 +1,788 @@
+// ============================================================================
+// Copyright (c) 2026 Faustino Frechilla
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+/// @file dummylog_merger.h
+/// @brief Merges timestamped logs into one, in chronological order
+///
+/// A native replacement for scripts/log_merger.py. Every input is mapped in
+/// memory and read in place: lines are found with memchr, timestamps are
+/// parsed by hand and the inputs are merged through a binary heap (k-way
+/// merge). Output lines are copied as they are into a big buffer which is
+/// written out with write(2).
+///
+/// Text inputs can use any of these timestamps at the start of each line
+/// (the format is detected on the first line which has one):
+///   [01/Jun/2012 12:29:17.953] ...   (the default of log_merger.py)
+///   2012-06-01 12:29:17.953 ...      ('T' instead of the space is fine too)
+///   1338553757.953000000 ...         (seconds, as dummylog_decoder writes)
+/// A line without a timestamp (a stack trace, for instance) stays attached to
+/// the line before it.
+///
+/// Binary logs written by DummyLogger (DUMMYLOG_BINARY) are merged directly
+/// and written out as text, exactly as dummylog_decoder does. Their
+/// timestamps come from CLOCK_MONOTONIC, so they can only be merged with
+/// logs of the same machine which use the same clock. Entries of a binary log
+/// written in asynchronous mode are not in chronological order (each thread
+/// has its own ring), so the entries of every binary log are sorted by
+/// timestamp before merging.
+///
+/// Every text input is expected to be in chronological order already.
+/// Entries with the same timestamp keep the order of the inputs
+///
+/// @author Faustino Frechilla
+/// @history
+/// Ref       Who                When         What
+///           Faustino Frechilla 17-Oct-2026  Original development
+///           Faustino Frechilla 17-Oct-2026  Binary logs sorted before merging
+///           Faustino Frechilla 17-Oct-2026  Binary entries decoded into a reused buffer
+/// @endhistory
+///
+// ============================================================================
+
+#ifndef _DUMMYLOGMERGER_H_
+#define _DUMMYLOGMERGER_H_
+
+#include <stdint.h>     // types (uint64_t...)
+#include <string.h>     // memchr, memcpy
+#include <errno.h>      // EINTR
+#include <fcntl.h>      // open
+#include <unistd.h>     // write, close
+#include <sys/mman.h>   // mmap, munmap, madvise
+#include <sys/stat.h>   // fstat
+#include <algorithm>    // std::stable_sort
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "dummylogger_binary.h"
+
+// size of the output buffer
+#define DUMMYLOG_MERGER_OUTPUT_BUFFER (1024 * 1024) // (1MB)
+
+/// @brief parses the timestamps at the start of the lines of a text log
+/// Timestamps are turned into nanoseconds since the epoch (UTC), except for
+/// TIMESTAMP_SECONDS which are taken as they come
+class DummyLogTimestamp
+{
+public:
+    enum Format_t
+    {
+        TIMESTAMP_UNKNOWN,
+        TIMESTAMP_BRACKETS, // [01/Jun/2012 12:29:17.953]
+        TIMESTAMP_ISO,      // 2012-06-01 12:29:17.953
+        TIMESTAMP_SECONDS   // 1338553757.953000000
+    };
+
+    /// @brief finds out the format of the timestamp at a_line
+    /// @return TIMESTAMP_UNKNOWN if there isn't any
+    static Format_t Detect(const char* a_line, const char* a_end)
+    {
+        uint64_t nsecs;
+        if (ParseBrackets(a_line, a_end, nsecs))
+        {
+            return TIMESTAMP_BRACKETS;
+        }
+        if (ParseIso(a_line, a_end, nsecs))
+        {
+            return TIMESTAMP_ISO;
+        }
+        if (ParseSeconds(a_line, a_end, nsecs))
+        {
+            return TIMESTAMP_SECONDS;
+        }
+        return TIMESTAMP_UNKNOWN;
+    }
+
+    /// @brief parses the timestamp at the start of a_line
+    /// @return false if there isn't any in a_format
+    static inline bool Parse(
+        Format_t a_format, const char* a_line, const char* a_end, uint64_t &out_nsecs)
+    {
+        switch (a_format)
+        {
+        case TIMESTAMP_BRACKETS:
+            return ParseBrackets(a_line, a_end, out_nsecs);
+        case TIMESTAMP_ISO:
+            return ParseIso(a_line, a_end, out_nsecs);
+        case TIMESTAMP_SECONDS:
+            return ParseSeconds(a_line, a_end, out_nsecs);
+        default:
+            return false;
+        }
+    }
+
+    /// @brief [DD/Mon/YYYY HH:MM:SS(.fraction)]
+    static inline bool ParseBrackets(const char* a_line, const char* a_end, uint64_t &out_nsecs)
+    {
+        // the shortest one: "[01/Jun/2012 12:29:17]"
+        if (((a_end - a_line) < 22) || (a_line[0] != '[') ||
+            (a_line[3] != '/') || (a_line[7] != '/') || (a_line[12] != ' '))
+        {
+            return false;
+        }
+
+        uint32_t day, year;
+        int month = Month(a_line + 4);
+        if (!Digits(a_line + 1, 2, day) || (month < 0) || !Digits(a_line + 8, 4, year))
+        {
+            return false;
+        }
+
+        const char* cursor = a_line + 13;
+        if (!Time(cursor, a_end, Days(year, month + 1, day), out_nsecs))
+        {
+            return false;
+        }
+        return (cursor < a_end) && (*cursor == ']');
+    }
+
+    /// @brief YYYY-MM-DD HH:MM:SS(.fraction), 'T' instead of ' ' and an
+    ///        opening '[' are fine too
+    static inline bool ParseIso(const char* a_line, const char* a_end, uint64_t &out_nsecs)
+    {
+        if ((a_line < a_end) && (*a_line == '['))
+        {
+            a_line++;
+        }
+
+        // "2012-06-01 12:29:17"
+        if (((a_end - a_line) < 19) || (a_line[4] != '-') || (a_line[7] != '-') ||
+            ((a_line[10] != ' ') && (a_line[10] != 'T')))
+        {
+            return false;
+        }
+
+        uint32_t year, month, day;
+        if (!Digits(a_line, 4, year) || !Digits(a_line + 5, 2, month) ||
+            !Digits(a_line + 8, 2, day) || (month < 1) || (month > 12))
+        {
+            return false;
+        }
+
+        const char* cursor = a_line + 11;
+        return Time(cursor, a_end, Days(year, month, day), out_nsecs);
+    }
+
+    /// @brief <seconds>.<fraction> followed by a space
+    static inline bool ParseSeconds(const char* a_line, const char* a_end, uint64_t &out_nsecs)
+    {
+        const char* cursor = a_line;
+        uint64_t seconds = 0;
+        while ((cursor < a_end) && (*cursor >= '0') && (*cursor <= '9'))
+        {
+            seconds = (seconds * 10) + (*cursor - '0');
+            cursor++;
+        }
+        if ((cursor == a_line) || (cursor == a_end) || (*cursor != '.'))
+        {
+            return false;
+        }
+
+        cursor++;
+        uint64_t fraction;
+        if (!Fraction(cursor, a_end, fraction) || (cursor == a_end) || (*cursor != ' '))
+        {
+            return false;
+        }
+        out_nsecs = (seconds * 1000000000ULL) + fraction;
+        return true;
+    }
+
+private:
+    /// @brief reads a_count decimal digits
+    static inline bool Digits(const char* a_text, int a_count, uint32_t &out_value)
+    {
+        out_value = 0;
+        for (int i = 0; i < a_count; i++)
+        {
+            uint32_t digit = static_cast<uint32_t>(a_text[i] - '0');
+            if (digit > 9)
+            {
+                return false;
+            }
+            out_value = (out_value * 10) + digit;
+        }
+        return true;
+    }
+
+    /// @brief reads up to 9 digits after a decimal point as nanoseconds.
+    ///        Digits after those are skipped
+    static inline bool Fraction(const char* &a_cursor, const char* a_end, uint64_t &out_nsecs)
+    {
+        static const uint32_t SCALE[10] = {
+            1000000000, 100000000, 10000000, 1000000, 100000, 10000, 1000, 100, 10, 1};
+
+        uint32_t value = 0;
+        int digits = 0;
+        while ((a_cursor < a_end) && (*a_cursor >= '0') && (*a_cursor <= '9'))
+        {
+            if (digits < 9)
+            {
+                value = (value * 10) + (*a_cursor - '0');
+                digits++;
+            }
+            a_cursor++;
+        }
+        out_nsecs = static_cast<uint64_t>(value) * SCALE[digits];
+        return digits > 0;
+    }
+
+    /// @brief HH:MM:SS(.fraction) of the day a_days (since the epoch)
+    static inline bool Time(
+        const char* &a_cursor, const char* a_end, int64_t a_days, uint64_t &out_nsecs)
+    {
+        uint32_t hours, minutes, seconds;
+        if (((a_end - a_cursor) < 8) || (a_cursor[2] != ':') || (a_cursor[5] != ':') ||
+            !Digits(a_cursor, 2, hours) || !Digits(a_cursor + 3, 2, minutes) ||
+            !Digits(a_cursor + 6, 2, seconds))
+        {
+            return false;
+        }
+        a_cursor += 8;
+
+        uint64_t fraction = 0;
+        if ((a_cursor < a_end) && ((*a_cursor == '.') || (*a_cursor == ',')))
+        {
+            a_cursor++;
+            if (!Fraction(a_cursor, a_end, fraction))
+            {
+                return false;
+            }
+        }
+
+        int64_t secs = (a_days * 86400) + (hours * 3600) + (minutes * 60) + seconds;
+        out_nsecs = (static_cast<uint64_t>(secs) * 1000000000ULL) + fraction;
+        return true;
+    }
+
+    /// @return 0 to 11 for Jan to Dec, -1 if it isn't a month
+    static inline int Month(const char* a_text)
+    {
+        // the 3 letters in one integer, ignoring the case of the letters
+        uint32_t key = ((a_text[0] | 0x20) << 16) | ((a_text[1] | 0x20) << 8) | (a_text[2] | 0x20);
+        switch (key)
+        {
+        case ('j' << 16) | ('a' << 8) | 'n': return 0;
+        case ('f' << 16) | ('e' << 8) | 'b': return 1;
+        case ('m' << 16) | ('a' << 8) | 'r': return 2;
+        case ('a' << 16) | ('p' << 8) | 'r': return 3;
+        case ('m' << 16) | ('a' << 8) | 'y': return 4;
+        case ('j' << 16) | ('u' << 8) | 'n': return 5;
+        case ('j' << 16) | ('u' << 8) | 'l': return 6;
+        case ('a' << 16) | ('u' << 8) | 'g': return 7;
+        case ('s' << 16) | ('e' << 8) | 'p': return 8;
+        case ('o' << 16) | ('c' << 8) | 't': return 9;
+        case ('n' << 16) | ('o' << 8) | 'v': return 10;
+        case ('d' << 16) | ('e' << 8) | 'c': return 11;
+        default: return -1;
+        }
+    }
+
+    /// @return days since 1970-01-01 (proleptic gregorian calendar)
+    static inline int64_t Days(int64_t a_year, uint32_t a_month, uint32_t a_day)
+    {
+        a_year -= (a_month <= 2) ? 1 : 0;
+        int64_t era = (a_year >= 0 ? a_year : a_year - 399) / 400;
+        int64_t yearOfEra = a_year - (era * 400);
+        int64_t dayOfYear = ((153 * (a_month + (a_month > 2 ? -3 : 9)) + 2) / 5) + a_day - 1;
+        int64_t dayOfEra = (yearOfEra * 365) + (yearOfEra / 4) - (yearOfEra / 100) + dayOfYear;
+        return (era * 146097) + dayOfEra - 719468;
+    }
+};
+
+/// @brief buffers the merged output and writes it out with write(2)
+class DummyLogMergerOutput
+{
+public:
+    explicit DummyLogMergerOutput(int a_fd):
+        m_fd(a_fd),
+        m_buffer(DUMMYLOG_MERGER_OUTPUT_BUFFER),
+        m_used(0),
+        m_failed(false)
+    {}
+
+    ~DummyLogMergerOutput()
+    {
+        Flush();
+    }
+
+    inline void Append(const char* a_data, std::size_t a_size)
+    {
+        if ((m_used + a_size) > m_buffer.size())
+        {
+            Flush();
+            if (a_size > m_buffer.size())
+            {
+                // not worth copying
+                WriteAll(a_data, a_size);
+                return;
+            }
+        }
+        memcpy(&m_buffer[m_used], a_data, a_size);
+        m_used += a_size;
+    }
+
+    void Flush()
+    {
+        WriteAll(&m_buffer[0], m_used);
+        m_used = 0;
+    }
+
+    /// @return true if a write failed
+    inline bool Failed() const
+    {
+        return m_failed;
+    }
+
+private:
+    int m_fd;
+    std::vector<char> m_buffer;
+    std::size_t m_used;
+    bool m_failed;
+
+    void WriteAll(const char* a_data, std::size_t a_size)
+    {
+        while ((a_size > 0) && !m_failed)
+        {
+            ssize_t written = write(m_fd, a_data, a_size);
+            if ((written < 0) && (errno == EINTR))
+            {
+                // interrupted by a signal before anything was written
+                continue;
+            }
+            if (written <= 0)
+            {
+                m_failed = true;
+                break;
+            }
+            a_data += written;
+            a_size -= written;
+        }
+    }
+
+    // prevent copying
+    DummyLogMergerOutput(const DummyLogMergerOutput&);
+    DummyLogMergerOutput& operator=(const DummyLogMergerOutput&);
+};
+
+/// @brief merges several logs into one. Example:
+/// DummyLogMerger merger;
+/// merger.AddFile("a.log");
+/// merger.AddFile("b.bin");
+/// DummyLogMergerOutput output(1); // standard output
+/// merger.Merge(output);
+class DummyLogMerger
+{
+public:
+    DummyLogMerger():
+        m_inputs()
+    {}
+
+    ~DummyLogMerger()
+    {
+        for (std::size_t i = 0; i < m_inputs.size(); i++)
+        {
+            if (m_inputs[i]->size > 0)
+            {
+                munmap(const_cast<char*>(m_inputs[i]->data), m_inputs[i]->size);
+            }
+            delete m_inputs[i];
+        }
+    }
+
+    /// @brief maps a log file in memory. Binary logs are told apart by
+    ///        their magic
+    /// @return false if it couldn't be opened or mapped
+    bool AddFile(const std::string &a_path)
+    {
+        int fd = open(a_path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        struct stat info;
+        if (fstat(fd, &info) != 0)
+        {
+            close(fd);
+            return false;
+        }
+
+        const char* data = 0;
+        std::size_t size = static_cast<std::size_t>(info.st_size);
+        if (size > 0)
+        {
+            void* mapped = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED)
+            {
+                close(fd);
+                return false;
+            }
+            // read once, front to back: aggressive read ahead
+            madvise(mapped, size, MADV_SEQUENTIAL);
+            data = static_cast<const char*>(mapped);
+        }
+        close(fd);
+
+        Input* input = new Input(data, size, m_inputs.size());
+        input->binary = input->decoder.LoadFormats(data, size);
+        if (input->binary)
+        {
+            IndexBinary(*input);
+        }
+        m_inputs.push_back(input);
+        return true;
+    }
+
+    /// @brief merges every input into a_output
+    /// @return number of entries (lines plus the lines attached to them, or
+    ///         binary log entries) written
+    uint64_t Merge(DummyLogMergerOutput &a_output)
+    {
+        std::vector<Input*> heap;
+        for (std::size_t i = 0; i < m_inputs.size(); i++)
+        {
+            if (Advance(*m_inputs[i]))
+            {
+                heap.push_back(m_inputs[i]);
+                SiftUp(heap, heap.size() - 1);
+            }
+        }
+
+        uint64_t entries = 0;
+        DecodedEntry decoded;
+        while (!heap.empty())
+        {
+            Input &top = *heap[0];
+            if (top.binary)
+            {
+                decoded.Clear();
+                top.decoder.DecodeLog(top.entry, top.entryEnd - top.entry, decoded);
+                a_output.Append(decoded.Data(), decoded.Size());
+            }
+            else
+            {
+                a_output.Append(top.entry, top.entryEnd - top.entry);
+                if (*(top.entryEnd - 1) != '\n')
+                {
+                    // the last line of a file which doesn't end with one
+                    a_output.Append("\n", 1);
+                }
+            }
+            entries++;
+
+            if (!Advance(top))
+            {
+                heap[0] = heap.back();
+                heap.pop_back();
+            }
+            // most of the time the same input is still the oldest one
+            SiftDown(heap, 0);
+        }
+
+        a_output.Flush();
+        return entries;
+    }
+
+private:
+    /// @brief the stream binary entries are decoded into. Its buffer is
+    /// reused from one entry to the next, so decoding doesn't allocate once
+    /// it is big enough for the longest entry
+    class DecodedEntry : public std::ostream
+    {
+    public:
+        DecodedEntry():
+            std::ostream(0),
+            m_buffer()
+        {
+            rdbuf(&m_buffer);
+        }
+
+        inline const char* Data() const
+        {
+            return m_buffer.data.data();
+        }
+
+        inline std::size_t Size() const
+        {
+            return m_buffer.data.size();
+        }
+
+        /// @brief forgets the previous entry (its memory is kept)
+        inline void Clear()
+        {
+            m_buffer.data.clear();
+        }
+
+    private:
+        /// @brief appends whatever is written to a vector
+        struct Buffer : public std::streambuf
+        {
+            std::vector<char> data;
+
+            virtual int_type overflow(int_type a_char)
+            {
+                if (!traits_type::eq_int_type(a_char, traits_type::eof()))
+                {
+                    data.push_back(traits_type::to_char_type(a_char));
+                }
+                return traits_type::not_eof(a_char);
+            }
+
+            virtual std::streamsize xsputn(const char* a_data, std::streamsize a_size)
+            {
+                data.insert(data.end(), a_data, a_data + a_size);
+                return a_size;
+            }
+        };
+
+        Buffer m_buffer;
+    };
+
+    /// @brief a log entry of a binary log
+    struct BinaryEntry
+    {
+        uint64_t timestamp;
+        const char* payload;
+        uint16_t payloadSize;
+
+        inline bool operator<(const BinaryEntry &a_other) const
+        {
+            return timestamp < a_other.timestamp;
+        }
+    };
+
+    /// @brief a log being merged and its current entry
+    struct Input
+    {
+        Input(const char* a_data, std::size_t a_size, std::size_t a_index):
+            data(a_data), size(a_size), index(a_index), binary(false),
+            format(DummyLogTimestamp::TIMESTAMP_UNKNOWN), cursor(a_data),
+            entry(0), entryEnd(0), timestamp(0), nextTimestamp(0), decoder(),
+            binaryEntries(), nextBinaryEntry(0)
+        {}
+
+        const char* data;
+        std::size_t size;
+        std::size_t index;
+        bool binary;
+        DummyLogTimestamp::Format_t format;
+
+        /// @brief where the entry after the current one starts (text logs)
+        const char* cursor;
+
+        /// @brief the current entry (payload of a binary entry)
+        const char* entry;
+        const char* entryEnd;
+        uint64_t timestamp;
+
+        /// @brief timestamp of the line at cursor (text logs), which was
+        ///        parsed while looking for the end of the current entry
+        uint64_t nextTimestamp;
+
+        DummyLogBinaryDecoder decoder;
+
+        /// @brief log entries of a binary log, in chronological order
+        std::vector<BinaryEntry> binaryEntries;
+        std::size_t nextBinaryEntry;
+    };
+
+    std::vector<Input*> m_inputs;
+
+    /// @return true if a goes before b
+    static inline bool Before(const Input* a_a, const Input* a_b)
+    {
+        return (a_a->timestamp < a_b->timestamp) ||
+               ((a_a->timestamp == a_b->timestamp) && (a_a->index < a_b->index));
+    }
+
+    static void SiftUp(std::vector<Input*> &a_heap, std::size_t a_pos)
+    {
+        while (a_pos > 0)
+        {
+            std::size_t parent = (a_pos - 1) / 2;
+            if (!Before(a_heap[a_pos], a_heap[parent]))
+            {
+                break;
+            }
+            std::swap(a_heap[a_pos], a_heap[parent]);
+            a_pos = parent;
+        }
+    }
+
+    static void SiftDown(std::vector<Input*> &a_heap, std::size_t a_pos)
+    {
+        std::size_t size = a_heap.size();
+        while (true)
+        {
+            std::size_t first = a_pos;
+            std::size_t left = (2 * a_pos) + 1;
+            std::size_t right = left + 1;
+            if ((left < size) && Before(a_heap[left], a_heap[first]))
+            {
+                first = left;
+            }
+            if ((right < size) && Before(a_heap[right], a_heap[first]))
+            {
+                first = right;
+            }
+            if (first == a_pos)
+            {
+                break;
+            }
+            std::swap(a_heap[a_pos], a_heap[first]);
+            a_pos = first;
+        }
+    }
+
+    /// @brief moves a_input on to its next entry
+    /// @return false if there are no more
+    static inline bool Advance(Input &a_input)
+    {
+        return a_input.binary ? AdvanceBinary(a_input) : AdvanceText(a_input);
+    }
+
+    static inline bool AdvanceBinary(Input &a_input)
+    {
+        if (a_input.nextBinaryEntry >= a_input.binaryEntries.size())
+        {
+            return false;
+        }
+
+        const BinaryEntry &entry = a_input.binaryEntries[a_input.nextBinaryEntry++];
+        a_input.entry = entry.payload;
+        a_input.entryEnd = entry.payload + entry.payloadSize;
+        a_input.timestamp = entry.timestamp;
+        return true;
+    }
+
+    /// @brief finds the log entries of a binary log and sorts them by
+    ///        timestamp. Entries with the same one keep the order of the file
+    static void IndexBinary(Input &a_input)
+    {
+        const char* cursor = a_input.data + DUMMYLOG_BINARY_MAGIC_SIZE;
+        const char* end = a_input.data + a_input.size;
+        bool sorted = true;
+        while ((cursor + DUMMYLOG_BINARY_ENTRY_HEADER_SIZE) <= end)
+        {
+            uint8_t kind = static_cast<uint8_t>(cursor[0]);
+            uint16_t payloadSize;
+            memcpy(&payloadSize, cursor + 1, 2);
+            const char* payload = cursor + DUMMYLOG_BINARY_ENTRY_HEADER_SIZE;
+            if ((payload + payloadSize) > end)
+            {
+                // truncated
+                break;
+            }
+            cursor = payload + payloadSize;
+
+            if (kind != DUMMYLOG_ENTRY_LOG)
+            {
+                continue;
+            }
+            if (payloadSize < DUMMYLOG_BINARY_LOG_HEADER_SIZE)
+            {
+                a_input.decoder.SkipMalformed("log", payloadSize);
+            }
+            else
+            {
+                BinaryEntry entry;
+                entry.timestamp = DummyLogBinaryDecoder::LogTimestamp(payload);
+                entry.payload = payload;
+                entry.payloadSize = payloadSize;
+                sorted = sorted && (a_input.binaryEntries.empty() ||
+                                    !(entry < a_input.binaryEntries.back()));
+                a_input.binaryEntries.push_back(entry);
+            }
+        }
+
+        if (!sorted)
+        {
+            std::stable_sort(a_input.binaryEntries.begin(), a_input.binaryEntries.end());
+        }
+    }
+
+    static bool AdvanceText(Input &a_input)
+    {
+        const char* end = a_input.data + a_input.size;
+        if (a_input.cursor >= end)
+        {
+            return false;
+        }
+
+        a_input.entry = a_input.cursor;
+        if (a_input.entry == a_input.data)
+        {
+            // the first line: lines before the first timestamp go first
+            a_input.timestamp = 0;
+            if (a_input.format == DummyLogTimestamp::TIMESTAMP_UNKNOWN)
+            {
+                DetectFormat(a_input);
+            }
+            DummyLogTimestamp::Parse(a_input.format, a_input.entry, end, a_input.timestamp);
+        }
+        else
+        {
+            a_input.timestamp = a_input.nextTimestamp;
+        }
+
+        // the entry goes on until the next line with a timestamp
+        const char* cursor = a_input.entry;
+        while (true)
+        {
+            const char* newLine = static_cast<const char*>(memchr(cursor, '\n', end - cursor));
+            if (newLine == 0)
+            {
+                a_input.cursor = a_input.entryEnd = end;
+                break;
+            }
+
+            cursor = newLine + 1;
+            if ((cursor < end) &&
+                DummyLogTimestamp::Parse(a_input.format, cursor, end, a_input.nextTimestamp))
+            {
+                a_input.cursor = a_input.entryEnd = cursor;
+                break;
+            }
+        }
+        return true;
+    }
+
+    /// @brief the format of the first timestamp found in the log
+    static void DetectFormat(Input &a_input)
+    {
+        const char* end = a_input.data + a_input.size;
+        const char* line = a_input.data;
+        while ((line < end) && (a_input.format == DummyLogTimestamp::TIMESTAMP_UNKNOWN))
+        {
+            a_input.format = DummyLogTimestamp::Detect(line, end);
+
+            const char* newLine = static_cast<const char*>(memchr(line, '\n', end - line));
+            line = (newLine == 0) ? end : (newLine + 1);
+        }
+    }
+
+    // prevent copying
+    DummyLogMerger(const DummyLogMerger&);
+    DummyLogMerger& operator=(const DummyLogMerger&);
+};
+
+#endif /* _DUMMYLOGMERGER_H_ */
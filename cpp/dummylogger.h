@@ -1,92 +1,820 @@
-// ============================================================================
-// Copyright (c) 2017 Faustino Frechilla
-//
-// Permission is hereby granted, free of charge, to any person obtaining a copy
-// of this software and associated documentation files (the "Software"), to deal
-// in the Software without restriction, including without limitation the rights
-// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
-// copies of the Software, and to permit persons to whom the Software is
-// furnished to do so, subject to the following conditions:
-//
-// The above copyright notice and this permission notice shall be included in
-// all copies or substantial portions of the Software.
-//
-// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
-// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
-// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
-// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
-// THE SOFTWARE.
-//
-/// @file dummylogger.h
-/// @brief A simple log based on C++ streams
-///
-/// @author Faustino Frechilla
-/// @history
-/// Ref       Who                When         What
-///           Faustino Frechilla 01-Apr-2017  Original development
-/// @endhistory
-///
-// ============================================================================
-
-#pragma once
-
-#include <iostream>
-#include "singleton.h"
-
-
-/// @brief 
-/// This is a singleton class to log messages using C++ streams
-///
-/// Example of usage:
-/// DummyLogger::instance() << "This is a log message" << std::endl;
-class DummyLogger : public Singleton<DummyLogger>
-{
-public:
-    /// @brief getStream returns a reference to the stream being used by this 
-    ///        logger instance
-    /// @return
-    inline std::ostream& getStream() const
-    {
-        return _stream;
-    }
-
-    /// @brief operator<< operator used to forward log messages into the output stream
-    /// @param pf
-    /// @return
-    DummyLogger& operator<<(std::ostream& (*pf)(std::ostream&))
-    {
-        pf(_stream);
-        return *this;
-    }
-
-private:
-    /// @brief the strem where log messages will be forwarded
-    std::ostream& _stream;
-
-    DummyLogger(): _stream(std::cout)
-    {}
-    ~DummyLogger()
-    {}
-
-    // usage of "friend" is discouraged, but it is the only way to design a templatized singleton
-    friend class Singleton<DummyLogger>;
-    
-    // template method needed to be able to log strings ending with std::endl
-    template <typename T>
-    friend DummyLogger& operator<<(DummyLogger& log, T const& val);
-   
-private:
-    // prevent copying of this singleton
-    DummyLogger(const DummyLogger& src);
-    DummyLogger& operator =(const DummyLogger& src);
-
-}; // class DummyLogger
-
-template <typename T>
-DummyLogger& operator<<(DummyLogger& log, T const& val)
-{
-    log._stream << val;
-    return log;
-}
+// ============================================================================
+// Copyright (c) 2017 Faustino Frechilla
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+/// @file dummylogger.h
+/// @brief A simple log based on C++ streams
+///
+/// By default log messages are formatted and written by the calling thread.
+/// In asynchronous mode (startAsync) the calling thread only copies the
+/// arguments into a lock-free ring of its own (see dummylogger_ring.h), and
+/// a background thread formats them and writes them in batches, flushing
+/// the stream once per batch rather than once per std::endl.
+///
+/// Lines are never torn, no matter how many threads log at the same time.
+/// Every thread assembles its lines on its own (without locks) and a line is
+/// only written to the stream, in a single call, once it is complete. A line
+/// is complete when std::endl or std::flush is logged, or when the text
+/// logged so far ends in '\n'. What is left of the line of a thread that
+/// finishes is written out when it does (by the background thread in
+/// asynchronous mode), and the next thread starts with the default format.
+///
+/// DUMMYLOG_BINARY writes a binary log (see dummylogger_binary.h) into the
+/// stream set by setBinaryStream, formatting nothing at all. Its output is
+/// turned into text offline by tools/dummylog_decoder
+///
+/// DLOG_SAMPLED, DLOG_FIRST_N, DLOG_EVERY_N and DLOG_RATE_LIMITED bound the
+/// number of lines a single statement can log (see dummylogger_sampling.h).
+/// How many lines each of them suppressed is reported once in a while
+///
+/// Text lines go to std::cout unless a different sink is set (setSink). See
+/// dummylogger_mmap_sink.h for a sink which writes into memory mapped files
+///
+/// DLOG(level) logs with a severity level. Levels under DUMMYLOG_MIN_LEVEL
+/// are compiled out, and levels under the runtime threshold (setLevel) cost
+/// a load and a branch: their arguments are not even evaluated
+///
+/// @author Faustino Frechilla
+/// @history
+/// Ref       Who                When         What
+///           Faustino Frechilla 01-Apr-2017  Original development
+///           Faustino Frechilla 17-Oct-2026  Asynchronous mode
+///           Faustino Frechilla 17-Oct-2026  Binary log
+///           Faustino Frechilla 17-Oct-2026  Tear-free lines
+///           Faustino Frechilla 17-Oct-2026  Log levels
+///           Faustino Frechilla 17-Oct-2026  Sinks
+///           Faustino Frechilla 17-Oct-2026  Sampled and rate limited lines
+///           Faustino Frechilla 17-Oct-2026  Synchronous binary entries serialised
+///           Faustino Frechilla 17-Oct-2026  Suppressed lines reported on flush
+///           Faustino Frechilla 17-Oct-2026  Async strings padded and enums printed as in sync mode
+///           Faustino Frechilla 17-Oct-2026  Lines ending in '\n' and exiting threads
+/// @endhistory
+///
+// ============================================================================
+
+#pragma once
+
+#include <iostream>
+#include <thread>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <sstream>
+#include "singleton.h"
+#include "tsc_clock.h"
+#include "dummylogger_sink.h"
+#include "dummylogger_sampling.h"
+#include "dummylogger_ring.h"
+#include "dummylogger_binary.h"
+
+// time the background thread sleeps for when there is nothing to write
+#define DUMMYLOGGER_IDLE_SLEEP_USEC 1000 // (1ms)
+
+// minimum time between two reports of suppressed lines
+#define DUMMYLOGGER_SUPPRESSED_REPORT_SECS 10
+
+// a suppressed line checks whether a report is due once every this many
+// (plus one) lines suppressed by its call site
+#define DUMMYLOGGER_SUPPRESSED_CHECK_MASK 1023
+
+/// @brief writes a binary log entry. Arguments replace the "{}" in a_format
+/// (a string literal) once decoded. The format string is registered the
+/// first time the call site is run. Example:
+/// DUMMYLOG_BINARY("order {} filled at {}", orderId, price);
+#define DUMMYLOG_BINARY(a_format, ...)                                       \
+    do                                                                       \
+    {                                                                        \
+        static std::atomic<uint32_t> s_dummyLogFormatId(0);                  \
+        DummyLogger::Instance().logBinary(                                   \
+            s_dummyLogFormatId, a_format, __FILE__, __LINE__, ##__VA_ARGS__); \
+    } while (0)
+
+// severity levels of DLOG and DLOG_BINARY
+#define DUMMYLOG_LEVEL_TRACE   0
+#define DUMMYLOG_LEVEL_DEBUG   1
+#define DUMMYLOG_LEVEL_INFO    2
+#define DUMMYLOG_LEVEL_WARNING 3
+#define DUMMYLOG_LEVEL_ERROR   4
+#define DUMMYLOG_LEVEL_OFF     5
+
+// statements under this level are removed at compile time. Define it before
+// including this file, i.e. -DDUMMYLOG_MIN_LEVEL=DUMMYLOG_LEVEL_INFO
+#ifndef DUMMYLOG_MIN_LEVEL
+#define DUMMYLOG_MIN_LEVEL DUMMYLOG_LEVEL_TRACE
+#endif
+
+/// @brief true if a statement of level a_levelValue (a DUMMYLOG_LEVEL_*
+/// value) would be logged. A constant false if it is under DUMMYLOG_MIN_LEVEL
+#define DUMMYLOG_IS_ON(a_levelValue)                                         \
+    (((a_levelValue) >= DUMMYLOG_MIN_LEVEL) &&                               \
+     ((a_levelValue) >= DummyLoggerThreshold<>::s_level.load(std::memory_order_relaxed)))
+
+/// @brief true if DLOG(a_level) would log. Use it to guard work done only
+/// to be logged. Example:
+/// if (DLOG_IS_ON(DEBUG)) { dumpState(); }
+#define DLOG_IS_ON(a_level) DUMMYLOG_IS_ON(DUMMYLOG_LEVEL_##a_level)
+
+/// @brief logs a line with a severity level: TRACE, DEBUG, INFO, WARNING or
+/// ERROR. Nothing after DLOG(level) is evaluated if the level is off.
+/// Example:
+/// DLOG(DEBUG) << "queue size: " << queue.size() << std::endl;
+#define DLOG(a_level)                                                        \
+    !DUMMYLOG_IS_ON(DUMMYLOG_LEVEL_##a_level) ?                              \
+        (void) 0 : DummyLoggerVoidify() & DummyLogger::Instance()
+
+/// @brief DUMMYLOG_BINARY with a severity level. Example:
+/// DLOG_BINARY(INFO, "order {} filled at {}", orderId, price);
+#define DLOG_BINARY(a_level, a_format, ...)                                  \
+    do                                                                       \
+    {                                                                        \
+        if (DUMMYLOG_IS_ON(DUMMYLOG_LEVEL_##a_level))                        \
+        {                                                                    \
+            DUMMYLOG_BINARY(a_format, ##__VA_ARGS__);                        \
+        }                                                                    \
+    } while (0)
+
+/// @brief the DummyLogSite of the call site it is expanded at. Every lambda
+/// is a different type, so every expansion gets its own static
+#define DUMMYLOG_SITE()                                                      \
+    ([]() -> DummyLogSite& {                                                 \
+        static DummyLogSite s_dummyLogSite(__FILE__, __LINE__);              \
+        return s_dummyLogSite; }())
+
+/// @brief DLOG which logs the first a_first lines and one of every a_every
+/// lines after those (a_every can be 0). Nothing after it is evaluated for
+/// the lines which are not logged. Example:
+/// DLOG_SAMPLED(WARNING, 10, 1000) << "bad packet from " << peer << std::endl;
+#define DLOG_SAMPLED(a_level, a_first, a_every)                              \
+    !(DUMMYLOG_IS_ON(DUMMYLOG_LEVEL_##a_level) &&                            \
+      DummyLogger::Instance().sample(DUMMYLOG_SITE(), (a_first), (a_every))) ? \
+        (void) 0 : DummyLoggerVoidify() & DummyLogger::Instance()
+
+/// @brief DLOG which logs only the first a_first lines
+#define DLOG_FIRST_N(a_level, a_first) DLOG_SAMPLED(a_level, a_first, 0)
+
+/// @brief DLOG which logs one of every a_every lines (the first one included)
+#define DLOG_EVERY_N(a_level, a_every) DLOG_SAMPLED(a_level, 0, a_every)
+
+/// @brief DLOG which logs up to a_perSecond lines per second
+#define DLOG_RATE_LIMITED(a_level, a_perSecond)                              \
+    !(DUMMYLOG_IS_ON(DUMMYLOG_LEVEL_##a_level) &&                            \
+      DummyLogger::Instance().rateLimit(DUMMYLOG_SITE(), (a_perSecond))) ?   \
+        (void) 0 : DummyLoggerVoidify() & DummyLogger::Instance()
+
+/// @brief runtime threshold of DLOG. It lives out of DummyLogger, so
+/// checking it doesn't need the logger instance. A template only so the
+/// static member can be defined in this header
+template <int DUMMY_T = 0>
+struct DummyLoggerThreshold
+{
+    static std::atomic<int> s_level;
+};
+
+template <int DUMMY_T>
+std::atomic<int> DummyLoggerThreshold<DUMMY_T>::s_level(DUMMYLOG_MIN_LEVEL);
+
+
+/// @brief 
+/// This is a singleton class to log messages using C++ streams
+///
+/// Example of usage:
+/// DummyLogger::Instance() << "This is a log message" << std::endl;
+///
+/// Asynchronous mode. Switch it on during startup, before other threads log:
+/// DummyLogger::Instance().startAsync(DUMMYLOGGER_FULL_RING_DROP);
+/// DummyLogger::Instance() << "value: " << 42 << std::endl;
+/// /* ... */
+/// DummyLogger::Instance().stopAsync(); // writes whatever is pending
+///
+/// In asynchronous mode strings, numbers, pointers and manipulators are
+/// copied as they are. Other types are formatted into a string by the
+/// calling thread using their operator<<. A line logged in asynchronous mode
+/// is written out once it ends (std::endl), so log with std::endl rather
+/// than '\n'. Call flush() or stopAsync() before the process exits or the
+/// last messages will be lost
+///
+/// Log levels:
+/// DummyLogger::Instance().setLevel(DUMMYLOG_LEVEL_INFO);
+/// DLOG(INFO) << "logged" << std::endl;
+/// DLOG(DEBUG) << "not logged, " << expensive() << " isn't called" << std::endl;
+class DummyLogger : public Singleton<DummyLogger>
+{
+public:
+    /// @brief switches on the asynchronous mode and spawns the background
+    ///        thread. It does nothing if it is already on
+    /// @param a_policy what to do when the ring of a thread is full. Blocking
+    ///        (the default) never loses messages but might stall the caller.
+    ///        See DummyLoggerFullRingPolicy_t
+    void startAsync(DummyLoggerFullRingPolicy_t a_policy = DUMMYLOGGER_FULL_RING_BLOCK)
+    {
+        if (_async.load())
+        {
+            return;
+        }
+
+        _policy = a_policy;
+        _stopConsumer.store(false);
+        _consumer.reset(new std::thread(&DummyLogger::consumerRoutine, this));
+        _async.store(true);
+    }
+
+    /// @brief writes everything pending and goes back to synchronous mode
+    void stopAsync()
+    {
+        if (!_async.load())
+        {
+            return;
+        }
+
+        _async.store(false);
+        flush();
+
+        _stopConsumer.store(true);
+        _consumer->join();
+        _consumer.reset();
+    }
+
+    /// @return true if the logger is in asynchronous mode
+    inline bool isAsync() const
+    {
+        return _async.load(std::memory_order_relaxed);
+    }
+
+    /// @brief blocks until every line completed (by any thread) before
+    /// this call has been written to the stream, and flushes the stream.
+    /// In synchronous mode the line of the calling thread is completed too.
+    /// Lines suppressed so far are reported (see reportSuppressed)
+    void flush()
+    {
+        if (!_consumer)
+        {
+            DummyLoggerLine::Instance().Commit(*_sink);
+            _sink->Flush();
+            // the tail of a storm of suppressed lines isn't left unreported
+            reportSuppressed();
+            return;
+        }
+
+        uint64_t request = _flushRequested.fetch_add(1) + 1;
+        Backoff backoff;
+        while (_flushDone.load() < request)
+        {
+            backoff.Wait();
+        }
+    }
+
+    /// @brief sets where text lines are written to. Call it during startup,
+    /// before startAsync, or while nobody else is logging
+    /// @param a_sink 0 to go back to std::cout. It must outlive its use
+    void setSink(DummyLoggerSink* a_sink)
+    {
+        flush();
+        _sink = (a_sink != 0) ? a_sink : &_streamSink;
+    }
+
+    /// @brief sets the stream binary log entries are written to. Call it
+    /// during startup, before startAsync. Binary log entries are discarded
+    /// until it is called
+    /// @param a_stream it must have been opened in binary mode
+    void setBinaryStream(std::ostream &a_stream)
+    {
+        std::lock_guard<std::mutex> lock(_binaryMutex);
+
+        _binaryStream = &a_stream;
+        _binaryStream->write(DUMMYLOG_BINARY_MAGIC, DUMMYLOG_BINARY_MAGIC_SIZE);
+
+        // formats registered before there was a stream
+        for (std::size_t i = 0; i < _binaryFormats.size(); i++)
+        {
+            _binaryStream->write(_binaryFormats[i].data(), _binaryFormats[i].size());
+        }
+    }
+
+    /// @brief used by DUMMYLOG_BINARY. Writes a binary log entry
+    /// @param a_formatId id of the format string. 0 if not registered yet
+    template <typename... ARGS_T>
+    inline void logBinary(
+        std::atomic<uint32_t> &a_formatId,
+        const char* a_format,
+        const char* a_file,
+        uint32_t a_line,
+        const ARGS_T&... a_args)
+    {
+        uint32_t formatId = a_formatId.load(std::memory_order_acquire);
+        if (formatId == 0)
+        {
+            formatId = registerBinaryFormat(a_formatId, a_format,
+                DummyLogBinaryEncoder::Signature<ARGS_T...>(), a_file, a_line);
+        }
+
+        if (_binaryStream == 0)
+        {
+            return;
+        }
+
+        char entry[DUMMYLOG_BINARY_MAX_ENTRY];
+        std::size_t size = DummyLogBinaryEncoder::EncodeLog(
+            entry, formatId, TscClock::Now(), a_args...);
+        writeBinary(entry, size);
+    }
+
+    /// @return number of records (arguments) dropped so far because the ring
+    ///        of the logging thread was full (DUMMYLOGGER_FULL_RING_DROP)
+    uint64_t droppedRecords() const
+    {
+        return DummyLoggerRing::Aggregate(static_cast<uint64_t>(0),
+            [](uint64_t a_sum, const DummyLoggerRing &a_ring) {
+                return a_sum + a_ring.DroppedRecords(); });
+    }
+
+    /// @brief sets the runtime threshold of DLOG. Statements under a_level
+    ///        are skipped. It can be called at any time from any thread
+    /// @param a_level a DUMMYLOG_LEVEL_* value. Levels under
+    ///        DUMMYLOG_MIN_LEVEL stay compiled out anyway
+    inline void setLevel(int a_level)
+    {
+        DummyLoggerThreshold<>::s_level.store(a_level, std::memory_order_relaxed);
+    }
+
+    /// @return the runtime threshold of DLOG
+    inline int getLevel() const
+    {
+        return DummyLoggerThreshold<>::s_level.load(std::memory_order_relaxed);
+    }
+
+    /// @brief used by DLOG_SAMPLED
+    /// @return true if the line is to be logged
+    inline bool sample(DummyLogSite &a_site, uint64_t a_first, uint64_t a_every)
+    {
+        uint64_t hits;
+        if (a_site.Sample(a_first, a_every, hits))
+        {
+            return true;
+        }
+
+        if (!a_site.IsRegistered() || ((hits & DUMMYLOGGER_SUPPRESSED_CHECK_MASK) == 0))
+        {
+            lineSuppressed(a_site, DummyLogSite::KIND_SAMPLED, a_first, a_every);
+        }
+        return false;
+    }
+
+    /// @brief used by DLOG_RATE_LIMITED
+    /// @return true if the line is to be logged
+    inline bool rateLimit(DummyLogSite &a_site, uint32_t a_perSecond)
+    {
+        uint64_t hits;
+        if (a_site.RateLimit(a_perSecond, hits))
+        {
+            return true;
+        }
+
+        if (!a_site.IsRegistered() || ((hits & DUMMYLOGGER_SUPPRESSED_CHECK_MASK) == 0))
+        {
+            lineSuppressed(a_site, DummyLogSite::KIND_RATE_LIMITED, a_perSecond, 0);
+        }
+        return false;
+    }
+
+    /// @brief writes one line per sampled or rate limited call site which
+    /// suppressed lines since the last report, saying how many. It is called
+    /// by flush (and so by stopAsync) and every
+    /// DUMMYLOGGER_SUPPRESSED_REPORT_SECS (at most) by the background thread
+    /// or, in synchronous mode, by the next line completed by any thread.
+    /// Flush before the process exits to report the last ones
+    void reportSuppressed()
+    {
+        std::lock_guard<std::mutex> lock(_reportMutex);
+
+        bool reported = false;
+        for (DummyLogSite* site = DummyLogSite::Head(); site != 0; site = site->Next())
+        {
+            // it might go back for a moment while a new second starts
+            uint64_t suppressed = site->Suppressed();
+            if (suppressed <= site->Reported())
+            {
+                continue;
+            }
+
+            std::ostringstream line;
+            line << site->File() << ":" << site->Line() << ": "
+                 << (suppressed - site->Reported()) << " lines suppressed\n";
+            _sink->Write(line.str().data(), line.str().size());
+            site->Reported() = suppressed;
+            reported = true;
+        }
+
+        if (reported)
+        {
+            _sink->Flush();
+        }
+    }
+
+    /// @brief getStream returns a reference to the stream being used by this 
+    ///        logger instance when no other sink is set
+    /// @return
+    inline std::ostream& getStream() const
+    {
+        return _stream;
+    }
+
+    /// @brief operator<< operator used to forward log messages into the output stream
+    /// @param pf
+    /// @return
+    DummyLogger& operator<<(std::ostream& (*pf)(std::ostream&))
+    {
+        if (_async.load(std::memory_order_relaxed))
+        {
+            DummyLogRecord record;
+            if (pf == static_cast<DummyLogRecord::StreamManipulator_t>(std::endl))
+            {
+                record.type = DummyLogRecord::TYPE_ENDL;
+            }
+            else if (pf == static_cast<DummyLogRecord::StreamManipulator_t>(std::flush))
+            {
+                record.type = DummyLogRecord::TYPE_FLUSH;
+            }
+            else
+            {
+                record.type = DummyLogRecord::TYPE_STREAM_MANIPULATOR;
+                record.value.streamManipulator = pf;
+            }
+            DummyLoggerRing::Instance().Push(record, _policy);
+        }
+        else
+        {
+            DummyLoggerLine &line = DummyLoggerLine::Instance();
+            if (pf == static_cast<DummyLogRecord::StreamManipulator_t>(std::endl))
+            {
+                line.Stream() << '\n';
+                line.Commit(*_sink);
+                _sink->Flush();
+                if (DummyLogSite::Head() != 0)
+                {
+                    // a storm of suppressed lines might be over
+                    reportSuppressedIfDue();
+                }
+            }
+            else if (pf == static_cast<DummyLogRecord::StreamManipulator_t>(std::flush))
+            {
+                line.Commit(*_sink);
+                _sink->Flush();
+            }
+            else
+            {
+                pf(line.Stream());
+            }
+        }
+        return *this;
+    }
+
+private:
+    /// @brief the strem where log messages will be forwarded
+    std::ostream& _stream;
+
+    /// @brief writes text lines into _stream
+    DummyLoggerStreamSink _streamSink;
+
+    /// @brief where text lines are written to
+    DummyLoggerSink* _sink;
+
+    /// @brief true while in asynchronous mode
+    std::atomic<bool> _async;
+
+    /// @brief what to do when a ring is full in asynchronous mode
+    DummyLoggerFullRingPolicy_t _policy;
+
+    /// @brief the background thread (asynchronous mode)
+    std::unique_ptr<std::thread> _consumer;
+
+    /// @brief tells the background thread to finish
+    std::atomic<bool> _stopConsumer;
+
+    /// @brief number of calls to flush so far
+    std::atomic<uint64_t> _flushRequested;
+
+    /// @brief latest flush request the background thread is done with
+    std::atomic<uint64_t> _flushDone;
+
+    /// @brief where binary log entries go (0 if nowhere)
+    std::ostream* _binaryStream;
+
+    /// @brief every binary format entry written so far
+    std::vector<std::string> _binaryFormats;
+
+    /// @brief serialises the registration of binary formats and, in
+    ///        synchronous mode, every write to the binary stream
+    std::mutex _binaryMutex;
+
+    /// @brief time (DummyLogSite::NowSecs) of the next report of suppressed
+    ///        lines
+    std::atomic<uint64_t> _nextSuppressedReport;
+
+    /// @brief serialises reports of suppressed lines
+    std::mutex _reportMutex;
+
+    DummyLogger():
+        _stream(std::cout),
+        _streamSink(std::cout),
+        _sink(&_streamSink),
+        _async(false),
+        _policy(DUMMYLOGGER_FULL_RING_BLOCK),
+        _consumer(),
+        _stopConsumer(false),
+        _flushRequested(0),
+        _flushDone(0),
+        _binaryStream(0),
+        _binaryFormats(),
+        _binaryMutex(),
+        _nextSuppressedReport(0),
+        _reportMutex()
+    {}
+    ~DummyLogger()
+    {}
+
+    /// @brief drains every ring into the stream
+    /// @return the number of records written
+    uint64_t writePending()
+    {
+        uint64_t written = 0;
+        DummyLoggerRing::ForEachInstance([this, &written](DummyLoggerRing &a_ring) {
+            DummyLogRecord record;
+            while (a_ring.Pop(record))
+            {
+                written++;
+                if (record.type != DummyLogRecord::TYPE_BINARY)
+                {
+                    // lines are only written out once complete
+                    a_ring.Format(record);
+                    if ((record.type == DummyLogRecord::TYPE_ENDL) ||
+                        (record.type == DummyLogRecord::TYPE_FLUSH) ||
+                        (record.type == DummyLogRecord::TYPE_THREAD_EXIT) ||
+                        a_ring.PendingLine().EndsLine())
+                    {
+                        commitPendingLine(a_ring);
+                    }
+                    if (record.type == DummyLogRecord::TYPE_THREAD_EXIT)
+                    {
+                        // the next owner starts with the default format
+                        a_ring.PendingLine().ResetFormat();
+                    }
+                    continue;
+                }
+
+                // the rest of a binary entry must be written before
+                // anything else goes into the binary stream. It is either
+                // in the ring already or about to be
+                _binaryStream->write(record.value.text, record.length);
+                while (record.flags & DummyLogRecord::FLAG_MORE)
+                {
+                    Backoff backoff;
+                    while (!a_ring.Pop(record))
+                    {
+                        backoff.Wait();
+                    }
+                    _binaryStream->write(record.value.text, record.length);
+                    written++;
+                }
+            }
+        });
+        return written;
+    }
+
+    /// @brief registers a binary format string and writes its definition
+    /// @return the id of the format
+    SINGLETON_NOINLINE uint32_t registerBinaryFormat(
+        std::atomic<uint32_t> &a_formatId,
+        const char* a_format,
+        const char* a_signature,
+        const char* a_file,
+        uint32_t a_line)
+    {
+        std::lock_guard<std::mutex> lock(_binaryMutex);
+
+        // another thread might have registered this call site already
+        uint32_t formatId = a_formatId.load(std::memory_order_relaxed);
+        if (formatId != 0)
+        {
+            return formatId;
+        }
+        formatId = static_cast<uint32_t>(_binaryFormats.size() + 1);
+
+        char entry[DUMMYLOG_BINARY_MAX_ENTRY];
+        std::size_t size = DummyLogBinaryEncoder::EncodeFormat(
+            entry, formatId, a_format, a_signature, a_file, a_line);
+        _binaryFormats.push_back(std::string(entry, size));
+        if (_binaryStream)
+        {
+            // _binaryMutex is already held
+            writeBinaryLocked(entry, size);
+        }
+
+        a_formatId.store(formatId, std::memory_order_release);
+        return formatId;
+    }
+
+    /// @brief writes a binary entry to the binary stream (through the ring
+    ///        of the calling thread in asynchronous mode)
+    inline void writeBinary(const char* a_entry, std::size_t a_size)
+    {
+        if (_async.load(std::memory_order_relaxed))
+        {
+            DummyLoggerRing::Instance().PushBinary(a_entry, a_size, _policy);
+        }
+        else
+        {
+            // entries of different threads must not interleave
+            std::lock_guard<std::mutex> lock(_binaryMutex);
+            _binaryStream->write(a_entry, a_size);
+        }
+    }
+
+    /// @brief same as writeBinary, with _binaryMutex held by the caller
+    inline void writeBinaryLocked(const char* a_entry, std::size_t a_size)
+    {
+        if (_async.load(std::memory_order_relaxed))
+        {
+            DummyLoggerRing::Instance().PushBinary(a_entry, a_size, _policy);
+        }
+        else
+        {
+            _binaryStream->write(a_entry, a_size);
+        }
+    }
+
+    /// @brief writes the line pending in a_ring (background thread only)
+    inline void commitPendingLine(DummyLoggerRing &a_ring)
+    {
+        DummyLogLineStream &pending = a_ring.PendingLine();
+        std::string line = pending.str();
+        if (!line.empty())
+        {
+            _sink->Write(line.data(), line.size());
+            pending.str(std::string());
+        }
+    }
+
+    /// @brief registers the site of a suppressed line and reports the
+    ///        suppressed lines if it is time to (synchronous mode)
+    SINGLETON_NOINLINE void lineSuppressed(
+        DummyLogSite &a_site, DummyLogSite::Kind_t a_kind, uint64_t a_first, uint64_t a_every)
+    {
+        a_site.Register(a_kind, a_first, a_every);
+        if (!_async.load(std::memory_order_relaxed))
+        {
+            reportSuppressedIfDue();
+        }
+    }
+
+    /// @brief calls reportSuppressed if the last report is old enough
+    inline void reportSuppressedIfDue()
+    {
+        uint64_t now = DummyLogSite::NowSecs();
+        uint64_t next = _nextSuppressedReport.load(std::memory_order_relaxed);
+        if ((now >= next) &&
+            _nextSuppressedReport.compare_exchange_strong(
+                next, now + DUMMYLOGGER_SUPPRESSED_REPORT_SECS))
+        {
+            reportSuppressed();
+        }
+    }
+
+    /// @brief the routine run by the background thread
+    void consumerRoutine()
+    {
+        while (true)
+        {
+            // read before draining the rings, so every message logged before
+            // the flush call is written before the request is marked as done
+            uint64_t flushRequest = _flushRequested.load();
+            bool stop = _stopConsumer.load();
+
+            uint64_t written = writePending();
+            if (written > 0)
+            {
+                // one flush per batch
+                _sink->Flush();
+                if (_binaryStream)
+                {
+                    _binaryStream->flush();
+                }
+            }
+            if (flushRequest != _flushDone.load())
+            {
+                // flush reports suppressed lines too
+                reportSuppressed();
+            }
+            else
+            {
+                reportSuppressedIfDue();
+            }
+            _flushDone.store(flushRequest);
+
+            if (stop)
+            {
+                // nobody is going to complete them now
+                DummyLoggerRing::ForEachInstance([this](DummyLoggerRing &a_ring) {
+                    commitPendingLine(a_ring); });
+                _sink->Flush();
+                break;
+            }
+            if (written == 0)
+            {
+                std::this_thread::sleep_for(
+                    std::chrono::microseconds(DUMMYLOGGER_IDLE_SLEEP_USEC));
+            }
+        }
+    }
+
+    // usage of "friend" is discouraged, but it is the only way to design a templatized singleton
+    friend class Singleton<DummyLogger>;
+    
+    // template method needed to be able to log strings ending with std::endl
+    template <typename T>
+    friend DummyLogger& operator<<(DummyLogger& log, T const& val);
+
+    // writes the line of a thread that finishes into _sink
+    friend class DummyLoggerLine;
+   
+private:
+    // prevent copying of this singleton
+    DummyLogger(const DummyLogger& src);
+    DummyLogger& operator =(const DummyLogger& src);
+
+}; // class DummyLogger
+
+/// @brief turns the result of a DLOG statement into void, so both branches
+/// of the conditional operator in DLOG have the same type. operator& binds
+/// more loosely than operator<< but more tightly than ?:
+class DummyLoggerVoidify
+{
+public:
+    inline void operator&(DummyLogger&) {}
+};
+
+template <typename T>
+DummyLogger& operator<<(DummyLogger& log, T const& val)
+{
+    if (log._async.load(std::memory_order_relaxed))
+    {
+        DummyLoggerRing::Instance().Append(val, log._policy);
+    }
+    else
+    {
+        // text ending in '\n' completes the line, as if it had gone
+        // straight into the stream
+        DummyLoggerLine &line = DummyLoggerLine::Instance();
+        line.Stream() << val;
+        if (line.Stream().EndsLine())
+        {
+            line.Commit(*log._sink);
+        }
+    }
+    return log;
+}
+
+inline void DummyLoggerLine::OnThreadExit()
+{
+    Commit(*(DummyLogger::Instance()._sink));
+    m_stream.ResetFormat();
+}
+
+inline void DummyLoggerRing::OnThreadExit()
+{
+    // the next owner doesn't inherit a line being dropped
+    m_droppingLine = false;
+
+    DummyLogRecord record;
+    record.type = DummyLogRecord::TYPE_THREAD_EXIT;
+    Backoff backoff;
+    while (!m_queue.push(record))
+    {
+        if (!DummyLogger::Instance().isAsync())
+        {
+            // nobody is draining the ring. stopAsync wrote every pending
+            // line already, so only the format is carried over
+            break;
+        }
+        backoff.Wait();
+    }
+}
@@ -0,0 +1,613 @@
+// ============================================================================
+// Copyright (c) 2026 Faustino Frechilla
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+/// @file dummylogger_binary.h
+/// @brief Encoding and decoding of the binary log written by DummyLogger
+///
+/// A binary log (see DUMMYLOG_BINARY in dummylogger.h) never formats
+/// anything while logging. Each format string is registered the first time
+/// its call site is run and gets an id. From then on every call only writes
+/// the id, a timestamp and the raw bytes of its arguments. The text is
+/// rebuilt offline by DummyLogBinaryDecoder (see tools/dummylog_decoder.cpp).
+///
+/// Stream layout (host byte order):
+///   magic    DUMMYLOG_BINARY_MAGIC (8 bytes)
+///   entries  uint8_t kind, uint16_t payload size, payload
+/// Payload of a DUMMYLOG_ENTRY_FORMAT entry:
+///   uint32_t id, uint32_t line, uint8_t argument count, a type tag per
+///   argument, then format and file name as null-terminated strings
+/// Payload of a DUMMYLOG_ENTRY_LOG entry:
+///   uint32_t id, uint64_t timestamp (nanoseconds, see TscClock), then the
+///   arguments. Strings are a uint8_t length followed by their bytes
+/// Entries of both kinds can come in any order, since every thread has its
+/// own ring, so the decoder reads every format definition first.
+///
+/// "{}" in the format string is replaced by the next argument
+///
+/// @author Faustino Frechilla
+/// @history
+/// Ref       Who                When         What
+///           Faustino Frechilla 17-Oct-2026  Original development
+///           Faustino Frechilla 17-Oct-2026  Entries decoded one by one
+///           Faustino Frechilla 17-Oct-2026  Malformed entries skipped
+/// @endhistory
+///
+// ============================================================================
+
+#ifndef _DUMMYLOGGERBINARY_H_
+#define _DUMMYLOGGERBINARY_H_
+
+#include <stdint.h>   // types (uint64_t...)
+#include <string.h>   // memcpy, strlen
+#include <iostream>
+#include <iomanip>    // std::setw
+#include <string>
+#include <vector>
+#include <map>
+#include <type_traits>
+
+#define DUMMYLOG_BINARY_MAGIC      "DLOGBIN1"
+#define DUMMYLOG_BINARY_MAGIC_SIZE 8
+// strings longer than this are truncated
+#define DUMMYLOG_BINARY_MAX_STRING 255
+// maximum number of arguments of a single log call
+#define DUMMYLOG_BINARY_MAX_ARGS   16
+// kind (1 byte) and payload size (2 bytes)
+#define DUMMYLOG_BINARY_ENTRY_HEADER_SIZE 3
+// id (4 bytes) and timestamp (8 bytes) at the start of a log entry payload
+#define DUMMYLOG_BINARY_LOG_HEADER_SIZE 12
+// big enough for any entry of DUMMYLOG_BINARY_MAX_ARGS arguments
+#define DUMMYLOG_BINARY_MAX_ENTRY \
+    (DUMMYLOG_BINARY_ENTRY_HEADER_SIZE + 4 + 8 + \
+     (DUMMYLOG_BINARY_MAX_ARGS * (DUMMYLOG_BINARY_MAX_STRING + 1)))
+
+/// @brief kinds of entries in a binary log
+enum DummyLogBinaryEntry_t
+{
+    DUMMYLOG_ENTRY_FORMAT = 1,
+    DUMMYLOG_ENTRY_LOG    = 2
+};
+
+/// @brief type tags of the arguments of a binary log call
+enum DummyLogBinaryArgType_t
+{
+    DUMMYLOG_ARG_INT64   = 'I',
+    DUMMYLOG_ARG_UINT64  = 'U',
+    DUMMYLOG_ARG_DOUBLE  = 'd',
+    DUMMYLOG_ARG_CHAR    = 'c',
+    DUMMYLOG_ARG_BOOL    = 'b',
+    DUMMYLOG_ARG_STRING  = 's',
+    DUMMYLOG_ARG_POINTER = 'p'
+};
+
+/// @brief how an argument of type T is written into a binary log
+/// Integers are widened to 64 bits, so the decoder only has to know about
+/// a handful of types. Types not listed here can't be logged in binary form
+template <typename T, typename ENABLE = void>
+struct DummyLogBinaryArg
+{
+    static_assert(sizeof(T) == 0,
+        "type not supported by the binary log. Use the text log instead");
+};
+
+template <typename T>
+struct DummyLogBinaryArg<T, typename std::enable_if<
+    std::is_integral<T>::value && std::is_signed<T>::value &&
+    !std::is_same<T, char>::value>::type>
+{
+    static const char TAG = DUMMYLOG_ARG_INT64;
+    static inline std::size_t Size(T) { return sizeof(int64_t); }
+    static inline char* Encode(char* a_buffer, T a_value)
+    {
+        int64_t value = a_value;
+        memcpy(a_buffer, &value, sizeof(value));
+        return a_buffer + sizeof(value);
+    }
+};
+
+template <typename T>
+struct DummyLogBinaryArg<T, typename std::enable_if<
+    std::is_integral<T>::value && !std::is_signed<T>::value &&
+    !std::is_same<T, bool>::value && !std::is_same<T, char>::value>::type>
+{
+    static const char TAG = DUMMYLOG_ARG_UINT64;
+    static inline std::size_t Size(T) { return sizeof(uint64_t); }
+    static inline char* Encode(char* a_buffer, T a_value)
+    {
+        uint64_t value = a_value;
+        memcpy(a_buffer, &value, sizeof(value));
+        return a_buffer + sizeof(value);
+    }
+};
+
+template <typename T>
+struct DummyLogBinaryArg<T, typename std::enable_if<
+    std::is_floating_point<T>::value>::type>
+{
+    static const char TAG = DUMMYLOG_ARG_DOUBLE;
+    static inline std::size_t Size(T) { return sizeof(double); }
+    static inline char* Encode(char* a_buffer, T a_value)
+    {
+        double value = a_value;
+        memcpy(a_buffer, &value, sizeof(value));
+        return a_buffer + sizeof(value);
+    }
+};
+
+template <>
+struct DummyLogBinaryArg<char>
+{
+    static const char TAG = DUMMYLOG_ARG_CHAR;
+    static inline std::size_t Size(char) { return 1; }
+    static inline char* Encode(char* a_buffer, char a_value)
+    {
+        *a_buffer = a_value;
+        return a_buffer + 1;
+    }
+};
+
+template <>
+struct DummyLogBinaryArg<bool>
+{
+    static const char TAG = DUMMYLOG_ARG_BOOL;
+    static inline std::size_t Size(bool) { return 1; }
+    static inline char* Encode(char* a_buffer, bool a_value)
+    {
+        *a_buffer = a_value ? 1 : 0;
+        return a_buffer + 1;
+    }
+};
+
+template <>
+struct DummyLogBinaryArg<const char*>
+{
+    static const char TAG = DUMMYLOG_ARG_STRING;
+    static inline std::size_t Length(const char* a_value)
+    {
+        std::size_t length = (a_value == 0) ? 0 : strlen(a_value);
+        return (length > DUMMYLOG_BINARY_MAX_STRING) ? DUMMYLOG_BINARY_MAX_STRING : length;
+    }
+    static inline std::size_t Size(const char* a_value) { return 1 + Length(a_value); }
+    static inline char* Encode(char* a_buffer, const char* a_value)
+    {
+        std::size_t length = Length(a_value);
+        *a_buffer = static_cast<char>(length);
+        memcpy(a_buffer + 1, a_value, length);
+        return a_buffer + 1 + length;
+    }
+};
+
+template <>
+struct DummyLogBinaryArg<char*> : public DummyLogBinaryArg<const char*>
+{};
+
+template <>
+struct DummyLogBinaryArg<std::string>
+{
+    static const char TAG = DUMMYLOG_ARG_STRING;
+    static inline std::size_t Length(const std::string &a_value)
+    {
+        return (a_value.size() > DUMMYLOG_BINARY_MAX_STRING) ?
+            DUMMYLOG_BINARY_MAX_STRING : a_value.size();
+    }
+    static inline std::size_t Size(const std::string &a_value) { return 1 + Length(a_value); }
+    static inline char* Encode(char* a_buffer, const std::string &a_value)
+    {
+        std::size_t length = Length(a_value);
+        *a_buffer = static_cast<char>(length);
+        memcpy(a_buffer + 1, a_value.data(), length);
+        return a_buffer + 1 + length;
+    }
+};
+
+template <typename T>
+struct DummyLogBinaryArg<T*, typename std::enable_if<
+    !std::is_same<typename std::remove_cv<T>::type, char>::value>::type>
+{
+    static const char TAG = DUMMYLOG_ARG_POINTER;
+    static inline std::size_t Size(const T*) { return sizeof(uint64_t); }
+    static inline char* Encode(char* a_buffer, const T* a_value)
+    {
+        uint64_t value = reinterpret_cast<uintptr_t>(a_value);
+        memcpy(a_buffer, &value, sizeof(value));
+        return a_buffer + sizeof(value);
+    }
+};
+
+/// @brief encodes binary log entries
+class DummyLogBinaryEncoder
+{
+public:
+    /// @brief the type tags of ARGS_T as a null-terminated string
+    template <typename... ARGS_T>
+    static const char* Signature()
+    {
+        static const char s_signature[] = {
+            DummyLogBinaryArg<typename std::decay<ARGS_T>::type>::TAG..., '\0'};
+        return s_signature;
+    }
+
+    /// @brief encodes the definition of a format string
+    /// @param out_buffer at least DUMMYLOG_BINARY_MAX_ENTRY bytes long
+    /// @return the size of the entry
+    static std::size_t EncodeFormat(
+        char* out_buffer,
+        uint32_t a_id,
+        const char* a_format,
+        const char* a_signature,
+        const char* a_file,
+        uint32_t a_line)
+    {
+        std::size_t argCount = strlen(a_signature);
+        // format and file name are truncated so the entry fits
+        std::size_t fixedSize = 4 + 4 + 1 + argCount + 2;
+        std::size_t formatLength = strlen(a_format);
+        std::size_t fileLength   = strlen(a_file);
+        std::size_t available    = DUMMYLOG_BINARY_MAX_ENTRY -
+            DUMMYLOG_BINARY_ENTRY_HEADER_SIZE - fixedSize;
+        if (fileLength > (available / 2))
+        {
+            // keep the end of the path, it's the interesting part
+            a_file += fileLength - (available / 2);
+            fileLength = available / 2;
+        }
+        if (formatLength > (available - fileLength))
+        {
+            formatLength = available - fileLength;
+        }
+
+        char* payload = out_buffer + DUMMYLOG_BINARY_ENTRY_HEADER_SIZE;
+        char* cursor  = payload;
+        memcpy(cursor, &a_id, 4);    cursor += 4;
+        memcpy(cursor, &a_line, 4);  cursor += 4;
+        *cursor++ = static_cast<char>(argCount);
+        memcpy(cursor, a_signature, argCount); cursor += argCount;
+        memcpy(cursor, a_format, formatLength); cursor += formatLength;
+        *cursor++ = '\0';
+        memcpy(cursor, a_file, fileLength); cursor += fileLength;
+        *cursor++ = '\0';
+
+        return EncodeHeader(out_buffer, DUMMYLOG_ENTRY_FORMAT, cursor - payload);
+    }
+
+    /// @brief encodes a log call
+    /// @param out_buffer at least DUMMYLOG_BINARY_MAX_ENTRY bytes long
+    /// @return the size of the entry
+    template <typename... ARGS_T>
+    static inline std::size_t EncodeLog(
+        char* out_buffer, uint32_t a_id, uint64_t a_timestamp, const ARGS_T&... a_args)
+    {
+        static_assert(sizeof...(ARGS_T) <= DUMMYLOG_BINARY_MAX_ARGS,
+            "too many arguments for a single binary log call");
+
+        char* payload = out_buffer + DUMMYLOG_BINARY_ENTRY_HEADER_SIZE;
+        char* cursor  = payload;
+        memcpy(cursor, &a_id, 4);        cursor += 4;
+        memcpy(cursor, &a_timestamp, 8); cursor += 8;
+        cursor = EncodeArgs(cursor, a_args...);
+
+        return EncodeHeader(out_buffer, DUMMYLOG_ENTRY_LOG, cursor - payload);
+    }
+
+private:
+    DummyLogBinaryEncoder();
+
+    static inline std::size_t EncodeHeader(
+        char* out_buffer, DummyLogBinaryEntry_t a_kind, std::size_t a_payloadSize)
+    {
+        uint16_t payloadSize = static_cast<uint16_t>(a_payloadSize);
+        out_buffer[0] = static_cast<char>(a_kind);
+        memcpy(out_buffer + 1, &payloadSize, 2);
+        return DUMMYLOG_BINARY_ENTRY_HEADER_SIZE + a_payloadSize;
+    }
+
+    static inline char* EncodeArgs(char* a_cursor)
+    {
+        return a_cursor;
+    }
+
+    template <typename T, typename... ARGS_T>
+    static inline char* EncodeArgs(char* a_cursor, const T &a_value, const ARGS_T&... a_args)
+    {
+        typedef typename std::decay<T>::type Decayed_t;
+        a_cursor = DummyLogBinaryArg<Decayed_t>::Encode(a_cursor, a_value);
+        return EncodeArgs(a_cursor, a_args...);
+    }
+};
+
+/// @brief turns a binary log back into text
+/// Every line looks like:
+///   <seconds>.<nanoseconds> <file>:<line> <formatted message>
+/// Logs are read from disk, so nothing in them is trusted: entries which
+/// are too short for what they say they hold are skipped with a warning on
+/// std::cerr
+class DummyLogBinaryDecoder
+{
+public:
+    DummyLogBinaryDecoder():
+        m_formats(),
+        m_malformed(0)
+    {}
+
+    /// @brief decodes a whole binary log
+    /// @param a_data the binary log (including the magic)
+    /// @param a_size its size in bytes
+    /// @param a_output where the text goes
+    /// @return the number of log entries decoded, -1 if a_data is not a
+    ///         binary log. A truncated last entry and malformed entries are
+    ///         ignored
+    long Decode(const char* a_data, std::size_t a_size, std::ostream &a_output)
+    {
+        if ((a_size < DUMMYLOG_BINARY_MAGIC_SIZE) ||
+            (memcmp(a_data, DUMMYLOG_BINARY_MAGIC, DUMMYLOG_BINARY_MAGIC_SIZE) != 0))
+        {
+            return -1;
+        }
+
+        // first pass: format definitions
+        ForEachEntry(a_data, a_size, DUMMYLOG_ENTRY_FORMAT, a_output);
+        // second pass: log calls
+        return ForEachEntry(a_data, a_size, DUMMYLOG_ENTRY_LOG, a_output);
+    }
+
+    /// @brief reads the format definitions of a binary log, so its log
+    ///        entries can be decoded one by one (DecodeLog)
+    /// @return false if a_data is not a binary log
+    bool LoadFormats(const char* a_data, std::size_t a_size)
+    {
+        if ((a_size < DUMMYLOG_BINARY_MAGIC_SIZE) ||
+            (memcmp(a_data, DUMMYLOG_BINARY_MAGIC, DUMMYLOG_BINARY_MAGIC_SIZE) != 0))
+        {
+            return false;
+        }
+
+        ForEachEntry(a_data, a_size, DUMMYLOG_ENTRY_FORMAT, std::cout);
+        return true;
+    }
+
+    /// @return number of malformed entries skipped so far
+    inline uint64_t MalformedEntries() const
+    {
+        return m_malformed;
+    }
+
+    /// @brief counts a malformed entry of a_size bytes, and warns about it
+    void SkipMalformed(const char* a_kind, std::size_t a_size)
+    {
+        m_malformed++;
+        std::cerr << "dummylog: skipping malformed " << a_kind
+                  << " entry (" << a_size << " bytes)" << std::endl;
+    }
+
+    /// @return the timestamp of a log entry
+    /// @param a_payload the payload of the entry (right after its header).
+    ///        It must be at least DUMMYLOG_BINARY_LOG_HEADER_SIZE bytes long
+    static inline uint64_t LogTimestamp(const char* a_payload)
+    {
+        uint64_t timestamp;
+        memcpy(&timestamp, a_payload + 4, 8);
+        return timestamp;
+    }
+
+    /// @brief writes a log entry as a line of text. The formats it uses must
+    ///        have been read (LoadFormats)
+    /// @param a_payload the payload of the entry (right after its header)
+    /// @param a_size size of the payload
+    /// @return false if the entry is too short to be one (nothing is written)
+    bool DecodeLog(const char* a_payload, std::size_t a_size, std::ostream &a_output)
+    {
+        if (a_size < DUMMYLOG_BINARY_LOG_HEADER_SIZE)
+        {
+            SkipMalformed("log", a_size);
+            return false;
+        }
+
+        uint32_t id;
+        memcpy(&id, a_payload, 4);
+        uint64_t timestamp = LogTimestamp(a_payload);
+
+        a_output << (timestamp / 1000000000ULL) << "."
+                 << std::setw(9) << std::setfill('0') << (timestamp % 1000000000ULL)
+                 << std::setfill(' ') << " ";
+
+        std::map<uint32_t, Format_t>::const_iterator it = m_formats.find(id);
+        if (it == m_formats.end())
+        {
+            a_output << "<unknown format id " << id << ">" << std::endl;
+            return true;
+        }
+        const Format_t &format = it->second;
+        a_output << format.file << ":" << format.line << " ";
+
+        const char* cursor = a_payload + DUMMYLOG_BINARY_LOG_HEADER_SIZE;
+        const char* end    = a_payload + a_size;
+        std::size_t formatOffset = 0;
+        for (std::size_t i = 0; i < format.signature.size(); i++)
+        {
+            // text up to the next placeholder
+            std::size_t placeholder = format.format.find("{}", formatOffset);
+            if (placeholder == std::string::npos)
+            {
+                a_output << format.format.substr(formatOffset) << " ";
+                formatOffset = format.format.size();
+            }
+            else
+            {
+                a_output << format.format.substr(formatOffset, placeholder - formatOffset);
+                formatOffset = placeholder + 2;
+            }
+
+            cursor = DecodeArg(format.signature[i], cursor, end, a_output);
+            if (cursor == 0)
+            {
+                a_output << "<truncated>";
+                break;
+            }
+        }
+        if (formatOffset < format.format.size())
+        {
+            a_output << format.format.substr(formatOffset);
+        }
+        a_output << std::endl;
+        return true;
+    }
+
+private:
+    struct Format_t
+    {
+        uint32_t line;
+        std::string signature;
+        std::string format;
+        std::string file;
+    };
+
+    std::map<uint32_t, Format_t> m_formats;
+    uint64_t m_malformed;
+
+    long ForEachEntry(
+        const char* a_data,
+        std::size_t a_size,
+        DummyLogBinaryEntry_t a_kind,
+        std::ostream &a_output)
+    {
+        long count = 0;
+        std::size_t offset = DUMMYLOG_BINARY_MAGIC_SIZE;
+        while ((offset + DUMMYLOG_BINARY_ENTRY_HEADER_SIZE) <= a_size)
+        {
+            uint8_t kind = static_cast<uint8_t>(a_data[offset]);
+            uint16_t payloadSize;
+            memcpy(&payloadSize, a_data + offset + 1, 2);
+            offset += DUMMYLOG_BINARY_ENTRY_HEADER_SIZE;
+            if ((offset + payloadSize) > a_size)
+            {
+                break;
+            }
+
+            if (kind == a_kind)
+            {
+                bool decoded = (kind == DUMMYLOG_ENTRY_FORMAT) ?
+                    DecodeFormat(a_data + offset, payloadSize) :
+                    DecodeLog(a_data + offset, payloadSize, a_output);
+                count += decoded ? 1 : 0;
+            }
+            offset += payloadSize;
+        }
+        return count;
+    }
+
+    /// @return false if the entry is malformed
+    bool DecodeFormat(const char* a_payload, std::size_t a_size)
+    {
+        // id, line and argument count, then a tag per argument
+        uint8_t argCount = (a_size >= 9) ? static_cast<uint8_t>(a_payload[8]) : 0;
+        if ((a_size < 9) || ((9 + static_cast<std::size_t>(argCount)) > a_size))
+        {
+            SkipMalformed("format", a_size);
+            return false;
+        }
+
+        // both strings must end inside the payload
+        const char* end = a_payload + a_size;
+        const char* formatText = a_payload + 9 + argCount;
+        const char* formatEnd = static_cast<const char*>(
+            memchr(formatText, '\0', end - formatText));
+        const char* fileText = (formatEnd != 0) ? (formatEnd + 1) : end;
+        const char* fileEnd = static_cast<const char*>(
+            memchr(fileText, '\0', end - fileText));
+        if ((formatEnd == 0) || (fileEnd == 0))
+        {
+            SkipMalformed("format", a_size);
+            return false;
+        }
+
+        uint32_t id;
+        Format_t format;
+        memcpy(&id, a_payload, 4);
+        memcpy(&format.line, a_payload + 4, 4);
+        format.signature.assign(a_payload + 9, argCount);
+        format.format.assign(formatText, formatEnd - formatText);
+        format.file.assign(fileText, fileEnd - fileText);
+
+        m_formats[id] = format;
+        return true;
+    }
+
+    /// @return where the next argument starts. 0 if a_end was hit
+    static const char* DecodeArg(
+        char a_tag, const char* a_cursor, const char* a_end, std::ostream &a_output)
+    {
+        switch (a_tag)
+        {
+        case DUMMYLOG_ARG_INT64:
+        {
+            int64_t value;
+            if ((a_cursor + 8) > a_end) return 0;
+            memcpy(&value, a_cursor, 8);
+            a_output << value;
+            return a_cursor + 8;
+        }
+        case DUMMYLOG_ARG_UINT64:
+        {
+            uint64_t value;
+            if ((a_cursor + 8) > a_end) return 0;
+            memcpy(&value, a_cursor, 8);
+            a_output << value;
+            return a_cursor + 8;
+        }
+        case DUMMYLOG_ARG_DOUBLE:
+        {
+            double value;
+            if ((a_cursor + 8) > a_end) return 0;
+            memcpy(&value, a_cursor, 8);
+            a_output << value;
+            return a_cursor + 8;
+        }
+        case DUMMYLOG_ARG_POINTER:
+        {
+            uint64_t value;
+            if ((a_cursor + 8) > a_end) return 0;
+            memcpy(&value, a_cursor, 8);
+            a_output << "0x" << std::hex << value << std::dec;
+            return a_cursor + 8;
+        }
+        case DUMMYLOG_ARG_CHAR:
+            if ((a_cursor + 1) > a_end) return 0;
+            a_output << *a_cursor;
+            return a_cursor + 1;
+        case DUMMYLOG_ARG_BOOL:
+            if ((a_cursor + 1) > a_end) return 0;
+            a_output << ((*a_cursor) ? "true" : "false");
+            return a_cursor + 1;
+        case DUMMYLOG_ARG_STRING:
+        {
+            if ((a_cursor + 1) > a_end) return 0;
+            std::size_t length = static_cast<uint8_t>(*a_cursor);
+            if ((a_cursor + 1 + length) > a_end) return 0;
+            a_output.write(a_cursor + 1, length);
+            return a_cursor + 1 + length;
+        }
+        default:
+            return 0;
+        }
+    }
+};
+
+#endif /* _DUMMYLOGGERBINARY_H_ */
@@ -0,0 +1,594 @@
+// ============================================================================
+// Copyright (c) 2026 Faustino Frechilla
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+/// @file dummylogger_mmap_sink.h
+/// @brief A DummyLogger sink which writes into memory mapped files
+///
+/// Lines are copied into a file mapped in memory (MAP_SHARED) and the kernel
+/// writes the pages back whenever it sees fit. Writing a line is an atomic
+/// fetch-and-add to reserve its space plus a memcpy: no system calls and no
+/// locks. Files have a fixed size and are preallocated (and their pages
+/// faulted in) by a background thread before they are needed.
+///
+/// The sink rolls over to a new file when the current one is full or, if a
+/// rotation period is given, when it has been in use for that long. Files are
+/// named <prefix>.000001, <prefix>.000002... and truncated to the size of
+/// their contents once they are done with. The file in use is as big as a
+/// whole file until then, the bytes after the last line being zeros
+///
+/// @author Faustino Frechilla
+/// @history
+/// Ref       Who                When         What
+///           Faustino Frechilla 17-Oct-2026  Original development
+///           Faustino Frechilla 17-Oct-2026  Files created and retired out of the lock
+///           Faustino Frechilla 17-Oct-2026  Files put into use in the order they are numbered
+/// @endhistory
+///
+// ============================================================================
+
+#ifndef _DUMMYLOGGERMMAPSINK_H_
+#define _DUMMYLOGGERMMAPSINK_H_
+
+#include <stdint.h>     // types (uint64_t...)
+#include <stdio.h>      // snprintf
+#include <string.h>     // memcpy
+#include <fcntl.h>      // open, posix_fallocate
+#include <unistd.h>     // ftruncate, close, unlink
+#include <sys/mman.h>   // mmap, munmap
+#include <assert.h>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <string>
+#include <memory>
+#include "clock.h"
+#include "backoff.h"
+#include "dummylogger_sink.h"
+
+// number of files that can be mapped at the same time: the one being written
+// plus the ones which were just filled up and might still be being copied to
+#define DUMMYLOGGER_MMAP_SINK_SEGMENTS 4
+
+// time the background thread sleeps for between rounds
+#define DUMMYLOGGER_MMAP_SINK_POLL_USEC 1000 // (1ms)
+
+/// @brief writes lines into memory mapped files, rolling over to a new file
+/// when the current one is full or when the rotation period expires
+///
+/// Example of usage:
+/// DummyLoggerMmapSink sink("/var/log/app", 64 * 1024 * 1024);
+/// DummyLogger::Instance().setSink(&sink);
+/// /* ... */
+/// DummyLogger::Instance().setSink(0); // before sink is destroyed
+class DummyLoggerMmapSink : public DummyLoggerSink
+{
+public:
+    /// @param a_prefix path of the files without the sequence number
+    /// @param a_fileSize size of each file in bytes. A line which is bigger
+    ///        than a whole file is dropped
+    /// @param a_rotationMsecs a non empty file is closed after it has been
+    ///        in use for this long. 0 to roll over only when files are full
+    DummyLoggerMmapSink(
+        const std::string &a_prefix,
+        uint64_t a_fileSize,
+        uint32_t a_rotationMsecs = 0);
+
+    /// @brief truncates the files to the size of their contents. Nothing
+    /// must be written into the sink while (or after) it is being destroyed
+    virtual ~DummyLoggerMmapSink();
+
+    /// @brief copies a line into the current file. Thread safe and lock free
+    /// as long as the background thread keeps up preparing new files
+    virtual void Write(const char* a_data, std::size_t a_size);
+
+    /// @brief does nothing. Lines are in the page cache (visible to any
+    /// reader of the file) as soon as they are copied, and the kernel writes
+    /// them back to disk asynchronously
+    virtual void Flush()
+    {}
+
+    /// @return true if the first file could be created
+    inline bool IsOpen() const
+    {
+        return m_segments[0].data != 0;
+    }
+
+    /// @return number of lines dropped so far because they were too big or
+    ///         a file couldn't be created
+    inline uint64_t DroppedLines() const
+    {
+        return m_droppedLines.load(std::memory_order_relaxed);
+    }
+
+    /// @return number of files created so far
+    inline uint32_t FileCount() const
+    {
+        return m_fileCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    /// @brief a memory mapped file which isn't in use by writers: being
+    /// created or retired, which is done without locking m_mutex
+    struct MappedFile
+    {
+        /// @brief address where the file is mapped. 0 if not mapped
+        char* data;
+        int fd;
+        /// @brief size of its contents
+        uint64_t end;
+        /// @brief sequence number in the name of the file
+        uint32_t number;
+    };
+
+    /// @brief a memory mapped file writers can use
+    struct Segment
+    {
+        /// @brief address where the file is mapped. 0 if not mapped
+        char* data;
+        int fd;
+        /// @brief sequence number in the name of the file
+        uint32_t number;
+        /// @brief size of the contents of the file once it is full
+        uint64_t end;
+        /// @brief true once writers have moved on to the next file
+        bool full;
+        /// @brief time (RealClock) the file has to be closed at
+        uint64_t deadline;
+        /// @brief bytes copied into the file so far
+        std::atomic<uint64_t> written;
+    };
+
+    // the write position is made of a generation (the number of files
+    // filled up so far) in the upper bits and an offset in the lower ones
+    static const int      POSITION_SHIFT = 40;
+    static const uint64_t POSITION_OFFSET_MASK = (1ULL << POSITION_SHIFT) - 1;
+
+    std::string m_prefix;
+    uint64_t m_fileSize;
+    uint64_t m_rotationNsecs;
+
+    /// @brief generation and offset where the next line goes
+    std::atomic<uint64_t> m_position;
+
+    /// @brief a generation writes into m_segments[generation % SEGMENTS]
+    Segment m_segments[DUMMYLOGGER_MMAP_SINK_SEGMENTS];
+
+    /// @brief file created in advance by the background thread
+    MappedFile m_prepared;
+
+    /// @brief protects the segments, m_prepared and m_creating. It is only
+    /// held to move files in and out of them, never while files are created
+    /// or retired
+    std::mutex m_mutex;
+
+    /// @brief true while a file is being created. Only one file is created
+    /// at a time, so files are put into use in the order they are numbered
+    bool m_creating;
+
+    /// @brief signalled when a file has been created
+    std::condition_variable m_createdCond;
+
+    std::atomic<uint64_t> m_droppedLines;
+    std::atomic<uint32_t> m_fileCount;
+
+    std::atomic<bool> m_stop;
+    std::unique_ptr<std::thread> m_thread;
+
+    /// @brief moves writers on to the next file. Called by whoever reserved
+    ///        the first bytes beyond the end of the current one
+    /// @param a_generation the generation which is full
+    /// @param a_end where the contents of its file end
+    void Rotate(uint64_t a_generation, uint64_t a_end);
+
+    /// @brief creates and maps a new file. m_mutex must not be locked, and
+    ///        m_creating must have been set by the caller
+    /// @return false if it couldn't be done (out_file.data is 0 then)
+    bool CreateFile(MappedFile &out_file);
+
+    /// @brief waits for the copies into a full file to finish and takes
+    ///        the file out of a_segment. m_mutex must be locked
+    void Detach(Segment &a_segment, MappedFile &out_file);
+
+    /// @brief unmaps a file taken out of its segment and truncates it to
+    ///        its contents. m_mutex must not be locked
+    void Retire(MappedFile &a_file);
+
+    /// @brief the routine run by the background thread
+    void BackgroundRoutine();
+
+    // prevent copying
+    DummyLoggerMmapSink(const DummyLoggerMmapSink&);
+    DummyLoggerMmapSink& operator=(const DummyLoggerMmapSink&);
+};
+
+inline DummyLoggerMmapSink::DummyLoggerMmapSink(
+    const std::string &a_prefix,
+    uint64_t a_fileSize,
+    uint32_t a_rotationMsecs):
+        m_prefix(a_prefix),
+        m_fileSize(a_fileSize),
+        m_rotationNsecs(static_cast<uint64_t>(a_rotationMsecs) * 1000000ULL),
+        m_position(0),
+        m_mutex(),
+        m_creating(false),
+        m_createdCond(),
+        m_droppedLines(0),
+        m_fileCount(0),
+        m_stop(false),
+        m_thread()
+{
+    // writers which find the file full keep adding to the offset until the
+    // next file is ready. Leave plenty of room before the generation bits
+    assert(a_fileSize > 0);
+    assert(a_fileSize < (1ULL << (POSITION_SHIFT - 1)));
+
+    for (int i = 0; i < DUMMYLOGGER_MMAP_SINK_SEGMENTS; i++)
+    {
+        m_segments[i].data = 0;
+        m_segments[i].fd = -1;
+        m_segments[i].number = 0;
+        m_segments[i].end = 0;
+        m_segments[i].full = false;
+        m_segments[i].deadline = 0;
+        m_segments[i].written.store(0);
+    }
+
+    MappedFile first;
+    CreateFile(first);
+    m_segments[0].data = first.data;
+    m_segments[0].fd = first.fd;
+    m_segments[0].number = first.number;
+    m_segments[0].deadline = RealClock::Now() + m_rotationNsecs;
+    CreateFile(m_prepared);
+
+    m_thread.reset(new std::thread(&DummyLoggerMmapSink::BackgroundRoutine, this));
+}
+
+inline DummyLoggerMmapSink::~DummyLoggerMmapSink()
+{
+    m_stop.store(true);
+    m_thread->join();
+
+    // the file in use ends where the last line does
+    uint64_t position = m_position.load(std::memory_order_acquire);
+    Segment &current = m_segments[(position >> POSITION_SHIFT) % DUMMYLOGGER_MMAP_SINK_SEGMENTS];
+    uint64_t offset = position & POSITION_OFFSET_MASK;
+    current.end = (offset < m_fileSize) ? offset : m_fileSize;
+    current.full = true;
+
+    for (int i = 0; i < DUMMYLOGGER_MMAP_SINK_SEGMENTS; i++)
+    {
+        MappedFile retired;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            Detach(m_segments[i], retired);
+        }
+        Retire(retired);
+    }
+
+    // a file which was never used
+    if (m_prepared.data != 0)
+    {
+        munmap(m_prepared.data, m_fileSize);
+        close(m_prepared.fd);
+        char path[32];
+        snprintf(path, sizeof(path), ".%06u", m_prepared.number);
+        unlink((m_prefix + path).c_str());
+    }
+}
+
+inline void DummyLoggerMmapSink::Write(const char* a_data, std::size_t a_size)
+{
+    if (a_size > m_fileSize)
+    {
+        m_droppedLines.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    while (true)
+    {
+        // acquire: the file of a new generation is mapped before the
+        // position moves on to it
+        uint64_t position = m_position.fetch_add(a_size, std::memory_order_acquire);
+        uint64_t generation = position >> POSITION_SHIFT;
+        uint64_t offset = position & POSITION_OFFSET_MASK;
+        Segment &segment = m_segments[generation % DUMMYLOGGER_MMAP_SINK_SEGMENTS];
+
+        if ((offset + a_size) <= m_fileSize)
+        {
+            if (segment.data == 0)
+            {
+                // the file couldn't be created
+                m_droppedLines.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            memcpy(segment.data + offset, a_data, a_size);
+            segment.written.fetch_add(a_size, std::memory_order_release);
+            return;
+        }
+
+        if (offset <= m_fileSize)
+        {
+            // the first one not to fit, so this line ends the file
+            Rotate(generation, offset);
+        }
+        else
+        {
+            Backoff backoff;
+            while ((m_position.load(std::memory_order_relaxed) >> POSITION_SHIFT) == generation)
+            {
+                backoff.Wait();
+            }
+        }
+    }
+}
+
+inline void DummyLoggerMmapSink::Rotate(uint64_t a_generation, uint64_t a_end)
+{
+    // writers are waiting for the next file: m_mutex is only held to swap
+    // files in and out of the segments
+    MappedFile fresh;
+    bool create = false;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        Segment &full = m_segments[a_generation % DUMMYLOGGER_MMAP_SINK_SEGMENTS];
+        full.end = a_end;
+        full.full = true;
+
+        // a file being prepared takes the next number. Creating another
+        // one now would put a later number into use before it
+        while (m_creating)
+        {
+            m_createdCond.wait(lock);
+        }
+
+        fresh = m_prepared;
+        m_prepared.data = 0;
+        m_prepared.fd = -1;
+        if (fresh.data == 0)
+        {
+            // the background thread didn't keep up (or it failed)
+            m_creating = true;
+            create = true;
+        }
+    }
+
+    if (create)
+    {
+        CreateFile(fresh);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_creating = false;
+        }
+        m_createdCond.notify_all();
+    }
+
+    MappedFile retired;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // the background thread should have retired this one long ago
+        Segment &next = m_segments[(a_generation + 1) % DUMMYLOGGER_MMAP_SINK_SEGMENTS];
+        Detach(next, retired);
+
+        next.data = fresh.data;
+        next.fd = fresh.fd;
+        next.number = fresh.number;
+        next.end = 0;
+        next.full = false;
+        next.deadline = RealClock::Now() + m_rotationNsecs;
+        next.written.store(0, std::memory_order_relaxed);
+
+        m_position.store((a_generation + 1) << POSITION_SHIFT, std::memory_order_release);
+    }
+
+    Retire(retired);
+}
+
+inline bool DummyLoggerMmapSink::CreateFile(MappedFile &out_file)
+{
+    out_file.data = 0;
+    out_file.end = 0;
+    out_file.number = m_fileCount.load() + 1;
+
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%06u", out_file.number);
+    std::string path = m_prefix + suffix;
+    out_file.fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out_file.fd < 0)
+    {
+        return false;
+    }
+
+    // reserve the blocks now so the kernel never has to look for them while
+    // a page is being written back. Not every file system supports it
+    void* data = MAP_FAILED;
+    if ((posix_fallocate(out_file.fd, 0, m_fileSize) == 0) ||
+        (ftruncate(out_file.fd, m_fileSize) == 0))
+    {
+        // MAP_POPULATE faults every page in now rather than on the first write
+        data = mmap(0, m_fileSize, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, out_file.fd, 0);
+    }
+
+    if (data == MAP_FAILED)
+    {
+        // don't leave a file nobody will write into behind
+        close(out_file.fd);
+        out_file.fd = -1;
+        unlink(path.c_str());
+        return false;
+    }
+
+    out_file.data = static_cast<char*>(data);
+    m_fileCount.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+inline void DummyLoggerMmapSink::Detach(Segment &a_segment, MappedFile &out_file)
+{
+    out_file.data = a_segment.data;
+    out_file.fd = a_segment.fd;
+    out_file.end = a_segment.end;
+    out_file.number = a_segment.number;
+    if (a_segment.fd < 0)
+    {
+        return;
+    }
+    assert(a_segment.full);
+
+    if (a_segment.data != 0)
+    {
+        // writers which reserved their space before the file was full might
+        // still be copying their lines
+        Backoff backoff;
+        while (a_segment.written.load(std::memory_order_acquire) < a_segment.end)
+        {
+            backoff.Wait();
+        }
+    }
+    a_segment.data = 0;
+    a_segment.fd = -1;
+}
+
+inline void DummyLoggerMmapSink::Retire(MappedFile &a_file)
+{
+    if (a_file.fd < 0)
+    {
+        return;
+    }
+
+    if (a_file.data != 0)
+    {
+        munmap(a_file.data, m_fileSize);
+        a_file.data = 0;
+    }
+
+    // the kernel takes care of writing the pages back
+    int rv = ftruncate(a_file.fd, a_file.end);
+    assert(rv == 0);
+    (void) rv;
+    close(a_file.fd);
+    a_file.fd = -1;
+}
+
+inline void DummyLoggerMmapSink::BackgroundRoutine()
+{
+    while (!m_stop.load())
+    {
+        bool forceRotation = false;
+        bool prepare = false;
+        MappedFile retired[DUMMYLOGGER_MMAP_SINK_SEGMENTS];
+        int retiredCount = 0;
+        uint64_t position = m_position.load(std::memory_order_relaxed);
+        uint64_t generation = position >> POSITION_SHIFT;
+        uint64_t offset = position & POSITION_OFFSET_MASK;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            // files writers are done with
+            for (int i = 0; i < DUMMYLOGGER_MMAP_SINK_SEGMENTS; i++)
+            {
+                Segment &segment = m_segments[i];
+                if (segment.full && (segment.fd >= 0) &&
+                    (segment.written.load(std::memory_order_acquire) >= segment.end))
+                {
+                    Detach(segment, retired[retiredCount++]);
+                }
+            }
+
+            // the next file, unless a writer is already creating one
+            prepare = (m_prepared.data == 0) && !m_creating;
+            if (prepare)
+            {
+                m_creating = true;
+            }
+
+            Segment &current = m_segments[generation % DUMMYLOGGER_MMAP_SINK_SEGMENTS];
+            if ((m_rotationNsecs > 0) && !current.full &&
+                (RealClock::Now() >= current.deadline))
+            {
+                if (offset == 0)
+                {
+                    // empty files are not rotated
+                    current.deadline += m_rotationNsecs;
+                }
+                else
+                {
+                    forceRotation = true;
+                }
+            }
+        }
+
+        // unmapping, truncating and creating files takes long. Writers
+        // rotating in the meantime must not wait for it
+        for (int i = 0; i < retiredCount; i++)
+        {
+            Retire(retired[i]);
+        }
+
+        if (prepare)
+        {
+            MappedFile prepared;
+            bool created = CreateFile(prepared);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                // only this thread fills m_prepared in
+                assert(m_prepared.data == 0);
+                if (created)
+                {
+                    m_prepared = prepared;
+                }
+                m_creating = false;
+            }
+            // writers which were waiting for it to rotate
+            m_createdCond.notify_all();
+        }
+
+        // reserve everything left in the file, as if a huge line was written
+        while (forceRotation)
+        {
+            if (((position >> POSITION_SHIFT) != generation) ||
+                ((position & POSITION_OFFSET_MASK) > m_fileSize))
+            {
+                // it filled up in the meantime
+                break;
+            }
+
+            if (m_position.compare_exchange_weak(
+                    position, (generation << POSITION_SHIFT) | (m_fileSize + 1)))
+            {
+                Rotate(generation, position & POSITION_OFFSET_MASK);
+                break;
+            }
+        }
+
+        std::this_thread::sleep_for(
+            std::chrono::microseconds(DUMMYLOGGER_MMAP_SINK_POLL_USEC));
+    }
+}
+
+#endif /* _DUMMYLOGGERMMAPSINK_H_ */
@@ -0,0 +1,708 @@
+// ============================================================================
+// Copyright (c) 2026 Faustino Frechilla
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+/// @file dummylogger_ring.h
+/// @brief The per-thread buffers used by DummyLogger
+///
+/// Every thread logging in asynchronous mode owns a ring (a single producer
+/// lock-free queue) where each argument streamed into the logger is copied as
+/// a fixed size record. The background thread of the logger is the only
+/// consumer of all the rings. Records are turned into text by the consumer,
+/// so the calling thread only pays for a copy of the arguments.
+///
+/// Binary log entries (see dummylogger_binary.h) travel through the same
+/// rings, split in as many records as needed. They are pushed whole or not
+/// at all
+///
+/// Text lines are never torn. The background thread formats the records of
+/// each ring into a pending line of that ring, and only writes it out once
+/// its std::endl has been popped (or the text ends in '\n', or the thread
+/// which owned the ring has finished). In synchronous mode each thread assembles
+/// its lines in its own DummyLoggerLine instead
+///
+/// Lines look the same in both modes: manipulators (std::hex, std::setw,
+/// std::setfill...) are replayed by the background thread on the pending
+/// line, and enums are printed by their own operator<< if they have one or
+/// as their underlying type otherwise
+///
+/// @author Faustino Frechilla
+/// @history
+/// Ref       Who                When         What
+///           Faustino Frechilla 17-Oct-2026  Original development
+///           Faustino Frechilla 17-Oct-2026  Binary log entries
+///           Faustino Frechilla 17-Oct-2026  Whole lines (DummyLoggerLine)
+///           Faustino Frechilla 17-Oct-2026  Enums and <iomanip> as in sync mode
+///           Faustino Frechilla 17-Oct-2026  Lines ending in '\n' and exiting threads
+///           Faustino Frechilla 17-Oct-2026  Rings reset for their next owner
+/// @endhistory
+///
+// ============================================================================
+
+#ifndef _DUMMYLOGGERRING_H_
+#define _DUMMYLOGGERRING_H_
+
+#include <stdint.h>   // types (uint64_t...)
+#include <string.h>   // memcpy
+#include <iostream>
+#include <iomanip>    // std::setw, std::setfill...
+#include <sstream>    // std::ostringstream
+#include <utility>    // std::declval
+#include <string>
+#include <atomic>
+#include <type_traits>
+#include "lock_free_queue.h"
+#include "replicated_singleton.h"
+#include "dummylogger_sink.h"
+
+// number of records each per-thread ring can hold (minus 1). Power of 2
+#ifndef DUMMYLOGGER_RING_SIZE
+#define DUMMYLOGGER_RING_SIZE 4096 // (2^12)
+#endif
+
+// bytes of text carried by a single record. Longer strings are split into
+// several records. It makes a record exactly 64 bytes long
+#define DUMMYLOG_RECORD_TEXT_SIZE 56
+
+/// @brief what the logger does when the ring of the calling thread is full
+enum DummyLoggerFullRingPolicy_t
+{
+    /// the calling thread waits until the background thread makes room.
+    /// Nothing is lost, but the hot path stalls while the output is slow
+    DUMMYLOGGER_FULL_RING_BLOCK,
+    /// the record is dropped, along with the rest of its line (up to the
+    /// next std::endl) and counted. The hot path never stalls, but lines
+    /// already started might come out truncated
+    DUMMYLOGGER_FULL_RING_DROP
+};
+
+namespace dummylogger_detail
+{
+    /// @brief what the fallback below returns
+    struct NoStreamOperator {};
+
+    /// @brief an exact match for any enum, but a template. It loses against
+    /// an operator<< written for the enum and wins against the built-in
+    /// conversion to int. Never defined: only used by HasStreamOperator
+    template <typename E>
+    typename std::enable_if<std::is_enum<E>::value, NoStreamOperator>::type
+    operator<<(std::ostream&, const E&);
+
+    /// @brief true if the enum E has an operator<< of its own
+    template <typename E>
+    struct HasStreamOperator
+    {
+        static const bool value = !std::is_same<
+            decltype(std::declval<std::ostream&>() << std::declval<const E&>()),
+            NoStreamOperator>::value;
+    };
+}
+
+/// @brief a single argument streamed into the logger
+struct DummyLogRecord
+{
+    typedef std::ostream& (*StreamManipulator_t)(std::ostream&);
+    typedef std::ios_base& (*IosManipulator_t)(std::ios_base&);
+
+    enum Type_t
+    {
+        TYPE_INT64,
+        TYPE_UINT64,
+        TYPE_DOUBLE,
+        TYPE_CHAR,
+        TYPE_BOOL,
+        TYPE_POINTER,
+        /// (a piece of) a string. Its length is in 'length'
+        TYPE_TEXT,
+        /// std::endl. The output is flushed once per batch, not per line
+        TYPE_ENDL,
+        /// std::flush. Same as above
+        TYPE_FLUSH,
+        /// any other std::ostream manipulator
+        TYPE_STREAM_MANIPULATOR,
+        /// std::ios_base manipulators (std::hex, std::fixed...)
+        TYPE_IOS_MANIPULATOR,
+        /// (a piece of) a binary log entry. Not written to the text stream
+        TYPE_BINARY,
+        /// std::setw. The width is in 'i64'
+        TYPE_WIDTH,
+        /// std::setprecision. The precision is in 'i64'
+        TYPE_PRECISION,
+        /// std::setfill. The character is in 'chr'
+        TYPE_FILL,
+        /// std::setiosflags. The flags to set are in 'i64'
+        TYPE_SETF,
+        /// std::resetiosflags. The flags to clear are in 'i64'
+        TYPE_UNSETF,
+        /// std::setbase. The std::ios_base::basefield bits are in 'i64'
+        TYPE_BASEFIELD,
+        /// the thread which owned the ring has finished. What is left of
+        /// its line is written and the format is reset for the next owner
+        TYPE_THREAD_EXIT
+    };
+
+    enum Flags_t
+    {
+        /// more pieces of the same binary entry or string follow
+        FLAG_MORE = 0x01
+    };
+
+    uint8_t type;
+    uint8_t length;
+    uint8_t flags;
+    union
+    {
+        int64_t i64;
+        uint64_t u64;
+        double dbl;
+        char chr;
+        bool bln;
+        const void* ptr;
+        StreamManipulator_t streamManipulator;
+        IosManipulator_t iosManipulator;
+        char text[DUMMYLOG_RECORD_TEXT_SIZE];
+    } value;
+
+    /// @brief writes the record into a_stream
+    inline void Format(std::ostream &a_stream) const
+    {
+        switch (type)
+        {
+        case TYPE_INT64:   a_stream << value.i64; break;
+        case TYPE_UINT64:  a_stream << value.u64; break;
+        case TYPE_DOUBLE:  a_stream << value.dbl; break;
+        case TYPE_CHAR:    a_stream << value.chr; break;
+        case TYPE_BOOL:    a_stream << value.bln; break;
+        case TYPE_POINTER: a_stream << value.ptr; break;
+        case TYPE_TEXT:    a_stream.write(value.text, length); break;
+        case TYPE_ENDL:    a_stream << '\n'; break;
+        case TYPE_FLUSH:   break;
+        case TYPE_STREAM_MANIPULATOR: value.streamManipulator(a_stream); break;
+        case TYPE_IOS_MANIPULATOR:    value.iosManipulator(a_stream); break;
+        case TYPE_WIDTH:     a_stream.width(static_cast<std::streamsize>(value.i64)); break;
+        case TYPE_PRECISION: a_stream.precision(static_cast<std::streamsize>(value.i64)); break;
+        case TYPE_FILL:      a_stream.fill(value.chr); break;
+        case TYPE_SETF:
+            a_stream.setf(static_cast<std::ios_base::fmtflags>(value.i64));
+            break;
+        case TYPE_UNSETF:
+            a_stream.unsetf(static_cast<std::ios_base::fmtflags>(value.i64));
+            break;
+        case TYPE_BASEFIELD:
+            a_stream.setf(static_cast<std::ios_base::fmtflags>(value.i64), std::ios_base::basefield);
+            break;
+        default: break;
+        }
+    }
+};
+
+/// @brief the stream a line is assembled into. It can tell whether what
+/// has been written so far ends a line without copying it
+class DummyLogLineStream : public std::ostream
+{
+public:
+    DummyLogLineStream():
+        std::ostream(0),
+        m_buffer()
+    {
+        rdbuf(&m_buffer);
+    }
+
+    /// @return a copy of what has been written so far
+    inline std::string str() const
+    {
+        return m_buffer.str();
+    }
+
+    /// @brief replaces what has been written so far with a_text
+    inline void str(const std::string &a_text)
+    {
+        m_buffer.str(a_text);
+    }
+
+    /// @return true if the last character written is '\n'
+    inline bool EndsLine() const
+    {
+        return m_buffer.EndsLine();
+    }
+
+    /// @brief sets flags, width, precision and fill back to the defaults
+    inline void ResetFormat()
+    {
+        flags(std::ios_base::skipws | std::ios_base::dec);
+        width(0);
+        precision(6);
+        fill(' ');
+    }
+
+private:
+    /// @brief a std::stringbuf which gives access to its last character
+    class Buffer : public std::stringbuf
+    {
+    public:
+        inline bool EndsLine() const
+        {
+            return (pptr() > pbase()) && (*(pptr() - 1) == '\n');
+        }
+    };
+
+    Buffer m_buffer;
+};
+
+/// @brief the ring of a thread logging in asynchronous mode
+class DummyLoggerRing : public PerThreadSingleton<DummyLoggerRing>
+{
+public:
+    typedef ArrayLockFreeQueue<DummyLogRecord, DUMMYLOGGER_RING_SIZE> Queue_t;
+
+    /// @brief copies a_value into the ring as one or more records
+    template <typename T>
+    inline void Append(const T &a_value, DummyLoggerFullRingPolicy_t a_policy)
+    {
+        AppendValue(a_value, a_policy, typename Category<T>::type());
+    }
+
+    /// @brief pushes a record into the ring following a_policy if full
+    inline void Push(const DummyLogRecord &a_record, DummyLoggerFullRingPolicy_t a_policy)
+    {
+        if (m_droppingLine)
+        {
+            m_droppedRecords.fetch_add(1, std::memory_order_relaxed);
+            if (a_record.type == DummyLogRecord::TYPE_ENDL)
+            {
+                // try to terminate the truncated line
+                m_droppingLine = !m_queue.push(a_record);
+            }
+            return;
+        }
+
+        Backoff backoff;
+        while (!m_queue.push(a_record))
+        {
+            if (a_policy == DUMMYLOGGER_FULL_RING_DROP)
+            {
+                m_droppedRecords.fetch_add(1, std::memory_order_relaxed);
+                m_droppingLine = (a_record.type != DummyLogRecord::TYPE_ENDL);
+                return;
+            }
+
+            // DUMMYLOGGER_FULL_RING_BLOCK: let the background thread run
+            backoff.Wait();
+        }
+    }
+
+    /// @brief pushes a binary log entry into the ring. The entry is pushed
+    /// whole, so with DUMMYLOGGER_FULL_RING_DROP it is dropped (and its
+    /// records counted) if there isn't room for all of it
+    inline void PushBinary(
+        const char* a_entry, std::size_t a_size, DummyLoggerFullRingPolicy_t a_policy)
+    {
+        std::size_t records = (a_size + DUMMYLOG_RECORD_TEXT_SIZE - 1) / DUMMYLOG_RECORD_TEXT_SIZE;
+        if (a_policy == DUMMYLOGGER_FULL_RING_DROP)
+        {
+            // the background thread can only make the ring emptier, so
+            // this is a safe estimate of the room left
+            std::size_t room = (DUMMYLOGGER_RING_SIZE - 1) - m_queue.size();
+            if (room < records)
+            {
+                m_droppedRecords.fetch_add(records, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        DummyLogRecord record;
+        record.type = DummyLogRecord::TYPE_BINARY;
+        while (a_size > 0)
+        {
+            std::size_t length = (a_size > DUMMYLOG_RECORD_TEXT_SIZE) ?
+                DUMMYLOG_RECORD_TEXT_SIZE : a_size;
+            memcpy(record.value.text, a_entry, length);
+            record.length = static_cast<uint8_t>(length);
+            record.flags  = (a_size > length) ? DummyLogRecord::FLAG_MORE : 0;
+
+            Backoff backoff;
+            while (!m_queue.push(record))
+            {
+                backoff.Wait();
+            }
+
+            a_entry += length;
+            a_size  -= length;
+        }
+    }
+
+    /// @brief pops a record. Only called by the background thread
+    inline bool Pop(DummyLogRecord &out_record)
+    {
+        return m_queue.pop(out_record);
+    }
+
+    /// @brief the line being assembled by the background thread out of
+    ///        the records of this ring. Only used by the background thread
+    inline DummyLogLineStream& PendingLine()
+    {
+        return m_pendingLine;
+    }
+
+    /// @brief formats a record popped from this ring into its pending line.
+    /// Only used by the background thread
+    inline void Format(const DummyLogRecord &a_record)
+    {
+        if (a_record.type == DummyLogRecord::TYPE_TEXT)
+        {
+            if (m_pendingText.empty() && (m_pendingLine.width() == 0) &&
+                !(a_record.flags & DummyLogRecord::FLAG_MORE))
+            {
+                // the whole string, and no padding to worry about
+                m_pendingLine.write(a_record.value.text, a_record.length);
+                return;
+            }
+
+            // strings are padded as a whole (std::setw), so they are put
+            // together before they are formatted
+            m_pendingText.append(a_record.value.text, a_record.length);
+            if (!(a_record.flags & DummyLogRecord::FLAG_MORE))
+            {
+                // the end of the string. Empty strings are padded too
+                m_pendingLine << m_pendingText;
+                m_pendingText.clear();
+            }
+            return;
+        }
+
+        if (!m_pendingText.empty())
+        {
+            // what is left of a string whose end was dropped
+            m_pendingLine << m_pendingText;
+            m_pendingText.clear();
+        }
+        a_record.Format(m_pendingLine);
+    }
+
+    /// @return records dropped because the ring was full
+    inline uint64_t DroppedRecords() const
+    {
+        return m_droppedRecords.load(std::memory_order_relaxed);
+    }
+
+private:
+    /// categories of the types that can be streamed into the logger
+    struct IntegerTag {};
+    struct UnsignedTag {};
+    struct FloatTag {};
+    struct CharTag {};
+    struct BoolTag {};
+    struct TextTag {};
+    struct PointerTag {};
+    struct IosManipulatorTag {};
+    struct IomanipTag {};
+    struct OtherTag {};
+
+    /// the types returned by the manipulators of <iomanip>
+    typedef decltype(std::setw(0))          Setw_t;
+    typedef decltype(std::setprecision(0))  Setprecision_t;
+    typedef decltype(std::setfill('\0'))    Setfill_t;
+    typedef decltype(std::setbase(0))       Setbase_t;
+    typedef decltype(std::setiosflags(std::ios_base::fmtflags()))   Setiosflags_t;
+    typedef decltype(std::resetiosflags(std::ios_base::fmtflags())) Resetiosflags_t;
+
+    /// enums with an operator<< of their own are formatted by it (by the
+    /// calling thread). The rest are printed as their underlying type
+    template <typename D, bool IS_ENUM = std::is_enum<D>::value>
+    struct EnumCategory
+    {
+        typedef OtherTag type;
+    };
+
+    template <typename D>
+    struct EnumCategory<D, true>
+    {
+        typedef typename std::conditional<dummylogger_detail::HasStreamOperator<D>::value, OtherTag,
+                typename std::conditional<std::is_signed<typename std::underlying_type<D>::type>::value,
+                                          IntegerTag, UnsignedTag>::type>::type type;
+    };
+
+    template <typename T>
+    struct Category
+    {
+        typedef typename std::decay<T>::type D;
+        typedef typename std::conditional<std::is_same<D, bool>::value, BoolTag,
+                typename std::conditional<std::is_same<D, char>::value ||
+                                          std::is_same<D, signed char>::value ||
+                                          std::is_same<D, unsigned char>::value, CharTag,
+                typename std::conditional<std::is_same<D, char*>::value ||
+                                          std::is_same<D, const char*>::value ||
+                                          std::is_same<D, std::string>::value, TextTag,
+                typename std::conditional<std::is_same<D, DummyLogRecord::IosManipulator_t>::value,
+                                          IosManipulatorTag,
+                typename std::conditional<std::is_same<D, Setw_t>::value ||
+                                          std::is_same<D, Setprecision_t>::value ||
+                                          std::is_same<D, Setfill_t>::value ||
+                                          std::is_same<D, Setbase_t>::value ||
+                                          std::is_same<D, Setiosflags_t>::value ||
+                                          std::is_same<D, Resetiosflags_t>::value, IomanipTag,
+                typename std::conditional<std::is_integral<D>::value &&
+                                          std::is_signed<D>::value, IntegerTag,
+                typename std::conditional<std::is_integral<D>::value, UnsignedTag,
+                typename std::conditional<std::is_floating_point<D>::value, FloatTag,
+                typename std::conditional<std::is_pointer<D>::value, PointerTag,
+                typename EnumCategory<D>::type>::type>::type>::type>::type>::type>::type>::type>::type>::type type;
+    };
+
+    /// the queue of records. Only this thread pushes into it
+    Queue_t m_queue;
+
+    /// true while the rest of a line is being dropped
+    bool m_droppingLine;
+
+    /// records dropped because the ring was full
+    std::atomic<uint64_t> m_droppedRecords;
+
+    /// see PendingLine
+    DummyLogLineStream m_pendingLine;
+
+    /// pieces of a string waiting for the rest of it (background thread)
+    std::string m_pendingText;
+
+    /// the manipulators of <iomanip> are applied to it to find out what
+    /// they do. It has no buffer: nothing is ever written into it
+    std::ostream m_scratch;
+
+    DummyLoggerRing():
+        m_queue(),
+        m_droppingLine(false),
+        m_droppedRecords(0),
+        m_pendingLine(),
+        m_pendingText(),
+        m_scratch(0)
+    {}
+    ~DummyLoggerRing()
+    {}
+
+    friend class PerThreadSingleton<DummyLoggerRing>;
+
+    /// @brief stops dropping the line of the exiting thread and pushes a
+    /// TYPE_THREAD_EXIT record, so the background thread gets the pending
+    /// line ready for the next owner. It is defined in dummylogger.h, since
+    /// it has to know whether the background thread is running
+    virtual void OnThreadExit();
+
+    template <typename T>
+    inline void AppendValue(const T &a_value, DummyLoggerFullRingPolicy_t a_policy, IntegerTag)
+    {
+        DummyLogRecord record;
+        record.type = DummyLogRecord::TYPE_INT64;
+        record.value.i64 = static_cast<int64_t>(a_value);
+        Push(record, a_policy);
+    }
+
+    template <typename T>
+    inline void AppendValue(const T &a_value, DummyLoggerFullRingPolicy_t a_policy, UnsignedTag)
+    {
+        DummyLogRecord record;
+        record.type = DummyLogRecord::TYPE_UINT64;
+        record.value.u64 = static_cast<uint64_t>(a_value);
+        Push(record, a_policy);
+    }
+
+    template <typename T>
+    inline void AppendValue(const T &a_value, DummyLoggerFullRingPolicy_t a_policy, FloatTag)
+    {
+        DummyLogRecord record;
+        record.type = DummyLogRecord::TYPE_DOUBLE;
+        record.value.dbl = static_cast<double>(a_value);
+        Push(record, a_policy);
+    }
+
+    template <typename T>
+    inline void AppendValue(const T &a_value, DummyLoggerFullRingPolicy_t a_policy, CharTag)
+    {
+        DummyLogRecord record;
+        record.type = DummyLogRecord::TYPE_CHAR;
+        record.value.chr = static_cast<char>(a_value);
+        Push(record, a_policy);
+    }
+
+    template <typename T>
+    inline void AppendValue(const T &a_value, DummyLoggerFullRingPolicy_t a_policy, BoolTag)
+    {
+        DummyLogRecord record;
+        record.type = DummyLogRecord::TYPE_BOOL;
+        record.value.bln = a_value;
+        Push(record, a_policy);
+    }
+
+    template <typename T>
+    inline void AppendValue(const T &a_value, DummyLoggerFullRingPolicy_t a_policy, PointerTag)
+    {
+        DummyLogRecord record;
+        record.type = DummyLogRecord::TYPE_POINTER;
+        record.value.ptr = static_cast<const void*>(a_value);
+        Push(record, a_policy);
+    }
+
+    template <typename T>
+    inline void AppendValue(const T &a_value, DummyLoggerFullRingPolicy_t a_policy, IosManipulatorTag)
+    {
+        DummyLogRecord record;
+        record.type = DummyLogRecord::TYPE_IOS_MANIPULATOR;
+        record.value.iosManipulator = a_value;
+        Push(record, a_policy);
+    }
+
+    inline void AppendValue(const Setw_t &a_value, DummyLoggerFullRingPolicy_t a_policy, IomanipTag)
+    {
+        m_scratch << a_value;
+        PushStreamState(DummyLogRecord::TYPE_WIDTH, m_scratch.width(), a_policy);
+    }
+
+    inline void AppendValue(const Setprecision_t &a_value, DummyLoggerFullRingPolicy_t a_policy, IomanipTag)
+    {
+        m_scratch << a_value;
+        PushStreamState(DummyLogRecord::TYPE_PRECISION, m_scratch.precision(), a_policy);
+    }
+
+    inline void AppendValue(const Setfill_t &a_value, DummyLoggerFullRingPolicy_t a_policy, IomanipTag)
+    {
+        m_scratch << a_value;
+        DummyLogRecord record;
+        record.type = DummyLogRecord::TYPE_FILL;
+        record.value.chr = m_scratch.fill();
+        Push(record, a_policy);
+    }
+
+    inline void AppendValue(const Setbase_t &a_value, DummyLoggerFullRingPolicy_t a_policy, IomanipTag)
+    {
+        m_scratch.flags(std::ios_base::fmtflags());
+        m_scratch << a_value;
+        PushStreamState(DummyLogRecord::TYPE_BASEFIELD,
+                        m_scratch.flags() & std::ios_base::basefield, a_policy);
+    }
+
+    inline void AppendValue(const Setiosflags_t &a_value, DummyLoggerFullRingPolicy_t a_policy, IomanipTag)
+    {
+        // the flags which end up set
+        m_scratch.flags(std::ios_base::fmtflags());
+        m_scratch << a_value;
+        PushStreamState(DummyLogRecord::TYPE_SETF, m_scratch.flags(), a_policy);
+    }
+
+    inline void AppendValue(const Resetiosflags_t &a_value, DummyLoggerFullRingPolicy_t a_policy, IomanipTag)
+    {
+        // the flags which end up cleared
+        m_scratch.flags(~std::ios_base::fmtflags());
+        m_scratch << a_value;
+        PushStreamState(DummyLogRecord::TYPE_UNSETF, ~m_scratch.flags(), a_policy);
+    }
+
+    inline void PushStreamState(
+        DummyLogRecord::Type_t a_type, int64_t a_value, DummyLoggerFullRingPolicy_t a_policy)
+    {
+        DummyLogRecord record;
+        record.type = static_cast<uint8_t>(a_type);
+        record.value.i64 = a_value;
+        Push(record, a_policy);
+    }
+
+    inline void AppendValue(const std::string &a_value, DummyLoggerFullRingPolicy_t a_policy, TextTag)
+    {
+        AppendText(a_value.data(), a_value.size(), a_policy);
+    }
+
+    inline void AppendValue(const char* a_value, DummyLoggerFullRingPolicy_t a_policy, TextTag)
+    {
+        AppendText(a_value, (a_value == 0) ? 0 : strlen(a_value), a_policy);
+    }
+
+    /// @brief types with their own operator<< are formatted by the calling
+    /// thread. Only the resulting text is copied into the ring
+    template <typename T>
+    inline void AppendValue(const T &a_value, DummyLoggerFullRingPolicy_t a_policy, OtherTag)
+    {
+        std::ostringstream stream;
+        stream << a_value;
+        AppendValue(stream.str(), a_policy, TextTag());
+    }
+
+    inline void AppendText(const char* a_text, std::size_t a_length, DummyLoggerFullRingPolicy_t a_policy)
+    {
+        // an empty string is a record too: it still uses up the width set
+        // by std::setw
+        DummyLogRecord record;
+        record.type = DummyLogRecord::TYPE_TEXT;
+        do
+        {
+            std::size_t length = (a_length > DUMMYLOG_RECORD_TEXT_SIZE) ?
+                DUMMYLOG_RECORD_TEXT_SIZE : a_length;
+            memcpy(record.value.text, a_text, length);
+            record.length = static_cast<uint8_t>(length);
+            record.flags  = (a_length > length) ? DummyLogRecord::FLAG_MORE : 0;
+            Push(record, a_policy);
+
+            a_text   += length;
+            a_length -= length;
+        }
+        while (a_length > 0);
+    }
+};
+
+/// @brief the line being assembled by a thread logging in synchronous mode
+/// It is written to the output stream in a single call once complete, or
+/// once the text streamed so far ends in '\n'
+class DummyLoggerLine : public PerThreadSingleton<DummyLoggerLine>
+{
+public:
+    /// @brief where the arguments of the current line are formatted into.
+    /// Formatting flags (std::hex...) stick to the thread, not to the output
+    inline DummyLogLineStream& Stream()
+    {
+        return m_stream;
+    }
+
+    /// @brief writes the line assembled so far into a_sink and starts a
+    ///        new one
+    inline void Commit(DummyLoggerSink &a_sink)
+    {
+        std::string line = m_stream.str();
+        if (!line.empty())
+        {
+            a_sink.Write(line.data(), line.size());
+            m_stream.str(std::string());
+        }
+    }
+
+private:
+    DummyLogLineStream m_stream;
+
+    DummyLoggerLine():
+        m_stream()
+    {}
+    ~DummyLoggerLine()
+    {}
+
+    /// @brief writes what is left of the line of the exiting thread and
+    /// resets the format, so the next thread starts from scratch. It is
+    /// defined in dummylogger.h, since it writes into the sink of the logger
+    virtual void OnThreadExit();
+
+    friend class PerThreadSingleton<DummyLoggerLine>;
+};
+
+#endif /* _DUMMYLOGGERRING_H_ */
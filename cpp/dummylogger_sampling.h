@@ -0,0 +1,253 @@
+// ============================================================================
+// Copyright (c) 2026 Faustino Frechilla
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+/// @file dummylogger_sampling.h
+/// @brief State of the sampled and rate limited log statements of DummyLogger
+///
+/// Every DLOG_SAMPLED, DLOG_FIRST_N, DLOG_EVERY_N and DLOG_RATE_LIMITED call
+/// site owns a static DummyLogSite. Deciding whether a line is logged costs a
+/// relaxed fetch-and-add on it (plus a coarse clock read when rate limited).
+///
+/// Sites register themselves in a global list the first time they suppress a
+/// line, so DummyLogger can report how many lines each of them suppressed
+///
+/// @author Faustino Frechilla
+/// @history
+/// Ref       Who                When         What
+///           Faustino Frechilla 17-Oct-2026  Original development
+/// @endhistory
+///
+// ============================================================================
+
+#ifndef _DUMMYLOGGERSAMPLING_H_
+#define _DUMMYLOGGERSAMPLING_H_
+
+#include <stdint.h>   // types (uint64_t...)
+#include <time.h>     // clock_gettime
+#include <atomic>
+
+/// @brief the state of a sampled or rate limited call site
+class DummyLogSite
+{
+public:
+    enum Kind_t
+    {
+        KIND_SAMPLED,
+        KIND_RATE_LIMITED
+    };
+
+    /// @brief constexpr, so a static DummyLogSite is initialised at compile
+    /// time and its function has no guard to check on every call
+    constexpr DummyLogSite(const char* a_file, uint32_t a_line):
+        m_state(0),
+        m_windowSuppressed(0),
+        m_registered(false),
+        m_kind(KIND_SAMPLED),
+        m_first(0),
+        m_every(0),
+        m_reported(0),
+        m_next(0),
+        m_file(a_file),
+        m_line(a_line)
+    {}
+
+    /// @brief counts a hit of a sampled site
+    /// @param a_first the first a_first hits are logged
+    /// @param a_every after those, one of every a_every hits is logged.
+    ///        0 to log none
+    /// @param out_hits hits before this one
+    /// @return true if this hit is to be logged
+    inline bool Sample(uint64_t a_first, uint64_t a_every, uint64_t &out_hits)
+    {
+        out_hits = m_state.fetch_add(1, std::memory_order_relaxed);
+        return (out_hits < a_first) ||
+               ((a_every > 0) && (((out_hits - a_first) % a_every) == 0));
+    }
+
+    /// @brief counts a hit of a rate limited site. The state is made of the
+    /// current second (upper 32 bits) and the hits during it (lower 32 bits)
+    /// @param a_perSecond up to this many hits per second are logged
+    /// @param out_hits hits before this one during the current second
+    /// @return true if this hit is to be logged
+    inline bool RateLimit(uint32_t a_perSecond, uint64_t &out_hits)
+    {
+        uint64_t now = NowSecs();
+        uint64_t state = m_state.fetch_add(1, std::memory_order_relaxed);
+        if ((state >> 32) == now)
+        {
+            out_hits = state & 0xffffffffULL;
+            return out_hits < a_perSecond;
+        }
+
+        return NewWindow(now, state, a_perSecond, out_hits);
+    }
+
+    /// @return true if the site is in the list of sites (Head)
+    inline bool IsRegistered() const
+    {
+        return m_registered.load(std::memory_order_relaxed);
+    }
+
+    /// @brief adds the site to the list of sites. Called the first time a
+    /// line is suppressed. The parameters are needed by Suppressed
+    void Register(Kind_t a_kind, uint64_t a_first, uint64_t a_every)
+    {
+        if (m_registered.exchange(true))
+        {
+            return;
+        }
+
+        m_kind = a_kind;
+        m_first = a_first;
+        m_every = a_every;
+
+        DummyLogSite* head = Registry<>::s_head.load(std::memory_order_relaxed);
+        do
+        {
+            m_next = head;
+        } while (!Registry<>::s_head.compare_exchange_weak(
+                     head, this, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    /// @return number of lines suppressed by this site so far
+    uint64_t Suppressed() const
+    {
+        uint64_t state = m_state.load(std::memory_order_relaxed);
+        if (m_kind == KIND_RATE_LIMITED)
+        {
+            uint64_t hits = state & 0xffffffffULL;
+            return m_windowSuppressed.load(std::memory_order_relaxed) +
+                   ((hits > m_first) ? (hits - m_first) : 0);
+        }
+
+        uint64_t logged = (state < m_first) ? state : m_first;
+        if ((state > m_first) && (m_every > 0))
+        {
+            logged += ((state - m_first - 1) / m_every) + 1;
+        }
+        return state - logged;
+    }
+
+    /// @brief suppressed lines reported so far. Only used by the reporter
+    inline uint64_t& Reported()
+    {
+        return m_reported;
+    }
+
+    inline const char* File() const
+    {
+        return m_file;
+    }
+
+    inline uint32_t Line() const
+    {
+        return m_line;
+    }
+
+    /// @return the last site registered. Sites registered before it follow
+    static inline DummyLogSite* Head()
+    {
+        return Registry<>::s_head.load(std::memory_order_acquire);
+    }
+
+    inline DummyLogSite* Next() const
+    {
+        return m_next;
+    }
+
+    /// @return seconds of a coarse monotonic clock (a few nanoseconds to read)
+    static inline uint64_t NowSecs()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        return static_cast<uint64_t>(ts.tv_sec);
+    }
+
+private:
+    /// @brief hits (sampled) or second and hits (rate limited)
+    std::atomic<uint64_t> m_state;
+
+    /// @brief lines suppressed during the seconds which are over
+    std::atomic<uint64_t> m_windowSuppressed;
+
+    std::atomic<bool> m_registered;
+
+    // set once, when the site is registered
+    Kind_t m_kind;
+    uint64_t m_first; // a_perSecond when rate limited
+    uint64_t m_every;
+
+    uint64_t m_reported;
+    DummyLogSite* m_next;
+    const char* m_file;
+    uint32_t m_line;
+
+    /// @brief head of the list of sites. A template only so the static
+    /// member can be defined in this header
+    template <int DUMMY_T = 0>
+    struct Registry
+    {
+        static std::atomic<DummyLogSite*> s_head;
+    };
+
+    /// @brief starts the count of a new second, unless another thread did
+    /// already. The hits over the limit of the old one are saved
+    /// @param a_oldState the state RateLimit found, before its own hit
+    /// @return true if this hit is to be logged
+    __attribute__((noinline)) bool NewWindow(
+        uint64_t a_now, uint64_t a_oldState, uint32_t a_perSecond, uint64_t &out_hits)
+    {
+        uint64_t state = a_oldState + 1;
+        while ((state >> 32) != a_now)
+        {
+            if (m_state.compare_exchange_weak(
+                    state, (a_now << 32) | 1, std::memory_order_relaxed))
+            {
+                // the hit added by RateLimit belongs to the new second
+                uint64_t hits = state & 0xffffffffULL;
+                if ((state >> 32) == (a_oldState >> 32))
+                {
+                    hits--;
+                }
+                if (hits > a_perSecond)
+                {
+                    m_windowSuppressed.fetch_add(hits - a_perSecond, std::memory_order_relaxed);
+                }
+
+                out_hits = 0;
+                return true;
+            }
+        }
+
+        // another thread started the second. Count this hit in it
+        out_hits = m_state.fetch_add(1, std::memory_order_relaxed) & 0xffffffffULL;
+        return out_hits < a_perSecond;
+    }
+
+    // prevent copying
+    DummyLogSite(const DummyLogSite&);
+    DummyLogSite& operator=(const DummyLogSite&);
+};
+
+template <int DUMMY_T>
+std::atomic<DummyLogSite*> DummyLogSite::Registry<DUMMY_T>::s_head(0);
+
+#endif /* _DUMMYLOGGERSAMPLING_H_ */
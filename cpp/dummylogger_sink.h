@@ -0,0 +1,92 @@
+// ============================================================================
+// Copyright (c) 2026 Faustino Frechilla
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+/// @file dummylogger_sink.h
+/// @brief Where DummyLogger writes its text lines to
+///
+/// A sink receives whole lines, one call per line. By default DummyLogger
+/// writes into std::cout through a DummyLoggerStreamSink. See
+/// dummylogger_mmap_sink.h for a sink that writes into memory mapped files
+///
+/// @author Faustino Frechilla
+/// @history
+/// Ref       Who                When         What
+///           Faustino Frechilla 17-Oct-2026  Original development
+/// @endhistory
+///
+// ============================================================================
+
+#ifndef _DUMMYLOGGERSINK_H_
+#define _DUMMYLOGGERSINK_H_
+
+#include <cstddef>  // std::size_t
+#include <iostream>
+
+/// @brief interface of the destinations of the text lines of DummyLogger
+class DummyLoggerSink
+{
+public:
+    virtual ~DummyLoggerSink()
+    {}
+
+    /// @brief writes a line (or a group of them). It might be called by
+    /// several threads at the same time (synchronous mode). Each call must
+    /// end up in the output in one piece
+    virtual void Write(const char* a_data, std::size_t a_size) = 0;
+
+    /// @brief called once per std::endl in synchronous mode and once per
+    /// batch in asynchronous mode
+    virtual void Flush() = 0;
+};
+
+/// @brief writes lines into a std::ostream
+/// Each line is written with one call to write. That is enough to keep lines
+/// from different threads apart when the stream is std::cout (stdio locks
+/// every write) but not in general: a stream which isn't thread safe
+/// can only be used in asynchronous mode
+class DummyLoggerStreamSink : public DummyLoggerSink
+{
+public:
+    explicit DummyLoggerStreamSink(std::ostream &a_stream):
+        m_stream(a_stream)
+    {}
+    virtual ~DummyLoggerStreamSink()
+    {}
+
+    virtual void Write(const char* a_data, std::size_t a_size)
+    {
+        m_stream.write(a_data, a_size);
+    }
+
+    virtual void Flush()
+    {
+        m_stream.flush();
+    }
+
+private:
+    std::ostream &m_stream;
+
+    // prevent copying
+    DummyLoggerStreamSink(const DummyLoggerStreamSink&);
+    DummyLoggerStreamSink& operator=(const DummyLoggerStreamSink&);
+};
+
+#endif /* _DUMMYLOGGERSINK_H_ */
@@ -0,0 +1,341 @@
+// ============================================================================
+// Copyright (c) 2026 Faustino Frechilla
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+/// @file  event_bus.h
+/// @brief This file contains an event bus that routes events by their type
+///
+/// Handlers are Delegates to functions receiving a const reference to the
+/// event. Every event type gets its own MulticastDelegate, so publishing an
+/// event to handlers called in place takes no locks and allocates no memory:
+/// the bus indexes an array with the id of the event type and calls the
+/// handlers it finds there.
+///
+/// Type ids are small integers handed out the first time a type is used,
+/// and kept in a function-local static of EventBus::TypeId<EVENT_T>. The
+/// type, and so the static, is chosen at compile time; no name is hashed or
+/// compared at run time.
+///
+/// Handlers can also be subscribed together with a ConsumerThread of
+/// EventBus::Task_t. Events published to them are copied into a Task_t
+/// and called from the context of that thread. Task_t is an
+/// InplaceDelegate, so the copy itself allocates nothing, but handing the
+/// task over is ConsumerThread's job: its SafeQueue takes a mutex and its
+/// std::deque allocates whenever it grows into a new block. Queued dispatch
+/// is therefore not lock or allocation free; only direct dispatch is. The
+/// event must fit in the task along with the handler; bigger events are a
+/// compile time error. Example of usage:
+///
+/// struct PriceUpdate { uint32_t instrument; double price; };
+///
+/// class Strategy
+/// {
+/// public:
+///     void OnPrice(const PriceUpdate &a_update);
+/// };
+/// /* ... */
+///
+/// EventBus bus;
+/// ConsumerThread<EventBus::Task_t> worker(&EventBus::RunTask);
+/// Strategy strategy;
+/// // called from the context of the publisher
+/// bus.Subscribe(MakeDelegate(&strategy, &Strategy::OnPrice));
+/// // called from the context of worker
+/// bus.Subscribe(MakeDelegate(&strategy, &Strategy::OnPrice), worker);
+///
+/// PriceUpdate update = {7, 101.5};
+/// bus.Publish(update);
+///
+/// @author Faustino Frechilla
+/// @history
+/// Ref        Who                When        What
+///            Faustino Frechilla 17-Oct-2026 Original development
+///            Faustino Frechilla 17-Oct-2026 Too many event types abort
+///            Faustino Frechilla 17-Oct-2026 Documented the cost of queued dispatch
+/// @endhistory
+///
+// ============================================================================
+
+#ifndef _EVENTBUS_H_
+#define _EVENTBUS_H_
+
+#include <stdint.h>      // types (uint32_t...)
+#include <stdio.h>       // fprintf
+#include <stdlib.h>      // abort
+#include <atomic>
+#include <memory>        // std::unique_ptr
+#include <mutex>
+#include <vector>
+#include "delegate/Delegate.h"
+#include "delegate/InplaceDelegate.h"
+#include "delegate/MulticastDelegate.h"
+#include "consumer_thread.h"
+
+/// maximum number of event types used by the program. Using more aborts the
+/// program (in release builds too)
+#ifndef EVENT_BUS_MAX_EVENT_TYPES
+#define EVENT_BUS_MAX_EVENT_TYPES 256
+#endif
+
+/// bytes available for the handler and the copy of the event of a queued
+/// handler. A Delegate takes 24 of them
+#ifndef EVENT_BUS_TASK_SIZE
+#define EVENT_BUS_TASK_SIZE 64
+#endif
+
+class EventBus
+{
+public:
+    /// @brief what handlers subscribed with a ConsumerThread receive
+    typedef InplaceDelegate<void (), EVENT_BUS_TASK_SIZE> Task_t;
+    typedef ConsumerThread<Task_t> DispatchThread_t;
+
+    EventBus():
+        m_mutex(),
+        m_queuedHandlers()
+    {
+        for (uint32_t i = 0; i < EVENT_BUS_MAX_EVENT_TYPES; i++)
+        {
+            m_handlers[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /// @brief nothing can be publishing events when it is destroyed
+    ~EventBus()
+    {
+        for (uint32_t i = 0; i < EVENT_BUS_MAX_EVENT_TYPES; i++)
+        {
+            delete m_handlers[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    /// @brief a_handler will be called from the context of the publisher
+    template <typename EVENT_T>
+    void Subscribe(const Delegate<void (const EVENT_T&)> &a_handler)
+    {
+        GetHandlers<EVENT_T>().Subscribe(a_handler);
+    }
+
+    /// @brief a_handler will be called from the context of a_thread, which
+    /// must live longer than the subscription. Publishing blocks while the
+    /// queue of a_thread is full
+    template <typename EVENT_T>
+    void Subscribe(const Delegate<void (const EVENT_T&)> &a_handler, DispatchThread_t &a_thread)
+    {
+        QueuedHandler<EVENT_T>* queued = new QueuedHandler<EVENT_T>(a_handler, a_thread);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queuedHandlers.push_back(std::unique_ptr<QueuedHandlerBase>(queued));
+        }
+        GetHandlers<EVENT_T>().Subscribe(
+            MakeDelegate(queued, &QueuedHandler<EVENT_T>::OnEvent));
+    }
+
+    /// @brief removes a handler subscribed without a ConsumerThread
+    /// @return false if it was not subscribed
+    template <typename EVENT_T>
+    bool Unsubscribe(const Delegate<void (const EVENT_T&)> &a_handler)
+    {
+        HandlerList<EVENT_T>* list = FindHandlers<EVENT_T>();
+        return (list != 0) && list->Unsubscribe(a_handler);
+    }
+
+    /// @brief removes a handler subscribed with a_thread. Events already
+    /// queued to a_thread are still delivered
+    /// @return false if it was not subscribed
+    template <typename EVENT_T>
+    bool Unsubscribe(const Delegate<void (const EVENT_T&)> &a_handler, DispatchThread_t &a_thread)
+    {
+        HandlerList<EVENT_T>* list = FindHandlers<EVENT_T>();
+        if (list == 0)
+        {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (std::size_t i = 0; i < m_queuedHandlers.size(); i++)
+        {
+            QueuedHandler<EVENT_T>* queued =
+                dynamic_cast<QueuedHandler<EVENT_T>*>(m_queuedHandlers[i].get());
+            if ((queued != 0) && queued->Matches(a_handler, a_thread) &&
+                list->Unsubscribe(MakeDelegate(queued, &QueuedHandler<EVENT_T>::OnEvent)))
+            {
+                // a publish in progress may still be calling it, so it is
+                // not deleted until the bus is. It won't match again
+                queued->Detach();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /// @brief calls every handler of EVENT_T
+    template <typename EVENT_T>
+    void Publish(const EVENT_T &a_event) const
+    {
+        const HandlerList<EVENT_T>* list = FindHandlers<EVENT_T>();
+        if (list != 0)
+        {
+            (*list)(a_event);
+        }
+    }
+
+    /// @return number of handlers of EVENT_T
+    template <typename EVENT_T>
+    std::size_t Subscribers() const
+    {
+        const HandlerList<EVENT_T>* list = FindHandlers<EVENT_T>();
+        return (list != 0) ? list->Size() : 0;
+    }
+
+    /// @brief the consume function of the ConsumerThreads handlers are
+    /// subscribed with
+    static void RunTask(Task_t a_task)
+    {
+        a_task();
+    }
+
+    /// @return the id of EVENT_T. The first type used gets 0, the next one 1...
+    template <typename EVENT_T>
+    static uint32_t TypeId()
+    {
+        static const uint32_t s_id = NewTypeId();
+        return s_id;
+    }
+
+private:
+    class HandlerListBase
+    {
+    public:
+        virtual ~HandlerListBase() {}
+    };
+
+    template <typename EVENT_T>
+    class HandlerList :
+        public HandlerListBase,
+        public MulticastDelegate<void (const EVENT_T&)>
+    {
+    };
+
+    class QueuedHandlerBase
+    {
+    public:
+        virtual ~QueuedHandlerBase() {}
+    };
+
+    /// @brief queues a copy of every event it receives to a ConsumerThread
+    template <typename EVENT_T>
+    class QueuedHandler : public QueuedHandlerBase
+    {
+    public:
+        QueuedHandler(const Delegate<void (const EVENT_T&)> &a_handler, DispatchThread_t &a_thread):
+            m_handler(a_handler),
+            m_thread(&a_thread),
+            m_detached(false)
+        {}
+
+        void OnEvent(const EVENT_T &a_event)
+        {
+            Delegate<void (const EVENT_T&)> handler = m_handler;
+            m_thread->ProduceOrBlock(Task_t([handler, a_event]() { handler(a_event); }));
+        }
+
+        bool Matches(const Delegate<void (const EVENT_T&)> &a_handler, const DispatchThread_t &a_thread) const
+        {
+            return !m_detached && (m_handler == a_handler) && (m_thread == &a_thread);
+        }
+
+        void Detach()
+        {
+            m_detached = true;
+        }
+
+    private:
+        Delegate<void (const EVENT_T&)> m_handler;
+        DispatchThread_t* m_thread;
+        // unsubscribed. Only used under m_mutex
+        bool m_detached;
+    };
+
+    /// @brief the next type id. A template only so the static member can be
+    /// defined in this header
+    template <int DUMMY_T = 0>
+    struct TypeCounter
+    {
+        static std::atomic<uint32_t> s_next;
+    };
+
+    /// @return the next type id. Called once per event type
+    static uint32_t NewTypeId()
+    {
+        uint32_t id = TypeCounter<>::s_next.fetch_add(1, std::memory_order_relaxed);
+        if (id >= EVENT_BUS_MAX_EVENT_TYPES)
+        {
+            // m_handlers can't be indexed with it
+            fprintf(stderr, "EventBus: more than %u event types. "
+                            "Define a bigger EVENT_BUS_MAX_EVENT_TYPES\n",
+                    static_cast<uint32_t>(EVENT_BUS_MAX_EVENT_TYPES));
+            abort();
+        }
+        return id;
+    }
+
+    /// @brief handlers of every event type, indexed by type id
+    std::atomic<HandlerListBase*> m_handlers[EVENT_BUS_MAX_EVENT_TYPES];
+
+    /// protects the creation of handler lists and m_queuedHandlers
+    std::mutex m_mutex;
+    std::vector< std::unique_ptr<QueuedHandlerBase> > m_queuedHandlers;
+
+    template <typename EVENT_T>
+    inline HandlerList<EVENT_T>* FindHandlers() const
+    {
+        return static_cast<HandlerList<EVENT_T>*>(
+            m_handlers[TypeId<EVENT_T>()].load(std::memory_order_acquire));
+    }
+
+    /// @brief as FindHandlers, but the list is created if needed
+    template <typename EVENT_T>
+    HandlerList<EVENT_T>& GetHandlers()
+    {
+        HandlerList<EVENT_T>* list = FindHandlers<EVENT_T>();
+        if (list == 0)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            list = FindHandlers<EVENT_T>();
+            if (list == 0)
+            {
+                list = new HandlerList<EVENT_T>;
+                m_handlers[TypeId<EVENT_T>()].store(list, std::memory_order_release);
+            }
+        }
+        return *list;
+    }
+
+    // prevent copying
+    EventBus(const EventBus &a_src);
+    EventBus& operator=(const EventBus &a_src);
+};
+
+template <int DUMMY_T>
+std::atomic<uint32_t> EventBus::TypeCounter<DUMMY_T>::s_next(0);
+
+#endif /* _EVENTBUS_H_ */
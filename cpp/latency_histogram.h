@@ -0,0 +1,531 @@
+// ============================================================================
+// Copyright (c) 2026 Faustino Frechilla
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+/// @file  latency_histogram.h
+/// @brief Log-linear latency histograms (HdrHistogram layout)
+///
+/// Values (nanoseconds) are counted in buckets whose width grows with the
+/// value, so every value is kept with 3 significant digits from 1ns up to
+/// LATENCY_HISTOGRAM_MAX_VALUE (2^44ns, almost 5 hours) in a fixed array of
+/// LATENCY_HISTOGRAM_COUNTS_SIZE counters. Values up to 2047 get a bucket
+/// each. From there on every power of two is split in 1024 buckets. Bigger
+/// values are counted as the maximum. Percentile and Max report the highest
+/// value of a bucket (as HdrHistogram does), which can be up to 1/1024 of
+/// the value (about 0.1%) above what was recorded.
+///
+/// LatencyHistogram is written by a single thread: Record is a load and a
+/// store of the counter (no locked instruction), about as cheap as it gets.
+/// Counters are relaxed atomics so any other thread can read (Percentile,
+/// Add...) while it is being written. The snapshot is then not consistent
+/// across counters, but never off by more than the values recorded while it
+/// was taken. RecordConcurrent is the version for several writers.
+///
+/// ShardedLatencyHistogram keeps a LatencyHistogram per thread, so any
+/// thread can record without sharing cache lines with the others. Snapshot
+/// merges them on demand. Example of usage:
+///
+/// ShardedLatencyHistogram histogram;
+/// /* any thread */
+/// uint64_t start = TscClock::Now();
+/// DoSomething();
+/// histogram.Record(TscClock::Now() - start);
+/// /* reporting thread */
+/// LatencyHistogram snapshot;
+/// histogram.Snapshot(snapshot);
+/// snapshot.PrintPercentileDistribution(std::cout, 1000.0); // in usecs
+///
+/// PrintPercentileDistribution writes the same text as HdrHistogram's
+/// outputPercentileDistribution (.hgrm files), which the HdrHistogram
+/// plotter and the usual tools read
+///
+/// A histogram is LATENCY_HISTOGRAM_COUNTS_SIZE * 8 bytes (280KB). Shards
+/// are allocated the first time their thread records something
+///
+/// Your compiler must have support for c++11 and __builtin_clzll (gcc, clang)
+///
+/// @author Faustino Frechilla
+/// @history
+/// Ref        Who                When        What
+///            Faustino Frechilla 17-Oct-2026 Original development
+///            Faustino Frechilla 17-Oct-2026 Late values of exiting threads go to the shared shard
+/// @endhistory
+///
+// ============================================================================
+
+#ifndef _LATENCY_HISTOGRAM_H_
+#define _LATENCY_HISTOGRAM_H_
+
+#include <stdint.h>   // types (uint64_t...)
+#include <stdio.h>    // snprintf
+#include <math.h>     // sqrt, log2, floor, pow
+#include <atomic>
+#include <ostream>
+
+/// 2^LATENCY_HISTOGRAM_SUB_BUCKET_BITS buckets for the first values. The
+/// resolution is 1 part in 2^(LATENCY_HISTOGRAM_SUB_BUCKET_BITS - 1) from
+/// there on: 11 bits gives 3 significant digits
+#define LATENCY_HISTOGRAM_SUB_BUCKET_BITS 11
+/// powers of two split in sub buckets after the first values. 33 reaches
+/// 2^44 nanoseconds
+#define LATENCY_HISTOGRAM_BUCKETS         33
+
+#define LATENCY_HISTOGRAM_SUB_BUCKET_HALF_BITS (LATENCY_HISTOGRAM_SUB_BUCKET_BITS - 1)
+#define LATENCY_HISTOGRAM_SUB_BUCKET_HALF      (1U << LATENCY_HISTOGRAM_SUB_BUCKET_HALF_BITS)
+#define LATENCY_HISTOGRAM_SUB_BUCKET_MASK      ((1ULL << LATENCY_HISTOGRAM_SUB_BUCKET_BITS) - 1)
+#define LATENCY_HISTOGRAM_COUNTS_SIZE \
+    ((LATENCY_HISTOGRAM_BUCKETS + 2) << LATENCY_HISTOGRAM_SUB_BUCKET_HALF_BITS)
+#define LATENCY_HISTOGRAM_MAX_VALUE \
+    ((1ULL << (LATENCY_HISTOGRAM_SUB_BUCKET_BITS + LATENCY_HISTOGRAM_BUCKETS)) - 1)
+
+/// threads which can own a shard of a ShardedLatencyHistogram at the same
+/// time (64 at most). The others share one shard, written with atomic
+/// increments
+#ifndef LATENCY_HISTOGRAM_MAX_SHARDS
+#define LATENCY_HISTOGRAM_MAX_SHARDS 64
+#endif
+#if LATENCY_HISTOGRAM_MAX_SHARDS > 64
+#error "LATENCY_HISTOGRAM_MAX_SHARDS can't be bigger than 64"
+#endif
+
+/// @brief a log-linear histogram written by a single thread
+class LatencyHistogram
+{
+public:
+    LatencyHistogram()
+    {
+        Reset();
+    }
+
+    /// @brief counts a_value. Only one thread may call it at a time
+    inline void Record(uint64_t a_value)
+    {
+        std::atomic<uint64_t> &count = m_counts[CountsIndex(a_value)];
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    /// @brief counts a_value. Any number of threads can call it at once
+    inline void RecordConcurrent(uint64_t a_value)
+    {
+        m_counts[CountsIndex(a_value)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// @brief adds the counts of a_other to this histogram. Only the thread
+    /// which writes this histogram may call it. a_other can be being written
+    void Add(const LatencyHistogram &a_other)
+    {
+        for (uint32_t i = 0; i < LATENCY_HISTOGRAM_COUNTS_SIZE; i++)
+        {
+            uint64_t count = a_other.m_counts[i].load(std::memory_order_relaxed);
+            if (count != 0)
+            {
+                m_counts[i].store(m_counts[i].load(std::memory_order_relaxed) + count,
+                                  std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// @brief forgets every value. Only the thread which writes this
+    /// histogram may call it
+    void Reset()
+    {
+        for (uint32_t i = 0; i < LATENCY_HISTOGRAM_COUNTS_SIZE; i++)
+        {
+            m_counts[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /// @return how many values were recorded
+    uint64_t TotalCount() const
+    {
+        uint64_t total = 0;
+        for (uint32_t i = 0; i < LATENCY_HISTOGRAM_COUNTS_SIZE; i++)
+        {
+            total += m_counts[i].load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    /// @return the smallest value recorded (any value in its bucket would
+    ///         return the same). 0 if the histogram is empty
+    uint64_t Min() const
+    {
+        for (uint32_t i = 0; i < LATENCY_HISTOGRAM_COUNTS_SIZE; i++)
+        {
+            if (m_counts[i].load(std::memory_order_relaxed) != 0)
+            {
+                return LowestEquivalentValue(i);
+            }
+        }
+        return 0;
+    }
+
+    /// @return the biggest value recorded, rounded up to the top of its
+    ///         bucket. 0 if the histogram is empty
+    uint64_t Max() const
+    {
+        for (uint32_t i = LATENCY_HISTOGRAM_COUNTS_SIZE; i > 0; i--)
+        {
+            if (m_counts[i - 1].load(std::memory_order_relaxed) != 0)
+            {
+                return HighestEquivalentValue(i - 1);
+            }
+        }
+        return 0;
+    }
+
+    /// @return the mean of the values (taking the middle of each bucket)
+    double Mean() const
+    {
+        uint64_t total = 0;
+        double sum = 0.0;
+        for (uint32_t i = 0; i < LATENCY_HISTOGRAM_COUNTS_SIZE; i++)
+        {
+            uint64_t count = m_counts[i].load(std::memory_order_relaxed);
+            total += count;
+            sum += static_cast<double>(MedianEquivalentValue(i)) * count;
+        }
+        return (total == 0) ? 0.0 : (sum / total);
+    }
+
+    /// @return the standard deviation of the values
+    double StdDeviation() const
+    {
+        uint64_t total = 0;
+        double mean = Mean();
+        double sum = 0.0;
+        for (uint32_t i = 0; i < LATENCY_HISTOGRAM_COUNTS_SIZE; i++)
+        {
+            uint64_t count = m_counts[i].load(std::memory_order_relaxed);
+            double deviation = static_cast<double>(MedianEquivalentValue(i)) - mean;
+            total += count;
+            sum += deviation * deviation * count;
+        }
+        return (total == 0) ? 0.0 : sqrt(sum / total);
+    }
+
+    /// @param a_percentile 0.0 to 100.0
+    /// @return the value a_percentile% of the values are lower or equal to,
+    ///         rounded up to the top of its bucket. 0 if the histogram is empty
+    uint64_t Percentile(double a_percentile) const
+    {
+        uint64_t total = TotalCount();
+        if (total == 0)
+        {
+            return 0;
+        }
+
+        double percentile = (a_percentile > 100.0) ? 100.0 : a_percentile;
+        uint64_t target = static_cast<uint64_t>(((percentile / 100.0) * total) + 0.5);
+        if (target == 0)
+        {
+            target = 1;
+        }
+
+        uint64_t cumulative = 0;
+        for (uint32_t i = 0; i < LATENCY_HISTOGRAM_COUNTS_SIZE; i++)
+        {
+            cumulative += m_counts[i].load(std::memory_order_relaxed);
+            if (cumulative >= target)
+            {
+                return HighestEquivalentValue(i);
+            }
+        }
+        // counts grew while they were being added up
+        return Max();
+    }
+
+    /// @brief prints a one line summary:
+    ///   count=... min=... mean=... p50=... p90=... p99=... p999=... max=...
+    void Print(std::ostream &a_out) const
+    {
+        char line[256];
+        snprintf(line, sizeof(line),
+                 "count=%llu min=%llu mean=%.1f p50=%llu p90=%llu p99=%llu p999=%llu max=%llu",
+                 static_cast<unsigned long long>(TotalCount()),
+                 static_cast<unsigned long long>(Min()),
+                 Mean(),
+                 static_cast<unsigned long long>(Percentile(50.0)),
+                 static_cast<unsigned long long>(Percentile(90.0)),
+                 static_cast<unsigned long long>(Percentile(99.0)),
+                 static_cast<unsigned long long>(Percentile(99.9)),
+                 static_cast<unsigned long long>(Max()));
+        a_out << line << std::endl;
+    }
+
+    /// @brief prints the percentile distribution in the format of
+    /// HdrHistogram's outputPercentileDistribution (.hgrm)
+    /// @param a_valueScale values are divided by it (1000.0 prints usecs)
+    /// @param a_ticksPerHalfDistance lines per halving of the distance to 100%
+    void PrintPercentileDistribution(std::ostream &a_out, double a_valueScale = 1.0,
+                                     uint32_t a_ticksPerHalfDistance = 5) const
+    {
+        char line[256];
+        snprintf(line, sizeof(line), "%12s %14s %10s %14s\n\n",
+                 "Value", "Percentile", "TotalCount", "1/(1-Percentile)");
+        a_out << line;
+
+        uint64_t total = TotalCount();
+        uint64_t cumulative = 0;
+        double nextPercentile = 0.0;
+        for (uint32_t i = 0; (i < LATENCY_HISTOGRAM_COUNTS_SIZE) && (total != 0); i++)
+        {
+            uint64_t count = m_counts[i].load(std::memory_order_relaxed);
+            if (count == 0)
+            {
+                continue;
+            }
+            cumulative += count;
+            double value = HighestEquivalentValue(i) / a_valueScale;
+
+            if (cumulative >= total)
+            {
+                snprintf(line, sizeof(line), "%12.3f %1.12f %10llu\n",
+                         value, 1.0, static_cast<unsigned long long>(cumulative));
+                a_out << line;
+                break;
+            }
+
+            double reached = (100.0 * cumulative) / total;
+            while (nextPercentile <= reached)
+            {
+                snprintf(line, sizeof(line), "%12.3f %1.12f %10llu %14.2f\n",
+                         value, nextPercentile / 100.0,
+                         static_cast<unsigned long long>(cumulative),
+                         1.0 / (1.0 - (nextPercentile / 100.0)));
+                a_out << line;
+
+                // the closer to 100%, the smaller the steps
+                double halvings = floor(log2(100.0 / (100.0 - nextPercentile))) + 1.0;
+                nextPercentile += 100.0 / (a_ticksPerHalfDistance * pow(2.0, halvings));
+            }
+        }
+
+        snprintf(line, sizeof(line), "#[Mean    = %12.3f, StdDeviation   = %12.3f]\n",
+                 Mean() / a_valueScale, StdDeviation() / a_valueScale);
+        a_out << line;
+        snprintf(line, sizeof(line), "#[Max     = %12.3f, Total count    = %12llu]\n",
+                 Max() / a_valueScale, static_cast<unsigned long long>(total));
+        a_out << line;
+        snprintf(line, sizeof(line), "#[Buckets = %12d, SubBuckets     = %12d]\n",
+                 LATENCY_HISTOGRAM_BUCKETS + 1, 1 << LATENCY_HISTOGRAM_SUB_BUCKET_BITS);
+        a_out << line;
+    }
+
+    /// @return the position in the counters array where a_value is counted
+    static inline uint32_t CountsIndex(uint64_t a_value)
+    {
+        if (a_value > LATENCY_HISTOGRAM_MAX_VALUE)
+        {
+            a_value = LATENCY_HISTOGRAM_MAX_VALUE;
+        }
+        // bucket 0 holds the values lower than 2^LATENCY_HISTOGRAM_SUB_BUCKET_BITS
+        // one by one. Bucket n the ones in [2^(n+10), 2^(n+11)) 2^n at a time
+        uint32_t bucket = (63 - __builtin_clzll(a_value | LATENCY_HISTOGRAM_SUB_BUCKET_MASK)) -
+            LATENCY_HISTOGRAM_SUB_BUCKET_HALF_BITS;
+        uint32_t subBucket = static_cast<uint32_t>(a_value >> bucket);
+        return (bucket << LATENCY_HISTOGRAM_SUB_BUCKET_HALF_BITS) + subBucket;
+    }
+
+    /// @return the smallest value counted in a_index
+    static inline uint64_t LowestEquivalentValue(uint32_t a_index)
+    {
+        if (a_index < (1U << LATENCY_HISTOGRAM_SUB_BUCKET_BITS))
+        {
+            return a_index;
+        }
+        uint32_t bucket = (a_index >> LATENCY_HISTOGRAM_SUB_BUCKET_HALF_BITS) - 1;
+        uint64_t subBucket = (a_index & (LATENCY_HISTOGRAM_SUB_BUCKET_HALF - 1)) +
+            LATENCY_HISTOGRAM_SUB_BUCKET_HALF;
+        return subBucket << bucket;
+    }
+
+    /// @return the biggest value counted in a_index
+    static inline uint64_t HighestEquivalentValue(uint32_t a_index)
+    {
+        return LowestEquivalentValue(a_index) + BucketWidth(a_index) - 1;
+    }
+
+    /// @return the value in the middle of a_index
+    static inline uint64_t MedianEquivalentValue(uint32_t a_index)
+    {
+        return LowestEquivalentValue(a_index) + (BucketWidth(a_index) >> 1);
+    }
+
+private:
+    std::atomic<uint64_t> m_counts[LATENCY_HISTOGRAM_COUNTS_SIZE];
+
+    /// @return how many different values are counted in a_index
+    static inline uint64_t BucketWidth(uint32_t a_index)
+    {
+        if (a_index < (1U << LATENCY_HISTOGRAM_SUB_BUCKET_BITS))
+        {
+            return 1;
+        }
+        return 1ULL << ((a_index >> LATENCY_HISTOGRAM_SUB_BUCKET_HALF_BITS) - 1);
+    }
+
+    // prevent copying
+    LatencyHistogram(const LatencyHistogram &a_src);
+    LatencyHistogram& operator=(const LatencyHistogram &a_src);
+};
+
+/// @brief a LatencyHistogram per recording thread
+class ShardedLatencyHistogram
+{
+public:
+    ShardedLatencyHistogram()
+    {
+        for (uint32_t i = 0; i < LATENCY_HISTOGRAM_MAX_SHARDS; i++)
+        {
+            m_shards[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /// @brief no thread may be recording when it is destroyed
+    ~ShardedLatencyHistogram()
+    {
+        for (uint32_t i = 0; i < LATENCY_HISTOGRAM_MAX_SHARDS; i++)
+        {
+            delete m_shards[i].load(std::memory_order_acquire);
+        }
+    }
+
+    /// @brief counts a_value in the shard of the calling thread
+    inline void Record(uint64_t a_value)
+    {
+        uint32_t index = ThreadIndex();
+        if (index >= LATENCY_HISTOGRAM_MAX_SHARDS)
+        {
+            m_shared.RecordConcurrent(a_value);
+            return;
+        }
+
+        // only the thread which owns the index writes this pointer
+        LatencyHistogram* shard = m_shards[index].load(std::memory_order_relaxed);
+        if (shard == 0)
+        {
+            shard = new LatencyHistogram();
+            m_shards[index].store(shard, std::memory_order_release);
+        }
+        shard->Record(a_value);
+    }
+
+    /// @brief merges every shard into out_histogram, which is reset first.
+    /// It can be called from any thread while the others record
+    void Snapshot(LatencyHistogram &out_histogram) const
+    {
+        out_histogram.Reset();
+        out_histogram.Add(m_shared);
+        for (uint32_t i = 0; i < LATENCY_HISTOGRAM_MAX_SHARDS; i++)
+        {
+            const LatencyHistogram* shard = m_shards[i].load(std::memory_order_acquire);
+            if (shard != 0)
+            {
+                out_histogram.Add(*shard);
+            }
+        }
+    }
+
+private:
+    std::atomic<LatencyHistogram*> m_shards[LATENCY_HISTOGRAM_MAX_SHARDS];
+    /// for the threads which couldn't get an index of their own
+    LatencyHistogram m_shared;
+
+    /// @brief the index of a thread. It is given back when the thread
+    /// exits, and handed over to the next new thread
+    struct ThreadSlot
+    {
+        uint32_t index;
+
+        ThreadSlot()
+        {
+            std::atomic<uint64_t> &freeMask = FreeMask();
+            uint64_t mask = freeMask.load(std::memory_order_relaxed);
+            do
+            {
+                if (mask == 0)
+                {
+                    index = LATENCY_HISTOGRAM_MAX_SHARDS;
+                    return;
+                }
+                index = __builtin_ctzll(mask);
+                // acquire: the previous owner is done with the shards of
+                // this index
+            } while (!freeMask.compare_exchange_weak(
+                mask, mask & ~(1ULL << index), std::memory_order_acquire, std::memory_order_relaxed));
+        }
+
+        ~ThreadSlot()
+        {
+            if (index < LATENCY_HISTOGRAM_MAX_SHARDS)
+            {
+                // values recorded by thread_local destructors which run
+                // after this one go to the shared histogram: the shards of
+                // this index may belong to another thread from now on
+                ThisThreadIndex() = LATENCY_HISTOGRAM_MAX_SHARDS;
+                FreeMask().fetch_or(1ULL << index, std::memory_order_release);
+            }
+        }
+    };
+
+    /// @return the index of the calling thread, the same one for every
+    ///         ShardedLatencyHistogram. LATENCY_HISTOGRAM_MAX_SHARDS if
+    ///         every index is taken
+    static inline uint32_t ThreadIndex()
+    {
+        uint32_t &index = ThisThreadIndex();
+        if (index > LATENCY_HISTOGRAM_MAX_SHARDS)
+        {
+            index = ClaimThreadIndex();
+        }
+        return index;
+    }
+
+    /// @return the index cached by the calling thread.
+    ///         LATENCY_HISTOGRAM_MAX_SHARDS + 1 until it claims one
+    static inline uint32_t& ThisThreadIndex()
+    {
+        // a plain integer. Unlike ThreadSlot it needs no guard to be read
+        static thread_local uint32_t t_index = LATENCY_HISTOGRAM_MAX_SHARDS + 1;
+        return t_index;
+    }
+
+    /// @brief claims an index for the calling thread. ThreadSlot gives it
+    /// back when the thread exits
+    static uint32_t ClaimThreadIndex()
+    {
+        static thread_local ThreadSlot t_slot;
+        return t_slot.index;
+    }
+
+    // function-local static so this class can live in a header file
+    static inline std::atomic<uint64_t>& FreeMask()
+    {
+        static std::atomic<uint64_t> s_freeMask(~0ULL >> (64 - LATENCY_HISTOGRAM_MAX_SHARDS));
+        return s_freeMask;
+    }
+
+    // prevent copying
+    ShardedLatencyHistogram(const ShardedLatencyHistogram &a_src);
+    ShardedLatencyHistogram& operator=(const ShardedLatencyHistogram &a_src);
+};
+
+#endif /* _LATENCY_HISTOGRAM_H_ */
@@ -20,14 +20,32 @@
 // THE SOFTWARE.
 //
 /// @file lock_free_atomic_ops.h
-/// @brief This file contains functions to wrap the built-in atomic operations 
-///        defined for your compiler
+/// @brief This file contains the atomic operations used by the lock-free
+///        code of this repository
+///
+/// AtomicLoad, AtomicStore, AtomicAdd, AtomicSub, CAS and CASVal work on
+/// std::atomic variables and take the memory order explicitly. They default
+/// to std::memory_order_seq_cst, the strongest (and slowest) ordering. CAS
+/// and CASVal take the expected value by value, so a failed CAS doesn't
+/// overwrite it, unlike std::atomic::compare_exchange_*.
+///
+/// DoubleWidthCAS compares and swaps two adjacent 64 bit words at once
+/// (an AtomicPair), which is what tagged pointers need. It is a single
+/// lock cmpxchg16b on x86-64, the 16 byte builtins where the compiler has
+/// them, and a small table of spin locks anywhere else
+/// (ATOMIC_OPS_DWCAS_LOCK_FREE is 0 then). Either way an AtomicPair must
+/// only be accessed through DoubleWidthCAS and DoubleWidthLoad.
+///
+/// CpuRelax tells the CPU the calling thread is spinning (pause on x86,
+/// yield on ARM). It is meant for the body of spin loops
 ///
 /// @author Faustino Frechilla
 /// @history
 /// Ref  Who                 When         What
 ///      Faustino Frechilla  11-Jul-2010  Original development. GCC support
 ///      Faustino Frechilla  08-Aug-2014  Change to MIT license
+///      Faustino Frechilla  17-Oct-2026  std::atomic based, with explicit memory orders,
+///                                       double-width CAS and CpuRelax
 /// @endhistory
 /// 
 // ============================================================================
@@ -35,40 +53,192 @@
 #ifndef __ATOMIC_OPS_H
 #define __ATOMIC_OPS_H
 
-#ifdef __GNUC__
-// Atomic functions in GCC are present from version 4.1.0 on
-// http://gcc.gnu.org/onlinedocs/gcc-4.1.0/gcc/Atomic-Builtins.html
+#include <stdint.h>     // uint64_t
+#include <atomic>
+
+#if defined(_MSC_VER)
+#include <intrin.h>     // _mm_pause, _InterlockedCompareExchange128
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>  // _mm_pause
+#endif
+
+/// @brief the strongest order a failed CAS may use for a_success
+inline std::memory_order CASFailureOrder(std::memory_order a_success)
+{
+    return (a_success == std::memory_order_acq_rel) ? std::memory_order_acquire :
+           (a_success == std::memory_order_release) ? std::memory_order_relaxed :
+           a_success;
+}
 
-// Test for GCC >= 4.1.0
-#if (__GNUC__ < 4) || \
-    ((__GNUC__ == 4) && ((__GNUC_MINOR__ < 1) || \
-                        ((__GNUC_MINOR__     == 1) && \
-                         (__GNUC_PATCHLEVEL__ < 0))) )
-                        
-#error Atomic built-in functions are only available in GCC in versions >= 4.1.0
+/// @return the value of a_atomic
+template <typename T>
+inline T AtomicLoad(const std::atomic<T> &a_atomic,
+                    std::memory_order a_order = std::memory_order_seq_cst)
+{
+    return a_atomic.load(a_order);
+}
 
-#endif // end of check for GCC 4.1.0
+/// @brief writes a_value into a_atomic
+template <typename T>
+inline void AtomicStore(std::atomic<T> &a_atomic, T a_value,
+                        std::memory_order a_order = std::memory_order_seq_cst)
+{
+    a_atomic.store(a_value, a_order);
+}
 
-/// @brief atomically adds a_count to the variable pointed by a_ptr
+/// @brief atomically adds a_count to a_atomic
 /// @return the value that had previously been in memory
-#define AtomicAdd(a_ptr,a_count) __sync_fetch_and_add (a_ptr, a_count)
+template <typename T>
+inline T AtomicAdd(std::atomic<T> &a_atomic, T a_count,
+                   std::memory_order a_order = std::memory_order_seq_cst)
+{
+    return a_atomic.fetch_add(a_count, a_order);
+}
 
-/// @brief atomically substracts a_count from the variable pointed by a_ptr
+/// @brief atomically substracts a_count from a_atomic
 /// @return the value that had previously been in memory
-#define AtomicSub(a_ptr,a_count) __sync_fetch_and_sub (a_ptr, a_count)
+template <typename T>
+inline T AtomicSub(std::atomic<T> &a_atomic, T a_count,
+                   std::memory_order a_order = std::memory_order_seq_cst)
+{
+    return a_atomic.fetch_sub(a_count, a_order);
+}
 
 /// @brief Compare And Swap
-///        If the current value of *a_ptr is a_oldVal, then write a_newVal into *a_ptr
+///        If the current value of a_atomic is a_oldVal, then write a_newVal into it
+/// @param a_order ordering of the successful swap. A failed one is as strong
+///        as allowed (see CASFailureOrder)
 /// @return true if the comparison is successful and a_newVal was written
-#define CAS(a_ptr, a_oldVal, a_newVal) __sync_bool_compare_and_swap(a_ptr, a_oldVal, a_newVal)
+template <typename T>
+inline bool CAS(std::atomic<T> &a_atomic, T a_oldVal, T a_newVal,
+                std::memory_order a_order = std::memory_order_seq_cst)
+{
+    return a_atomic.compare_exchange_strong(
+        a_oldVal, a_newVal, a_order, CASFailureOrder(a_order));
+}
 
 /// @brief Compare And Swap
-///        If the current value of *a_ptr is a_oldVal, then write a_newVal into *a_ptr
-/// @return the contents of *a_ptr before the operation
-#define CASVal(a_ptr, a_oldVal, a_newVal) __sync_val_compare_and_swap(a_ptr, a_oldVal, a_newVal)
+///        If the current value of a_atomic is a_oldVal, then write a_newVal into it
+/// @return the contents of a_atomic before the operation
+template <typename T>
+inline T CASVal(std::atomic<T> &a_atomic, T a_oldVal, T a_newVal,
+                std::memory_order a_order = std::memory_order_seq_cst)
+{
+    a_atomic.compare_exchange_strong(
+        a_oldVal, a_newVal, a_order, CASFailureOrder(a_order));
+    return a_oldVal;
+}
 
+/// @brief tells the CPU the calling thread is busy waiting. It saves power,
+/// leaves the core to the sibling hyperthread and avoids the pipeline flush
+/// when the loop finally exits
+inline void CpuRelax()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__) || (defined(__arm__) && (__ARM_ARCH >= 7))
+    __asm__ __volatile__("yield" ::: "memory");
 #else
-#error Atomic functions such as CAS or AtomicAdd are not defined for your compiler. Please add them in atomic_ops.h
-#endif // __GNUC__
+    // at least don't let the compiler fold the loop
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+/// @brief two 64 bit words which are compared and swapped together
+struct alignas(16) AtomicPair
+{
+    uint64_t low;
+    uint64_t high;
+};
+
+#if (defined(__GNUC__) && defined(__x86_64__)) || \
+    (defined(_MSC_VER) && defined(_M_X64))     || \
+    defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)
+#define ATOMIC_OPS_DWCAS_LOCK_FREE 1
+#else
+#define ATOMIC_OPS_DWCAS_LOCK_FREE 0
+
+// spin locks protecting the AtomicPairs when there is no double-width CAS.
+// Pairs are mapped to them by address
+#define ATOMIC_OPS_DWCAS_LOCKS 64
+
+/// @brief the spin locks. A template only so the static member can be
+/// defined in this header
+template <int DUMMY_T = 0>
+struct DoubleWidthLocks
+{
+    static std::atomic<bool> s_locks[ATOMIC_OPS_DWCAS_LOCKS];
+
+    static inline std::atomic<bool>& Get(const void* a_address)
+    {
+        return s_locks[(reinterpret_cast<uintptr_t>(a_address) >> 4) % ATOMIC_OPS_DWCAS_LOCKS];
+    }
+};
+
+template <int DUMMY_T>
+std::atomic<bool> DoubleWidthLocks<DUMMY_T>::s_locks[ATOMIC_OPS_DWCAS_LOCKS];
+#endif
+
+/// @brief Double-width Compare And Swap. Full barrier
+///        If the current value of a_target is io_expected, then write a_desired into it
+/// @param io_expected gets the current value of a_target if they differ
+/// @return true if the comparison is successful and a_desired was written
+inline bool DoubleWidthCAS(AtomicPair &a_target, AtomicPair &io_expected, const AtomicPair &a_desired)
+{
+#if defined(__GNUC__) && defined(__x86_64__)
+    bool swapped;
+    __asm__ __volatile__(
+        "lock cmpxchg16b %1\n\t"
+        "setz %0"
+        : "=q" (swapped), "+m" (a_target), "+a" (io_expected.low), "+d" (io_expected.high)
+        : "b" (a_desired.low), "c" (a_desired.high)
+        : "cc", "memory");
+    return swapped;
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return _InterlockedCompareExchange128(
+        reinterpret_cast<volatile long long*>(&a_target),
+        static_cast<long long>(a_desired.high),
+        static_cast<long long>(a_desired.low),
+        reinterpret_cast<long long*>(&io_expected)) != 0;
+#elif defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)
+    unsigned __int128 expected = (static_cast<unsigned __int128>(io_expected.high) << 64) | io_expected.low;
+    unsigned __int128 desired  = (static_cast<unsigned __int128>(a_desired.high) << 64) | a_desired.low;
+    unsigned __int128 previous = __sync_val_compare_and_swap(
+        reinterpret_cast<unsigned __int128*>(&a_target), expected, desired);
+    io_expected.low  = static_cast<uint64_t>(previous);
+    io_expected.high = static_cast<uint64_t>(previous >> 64);
+    return previous == expected;
+#else
+    std::atomic<bool> &lock = DoubleWidthLocks<>::Get(&a_target);
+    while (lock.exchange(true, std::memory_order_acquire))
+    {
+        CpuRelax();
+    }
+
+    bool swapped = (a_target.low == io_expected.low) && (a_target.high == io_expected.high);
+    if (swapped)
+    {
+        a_target = a_desired;
+    }
+    else
+    {
+        io_expected = a_target;
+    }
+
+    lock.store(false, std::memory_order_release);
+    return swapped;
+#endif
+}
+
+/// @return the value of a_target, read atomically. It is a CAS, so it needs
+/// the cache line in exclusive mode (and writable memory)
+inline AtomicPair DoubleWidthLoad(AtomicPair &a_target)
+{
+    AtomicPair value = {0, 0};
+    DoubleWidthCAS(a_target, value, value);
+    return value;
+}
 
 #endif // __ATOMIC_OPS_H
@@ -32,6 +32,8 @@
 ///      Faustino Frechilla  11-Aug-2014  LOCK_FREE_Q_SINGLE_PRODUCER removed. Single producer handled in template
 ///      Faustino Frechilla  12-Aug-2014  inheritance (specialisation) based on templates.
 ///      Faustino Frechilla  10-Aug-2015  Ported to c++11. Removed volatile keywords (using std::atomic)
+///      Faustino Frechilla  17-Oct-2026  Acquire/release ordering through lock_free_atomic_ops.h
+///      Faustino Frechilla  17-Oct-2026  Backoff in the CAS retry loops
 /// @endhistory
 /// 
 // ============================================================================
@@ -41,6 +43,8 @@
 
 #include <stdint.h>     // uint32_t
 #include <atomic>
+#include "lock_free_atomic_ops.h"
+#include "backoff.h"
 
 // default Queue size
 #define LOCK_FREE_Q_DEFAULT_SIZE 65536 // (2^16)
@@ -30,6 +30,9 @@
 ///      Faustino Frechilla  11-Aug-2014  Original development. File containing only specifics for multiple producers
 ///      Faustino Frechilla  12-Aug-2014  inheritance (specialisation) based on templates
 ///      Faustino Frechilla  10-Aug-2015  Ported to c++11. Removed volatile keywords (using std::atomic)
+///      Faustino Frechilla  17-Oct-2026  Acquire/release ordering through lock_free_atomic_ops.h
+///      Faustino Frechilla  17-Oct-2026  Weakest correct memory order for every operation
+///      Faustino Frechilla  17-Oct-2026  Backoff in the CAS retry loops
 /// @endhistory
 /// 
 // ============================================================================
@@ -38,7 +41,24 @@
 #define __LOCK_FREE_QUEUE_IMPL_MULTIPLE_PRODUCER_H__
 
 #include <assert.h> // assert()
-#include <sched.h>  // sched_yield()
+
+// Memory ordering. Every element is handed over twice:
+//   producer -> consumer: the element is written and then committed moving
+//     m_maximumReadIndex forward with a release CAS. Consumers load
+//     m_maximumReadIndex with acquire before they read the element. Commits
+//     are RMWs, so they extend the release sequence of the earlier ones:
+//     acquiring the commit of one producer also makes visible the elements
+//     committed before it
+//   consumer -> producer: the consumer reads the element and then moves
+//     m_readIndex forward with a release CAS. Producers load m_readIndex
+//     with acquire before they reserve (and later overwrite) the slot
+// Both indexes are also loaded with acquire and moved forward with release
+// by the threads which share them. Each thread then sees the other index
+// at least as far as the thread which last moved its own index saw it, so
+// a full queue can't look empty (or the other way round) because one of
+// the two loads returned an older value than the other
+// Anything else is relaxed: m_count and size()/full() are snapshots which
+// don't order any access to the elements
 
 template <typename ELEM_T, uint32_t Q_SIZE>
 ArrayLockFreeQueueMultipleProducers<ELEM_T, Q_SIZE>::ArrayLockFreeQueueMultipleProducers():
@@ -69,11 +89,11 @@ uint32_t ArrayLockFreeQueueMultipleProducers<ELEM_T, Q_SIZE>::size()
 {
 #ifdef _WITH_LOCK_FREE_Q_KEEP_REAL_SIZE
 
-    return m_count.load();
+    return AtomicLoad(m_count, std::memory_order_relaxed);
 #else
 
-    uint32_t currentWriteIndex = m_maximumReadIndex.load();
-    uint32_t currentReadIndex  = m_readIndex.load();
+    uint32_t currentWriteIndex = AtomicLoad(m_maximumReadIndex, std::memory_order_relaxed);
+    uint32_t currentReadIndex  = AtomicLoad(m_readIndex, std::memory_order_relaxed);
 
     // let's think of a scenario where this function returns bogus data
     // 1. when the statement 'currentWriteIndex = m_maximumReadIndex' is run
@@ -104,11 +124,11 @@ bool ArrayLockFreeQueueMultipleProducers<ELEM_T, Q_SIZE>::full()
 {
 #ifdef _WITH_LOCK_FREE_Q_KEEP_REAL_SIZE
 
-    return (m_count.load() == (Q_SIZE - 1));
+    return (AtomicLoad(m_count, std::memory_order_relaxed) == (Q_SIZE - 1));
 #else
 
-    uint32_t currentWriteIndex = m_writeIndex;
-    uint32_t currentReadIndex  = m_readIndex;
+    uint32_t currentWriteIndex = AtomicLoad(m_writeIndex, std::memory_order_relaxed);
+    uint32_t currentReadIndex  = AtomicLoad(m_readIndex, std::memory_order_relaxed);
     
     if (countToIndex(currentWriteIndex + 1) == countToIndex(currentReadIndex))
     {
@@ -127,25 +147,36 @@ template <typename ELEM_T, uint32_t Q_SIZE>
 bool ArrayLockFreeQueueMultipleProducers<ELEM_T, Q_SIZE>::push(const ELEM_T &a_data)
 {
     uint32_t currentWriteIndex;
+    Backoff backoff;
     
-    do
+    while (true)
     {
-        currentWriteIndex = m_writeIndex.load();
+        currentWriteIndex = AtomicLoad(m_writeIndex, std::memory_order_acquire);
         
-        if (countToIndex(currentWriteIndex + 1) == countToIndex(m_readIndex.load()))
+        // acquire: consumers are done with the slot before it is overwritten
+        if (countToIndex(currentWriteIndex + 1) ==
+                countToIndex(AtomicLoad(m_readIndex, std::memory_order_acquire)))
         {
             // the queue is full
             return false;
         }
-    // There is more than one producer. Keep looping till this thread is able 
-    // to allocate space for current piece of data
-    //
-    // using compare_exchange_strong because it isn't allowed to fail spuriously
-    // When the compare_exchange operation is in a loop the weak version
-    // will yield better performance on some platforms, but here we'd have to
-    // load m_writeIndex all over again
-    } while (!m_writeIndex.compare_exchange_strong(
-                currentWriteIndex, (currentWriteIndex + 1)));
+
+        // There is more than one producer. Keep looping till this thread is able 
+        // to allocate space for current piece of data
+        //
+        // using compare_exchange_strong because it isn't allowed to fail spuriously
+        // When the compare_exchange operation is in a loop the weak version
+        // will yield better performance on some platforms, but here we'd have to
+        // load m_writeIndex all over again
+        if (CAS(m_writeIndex, currentWriteIndex, (currentWriteIndex + 1),
+                std::memory_order_release))
+        {
+            break;
+        }
+
+        // another producer reserved this slot first
+        backoff.Wait();
+    }
     
     // Just made sure this index is reserved for this thread.
     m_theQueue[countToIndex(currentWriteIndex)] = a_data;
@@ -155,23 +186,22 @@ bool ArrayLockFreeQueueMultipleProducers<ELEM_T, Q_SIZE>::push(const ELEM_T &a_d
     // if there is more than 1 producer thread because this operation has to
     // be done in the same order as the previous CAS
     //
-    // using compare_exchange_weak because they are allowed to fail spuriously
-    // (act as if *this != expected, even if they are equal), but when the
-    // compare_exchange operation is in a loop the weak version will yield
-    // better performance on some platforms.
-    while (!m_maximumReadIndex.compare_exchange_weak(
-                currentWriteIndex, (currentWriteIndex + 1)))
+    // CAS takes currentWriteIndex by value. compare_exchange would overwrite
+    // it when it fails, and the next attempt would commit the slot of
+    // another producer. release: publishes the element to consumers
+    backoff.Reset();
+    while (!CAS(m_maximumReadIndex, currentWriteIndex, (currentWriteIndex + 1),
+                std::memory_order_release))
     {
-        // this is a good place to yield the thread in case there are more
-        // software threads than hardware processors and you have more
-        // than 1 producer thread
-        // have a look at sched_yield (POSIX.1b)
-        //sched_yield();
+        // a producer which reserved an earlier slot hasn't committed it yet.
+        // It might not even be running, hence the backoff (which ends up
+        // yielding the CPU)
+        backoff.Wait();
     }
 
     // The value was successfully inserted into the queue
 #ifdef _WITH_LOCK_FREE_Q_KEEP_REAL_SIZE
-    m_count.fetch_add(1);
+    AtomicAdd(m_count, 1u, std::memory_order_relaxed);
 #endif
 
     return true;
@@ -181,14 +211,17 @@ template <typename ELEM_T, uint32_t Q_SIZE>
 bool ArrayLockFreeQueueMultipleProducers<ELEM_T, Q_SIZE>::pop(ELEM_T &a_data)
 {
     uint32_t currentReadIndex;
+    Backoff backoff;
 
     do
     {
-        currentReadIndex = m_readIndex.load();
+        currentReadIndex = AtomicLoad(m_readIndex, std::memory_order_acquire);
 
         // to ensure thread-safety when there is more than 1 producer 
         // thread a second index is defined (m_maximumReadIndex)
-        if (countToIndex(currentReadIndex) == countToIndex(m_maximumReadIndex.load()))
+        // acquire: the element committed by the producer is visible
+        if (countToIndex(currentReadIndex) ==
+                countToIndex(AtomicLoad(m_maximumReadIndex, std::memory_order_acquire)))
         {
             // the queue is empty or
             // a producer thread has allocate space in the queue but is 
@@ -202,12 +235,14 @@ bool ArrayLockFreeQueueMultipleProducers<ELEM_T, Q_SIZE>::pop(ELEM_T &a_data)
         // try to perfrom now the CAS operation on the read index. If we succeed
         // a_data already contains what m_readIndex pointed to before we 
         // increased it
-        if (m_readIndex.compare_exchange_strong(currentReadIndex, (currentReadIndex + 1)))
+        // release: the slot is handed back to the producers once it is read
+        if (CAS(m_readIndex, currentReadIndex, (currentReadIndex + 1),
+                std::memory_order_release))
         {
             // got here. The value was retrieved from the queue. Note that the
             // data inside the m_queue array is not deleted nor reseted
 #ifdef _WITH_LOCK_FREE_Q_KEEP_REAL_SIZE
-            m_count.fetch_sub(1);
+            AtomicSub(m_count, 1u, std::memory_order_relaxed);
 #endif
             return true;
         }
@@ -215,6 +250,7 @@ bool ArrayLockFreeQueueMultipleProducers<ELEM_T, Q_SIZE>::pop(ELEM_T &a_data)
         // it failed retrieving the element off the queue. Someone else must
         // have read the element stored at countToIndex(currentReadIndex)
         // before we could perform the CAS operation        
+        backoff.Wait();
 
     } while(1); // keep looping to try again!
 
@@ -30,6 +30,9 @@
 ///      Faustino Frechilla  11-Aug-2014  Original development. File containing only specifics for single producer
 ///      Faustino Frechilla  12-Aug-2014  inheritance (specialisation) based on templates
 ///      Faustino Frechilla  10-Aug-2015  Ported to c++11. Removed volatile keywords (using std::atomic)
+///      Faustino Frechilla  17-Oct-2026  Acquire/release ordering through lock_free_atomic_ops.h
+///      Faustino Frechilla  17-Oct-2026  Weakest correct memory order for every operation
+///      Faustino Frechilla  17-Oct-2026  Backoff in the CAS retry loops
 /// @endhistory
 /// 
 // ============================================================================
@@ -39,6 +42,21 @@
 
 #include <assert.h> // assert()
 
+// Memory ordering. Every element is handed over twice:
+//   producer -> consumer: the element is written and then m_writeIndex is
+//     stored with release. Consumers load m_writeIndex with acquire before
+//     they read the element
+//   consumer -> producer: the consumer reads the element and then moves
+//     m_readIndex forward with a release CAS. The producer loads
+//     m_readIndex with acquire before it overwrites the slot
+// Consumers also load m_readIndex with acquire. It synchronises with the
+// consumer which moved it forward, which had already seen m_writeIndex at
+// least that far, so the m_writeIndex loaded afterwards can't be behind
+// m_readIndex (an empty queue would look full of unwritten elements)
+// Anything else is relaxed: m_writeIndex is only written by the producer,
+// which can read it back relaxed, and m_count and size()/full() are
+// snapshots which don't order any access to the elements
+
 template <typename ELEM_T, uint32_t Q_SIZE>
 ArrayLockFreeQueueSingleProducer<ELEM_T, Q_SIZE>::ArrayLockFreeQueueSingleProducer():
     m_writeIndex(0), // initialisation is not atomic
@@ -66,10 +84,10 @@ inline
 uint32_t ArrayLockFreeQueueSingleProducer<ELEM_T, Q_SIZE>::size()
 {
 #ifdef _WITH_LOCK_FREE_Q_KEEP_REAL_SIZE
-    return m_count.load();
+    return AtomicLoad(m_count, std::memory_order_relaxed);
 #else
-    uint32_t currentWriteIndex = m_writeIndex.load();
-    uint32_t currentReadIndex  = m_readIndex.load();
+    uint32_t currentWriteIndex = AtomicLoad(m_writeIndex, std::memory_order_relaxed);
+    uint32_t currentReadIndex  = AtomicLoad(m_readIndex, std::memory_order_relaxed);
 
     // let's think of a scenario where this function returns bogus data
     // 1. when the statement 'currentWriteIndex = m_writeIndex' is run
@@ -99,10 +117,10 @@ inline
 bool ArrayLockFreeQueueSingleProducer<ELEM_T, Q_SIZE>::full()
 {
 #ifdef _WITH_LOCK_FREE_Q_KEEP_REAL_SIZE
-    return (m_count.load() == (Q_SIZE - 1));
+    return (AtomicLoad(m_count, std::memory_order_relaxed) == (Q_SIZE - 1));
 #else
-    uint32_t currentWriteIndex = m_writeIndex.load();
-    uint32_t currentReadIndex  = m_readIndex.load();
+    uint32_t currentWriteIndex = AtomicLoad(m_writeIndex, std::memory_order_relaxed);
+    uint32_t currentReadIndex  = AtomicLoad(m_readIndex, std::memory_order_relaxed);
     
     if (countToIndex(currentWriteIndex + 1) == countToIndex(currentReadIndex))
     {
@@ -123,10 +141,11 @@ bool ArrayLockFreeQueueSingleProducer<ELEM_T, Q_SIZE>::push(const ELEM_T &a_data
     uint32_t currentWriteIndex;
     
     // no need to loop. There is only one producer (this thread)
-    currentWriteIndex = m_writeIndex.load();
+    currentWriteIndex = AtomicLoad(m_writeIndex, std::memory_order_relaxed);
     
+    // acquire: consumers are done with the slot before it is overwritten
     if (countToIndex(currentWriteIndex + 1) == 
-            countToIndex(m_readIndex.load()))
+            countToIndex(AtomicLoad(m_readIndex, std::memory_order_acquire)))
     {
         // the queue is full
         return false;
@@ -135,12 +154,13 @@ bool ArrayLockFreeQueueSingleProducer<ELEM_T, Q_SIZE>::push(const ELEM_T &a_data
     // up to this point we made sure there is space in the Q for more data
     m_theQueue[countToIndex(currentWriteIndex)] = a_data;
     
-    // increment write index 
-    m_writeIndex.fetch_add(1);
+    // increment write index. release: publishes the element to consumers
+    // A plain store is enough since no one else writes m_writeIndex
+    AtomicStore(m_writeIndex, (currentWriteIndex + 1), std::memory_order_release);
 
     // The value was successfully inserted into the queue
 #ifdef _WITH_LOCK_FREE_Q_KEEP_REAL_SIZE
-    m_count.fetch_add(1);
+    AtomicAdd(m_count, 1u, std::memory_order_relaxed);
 #endif
 
     return true;
@@ -150,13 +170,15 @@ template <typename ELEM_T, uint32_t Q_SIZE>
 bool ArrayLockFreeQueueSingleProducer<ELEM_T, Q_SIZE>::pop(ELEM_T &a_data)
 {
     uint32_t currentReadIndex;
+    Backoff backoff;
 
     do
     {
-        currentReadIndex = m_readIndex.load();
+        currentReadIndex = AtomicLoad(m_readIndex, std::memory_order_acquire);
 
+        // acquire: the element written by the producer is visible
         if (countToIndex(currentReadIndex) == 
-                countToIndex(m_writeIndex.load()))
+                countToIndex(AtomicLoad(m_writeIndex, std::memory_order_acquire)))
         {
             // queue is empty
             return false;
@@ -173,13 +195,14 @@ bool ArrayLockFreeQueueSingleProducer<ELEM_T, Q_SIZE>::pop(ELEM_T &a_data)
         // When the compare_exchange operation is in a loop the weak version 
         // will yield better performance on some platforms (but here we'd have to
         // load m_writeIndex all over again, better not to fail spuriously)
-        if (m_readIndex.compare_exchange_strong(
-                currentReadIndex, (currentReadIndex + 1)))
+        // release: the slot is handed back to the producer once it is read
+        if (CAS(m_readIndex, currentReadIndex, (currentReadIndex + 1),
+                std::memory_order_release))
         {
             // got here. The value was retrieved from the queue. Note that the
             // data inside the m_queue array is not deleted nor reseted
 #ifdef _WITH_LOCK_FREE_Q_KEEP_REAL_SIZE
-            m_count.fetch_sub(1);
+            AtomicSub(m_count, 1u, std::memory_order_relaxed);
 #endif
             return true;
         }
@@ -187,6 +210,7 @@ bool ArrayLockFreeQueueSingleProducer<ELEM_T, Q_SIZE>::pop(ELEM_T &a_data)
         // it failed retrieving the element off the queue. Someone else must
         // have read the element stored at countToIndex(currentReadIndex)
         // before we could perform the CAS operation        
+        backoff.Wait();
 
     } while(1); // keep looping to try again!
 
@@ -0,0 +1,501 @@
+// ============================================================================
+// Copyright (c) 2026 Faustino Frechilla
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+/// @file  perf_counters.h
+/// @brief Per-thread hardware performance counters (perf_event_open)
+///
+/// PerfCounterGroup opens a group of counters which count what the calling
+/// thread does from then on: cycles, instructions, branch misses, L1 data
+/// cache and last level cache misses (all of them in user space only), the
+/// CPU time of the thread and its context switches. The group is read with a single
+/// read() call, so every counter of a sample covers the same instructions.
+/// If the kernel multiplexes the group with others, values are scaled by
+/// the time it was actually counting.
+///
+/// PerfScope reads the group of the calling thread when it is created and
+/// again when it is destroyed, and adds the difference to a
+/// PerfCounterSample. The sample can then be printed per operation:
+///
+/// PerfCounterSample total;
+/// {
+///     PerfScope scope(total);
+///     for (int i = 0; i < OPERATIONS; i++)
+///     {
+///         DoSomething();
+///     }
+/// }
+/// total.Print(std::cout, OPERATIONS);
+/// // cycles/op=... instructions/op=... ipc=... l1d-misses/op=...
+///
+/// Every PerfScope costs two read() system calls (around a microsecond), so
+/// scopes around hot sections in production code should wrap batches of
+/// operations, not each one. PERF_SCOPE(a_total) creates a PerfScope that
+/// disappears when PERF_COUNTERS_DISABLE is defined.
+///
+/// Events the CPU or the kernel don't offer (virtual machines usually have
+/// no hardware counters at all) are left out of the group: Print skips
+/// them, and IsAvailable tells whether any was opened. The kernel must
+/// allow it: /proc/sys/kernel/perf_event_paranoid 2 or lower is enough.
+///
+/// PERF_EVENT_HITM counts loads served by a cache line modified in the
+/// cache of another core (false sharing, contended atomics). There is no
+/// generic event for it: it is the raw MEM_LOAD_L3_HIT_RETIRED.XSNP_HITM
+/// event of Intel cores since Skylake, only opened on Intel CPUs and not
+/// part of PERF_COUNTERS_DEFAULT_EVENTS. Check the encoding of your CPU
+/// before asking for it.
+///
+/// Your compiler must have support for c++11 and the target must be Linux
+///
+/// @author Faustino Frechilla
+/// @history
+/// Ref        Who                When        What
+///            Faustino Frechilla 17-Oct-2026 Original development
+/// @endhistory
+///
+// ============================================================================
+
+#ifndef _PERF_COUNTERS_H_
+#define _PERF_COUNTERS_H_
+
+#include <stdint.h>             // types (uint64_t...)
+#include <stdio.h>              // snprintf
+#include <string.h>             // memset
+#include <unistd.h>             // syscall, read, close
+#include <sys/ioctl.h>          // ioctl
+#include <sys/syscall.h>        // __NR_perf_event_open
+#include <linux/perf_event.h>   // perf_event_attr
+#include <ostream>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>              // __get_cpuid
+#endif
+
+enum PerfEvent_t
+{
+    PERF_EVENT_CYCLES = 0,
+    PERF_EVENT_INSTRUCTIONS,
+    PERF_EVENT_BRANCH_MISSES,
+    PERF_EVENT_L1D_MISSES,
+    PERF_EVENT_LLC_MISSES,
+    PERF_EVENT_HITM,
+    /// nanoseconds the thread was running
+    PERF_EVENT_TASK_CLOCK,
+    PERF_EVENT_CONTEXT_SWITCHES,
+
+    PERF_EVENT_COUNT
+};
+
+#define PERF_EVENT_BIT(a_event) (1U << (a_event))
+
+/// everything but PERF_EVENT_HITM
+#define PERF_COUNTERS_DEFAULT_EVENTS \
+    (((1U << PERF_EVENT_COUNT) - 1) & ~PERF_EVENT_BIT(PERF_EVENT_HITM))
+
+#define PERF_SCOPE_CONCAT_(a_x, a_y) a_x##a_y
+#define PERF_SCOPE_CONCAT(a_x, a_y)  PERF_SCOPE_CONCAT_(a_x, a_y)
+
+#ifdef PERF_COUNTERS_DISABLE
+#define PERF_SCOPE(a_total)
+#else
+/// @brief counts what the rest of the enclosing block does into a_total
+#define PERF_SCOPE(a_total) \
+    PerfScope PERF_SCOPE_CONCAT(perfScope, __LINE__)(a_total)
+#endif
+
+/// @brief values of the counters (or the difference between two reads)
+class PerfCounterSample
+{
+public:
+    PerfCounterSample()
+    {
+        Reset();
+    }
+
+    void Reset()
+    {
+        memset(m_values, 0, sizeof(m_values));
+        m_available = 0;
+    }
+
+    /// @return true if a_event was counted
+    inline bool IsAvailable(PerfEvent_t a_event) const
+    {
+        return (m_available & PERF_EVENT_BIT(a_event)) != 0;
+    }
+
+    inline uint64_t Value(PerfEvent_t a_event) const
+    {
+        return m_values[a_event];
+    }
+
+    inline void Set(PerfEvent_t a_event, uint64_t a_value)
+    {
+        m_values[a_event] = a_value;
+        m_available |= PERF_EVENT_BIT(a_event);
+    }
+
+    /// @brief adds what was counted between a_start and a_end
+    void AddDelta(const PerfCounterSample &a_start, const PerfCounterSample &a_end)
+    {
+        for (int i = 0; i < PERF_EVENT_COUNT; i++)
+        {
+            if (a_start.IsAvailable(static_cast<PerfEvent_t>(i)) &&
+                a_end.IsAvailable(static_cast<PerfEvent_t>(i)) &&
+                (a_end.m_values[i] >= a_start.m_values[i]))
+            {
+                m_values[i] += a_end.m_values[i] - a_start.m_values[i];
+                m_available |= PERF_EVENT_BIT(i);
+            }
+        }
+    }
+
+    /// @brief adds the counts of another sample (of another thread, say)
+    void Add(const PerfCounterSample &a_other)
+    {
+        for (int i = 0; i < PERF_EVENT_COUNT; i++)
+        {
+            m_values[i] += a_other.m_values[i];
+        }
+        m_available |= a_other.m_available;
+    }
+
+    /// @return a_event per operation. -1.0 if it wasn't counted
+    double PerOperation(PerfEvent_t a_event, uint64_t a_operations) const
+    {
+        if (!IsAvailable(a_event) || (a_operations == 0))
+        {
+            return -1.0;
+        }
+        return static_cast<double>(m_values[a_event]) / a_operations;
+    }
+
+    /// @brief prints every event counted, divided by a_operations, plus
+    /// the instructions per cycle:
+    ///   cycles/op=... instructions/op=... ipc=... task-clock-nsecs/op=...
+    /// "perf-counters=unavailable" if nothing was counted
+    void Print(std::ostream &a_out, uint64_t a_operations) const
+    {
+        if ((m_available == 0) || (a_operations == 0))
+        {
+            a_out << "perf-counters=unavailable" << std::endl;
+            return;
+        }
+
+        char field[64];
+        const char* separator = "";
+        for (int i = 0; i < PERF_EVENT_COUNT; i++)
+        {
+            PerfEvent_t event = static_cast<PerfEvent_t>(i);
+            if (IsAvailable(event))
+            {
+                snprintf(field, sizeof(field), "%s%s/op=%.3f",
+                         separator, EventName(event), PerOperation(event, a_operations));
+                a_out << field;
+                separator = " ";
+            }
+
+            if ((event == PERF_EVENT_INSTRUCTIONS) &&
+                IsAvailable(PERF_EVENT_CYCLES) && IsAvailable(PERF_EVENT_INSTRUCTIONS) &&
+                (m_values[PERF_EVENT_CYCLES] != 0))
+            {
+                snprintf(field, sizeof(field), "%sipc=%.2f", separator,
+                         static_cast<double>(m_values[PERF_EVENT_INSTRUCTIONS]) /
+                         m_values[PERF_EVENT_CYCLES]);
+                a_out << field;
+            }
+        }
+        a_out << std::endl;
+    }
+
+    /// @return the name of a_event as Print shows it
+    static const char* EventName(PerfEvent_t a_event)
+    {
+        static const char* const NAMES[PERF_EVENT_COUNT] = {
+            "cycles",
+            "instructions",
+            "branch-misses",
+            "l1d-misses",
+            "llc-misses",
+            "hitm",
+            "task-clock-nsecs",
+            "context-switches"
+        };
+        return NAMES[a_event];
+    }
+
+private:
+    uint64_t m_values[PERF_EVENT_COUNT];
+    /// PERF_EVENT_BIT of the events counted
+    uint32_t m_available;
+};
+
+/// @brief a group of counters of the thread which created it
+class PerfCounterGroup
+{
+public:
+    /// @brief opens the counters of a_events (PERF_EVENT_BIT mask) which
+    /// are available. They count the calling thread only, from now on
+    explicit PerfCounterGroup(uint32_t a_events = PERF_COUNTERS_DEFAULT_EVENTS):
+        m_leader(-1),
+        m_count(0)
+    {
+        for (int i = 0; i < PERF_EVENT_COUNT; i++)
+        {
+            PerfEvent_t event = static_cast<PerfEvent_t>(i);
+            struct perf_event_attr attr;
+            if (((a_events & PERF_EVENT_BIT(event)) == 0) || !EventAttr(event, attr))
+            {
+                continue;
+            }
+
+            // the first one to open leads the group. Counting starts
+            // straight away and never stops
+            attr.read_format = PERF_FORMAT_GROUP |
+                               PERF_FORMAT_TOTAL_TIME_ENABLED |
+                               PERF_FORMAT_TOTAL_TIME_RUNNING;
+            int fd = Open(attr);
+            if ((fd < 0) && !attr.exclude_kernel)
+            {
+                // not allowed to count in the kernel. Context switches are
+                // then always 0, but the task clock still works
+                attr.exclude_kernel = 1;
+                fd = Open(attr);
+            }
+            if (fd < 0)
+            {
+                continue;
+            }
+
+            if (m_leader < 0)
+            {
+                m_leader = fd;
+            }
+            m_fds[m_count] = fd;
+            m_events[m_count] = event;
+            m_count++;
+        }
+    }
+
+    ~PerfCounterGroup()
+    {
+        for (uint32_t i = 0; i < m_count; i++)
+        {
+            close(m_fds[i]);
+        }
+    }
+
+    /// @return true if at least one counter could be opened
+    inline bool IsAvailable() const
+    {
+        return m_leader >= 0;
+    }
+
+    /// @return true if a_event could be opened
+    bool IsAvailable(PerfEvent_t a_event) const
+    {
+        for (uint32_t i = 0; i < m_count; i++)
+        {
+            if (m_events[i] == a_event)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// @brief reads every counter of the group at once. Only the thread
+    /// which created the group should read it
+    /// @return false if the group couldn't be read (out_sample is empty)
+    bool Read(PerfCounterSample &out_sample) const
+    {
+        out_sample.Reset();
+        if (m_leader < 0)
+        {
+            return false;
+        }
+
+        // nr, time enabled, time running and a value per counter
+        uint64_t buffer[3 + PERF_EVENT_COUNT];
+        ssize_t size = read(m_leader, buffer, sizeof(buffer));
+        if ((size < static_cast<ssize_t>(3 * sizeof(uint64_t))) || (buffer[0] != m_count))
+        {
+            return false;
+        }
+
+        uint64_t enabled = buffer[1];
+        uint64_t running = buffer[2];
+        if (running == 0)
+        {
+            // the group couldn't be scheduled on the PMU at all
+            return false;
+        }
+
+        for (uint32_t i = 0; i < m_count; i++)
+        {
+            uint64_t value = buffer[3 + i];
+            if (running < enabled)
+            {
+                // multiplexed with other groups: extrapolate
+                value = static_cast<uint64_t>(
+                    static_cast<double>(value) * enabled / running);
+            }
+            out_sample.Set(m_events[i], value);
+        }
+        return true;
+    }
+
+    /// @return the group of the calling thread, opened with
+    ///         PERF_COUNTERS_DEFAULT_EVENTS the first time it is needed
+    static PerfCounterGroup& ThisThread()
+    {
+        static thread_local PerfCounterGroup t_group;
+        return t_group;
+    }
+
+private:
+    int m_leader;
+    int m_fds[PERF_EVENT_COUNT];
+    PerfEvent_t m_events[PERF_EVENT_COUNT];
+    uint32_t m_count;
+
+    /// @return the file descriptor of the new counter, -1 on error
+    int Open(struct perf_event_attr &a_attr) const
+    {
+        return static_cast<int>(syscall(__NR_perf_event_open, &a_attr,
+            0 /* this thread */, -1 /* any cpu */, m_leader, PERF_FLAG_FD_CLOEXEC));
+    }
+
+    /// @brief fills a_attr for a_event
+    /// @return false if a_event can't be counted on this CPU
+    static bool EventAttr(PerfEvent_t a_event, struct perf_event_attr &a_attr)
+    {
+        memset(&a_attr, 0, sizeof(a_attr));
+        a_attr.size = sizeof(a_attr);
+        a_attr.exclude_kernel = 1;
+        a_attr.exclude_hv = 1;
+        a_attr.type = PERF_TYPE_HARDWARE;
+
+        switch (a_event)
+        {
+        case PERF_EVENT_CYCLES:
+            a_attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            return true;
+
+        case PERF_EVENT_INSTRUCTIONS:
+            a_attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            return true;
+
+        case PERF_EVENT_BRANCH_MISSES:
+            a_attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            return true;
+
+        case PERF_EVENT_L1D_MISSES:
+            a_attr.type = PERF_TYPE_HW_CACHE;
+            a_attr.config = PERF_COUNT_HW_CACHE_L1D |
+                            (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                            (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            return true;
+
+        case PERF_EVENT_LLC_MISSES:
+            a_attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            return true;
+
+        case PERF_EVENT_HITM:
+            if (!IsIntel())
+            {
+                return false;
+            }
+            // MEM_LOAD_L3_HIT_RETIRED.XSNP_HITM: event 0xd2, umask 0x04
+            a_attr.type = PERF_TYPE_RAW;
+            a_attr.config = 0x04d2;
+            return true;
+
+        // these two happen in the kernel
+        case PERF_EVENT_TASK_CLOCK:
+            a_attr.type = PERF_TYPE_SOFTWARE;
+            a_attr.config = PERF_COUNT_SW_TASK_CLOCK;
+            a_attr.exclude_kernel = 0;
+            return true;
+
+        case PERF_EVENT_CONTEXT_SWITCHES:
+            a_attr.type = PERF_TYPE_SOFTWARE;
+            a_attr.config = PERF_COUNT_SW_CONTEXT_SWITCHES;
+            a_attr.exclude_kernel = 0;
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    static bool IsIntel()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned int eax, ebx, ecx, edx;
+        if (__get_cpuid(0, &eax, &ebx, &ecx, &edx) == 0)
+        {
+            return false;
+        }
+        // "GenuineIntel"
+        return (ebx == 0x756e6547) && (edx == 0x49656e69) && (ecx == 0x6c65746e);
+#else
+        return false;
+#endif
+    }
+
+    // prevent copying
+    PerfCounterGroup(const PerfCounterGroup &a_src);
+    PerfCounterGroup& operator=(const PerfCounterGroup &a_src);
+};
+
+/// @brief adds what the calling thread counts during its lifetime to a
+/// PerfCounterSample. The sample isn't protected: give each thread its own
+/// and Add them up afterwards
+class PerfScope
+{
+public:
+    explicit PerfScope(PerfCounterSample &a_total,
+                       const PerfCounterGroup &a_group = PerfCounterGroup::ThisThread()):
+        m_total(a_total),
+        m_group(a_group)
+    {
+        m_group.Read(m_start);
+    }
+
+    ~PerfScope()
+    {
+        PerfCounterSample end;
+        if (m_group.Read(end))
+        {
+            m_total.AddDelta(m_start, end);
+        }
+    }
+
+private:
+    PerfCounterSample &m_total;
+    const PerfCounterGroup &m_group;
+    PerfCounterSample m_start;
+
+    // prevent copying
+    PerfScope(const PerfScope &a_src);
+    PerfScope& operator=(const PerfScope &a_src);
+};
+
+#endif /* _PERF_COUNTERS_H_ */
@@ -0,0 +1,532 @@
+// ============================================================================
+// Copyright (c) 2026 Faustino Frechilla
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+/// @file replicated_singleton.h
+/// @brief Templates to create singletons replicated per thread or per NUMA node
+///
+/// Singleton<T> gives every thread the same instance, which turns objects
+/// written by every thread (counters, caches...) into a cache line ping-pong
+/// hotspot. The templates in this file keep a replica of the instance per
+/// thread (PerThreadSingleton) or per NUMA node (PerNumaNodeSingleton)
+/// instead. Both offer the same Instance() and GetPtr() methods as Singleton,
+/// so a class opts in by changing its base class (and the friend
+/// declaration). Call sites stay the same.
+///
+/// Every replica is registered in a lock-free list, so all of them can be
+/// visited (ForEachInstance) or aggregated (Aggregate) from any thread, for
+/// instance to add up per-thread counters. Replicas are allocated aligned to
+/// (and padded up to) REPLICATED_SINGLETON_CACHE_LINE_SIZE bytes so two of
+/// them never share a cache line.
+///
+/// Replicas are never destroyed, same as the instance of Singleton. The
+/// replica of a thread that exits is kept (with whatever it holds, so
+/// aggregates don't lose anything) and handed over to the next new thread
+/// that asks for one. Right before that, still in the exiting thread,
+/// PerThreadSingleton calls the OnThreadExit method of the replica, which a
+/// class can override to leave its replica ready for the next owner.
+///
+/// Your compiler must have support for c++11 and the target must be Linux
+/// (sched_getcpu and /sys are used to find the NUMA node of the caller)
+///
+/// @author Faustino Frechilla
+/// @history
+/// Ref       Who                When         What
+///           Faustino Frechilla 17-Oct-2026  Original development
+///           Faustino Frechilla 17-Oct-2026  PerThreadSingleton::OnThreadExit
+/// @endhistory
+///
+// ============================================================================
+
+#ifndef _REPLICATEDSINGLETON_H_
+#define _REPLICATEDSINGLETON_H_
+
+#include <stdlib.h>   // posix_memalign
+#include <stdio.h>    // snprintf, fopen
+#include <sched.h>    // sched_getcpu
+#include <assert.h>
+#include <atomic>
+#include <vector>
+#include <new>        // placement new
+#include "singleton.h"
+
+#define REPLICATED_SINGLETON_CACHE_LINE_SIZE 64
+
+// maximum number of NUMA nodes PerNumaNodeSingleton can tell apart. CPUs of
+// nodes beyond that share the replica of node 0
+#define REPLICATED_SINGLETON_MAX_NUMA_NODES 64
+
+/// @brief helpers shared by the replicated singletons
+class ReplicatedSingletonUtils
+{
+public:
+    /// @brief allocates memory for an object of size a_size which doesn't
+    ///        share any cache line with anything else
+    static void* AllocateAligned(std::size_t a_size)
+    {
+        std::size_t size = ((a_size + REPLICATED_SINGLETON_CACHE_LINE_SIZE - 1) /
+            REPLICATED_SINGLETON_CACHE_LINE_SIZE) * REPLICATED_SINGLETON_CACHE_LINE_SIZE;
+
+        void* memory = 0;
+        int rv = posix_memalign(&memory, REPLICATED_SINGLETON_CACHE_LINE_SIZE, size);
+        assert(rv == 0);
+        (void) rv;
+
+        return memory;
+    }
+
+    /// @return the NUMA node the calling thread is running on (0 if unknown)
+    static inline int CurrentNumaNode()
+    {
+        int cpu = sched_getcpu();
+        const std::vector<int> &nodes = CpuToNumaNode();
+        if ((cpu < 0) || (static_cast<std::size_t>(cpu) >= nodes.size()))
+        {
+            return 0;
+        }
+        return nodes[cpu];
+    }
+
+    /// @return the number of NUMA nodes in the system (at least 1)
+    static int NumaNodeCount()
+    {
+        const std::vector<int> &nodes = CpuToNumaNode();
+        int count = 1;
+        for (std::size_t i = 0; i < nodes.size(); i++)
+        {
+            if (nodes[i] + 1 > count)
+            {
+                count = nodes[i] + 1;
+            }
+        }
+        return count;
+    }
+
+private:
+    ReplicatedSingletonUtils();
+
+    /// @brief NUMA node of each CPU, read once from
+    ///        /sys/devices/system/node/node<N>/cpulist
+    static const std::vector<int>& CpuToNumaNode()
+    {
+        // thread-safe initialisation of function-local statics (c++11)
+        static const std::vector<int> s_nodes = ReadCpuToNumaNode();
+        return s_nodes;
+    }
+
+    static std::vector<int> ReadCpuToNumaNode()
+    {
+        std::vector<int> nodes;
+
+        for (int node = 0; node < REPLICATED_SINGLETON_MAX_NUMA_NODES; node++)
+        {
+            char path[128];
+            snprintf(path, sizeof(path),
+                "/sys/devices/system/node/node%d/cpulist", node);
+
+            FILE* file = fopen(path, "r");
+            if (file == 0)
+            {
+                continue;
+            }
+
+            // cpulist looks like "0-3,8-11"
+            int first;
+            while (fscanf(file, "%d", &first) == 1)
+            {
+                int last = first;
+                int separator = fgetc(file);
+                if (separator == '-')
+                {
+                    if (fscanf(file, "%d", &last) != 1)
+                    {
+                        break;
+                    }
+                    separator = fgetc(file);
+                }
+
+                if (last >= static_cast<int>(nodes.size()))
+                {
+                    nodes.resize(last + 1, 0);
+                }
+                for (int cpu = first; cpu <= last; cpu++)
+                {
+                    nodes[cpu] = node;
+                }
+
+                if (separator != ',')
+                {
+                    break;
+                }
+            }
+            fclose(file);
+        }
+
+        return nodes;
+    }
+};
+
+/// @brief A templatised class for singletons replicated per thread
+/// Each thread calling Instance() gets its own instance. Example of usage:
+///
+/// class MyCounters: public PerThreadSingleton<MyCounters>
+/// {
+/// public:
+///     // read by Aggregate from other threads, hence the atomic
+///     std::atomic<uint64_t> requests;
+/// private:
+///     friend class PerThreadSingleton<MyCounters>;
+///     MyCounters(): requests(0) {}
+///     ~MyCounters();
+/// };
+///
+/// /* hot path. No cache line shared with other threads */
+/// MyCounters::Instance().requests.fetch_add(1, std::memory_order_relaxed);
+///
+/// /* reporting thread */
+/// uint64_t total = MyCounters::Aggregate(static_cast<uint64_t>(0),
+///     [](uint64_t a_sum, const MyCounters &a_counters) {
+///         return a_sum + a_counters.requests.load(std::memory_order_relaxed); });
+template <class TClass>
+class PerThreadSingleton
+{
+public:
+    /// @brief Gives access to the instance of the calling thread
+    /// @return a reference to the instance of the calling thread
+    static TClass& Instance()
+    {
+        TClass* instance = t_instance;
+        if (instance == 0)
+        {
+            return CreateInstance();
+        }
+
+        return *instance;
+    }
+
+    /// @brief Gives access to the instance of the calling thread using a
+    ///        pointer
+    /// @return a pointer to the instance of the calling thread
+    static TClass* GetPtr()
+    {
+        return &(PerThreadSingleton<TClass>::Instance());
+    }
+
+    /// @brief Gets the calling thread a replica if it doesn't have one yet
+    /// Call it when a thread starts so its first call to Instance() on a hot
+    /// path doesn't have to build the replica
+    /// @return a reference to the instance of the calling thread
+    static SINGLETON_NOINLINE TClass& CreateInstance();
+
+    /// @brief calls a_function once per replica, including those whose
+    /// thread has finished. It can be called from any thread, while the
+    /// owners of the replicas are using them
+    template <typename FUNCTION_T>
+    static void ForEachInstance(FUNCTION_T a_function)
+    {
+        for (Replica* replica = m_replicas.load(std::memory_order_acquire);
+             replica != 0;
+             replica = replica->next)
+        {
+            a_function(*(replica->instance));
+        }
+    }
+
+    /// @brief folds every replica into a single value
+    /// @param a_init the initial value
+    /// @param a_op called as a_op(RESULT_T, const TClass&) per replica. It
+    ///        returns the new value
+    template <typename RESULT_T, typename OPERATION_T>
+    static RESULT_T Aggregate(RESULT_T a_init, OPERATION_T a_op)
+    {
+        RESULT_T result = a_init;
+        for (Replica* replica = m_replicas.load(std::memory_order_acquire);
+             replica != 0;
+             replica = replica->next)
+        {
+            result = a_op(result, *(replica->instance));
+        }
+        return result;
+    }
+
+    /// @return the number of replicas built so far
+    static std::size_t InstanceCount()
+    {
+        return m_replicaCount.load(std::memory_order_relaxed);
+    }
+
+protected:
+    PerThreadSingleton(){};
+    virtual ~PerThreadSingleton(){};
+
+    /// @brief called by the thread that owns the replica when it finishes,
+    /// right before the replica is handed over to whichever thread asks for
+    /// one next. Per-thread state that must not leak into the next owner is
+    /// reset here. It does nothing by default
+    virtual void OnThreadExit(){};
+
+private:
+    /// @brief a replica registered in the list of replicas
+    struct Replica
+    {
+        TClass* instance;
+        /// true while a thread owns it
+        std::atomic<bool> inUse;
+        /// next replica in the list. Never modified once in the list
+        Replica* next;
+    };
+
+    /// @brief gives the replica of a thread back when the thread finishes
+    struct ReplicaOwner
+    {
+        Replica* replica;
+
+        ReplicaOwner(): replica(0) {}
+        ~ReplicaOwner()
+        {
+            if (replica)
+            {
+                static_cast<PerThreadSingleton<TClass>*>(replica->instance)->OnThreadExit();
+                t_instance = 0;
+                replica->inUse.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    /// the instance of the calling thread. Trivially constructible so
+    /// reading it costs no more than a load from thread-local storage
+    static thread_local TClass* t_instance;
+
+    /// list of replicas. Replicas are pushed to the front and never removed
+    static std::atomic<Replica*> m_replicas;
+
+    /// number of replicas in the list
+    static std::atomic<std::size_t> m_replicaCount;
+};
+
+template <class TClass>
+TClass& PerThreadSingleton<TClass>::CreateInstance()
+{
+    if (t_instance != 0)
+    {
+        return *t_instance;
+    }
+
+    // it gives the replica back to the list when this thread finishes
+    static thread_local ReplicaOwner t_owner;
+
+    // reuse a replica whose thread has finished
+    Replica* replica = m_replicas.load(std::memory_order_acquire);
+    for (; replica != 0; replica = replica->next)
+    {
+        if (!replica->inUse.load(std::memory_order_relaxed) &&
+            !replica->inUse.exchange(true, std::memory_order_acquire))
+        {
+            break;
+        }
+    }
+
+    if (replica == 0)
+    {
+        replica = new Replica;
+        replica->instance = new (ReplicatedSingletonUtils::AllocateAligned(
+            sizeof(TClass))) TClass();
+        replica->inUse.store(true, std::memory_order_relaxed);
+
+        // push it to the front of the list
+        replica->next = m_replicas.load(std::memory_order_relaxed);
+        while (!m_replicas.compare_exchange_weak(
+                    replica->next, replica,
+                    std::memory_order_release,
+                    std::memory_order_relaxed))
+        {
+            ; // replica->next has been updated with the current head
+        }
+        m_replicaCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    t_owner.replica = replica;
+    t_instance = replica->instance;
+    return *t_instance;
+}
+
+template <class TClass>
+thread_local TClass* PerThreadSingleton<TClass>::t_instance = 0;
+template <class TClass>
+std::atomic<typename PerThreadSingleton<TClass>::Replica*>
+    PerThreadSingleton<TClass>::m_replicas(0);
+template <class TClass>
+std::atomic<std::size_t> PerThreadSingleton<TClass>::m_replicaCount(0);
+
+/// @brief A templatised class for singletons replicated per NUMA node
+/// Threads running on CPUs of the same NUMA node share the same instance, so
+/// it must be thread-safe. A thread might be moved to another node by the
+/// scheduler at any time, which means two calls to Instance() might return
+/// different instances. It is used the same way as PerThreadSingleton:
+///
+/// class MyCache: public PerNumaNodeSingleton<MyCache>
+/// {
+///     /* ... */
+///     friend class PerNumaNodeSingleton<MyCache>;
+///     MyCache();
+///     ~MyCache();
+/// };
+///
+/// MyCache::Instance().Lookup(key);
+template <class TClass>
+class PerNumaNodeSingleton
+{
+public:
+    /// @brief Gives access to the instance of the NUMA node the calling
+    ///        thread is running on
+    /// @return a reference to the instance of the current NUMA node
+    static TClass& Instance()
+    {
+        int node = ReplicatedSingletonUtils::CurrentNumaNode();
+        if (node >= REPLICATED_SINGLETON_MAX_NUMA_NODES)
+        {
+            node = 0;
+        }
+
+        TClass* instance = m_instances[node].load(std::memory_order_acquire);
+        if (instance == 0)
+        {
+            return CreateInstance(node);
+        }
+
+        return *instance;
+    }
+
+    /// @brief Gives access to the instance of the current NUMA node using a
+    ///        pointer
+    /// @return a pointer to the instance of the current NUMA node
+    static TClass* GetPtr()
+    {
+        return &(PerNumaNodeSingleton<TClass>::Instance());
+    }
+
+    /// @brief builds the instance of every NUMA node in the system. Call it
+    /// during startup so the first call to Instance() on a hot path doesn't
+    /// stall
+    static void CreateInstances()
+    {
+        int count = ReplicatedSingletonUtils::NumaNodeCount();
+        for (int node = 0; (node < count) && (node < REPLICATED_SINGLETON_MAX_NUMA_NODES); node++)
+        {
+            CreateInstance(node);
+        }
+    }
+
+    /// @brief calls a_function once per instance built so far. It can be
+    /// called from any thread
+    template <typename FUNCTION_T>
+    static void ForEachInstance(FUNCTION_T a_function)
+    {
+        for (int node = 0; node < REPLICATED_SINGLETON_MAX_NUMA_NODES; node++)
+        {
+            TClass* instance = m_instances[node].load(std::memory_order_acquire);
+            if (instance)
+            {
+                a_function(*instance);
+            }
+        }
+    }
+
+    /// @brief folds every instance into a single value
+    /// @param a_init the initial value
+    /// @param a_op called as a_op(RESULT_T, const TClass&) per instance. It
+    ///        returns the new value
+    template <typename RESULT_T, typename OPERATION_T>
+    static RESULT_T Aggregate(RESULT_T a_init, OPERATION_T a_op)
+    {
+        RESULT_T result = a_init;
+        for (int node = 0; node < REPLICATED_SINGLETON_MAX_NUMA_NODES; node++)
+        {
+            TClass* instance = m_instances[node].load(std::memory_order_acquire);
+            if (instance)
+            {
+                result = a_op(result, *instance);
+            }
+        }
+        return result;
+    }
+
+    /// @return the number of instances built so far
+    static std::size_t InstanceCount()
+    {
+        std::size_t count = 0;
+        for (int node = 0; node < REPLICATED_SINGLETON_MAX_NUMA_NODES; node++)
+        {
+            if (m_instances[node].load(std::memory_order_relaxed))
+            {
+                count++;
+            }
+        }
+        return count;
+    }
+
+protected:
+    PerNumaNodeSingleton(){};
+    virtual ~PerNumaNodeSingleton(){};
+
+private:
+    /// @brief builds the instance of a_node if it hasn't been built yet
+    static SINGLETON_NOINLINE TClass& CreateInstance(int a_node);
+
+    /// the instance of each NUMA node
+    static std::atomic<TClass*> m_instances[REPLICATED_SINGLETON_MAX_NUMA_NODES];
+
+    /// a spinlock so only one instance is built per node
+    static std::atomic<bool> m_lock;
+};
+
+template <class TClass>
+TClass& PerNumaNodeSingleton<TClass>::CreateInstance(int a_node)
+{
+    // same as Singleton::CreateInstance
+    Backoff backoff;
+    while (m_lock.exchange(true, std::memory_order_acquire))
+    {
+        while (m_lock.load(std::memory_order_relaxed))
+        {
+            backoff.Wait();
+        }
+    }
+
+    TClass* instance = m_instances[a_node].load(std::memory_order_relaxed);
+    if (instance == 0)
+    {
+        instance = new (ReplicatedSingletonUtils::AllocateAligned(
+            sizeof(TClass))) TClass();
+        m_instances[a_node].store(instance, std::memory_order_release);
+    }
+
+    m_lock.store(false, std::memory_order_release);
+
+    return *instance;
+}
+
+// static storage is zero-initialised, which is a null pointer
+template <class TClass>
+std::atomic<TClass*> PerNumaNodeSingleton<TClass>::m_instances[REPLICATED_SINGLETON_MAX_NUMA_NODES];
+template <class TClass>
+std::atomic<bool> PerNumaNodeSingleton<TClass>::m_lock(false);
+
+#endif /* _REPLICATEDSINGLETON_H_ */
@@ -36,6 +36,7 @@
 ///      Faustino Frechilla 19-May-2010 Ported to glib. Removed pthread dependency
 ///      Faustino Frechilla 06-Jun-2013 Ported to c++11. Removed glib dependency
 ///      Faustino Frechilla 19-Mar-2014 Copy/move constructor, operator= and move assignment
+///      Faustino Frechilla 17-Oct-2026 Size
 /// @endhistory
 ///
 // ============================================================================
@@ -92,6 +93,12 @@ public:
     /// @return true if the queue is empty. False otherwise
     bool IsEmpty() const;
 
+    /// @brief number of elements in the queue
+    /// This call can block if another thread owns the lock that protects the
+    /// queue. Other threads may push or pop right after it returns
+    /// @return the number of elements in the queue
+    std::size_t Size() const;
+
     /// @brief inserts an element into queue queue
     /// This call can block if another thread owns the lock that protects the
     /// queue. If the queue is full The thread will be blocked in this queue
@@ -32,6 +32,7 @@
 ///      Faustino Frechilla 06-Jun-2013 Ported to c++11. Removed glib dependency
 ///      Faustino Frechilla 13-Dec-2013 Handling spurious wakeups in TimedWaitPop
 ///      Faustino Frechilla 19-Mar-2014 Copy/move constructor, operator= and move assignment
+///      Faustino Frechilla 17-Oct-2026 Size
 /// @endhistory
 ///
 // ============================================================================
@@ -168,6 +169,13 @@ bool SafeQueue<T>::IsEmpty() const
     return m_theQueue.empty();
 }
 
+template <typename T>
+std::size_t SafeQueue<T>::Size() const
+{
+    std::lock_guard<std::mutex> lk(m_mutex);
+    return m_theQueue.size();
+}
+
 template <typename T>
 void SafeQueue<T>::Push(const T &a_elem)
 {
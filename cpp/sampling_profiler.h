@@ -0,0 +1,533 @@
+// ============================================================================
+// Copyright (c) 2026 Faustino Frechilla
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+/// @file  sampling_profiler.h
+/// @brief In-process sampling profiler (SIGPROF + frame pointer unwinding)
+///
+/// It answers the same question as scripts/poormansprofiler.sh (which
+/// stacks are hot?) without stopping the process: gdb freezes every thread
+/// for hundreds of milliseconds per sample, this profiler takes a couple of
+/// microseconds of the thread it interrupts.
+///
+/// Start arms a ITIMER_PROF timer, which sends SIGPROF every 1/a_hz seconds
+/// of CPU time consumed by the process. The kernel delivers it to a thread
+/// which is running, so busy threads get sampled in proportion to the CPU
+/// they use and idle ones aren't sampled at all. The signal handler:
+///   - walks the frame pointers of the interrupted thread, starting from
+///     its registers, checking every frame is above the previous one and
+///     not too far from it. A register which isn't a frame pointer can
+///     still pass those checks, so the stack is never dereferenced: it is
+///     copied out with process_vm_readv, which fails instead of faulting on
+///     memory that isn't mapped, and a bad frame pointer just ends the
+///     stack. Code built without frame pointers shows truncated stacks:
+///     build with -fno-omit-frame-pointer. Even then gcc leaves the frame
+///     out of leaf functions which don't use the stack, so a sample taken
+///     in one of those misses the function which called it
+///   - counts the stack in a fixed size open addressing table. A new stack
+///     claims an empty entry with a CAS, the same stack seen again is an
+///     atomic increment. Nothing is allocated or locked. If the table is
+///     full the sample is counted as dropped
+/// WriteFolded translates the addresses into function names (dladdr and
+/// the C++ demangler, so link with -rdynamic to get the names of the
+/// functions of the executable. The others are printed as module+offset)
+/// and writes one line per stack in the folded format flamegraph.pl reads:
+///   main;Server::Run;Server::Poll;poll 1234
+///
+/// Example of usage:
+///
+/// SamplingProfiler::Start(99);
+/// /* ... */
+/// SamplingProfiler::Stop();
+/// std::ofstream out("profile.folded");
+/// SamplingProfiler::WriteFolded(out);
+///
+/// The SIGPROF handler stays installed after Stop (a late signal with the
+/// default action would kill the process), so SIGPROF and ITIMER_PROF
+/// can't be used for anything else. Only one thread may call Start, Stop
+/// and Reset. WriteFolded can be called while sampling.
+///
+/// Your compiler must have support for c++11, and the target must be Linux
+/// on x86_64 or aarch64 (anywhere else only the interrupted function is
+/// recorded)
+///
+/// @author Faustino Frechilla
+/// @history
+/// Ref        Who                When        What
+///            Faustino Frechilla 17-Oct-2026 Original development
+///            Faustino Frechilla 17-Oct-2026 Stack copied without faulting
+///            Faustino Frechilla 17-Oct-2026 Start(1) arms a 1s timer
+/// @endhistory
+///
+// ============================================================================
+
+#ifndef _SAMPLING_PROFILER_H_
+#define _SAMPLING_PROFILER_H_
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE       // dladdr, REG_RIP
+#endif
+
+#include <stdint.h>       // types (uint64_t...)
+#include <stdio.h>        // snprintf
+#include <stdlib.h>       // free
+#include <string.h>       // memset
+#include <errno.h>
+#include <unistd.h>       // getpid
+#include <signal.h>       // sigaction
+#include <sys/uio.h>      // process_vm_readv
+#include <ucontext.h>     // ucontext_t
+#include <dlfcn.h>        // dladdr
+#include <cxxabi.h>       // abi::__cxa_demangle
+#include <sys/time.h>     // setitimer
+#include <atomic>
+#include <map>
+#include <string>
+#include <ostream>
+
+/// deepest stack recorded. Deeper stacks lose the frames closest to main
+#ifndef SAMPLING_PROFILER_MAX_DEPTH
+#define SAMPLING_PROFILER_MAX_DEPTH   64
+#endif
+/// different stacks the table can count (a power of 2)
+#ifndef SAMPLING_PROFILER_TABLE_SIZE
+#define SAMPLING_PROFILER_TABLE_SIZE  4096
+#endif
+/// entries looked at before a sample is dropped
+#define SAMPLING_PROFILER_MAX_PROBES  64
+/// biggest distance between two frames (and from the stack pointer to the
+/// first one) the unwinder believes
+#define SAMPLING_PROFILER_MAX_FRAME_SIZE (1024 * 1024)
+/// words of the stack copied at once by the unwinder
+#define SAMPLING_PROFILER_COPY_WORDS  64
+/// process_vm_readv copies are split at multiples of this (the smallest
+/// page size), so a copy running into memory which isn't mapped stops there
+#define SAMPLING_PROFILER_PAGE_SIZE   4096
+
+#define SAMPLING_PROFILER_DEFAULT_HZ  99
+
+/// @brief a SIGPROF based sampling profiler. Static members only, there is
+/// one timer per process
+class SamplingProfiler
+{
+public:
+    /// @brief starts sampling a_hz times per second of CPU time
+    /// @return false if the signal handler or the timer couldn't be set up
+    static bool Start(uint32_t a_hz = SAMPLING_PROFILER_DEFAULT_HZ)
+    {
+        State &state = GetState();
+        if ((a_hz == 0) || (a_hz > 1000000))
+        {
+            return false;
+        }
+
+        if (!state.handlerInstalled)
+        {
+            struct sigaction action;
+            memset(&action, 0, sizeof(action));
+            action.sa_sigaction = &SamplingProfiler::OnSignal;
+            action.sa_flags = SA_SIGINFO | SA_RESTART;
+            sigemptyset(&action.sa_mask);
+            if (sigaction(SIGPROF, &action, 0) != 0)
+            {
+                return false;
+            }
+            state.handlerInstalled = true;
+        }
+
+        state.enabled.store(true, std::memory_order_release);
+
+        // tv_usec must be below a second
+        uint32_t period = 1000000 / a_hz;
+        struct itimerval timer;
+        timer.it_interval.tv_sec  = period / 1000000;
+        timer.it_interval.tv_usec = period % 1000000;
+        timer.it_value = timer.it_interval;
+        if (setitimer(ITIMER_PROF, &timer, 0) != 0)
+        {
+            state.enabled.store(false, std::memory_order_release);
+            return false;
+        }
+        return true;
+    }
+
+    /// @brief stops sampling. What was counted is kept
+    static void Stop()
+    {
+        struct itimerval timer;
+        memset(&timer, 0, sizeof(timer));
+        setitimer(ITIMER_PROF, &timer, 0);
+        GetState().enabled.store(false, std::memory_order_release);
+    }
+
+    /// @return true between Start and Stop
+    static bool IsRunning()
+    {
+        return GetState().enabled.load(std::memory_order_acquire);
+    }
+
+    /// @brief forgets every sample. Call it while stopped
+    static void Reset()
+    {
+        State &state = GetState();
+        for (uint32_t i = 0; i < SAMPLING_PROFILER_TABLE_SIZE; i++)
+        {
+            state.table[i].count.store(0, std::memory_order_relaxed);
+            state.table[i].hash.store(ENTRY_EMPTY, std::memory_order_release);
+        }
+        state.samples.store(0, std::memory_order_relaxed);
+        state.dropped.store(0, std::memory_order_relaxed);
+    }
+
+    /// @return samples taken (counted or dropped)
+    static uint64_t Samples()
+    {
+        return GetState().samples.load(std::memory_order_relaxed);
+    }
+
+    /// @return samples which didn't fit in the table
+    static uint64_t Dropped()
+    {
+        return GetState().dropped.load(std::memory_order_relaxed);
+    }
+
+    /// @brief calls a_function(const uintptr_t* a_frames, uint32_t a_depth,
+    /// uint64_t a_count) for every stack counted. a_frames[0] is the
+    /// address the thread was interrupted at, the rest are return addresses
+    template <typename FUNCTION_T>
+    static void ForEachStack(FUNCTION_T a_function)
+    {
+        State &state = GetState();
+        for (uint32_t i = 0; i < SAMPLING_PROFILER_TABLE_SIZE; i++)
+        {
+            Entry &entry = state.table[i];
+            // acquire: the frames were written before the hash
+            uint64_t hash = entry.hash.load(std::memory_order_acquire);
+            if ((hash != ENTRY_EMPTY) && (hash != ENTRY_BUSY))
+            {
+                a_function(entry.frames, entry.depth, entry.count.load(std::memory_order_relaxed));
+            }
+        }
+    }
+
+    /// @brief writes every stack counted, symbolised, in folded format
+    /// (frames from the outermost to the innermost, ';' separated, and the
+    /// number of samples). Stacks which resolve to the same functions are
+    /// added up. Lines are sorted by stack
+    static void WriteFolded(std::ostream &a_out)
+    {
+        std::map<std::string, uint64_t> stacks;
+        std::map<uintptr_t, std::string> symbols;
+
+        ForEachStack([&stacks, &symbols](const uintptr_t* a_frames, uint32_t a_depth, uint64_t a_count) {
+            if (a_count == 0)
+            {
+                return;
+            }
+
+            std::string stack;
+            for (uint32_t i = a_depth; i > 0; i--)
+            {
+                // return addresses point after the call, which might
+                // already be the next function
+                uintptr_t address = (i > 1) ? (a_frames[i - 1] - 1) : a_frames[i - 1];
+                std::map<uintptr_t, std::string>::iterator it = symbols.find(address);
+                if (it == symbols.end())
+                {
+                    it = symbols.insert(std::make_pair(address, Symbolise(address))).first;
+                }
+                if (!stack.empty())
+                {
+                    stack += ';';
+                }
+                stack += it->second;
+            }
+            stacks[stack] += a_count;
+        });
+
+        for (std::map<std::string, uint64_t>::const_iterator it = stacks.begin();
+             it != stacks.end();
+             ++it)
+        {
+            a_out << it->first << ' ' << it->second << '\n';
+        }
+        a_out.flush();
+    }
+
+    /// @return the name of the function a_address belongs to, or
+    ///         module+offset if it hasn't got one
+    static std::string Symbolise(uintptr_t a_address)
+    {
+        char buffer[64];
+        Dl_info info;
+        if (dladdr(reinterpret_cast<void*>(a_address), &info) == 0)
+        {
+            snprintf(buffer, sizeof(buffer), "0x%lx", static_cast<unsigned long>(a_address));
+            return std::string(buffer);
+        }
+
+        if (info.dli_sname != 0)
+        {
+            int status = 0;
+            char* demangled = abi::__cxa_demangle(info.dli_sname, 0, 0, &status);
+            std::string name((status == 0) && (demangled != 0) ? demangled : info.dli_sname);
+            free(demangled);
+            return Sanitise(name);
+        }
+
+        const char* module = (info.dli_fname != 0) ? info.dli_fname : "?";
+        const char* slash = strrchr(module, '/');
+        snprintf(buffer, sizeof(buffer), "+0x%lx",
+                 static_cast<unsigned long>(a_address - reinterpret_cast<uintptr_t>(info.dli_fbase)));
+        return Sanitise(std::string((slash != 0) ? (slash + 1) : module) + buffer);
+    }
+
+private:
+    /// hash of an entry nobody uses
+    static const uint64_t ENTRY_EMPTY = 0;
+    /// hash of an entry which is being filled in
+    static const uint64_t ENTRY_BUSY = 1;
+
+    struct Entry
+    {
+        /// hash of the stack once frames and depth are written
+        std::atomic<uint64_t> hash;
+        std::atomic<uint64_t> count;
+        uint32_t depth;
+        uintptr_t frames[SAMPLING_PROFILER_MAX_DEPTH];
+    };
+
+    struct State
+    {
+        Entry table[SAMPLING_PROFILER_TABLE_SIZE];
+        std::atomic<bool> enabled;
+        std::atomic<uint64_t> samples;
+        std::atomic<uint64_t> dropped;
+        bool handlerInstalled;
+    };
+
+    /// @brief the state of the profiler. It is created by Start, before
+    /// the first signal, so the handler never runs its initialisation
+    static State& GetState()
+    {
+        // function-local static so this class can live in a header file.
+        // Zero initialised: every entry is ENTRY_EMPTY
+        static State s_state;
+        return s_state;
+    }
+
+    /// @brief folded stacks use ';' between frames and ' ' before the count
+    static std::string Sanitise(std::string a_name)
+    {
+        for (std::size_t i = 0; i < a_name.size(); i++)
+        {
+            if (a_name[i] == ';')
+            {
+                a_name[i] = ':';
+            }
+            else if ((a_name[i] == ' ') || (a_name[i] == '\n'))
+            {
+                a_name[i] = '_';
+            }
+        }
+        return a_name;
+    }
+
+    /// @brief copies SAMPLING_PROFILER_COPY_WORDS words (or as many as
+    /// are mapped) from a_address into out_copy. Async signal safe, and it
+    /// never faults
+    /// @return false if not even a frame (2 words) could be copied
+    static inline bool CopyStack(pid_t a_pid, uintptr_t a_address, uintptr_t* out_copy,
+                                 uintptr_t &out_end)
+    {
+        const uintptr_t size = SAMPLING_PROFILER_COPY_WORDS * sizeof(uintptr_t);
+        uintptr_t boundary = (a_address | (SAMPLING_PROFILER_PAGE_SIZE - 1)) + 1;
+        if (boundary < a_address)
+        {
+            // the last page of the address space
+            return false;
+        }
+
+        struct iovec local;
+        local.iov_base = out_copy;
+        local.iov_len  = size;
+
+        // copies don't stop half way through an iovec, so there is one per
+        // page
+        struct iovec remote[2];
+        unsigned long remoteCount = 1;
+        remote[0].iov_base = reinterpret_cast<void*>(a_address);
+        remote[0].iov_len  = ((boundary - a_address) < size) ? (boundary - a_address) : size;
+        if (remote[0].iov_len < size)
+        {
+            remote[1].iov_base = reinterpret_cast<void*>(boundary);
+            remote[1].iov_len  = size - remote[0].iov_len;
+            remoteCount = 2;
+        }
+
+        ssize_t copied = process_vm_readv(a_pid, &local, 1, remote, remoteCount, 0);
+        if (copied < static_cast<ssize_t>(2 * sizeof(uintptr_t)))
+        {
+            return false;
+        }
+        out_end = a_address + static_cast<uintptr_t>(copied);
+        return true;
+    }
+
+    /// @brief walks the frame pointers of the interrupted thread
+    /// @return number of addresses written to out_frames
+    static inline uint32_t Unwind(const ucontext_t* a_context, uintptr_t* out_frames)
+    {
+        uintptr_t pc;
+        uintptr_t fp;
+        uintptr_t sp;
+#if defined(__x86_64__)
+        pc = static_cast<uintptr_t>(a_context->uc_mcontext.gregs[REG_RIP]);
+        fp = static_cast<uintptr_t>(a_context->uc_mcontext.gregs[REG_RBP]);
+        sp = static_cast<uintptr_t>(a_context->uc_mcontext.gregs[REG_RSP]);
+#elif defined(__aarch64__)
+        pc = static_cast<uintptr_t>(a_context->uc_mcontext.pc);
+        fp = static_cast<uintptr_t>(a_context->uc_mcontext.regs[29]);
+        sp = static_cast<uintptr_t>(a_context->uc_mcontext.sp);
+#else
+        (void) a_context;
+        return 0;
+#endif
+
+        uint32_t depth = 0;
+        out_frames[depth++] = pc;
+
+        // frames are read from a copy of the stack, which is refreshed when
+        // the walk gets out of it
+        uintptr_t copy[SAMPLING_PROFILER_COPY_WORDS];
+        uintptr_t copyStart = 0;
+        uintptr_t copyEnd = 0;
+        pid_t pid = getpid();
+
+        // every frame starts with the frame pointer of the caller followed
+        // by the return address. A frame pointer which isn't aligned, goes
+        // down, jumps too far or points to memory which isn't mapped isn't
+        // one (the code might not keep them)
+        while ((depth < SAMPLING_PROFILER_MAX_DEPTH) &&
+               (fp >= sp) &&
+               ((fp - sp) < SAMPLING_PROFILER_MAX_FRAME_SIZE) &&
+               ((fp & (sizeof(uintptr_t) - 1)) == 0))
+        {
+            if ((fp < copyStart) || ((fp + (2 * sizeof(uintptr_t))) > copyEnd))
+            {
+                if (!CopyStack(pid, fp, copy, copyEnd))
+                {
+                    break;
+                }
+                copyStart = fp;
+            }
+
+            const uintptr_t* frame = &copy[(fp - copyStart) / sizeof(uintptr_t)];
+            uintptr_t returnAddress = frame[1];
+            if (returnAddress == 0)
+            {
+                break;
+            }
+            out_frames[depth++] = returnAddress;
+
+            sp = fp + (2 * sizeof(uintptr_t));
+            fp = frame[0];
+        }
+        return depth;
+    }
+
+    /// @brief FNV-1a of the frames. Never ENTRY_EMPTY nor ENTRY_BUSY
+    static inline uint64_t Hash(const uintptr_t* a_frames, uint32_t a_depth)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        for (uint32_t i = 0; i < a_depth; i++)
+        {
+            hash = (hash ^ a_frames[i]) * 1099511628211ULL;
+        }
+        return (hash <= ENTRY_BUSY) ? (hash + 2) : hash;
+    }
+
+    /// @brief counts a stack. Lock-free and async signal safe
+    static inline void Count(State &a_state, const uintptr_t* a_frames, uint32_t a_depth)
+    {
+        uint64_t hash = Hash(a_frames, a_depth);
+        for (uint32_t probe = 0; probe < SAMPLING_PROFILER_MAX_PROBES; probe++)
+        {
+            Entry &entry = a_state.table[(hash + probe) & (SAMPLING_PROFILER_TABLE_SIZE - 1)];
+            uint64_t current = entry.hash.load(std::memory_order_acquire);
+
+            if (current == ENTRY_EMPTY)
+            {
+                if (!entry.hash.compare_exchange_strong(current, ENTRY_BUSY,
+                                                        std::memory_order_acquire))
+                {
+                    // somebody else took it first. It might be this stack
+                    current = entry.hash.load(std::memory_order_acquire);
+                }
+                else
+                {
+                    entry.depth = a_depth;
+                    memcpy(entry.frames, a_frames, a_depth * sizeof(uintptr_t));
+                    entry.count.store(1, std::memory_order_relaxed);
+                    // release: readers which see the hash see the frames
+                    entry.hash.store(hash, std::memory_order_release);
+                    return;
+                }
+            }
+
+            // an entry being filled in (ENTRY_BUSY) can't be waited for:
+            // the thread filling it in might be the one interrupted. Same
+            // stack as a busy entry ends up in another entry, WriteFolded
+            // adds them up
+            if ((current == hash) && (entry.depth == a_depth) &&
+                (memcmp(entry.frames, a_frames, a_depth * sizeof(uintptr_t)) == 0))
+            {
+                entry.count.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        a_state.dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void OnSignal(int /*a_signal*/, siginfo_t* /*a_info*/, void* a_context)
+    {
+        int savedErrno = errno;
+
+        State &state = GetState();
+        if (state.enabled.load(std::memory_order_relaxed))
+        {
+            uintptr_t frames[SAMPLING_PROFILER_MAX_DEPTH];
+            uint32_t depth = Unwind(static_cast<const ucontext_t*>(a_context), frames);
+            state.samples.fetch_add(1, std::memory_order_relaxed);
+            if (depth > 0)
+            {
+                Count(state, frames, depth);
+            }
+            else
+            {
+                state.dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        errno = savedErrno;
+    }
+};
+
+#endif /* _SAMPLING_PROFILER_H_ */
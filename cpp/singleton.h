@@ -25,6 +25,11 @@
 /// This file contains a template that can be used to turn your class into a
 /// singleton only by inheritance
 ///
+/// Once the instance has been created Instance() costs a single atomic load
+/// with acquire semantics (a plain load on x86). The first call builds the
+/// instance; CreateInstance() can be used to do it at a chosen point during
+/// startup so the first call on a hot path doesn't stall
+///
 /// Your compiler must have support for c++11
 ///
 /// @author Faustino Frechilla
@@ -32,6 +37,8 @@
 /// Ref       Who                When         What
 ///           Faustino Frechilla 07-Apr-2010  Original development
 ///           Faustino Frechilla 12-Mar-2014  Thread-safe using c++11
+///           Faustino Frechilla 17-Oct-2026  Atomic fast path, backoff and
+///                                           eager creation
 /// @endhistory
 ///
 // ============================================================================
@@ -40,6 +47,13 @@
 #define _SINGLETON_H_
 
 #include <atomic>
+#include "backoff.h"
+
+#ifdef __GNUC__
+#define SINGLETON_NOINLINE __attribute__((noinline))
+#else
+#define SINGLETON_NOINLINE
+#endif
 
 /// @brief A templatised class for singletons
 /// Inherit from this class if you wish to make your class a singleton, so only
@@ -62,6 +76,9 @@
 ///
 /// /* ... */
 ///
+/// // optional: build the instance now rather than on the first call
+/// MySingleton::CreateInstance();
+///
 /// // accessing your brand new singleton
 /// MySingleton::Instance().MyMethod();
 /// 
@@ -73,27 +90,49 @@ public:
     /// @return a reference to the instance wrapped by the singleton
     static TClass& Instance()
     {
-        if (m_instancePtr == 0)
+        TClass* instance = m_instancePtr.load(std::memory_order_acquire);
+        if (instance == 0)
         {
-            // In the rare event that two threads come into this section only 
-            // one will acquire the spinlock and build the actual instance
-            while(std::atomic_exchange_explicit(&m_lock, true, std::memory_order_acquire))
-            {
-                ; // spin until acquired
-            }
-            
-            if (m_instancePtr == 0)
+            return CreateInstance();
+        }
+
+        return *instance;
+    }
+
+    /// @brief Builds the instance wrapped by this singleton if it hasn't
+    /// been built yet. Call it during startup so the first call to
+    /// Instance() on a hot path doesn't have to build it
+    /// @return a reference to the instance wrapped by the singleton
+    static SINGLETON_NOINLINE TClass& CreateInstance()
+    {
+        // In the rare event that two threads come into this section only
+        // one will acquire the spinlock and build the actual instance
+        // The backoff ends up yielding the CPU, since the instance might
+        // take a while to be built
+        Backoff backoff;
+        while (m_lock.exchange(true, std::memory_order_acquire))
+        {
+            // wait until the lock looks free before trying again so the
+            // waiting threads don't keep on stealing the cache line
+            while (m_lock.load(std::memory_order_relaxed))
             {
-                // This is the thread that will build the real instance since
-                // it hasn-t been instantiated yet
-                m_instancePtr = new TClass();
+                backoff.Wait();
             }
-            
-            // Release spinlock
-            std::atomic_store_explicit(&m_lock, false, std::memory_order_release);
         }
 
-        return *m_instancePtr;
+        TClass* instance = m_instancePtr.load(std::memory_order_relaxed);
+        if (instance == 0)
+        {
+            // This is the thread that will build the real instance since
+            // it hasn't been instantiated yet
+            instance = new TClass();
+            m_instancePtr.store(instance, std::memory_order_release);
+        }
+
+        // Release spinlock
+        m_lock.store(false, std::memory_order_release);
+
+        return *instance;
     }
 
     /// @brief Gives access to the singleton instance using a pointer
@@ -108,12 +147,12 @@ protected:
     virtual ~Singleton(){};
     
     // the actual instance wrapped around the singleton
-    static TClass *m_instancePtr;
+    static std::atomic<TClass*> m_instancePtr;
     // a spinlock to make this singleton implementation thread-safe
     static std::atomic<bool> m_lock;
 };
 
-template <class TClass> TClass* Singleton<TClass>::m_instancePtr = 0;
+template <class TClass> std::atomic<TClass*> Singleton<TClass>::m_instancePtr(0);
 template <class TClass> std::atomic<bool> Singleton<TClass>::m_lock(false);
 
 #endif /* _SINGLETON_H_ */
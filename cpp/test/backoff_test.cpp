@@ -0,0 +1,93 @@
+// ============================================================================
+/// @file  backoff_test.cpp
+/// @brief Testing the exponential backoff in backoff.h
+/// Compiling procedure:
+///   $ g++ -g -O0 -Wall -std=c++11 -D_REENTRANT -c backoff_test.cpp
+///   $ g++ backoff_test.o -o backoff_test -pthread -std=c++11
+///
+/// Expected output:
+/// growth: OK
+/// contended counter: 400000 increments
+// ============================================================================
+
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <assert.h>
+#include "backoff.h"
+
+#define TEST_THREADS    4
+#define TEST_INCREMENTS 100000
+
+class BackoffTest
+{
+public:
+    int runGrowth();
+    int runContendedCounter();
+};
+
+int BackoffTest::runGrowth()
+{
+    // 1, 2, 4 and 8 pauses before it starts yielding
+    Backoff backoff(8);
+    for (int i = 0; i < 4; i++)
+    {
+        assert(!backoff.IsYielding());
+        backoff.Wait();
+    }
+    assert(backoff.IsYielding());
+    backoff.Wait();
+    assert(backoff.IsYielding());
+
+    backoff.Reset();
+    assert(!backoff.IsYielding());
+
+    Backoff yielding(0);
+    assert(yielding.IsYielding());
+    yielding.Wait();
+
+    std::cout << "growth: OK" << std::endl;
+    return 0;
+}
+
+int BackoffTest::runContendedCounter()
+{
+    std::atomic<uint32_t> counter(0);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < TEST_THREADS; i++)
+    {
+        threads.push_back(std::thread([&counter]() {
+            for (int j = 0; j < TEST_INCREMENTS; j++)
+            {
+                Backoff backoff;
+                uint32_t expected = counter.load(std::memory_order_relaxed);
+                while (!counter.compare_exchange_weak(expected, expected + 1))
+                {
+                    backoff.Wait();
+                }
+            }
+        }));
+    }
+    for (int i = 0; i < TEST_THREADS; i++)
+    {
+        threads[i].join();
+    }
+
+    assert(counter.load() == (TEST_THREADS * TEST_INCREMENTS));
+
+    std::cout << "contended counter: " << counter.load() << " increments" << std::endl;
+    return 0;
+}
+
+int main()
+{
+    BackoffTest theTest;
+    int theBackoffTestResult = 0;
+
+    theBackoffTestResult |= theTest.runGrowth();
+    theBackoffTestResult |= theTest.runContendedCounter();
+
+    return theBackoffTestResult;
+}
@@ -0,0 +1,255 @@
+// ============================================================================
+/// @file  clock_test.cpp
+/// @brief Testing the clocks and a timer service driven by virtual time
+/// Virtual time is moved forward by the test itself, so the output of this
+/// test is always the same no matter how loaded the machine is
+/// Compiling procedure:
+///   $ g++ -g -O0 -Wall -std=c++11 -D_REENTRANT -c clock_test.cpp
+///   $ g++ clock_test.o -o clock_test -pthread -std=c++11
+///
+/// Expected output:
+/// TscClock vs RealClock: OK (stable TSC)
+/// TscClock vs RealClock after recalibrating: OK
+/// TscClock falling back to RealClock: OK
+/// virtual time 10000: periodic=1 one-shot=0
+/// virtual time 15000: periodic=1 one-shot=1
+/// virtual time 1000000: periodic=100 one-shot=1
+/// virtual time 2000000: periodic=100 one-shot=1 (cancelled)
+/// virtual time 2000000: chained=10
+/// Done!
+// ============================================================================
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <functional> // std::bind
+#include <assert.h>
+#include "clock.h"
+#include "tsc_clock.h"
+#include "timer_service.h"
+
+typedef BasicTimerService<VirtualClock> VirtualTimerService;
+
+class ClockTest
+{
+public:
+    ClockTest():
+        m_periodicCount(0),
+        m_oneShotCount(0),
+        m_chainedCount(0),
+        m_lastPeriodicTime(0),
+        m_service(0)
+    {}
+
+    virtual ~ClockTest()
+    {}
+
+    void Periodic(const uint64_t &a_currentTime)
+    {
+        m_periodicCount++;
+        m_lastPeriodicTime = a_currentTime;
+    }
+
+    void OneShot(const uint64_t& /*a_currentTime*/)
+    {
+        m_oneShotCount++;
+    }
+
+    // schedules the next link of the chain from the service thread
+    void Chained(const uint64_t& /*a_currentTime*/)
+    {
+        m_chainedCount++;
+        if (m_chainedCount < 10)
+        {
+            m_service->Schedule(
+                std::bind(&ClockTest::Chained, this, std::placeholders::_1), 0);
+        }
+    }
+
+    int runTscClock();
+    int runTscFallback();
+    int runVirtualClock();
+
+private:
+    int m_periodicCount;
+    int m_oneShotCount;
+    int m_chainedCount;
+    uint64_t m_lastPeriodicTime;
+    VirtualTimerService* m_service;
+
+    static uint64_t absDiff(uint64_t a_a, uint64_t a_b)
+    {
+        return (a_a > a_b) ? (a_a - a_b) : (a_b - a_a);
+    }
+
+    void print(const char* a_note = "")
+    {
+        std::cout << "virtual time " << VirtualClock::Now()
+                  << ": periodic=" << m_periodicCount
+                  << " one-shot=" << m_oneShotCount
+                  << a_note << std::endl;
+    }
+};
+
+int ClockTest::runTscClock()
+{
+    TscClock::Init();
+
+    // both clocks must be close to each other
+    assert(absDiff(TscClock::Now(), RealClock::Now()) < 1000000ULL); // 1ms
+
+    // and never go backwards
+    uint64_t previous = TscClock::Now();
+    for (int i = 0; i < 100000; i++)
+    {
+        uint64_t now = TscClock::Now();
+        assert(now >= previous);
+        previous = now;
+    }
+
+    // ticks can be converted later on
+    uint64_t ticks = TscClock::ReadTicks();
+    uint64_t now   = TscClock::Now();
+    assert(absDiff(TscClock::TicksToNsecs(ticks), now) < 1000000ULL);
+    (void) ticks;
+    (void) now;
+
+    if (!TscClock::IsStable())
+    {
+        std::cout << "TscClock vs RealClock: OK (unstable TSC, using RealClock)"
+                  << std::endl;
+        return 0;
+    }
+    assert(TscClock::GetFrequency() > 0);
+    std::cout << "TscClock vs RealClock: OK (stable TSC)" << std::endl;
+
+    // the first call after the recalibration period recalibrates the clock.
+    // It must not jump
+    uint64_t beforeTicks = TscClock::ReadTicks();
+    uint64_t before = TscClock::Now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    uint64_t after = TscClock::Now();
+    assert(after > before);
+    assert(absDiff(TscClock::Now(), RealClock::Now()) < 1000000ULL);
+
+    // ticks read before the recalibration still convert to their own time
+    assert(absDiff(TscClock::TicksToNsecs(beforeTicks), before) < 1000000ULL);
+    (void) beforeTicks;
+    (void) before;
+    (void) after;
+
+    std::cout << "TscClock vs RealClock after recalibrating: OK" << std::endl;
+    return 0;
+}
+
+int ClockTest::runTscFallback()
+{
+    // the switch to RealClock must not go back in time, even if the TSC was
+    // a bit ahead of it
+    uint64_t previous = TscClock::Now();
+    TscClock::MarkUnstable();
+    assert(!TscClock::IsStable());
+    for (int i = 0; i < 100000; i++)
+    {
+        uint64_t now = TscClock::Now();
+        assert(now >= previous);
+        previous = now;
+    }
+
+    // and RealClock is what it returns from then on
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    assert(absDiff(TscClock::Now(), RealClock::Now()) < 1000000ULL); // 1ms
+    (void) previous;
+
+    std::cout << "TscClock falling back to RealClock: OK" << std::endl;
+    return 0;
+}
+
+int ClockTest::runVirtualClock()
+{
+    VirtualClock::Reset(0);
+    assert(VirtualClock::Now() == 0);
+
+    VirtualTimerService service;
+    m_service = &service;
+
+    VirtualTimerService::TimerId_t periodicId = service.Schedule(
+        std::bind(&ClockTest::Periodic, this, std::placeholders::_1),
+        10000, 10000);
+    service.Schedule(
+        std::bind(&ClockTest::OneShot, this, std::placeholders::_1), 15000);
+
+    // nothing expires unless the virtual time moves
+    VirtualClock::AdvanceTo(9999);
+    assert(m_periodicCount == 0);
+
+    // every callback due has been called when AdvanceTo returns
+    VirtualClock::AdvanceTo(10000);
+    assert(m_periodicCount == 1);
+    assert(m_lastPeriodicTime == 10000);
+    print();
+
+    VirtualClock::AdvanceTo(15000);
+    assert(m_oneShotCount == 1);
+    print();
+
+    for (int i = 0; i < 1000; i++)
+    {
+        VirtualClock::Advance(985);
+    }
+    assert(VirtualClock::Now() == 1000000);
+    assert(m_periodicCount == 100);
+    assert(m_lastPeriodicTime == 1000000);
+    print();
+
+    service.Cancel(periodicId);
+    VirtualClock::AdvanceTo(2000000);
+    assert(m_periodicCount == 100);
+    print(" (cancelled)");
+
+    // timers scheduled by callbacks with no delay are processed before
+    // AdvanceTo returns
+    service.Schedule(
+        std::bind(&ClockTest::Chained, this, std::placeholders::_1), 0);
+    VirtualClock::Advance(0);
+    assert(m_chainedCount == 10);
+    std::cout << "virtual time " << VirtualClock::Now()
+              << ": chained=" << m_chainedCount << std::endl;
+
+    VirtualTimerService::Statistics_t statistics = service.GetStatistics();
+    assert(statistics.expirations == 111);
+    (void) statistics;
+
+    // callbacks can create and join other services driven by virtual time
+    // (they add and remove listeners while the clock is telling them)
+    bool nested = false;
+    service.Schedule([&nested](const uint64_t&) {
+        VirtualTimerService other;
+        other.Join();
+        nested = true;
+    }, 1000);
+    VirtualClock::Advance(1000);
+    assert(nested);
+    (void) nested;
+
+    service.Join();
+    m_service = 0;
+
+    // the service is not listening anymore
+    VirtualClock::Advance(1000000);
+
+    return 0;
+}
+
+int main()
+{
+    ClockTest theTest;
+    int theClockTestResult = 0;
+
+    theClockTestResult |= theTest.runTscClock();
+    theClockTestResult |= theTest.runTscFallback();
+    theClockTestResult |= theTest.runVirtualClock();
+
+    std::cout << "Done!" << std::endl;
+    return theClockTestResult;
+}
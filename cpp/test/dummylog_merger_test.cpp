@@ -0,0 +1,325 @@
+// ============================================================================
+/// @file  dummylog_merger_test.cpp
+/// @brief Testing the log merger (timestamp parsing and k-way merge of text
+///        and binary logs)
+/// Compiling procedure:
+///   $ g++ -g -O0 -Wall -std=c++11 -D_REENTRANT -c dummylog_merger_test.cpp
+///   $ g++ dummylog_merger_test.o -o dummylog_merger_test -pthread -std=c++11
+///
+/// Expected output:
+/// timestamps: OK
+/// text: OK
+/// binary: OK
+/// asynchronous binary: OK
+/// malformed binary: OK
+// ============================================================================
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <assert.h>
+#include <stdlib.h>    // mkstemp
+#include <string.h>    // strlen
+#include <unistd.h>    // unlink
+#include "dummylog_merger.h"
+
+class DummyLogMergerTest
+{
+public:
+    DummyLogMergerTest():
+        m_paths()
+    {}
+
+    ~DummyLogMergerTest()
+    {
+        for (std::size_t i = 0; i < m_paths.size(); i++)
+        {
+            unlink(m_paths[i].c_str());
+        }
+    }
+
+    int runTimestamps();
+    int runText();
+    int runBinary();
+    int runAsyncBinary();
+    int runMalformedBinary();
+
+private:
+    std::vector<std::string> m_paths;
+
+    // writes a_contents into a new temporary file
+    std::string createFile(const std::string &a_contents)
+    {
+        char path[] = "/tmp/dummylog_merger_test_XXXXXX";
+        int fd = mkstemp(path);
+        assert(fd >= 0);
+        ssize_t written = write(fd, a_contents.data(), a_contents.size());
+        assert(written == static_cast<ssize_t>(a_contents.size()));
+        (void) written;
+        close(fd);
+
+        m_paths.push_back(path);
+        return path;
+    }
+
+    // merges a_merger into a string
+    std::string merge(DummyLogMerger &a_merger, uint64_t &out_entries)
+    {
+        std::string path = createFile("");
+        int fd = open(path.c_str(), O_WRONLY | O_TRUNC);
+        {
+            DummyLogMergerOutput output(fd);
+            out_entries = a_merger.Merge(output);
+            assert(!output.Failed());
+        }
+        close(fd);
+
+        std::ifstream file(path.c_str());
+        std::stringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    // adds a new file with a_contents to a_merger
+    void addFile(DummyLogMerger &a_merger, const std::string &a_contents)
+    {
+        bool added = a_merger.AddFile(createFile(a_contents));
+        assert(added);
+        (void) added;
+    }
+
+    static uint64_t parse(DummyLogTimestamp::Format_t a_format, const char* a_line)
+    {
+        uint64_t nsecs = 0;
+        bool parsed = DummyLogTimestamp::Parse(a_format, a_line, a_line + strlen(a_line), nsecs);
+        assert(parsed);
+        (void) parsed;
+        return nsecs;
+    }
+};
+
+int DummyLogMergerTest::runTimestamps()
+{
+    // 2012-06-01 12:29:17 UTC
+    const uint64_t SECS = 1338553757ULL;
+
+    const char* line = "[01/Jun/2012 12:29:17.953] INFO";
+    assert(DummyLogTimestamp::Detect(line, line + strlen(line)) ==
+           DummyLogTimestamp::TIMESTAMP_BRACKETS);
+    assert(parse(DummyLogTimestamp::TIMESTAMP_BRACKETS, line) ==
+           (SECS * 1000000000ULL) + 953000000ULL);
+    assert(parse(DummyLogTimestamp::TIMESTAMP_BRACKETS, "[01/jun/2012 12:29:17] x") ==
+           (SECS * 1000000000ULL));
+
+    line = "2012-06-01T12:29:17.123456789123 x";
+    assert(DummyLogTimestamp::Detect(line, line + strlen(line)) ==
+           DummyLogTimestamp::TIMESTAMP_ISO);
+    assert(parse(DummyLogTimestamp::TIMESTAMP_ISO, line) ==
+           (SECS * 1000000000ULL) + 123456789ULL);
+    assert(parse(DummyLogTimestamp::TIMESTAMP_ISO, "[2000-02-29 00:00:00,5] x") ==
+           (951782400ULL * 1000000000ULL) + 500000000ULL);
+    assert(parse(DummyLogTimestamp::TIMESTAMP_ISO, "1970-01-01 00:00:00 x") == 0);
+
+    line = "1338553757.000000042 main.cpp:10 msg";
+    assert(DummyLogTimestamp::Detect(line, line + strlen(line)) ==
+           DummyLogTimestamp::TIMESTAMP_SECONDS);
+    assert(parse(DummyLogTimestamp::TIMESTAMP_SECONDS, line) ==
+           (SECS * 1000000000ULL) + 42ULL);
+
+    // not timestamps
+    line = "    at foo.bar(Baz.java:42)";
+    assert(DummyLogTimestamp::Detect(line, line + strlen(line)) ==
+           DummyLogTimestamp::TIMESTAMP_UNKNOWN);
+    line = "[01/Jux/2012 12:29:17.953] INFO";
+    assert(DummyLogTimestamp::Detect(line, line + strlen(line)) ==
+           DummyLogTimestamp::TIMESTAMP_UNKNOWN);
+
+    std::cout << "timestamps: OK" << std::endl;
+    return 0;
+}
+
+int DummyLogMergerTest::runText()
+{
+    DummyLogMerger merger;
+    addFile(merger,
+        "[01/Jun/2012 12:29:17.100] a1\n"
+        "[01/Jun/2012 12:29:17.300] a2\n"
+        "  continuation of a2\n"
+        "[01/Jun/2012 12:29:17.500] a3\n");
+    addFile(merger,
+        "header without a timestamp\n"
+        "2012-06-01 12:29:17.200 b1\n"
+        "2012-06-01 12:29:17.300 b2\n"
+        "2012-06-01 12:29:17.600 b3 (no new line at the end)");
+    addFile(merger, "");
+    bool added = merger.AddFile("/nonexistent/dummylog_merger_test");
+    assert(!added);
+    (void) added;
+
+    uint64_t entries;
+    std::string output = merge(merger, entries);
+    assert(entries == 7);
+    assert(output ==
+        "header without a timestamp\n"
+        "[01/Jun/2012 12:29:17.100] a1\n"
+        "2012-06-01 12:29:17.200 b1\n"
+        "[01/Jun/2012 12:29:17.300] a2\n"
+        "  continuation of a2\n"
+        "2012-06-01 12:29:17.300 b2\n"
+        "[01/Jun/2012 12:29:17.500] a3\n"
+        "2012-06-01 12:29:17.600 b3 (no new line at the end)\n");
+
+    std::cout << "text: OK" << std::endl;
+    return 0;
+}
+
+int DummyLogMergerTest::runBinary()
+{
+    // a binary log with entries at 1.000000010, 1.000000030... and a text
+    // log (as dummylog_decoder writes) with entries in between
+    std::string binary(DUMMYLOG_BINARY_MAGIC, DUMMYLOG_BINARY_MAGIC_SIZE);
+    char entry[DUMMYLOG_BINARY_MAX_ENTRY];
+    std::size_t size = DummyLogBinaryEncoder::EncodeFormat(
+        entry, 1, "value {}", DummyLogBinaryEncoder::Signature<int>(), "main.cpp", 7);
+    binary.append(entry, size);
+    for (int i = 0; i < 3; i++)
+    {
+        size = DummyLogBinaryEncoder::EncodeLog(entry, 1, 1000000010ULL + (20 * i), i);
+        binary.append(entry, size);
+    }
+
+    DummyLogMerger merger;
+    addFile(merger, binary);
+    addFile(merger,
+        "1.000000000 text.cpp:1 first\n"
+        "1.000000020 text.cpp:2 second\n"
+        "1.000000060 text.cpp:3 last\n");
+
+    uint64_t entries;
+    std::string output = merge(merger, entries);
+    assert(entries == 6);
+    assert(output ==
+        "1.000000000 text.cpp:1 first\n"
+        "1.000000010 main.cpp:7 value 0\n"
+        "1.000000020 text.cpp:2 second\n"
+        "1.000000030 main.cpp:7 value 1\n"
+        "1.000000050 main.cpp:7 value 2\n"
+        "1.000000060 text.cpp:3 last\n");
+
+    std::cout << "binary: OK" << std::endl;
+    return 0;
+}
+
+int DummyLogMergerTest::runAsyncBinary()
+{
+    // in asynchronous mode each thread writes its own ring in one go, so the
+    // entries of two threads come interleaved in time, not in order
+    const uint64_t TIMESTAMPS[] = {
+        1000000010ULL, 1000000040ULL, 1000000070ULL,  // ring of thread 1
+        1000000020ULL, 1000000030ULL, 1000000080ULL,  // ring of thread 2
+        1000000040ULL};                               // thread 1 again
+
+    std::string binary(DUMMYLOG_BINARY_MAGIC, DUMMYLOG_BINARY_MAGIC_SIZE);
+    char entry[DUMMYLOG_BINARY_MAX_ENTRY];
+    std::size_t size = DummyLogBinaryEncoder::EncodeFormat(
+        entry, 1, "value {}", DummyLogBinaryEncoder::Signature<int>(), "async.cpp", 3);
+    binary.append(entry, size);
+    for (int i = 0; i < 7; i++)
+    {
+        size = DummyLogBinaryEncoder::EncodeLog(entry, 1, TIMESTAMPS[i], i);
+        binary.append(entry, size);
+    }
+
+    DummyLogMerger merger;
+    addFile(merger, binary);
+    addFile(merger,
+        "1.000000035 text.cpp:1 between\n"
+        "1.000000075 text.cpp:2 later\n");
+
+    uint64_t entries;
+    std::string output = merge(merger, entries);
+    assert(entries == 9);
+    assert(output ==
+        "1.000000010 async.cpp:3 value 0\n"
+        "1.000000020 async.cpp:3 value 3\n"
+        "1.000000030 async.cpp:3 value 4\n"
+        "1.000000035 text.cpp:1 between\n"
+        "1.000000040 async.cpp:3 value 1\n"
+        "1.000000040 async.cpp:3 value 6\n"
+        "1.000000070 async.cpp:3 value 2\n"
+        "1.000000075 text.cpp:2 later\n"
+        "1.000000080 async.cpp:3 value 5\n");
+
+    std::cout << "asynchronous binary: OK" << std::endl;
+    return 0;
+}
+
+int DummyLogMergerTest::runMalformedBinary()
+{
+    std::string binary(DUMMYLOG_BINARY_MAGIC, DUMMYLOG_BINARY_MAGIC_SIZE);
+    char entry[DUMMYLOG_BINARY_MAX_ENTRY];
+    std::size_t size = DummyLogBinaryEncoder::EncodeFormat(
+        entry, 1, "value {}", DummyLogBinaryEncoder::Signature<int>(), "good.cpp", 1);
+    binary.append(entry, size);
+
+    // the name of the file isn't terminated inside the payload
+    size = DummyLogBinaryEncoder::EncodeFormat(
+        entry, 2, "bad {}", DummyLogBinaryEncoder::Signature<int>(), "bad.cpp", 2);
+    uint16_t payloadSize;
+    memcpy(&payloadSize, entry + 1, 2);
+    payloadSize--;
+    memcpy(entry + 1, &payloadSize, 2);
+    binary.append(entry, size - 1);
+
+    // more argument tags than bytes in the payload
+    const char tooManyArgs[] = {DUMMYLOG_ENTRY_FORMAT, 10, 0,
+                                3, 0, 0, 0, 3, 0, 0, 0, 100, 'x'};
+    binary.append(tooManyArgs, sizeof(tooManyArgs));
+
+    // a log entry without room for its timestamp
+    const char shortLog[] = {DUMMYLOG_ENTRY_LOG, 5, 0, 1, 0, 0, 0, 7};
+    binary.append(shortLog, sizeof(shortLog));
+
+    size = DummyLogBinaryEncoder::EncodeLog(entry, 1, 1000000010ULL, 1);
+    binary.append(entry, size);
+    size = DummyLogBinaryEncoder::EncodeLog(entry, 2, 1000000020ULL, 2);
+    binary.append(entry, size);
+
+    // the decoder skips what it can't trust
+    DummyLogBinaryDecoder decoder;
+    std::ostringstream decoded;
+    long decodedEntries = decoder.Decode(binary.data(), binary.size(), decoded);
+    assert(decodedEntries == 2);
+    assert(decoder.MalformedEntries() == 3);
+    assert(decoded.str() ==
+        "1.000000010 good.cpp:1 value 1\n"
+        "1.000000020 <unknown format id 2>\n");
+    (void) decodedEntries;
+
+    // and so does the merger
+    DummyLogMerger merger;
+    addFile(merger, binary);
+    uint64_t entries;
+    std::string output = merge(merger, entries);
+    assert(entries == 2);
+    assert(output == decoded.str());
+
+    std::cout << "malformed binary: OK" << std::endl;
+    return 0;
+}
+
+int main()
+{
+    DummyLogMergerTest theTest;
+    int theDummyLogMergerTestResult = 0;
+
+    theDummyLogMergerTestResult |= theTest.runTimestamps();
+    theDummyLogMergerTestResult |= theTest.runText();
+    theDummyLogMergerTestResult |= theTest.runBinary();
+    theDummyLogMergerTestResult |= theTest.runAsyncBinary();
+    theDummyLogMergerTestResult |= theTest.runMalformedBinary();
+
+    return theDummyLogMergerTestResult;
+}
@@ -0,0 +1,245 @@
+// ============================================================================
+/// @file  dummylogger_mmap_sink_test.cpp
+/// @brief Testing the memory mapped file sink of DummyLogger
+/// Files are written into a temporary directory which is removed afterwards
+/// Compiling procedure:
+///   $ g++ -g -O0 -Wall -std=c++11 -D_REENTRANT -c dummylogger_mmap_sink_test.cpp
+///   $ g++ dummylogger_mmap_sink_test.o -o dummylogger_mmap_sink_test -pthread -std=c++11
+///
+/// Expected output:
+/// size rotation: 40000 lines in N files
+/// time rotation: OK
+/// logger: OK
+/// creation failure: OK
+// ============================================================================
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <assert.h>
+#include <stdio.h>     // snprintf, sscanf
+#include <stdlib.h>    // mkdtemp
+#include <unistd.h>    // unlink, rmdir, access
+#include <signal.h>    // signal
+#include <sys/resource.h> // setrlimit
+#include "dummylogger.h"
+#include "dummylogger_mmap_sink.h"
+
+#define TEST_THREADS   4
+#define TEST_LINES     10000
+#define TEST_FILE_SIZE 16384
+
+class DummyLoggerMmapSinkTest
+{
+public:
+    DummyLoggerMmapSinkTest():
+        m_dir()
+    {
+        char dir[] = "/tmp/dummylogger_mmap_sink_test_XXXXXX";
+        char* rv = mkdtemp(dir);
+        assert(rv != 0);
+        (void) rv;
+        m_dir = dir;
+    }
+
+    ~DummyLoggerMmapSinkTest()
+    {
+        rmdir(m_dir.c_str());
+    }
+
+    int runSizeRotation();
+    int runTimeRotation();
+    int runLogger();
+    int runCreationFailure();
+
+private:
+    std::string m_dir;
+
+    std::string prefix(const char* a_name)
+    {
+        return m_dir + "/" + a_name;
+    }
+
+    // reads (and removes) every file written by a sink, in order. The file
+    // which was created in advance but never used is removed by the sink
+    static std::vector<std::string> readFiles(const std::string &a_prefix)
+    {
+        std::vector<std::string> contents;
+        for (uint32_t i = 1; ; i++)
+        {
+            char suffix[32];
+            snprintf(suffix, sizeof(suffix), ".%06u", i);
+            std::string path = a_prefix + suffix;
+
+            std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+            if (!file)
+            {
+                break;
+            }
+            std::stringstream data;
+            data << file.rdbuf();
+            contents.push_back(data.str());
+            unlink(path.c_str());
+        }
+        return contents;
+    }
+};
+
+int DummyLoggerMmapSinkTest::runSizeRotation()
+{
+    std::string filePrefix = prefix("size");
+    {
+        DummyLoggerMmapSink sink(filePrefix, TEST_FILE_SIZE);
+        assert(sink.IsOpen());
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < TEST_THREADS; i++)
+        {
+            threads.push_back(std::thread([i, &sink]() {
+                char line[64];
+                for (int j = 0; j < TEST_LINES; j++)
+                {
+                    int size = snprintf(line, sizeof(line), "thread %d line %d\n", i, j);
+                    sink.Write(line, size);
+                }
+            }));
+        }
+        for (int i = 0; i < TEST_THREADS; i++)
+        {
+            threads[i].join();
+        }
+
+        // too big for any file
+        std::string huge(TEST_FILE_SIZE + 1, 'x');
+        sink.Write(huge.data(), huge.size());
+        assert(sink.DroppedLines() == 1);
+    }
+
+    std::vector<std::string> contents = readFiles(filePrefix);
+    std::vector<int> nextLine(TEST_THREADS, 0);
+    long lines = 0;
+    for (std::size_t i = 0; i < contents.size(); i++)
+    {
+        // files are truncated to their contents, which are whole lines
+        assert(contents[i].size() <= TEST_FILE_SIZE);
+        assert(!contents[i].empty() && (contents[i][contents[i].size() - 1] == '\n'));
+        assert(contents[i].find('\0') == std::string::npos);
+
+        std::istringstream file(contents[i]);
+        std::string line;
+        while (std::getline(file, line))
+        {
+            int thread;
+            int index;
+            int fields = sscanf(line.c_str(), "thread %d line %d", &thread, &index);
+            assert(fields == 2);
+            assert(index == nextLine[thread]);
+            nextLine[thread]++;
+            lines++;
+            (void) fields;
+        }
+    }
+    assert(lines == (TEST_THREADS * TEST_LINES));
+
+    std::cout << "size rotation: " << lines << " lines in "
+              << contents.size() << " files" << std::endl;
+    return 0;
+}
+
+int DummyLoggerMmapSinkTest::runTimeRotation()
+{
+    std::string filePrefix = prefix("time");
+    {
+        DummyLoggerMmapSink sink(filePrefix, TEST_FILE_SIZE, 20);
+
+        // empty files are not rotated
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        assert(sink.FileCount() == 2);
+
+        sink.Write("first\n", 6);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        sink.Write("second\n", 7);
+
+        assert(sink.FileCount() == 3);
+    }
+
+    std::vector<std::string> contents = readFiles(filePrefix);
+    assert(contents.size() == 2);
+    assert(contents[0] == "first\n");
+    assert(contents[1] == "second\n");
+
+    std::cout << "time rotation: OK" << std::endl;
+    return 0;
+}
+
+int DummyLoggerMmapSinkTest::runLogger()
+{
+    std::string filePrefix = prefix("logger");
+    {
+        DummyLoggerMmapSink sink(filePrefix, TEST_FILE_SIZE);
+        DummyLogger::Instance().setSink(&sink);
+
+        DummyLogger::Instance() << "sync " << 1 << std::endl;
+        DummyLogger::Instance().startAsync();
+        DummyLogger::Instance() << "async " << 2 << std::endl;
+        DummyLogger::Instance().stopAsync();
+
+        DummyLogger::Instance().setSink(0);
+    }
+
+    std::vector<std::string> contents = readFiles(filePrefix);
+    assert(contents.size() == 1);
+    assert(contents[0] == "sync 1\nasync 2\n");
+
+    std::cout << "logger: OK" << std::endl;
+    return 0;
+}
+
+int DummyLoggerMmapSinkTest::runCreationFailure()
+{
+    // files can't be bigger than half the size of the sink files, so they
+    // are opened but can't be preallocated
+    struct rlimit previous;
+    getrlimit(RLIMIT_FSIZE, &previous);
+    struct rlimit limit = previous;
+    limit.rlim_cur = TEST_FILE_SIZE / 2;
+    setrlimit(RLIMIT_FSIZE, &limit);
+    signal(SIGXFSZ, SIG_IGN);
+
+    std::string filePrefix = prefix("failure");
+    {
+        DummyLoggerMmapSink sink(filePrefix, TEST_FILE_SIZE);
+        assert(!sink.IsOpen());
+        assert(sink.FileCount() == 0);
+
+        sink.Write("lost\n", 5);
+        assert(sink.DroppedLines() == 1);
+    }
+
+    setrlimit(RLIMIT_FSIZE, &previous);
+    signal(SIGXFSZ, SIG_DFL);
+
+    // nothing was left behind
+    int rv = access((filePrefix + ".000001").c_str(), F_OK);
+    assert(rv != 0);
+    (void) rv;
+
+    std::cout << "creation failure: OK" << std::endl;
+    return 0;
+}
+
+int main()
+{
+    DummyLoggerMmapSinkTest theTest;
+    int theDummyLoggerMmapSinkTestResult = 0;
+
+    theDummyLoggerMmapSinkTestResult |= theTest.runSizeRotation();
+    theDummyLoggerMmapSinkTestResult |= theTest.runTimeRotation();
+    theDummyLoggerMmapSinkTestResult |= theTest.runLogger();
+    theDummyLoggerMmapSinkTestResult |= theTest.runCreationFailure();
+
+    return theDummyLoggerMmapSinkTestResult;
+}
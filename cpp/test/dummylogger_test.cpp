@@ -0,0 +1,615 @@
+// ============================================================================
+/// @file  dummylogger_test.cpp
+/// @brief Testing the logger in synchronous and asynchronous mode
+/// std::cout is redirected into a string stream so the output can be checked
+/// Compiling procedure:
+///   $ g++ -g -O0 -Wall -std=c++11 -D_REENTRANT -c dummylogger_test.cpp
+///   $ g++ dummylogger_test.o -o dummylogger_test -pthread -std=c++11
+///
+/// Expected output:
+/// sync: OK
+/// async: OK
+/// formatting: OK
+/// sync, thread exit: OK
+/// async, thread exit: OK
+/// sync, 4 threads: 40000 whole lines
+/// async, 4 threads: 40000 whole lines
+/// async, drop policy: 40000 lines logged, N written, M records dropped
+/// binary: 2803 entries decoded
+/// levels: OK
+/// sampling: OK
+// ============================================================================
+
+// small rings so the drop policy can be tested
+#define DUMMYLOGGER_RING_SIZE 256
+// TRACE statements are compiled out
+#define DUMMYLOG_MIN_LEVEL DUMMYLOG_LEVEL_DEBUG
+
+#include <iostream>
+#include <iomanip>   // std::setw...
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm> // std::count
+#include <assert.h>
+#include <stdio.h>     // fflush
+#include <stdlib.h>    // mkstemp
+#include <unistd.h>    // dup, dup2
+#include <fstream>
+#include "dummylogger.h"
+
+#define TEST_THREADS 4
+#define TEST_LINES   10000
+
+struct Point
+{
+    int x;
+    int y;
+};
+
+std::ostream& operator<<(std::ostream &a_stream, const Point &a_point)
+{
+    return a_stream << "(" << a_point.x << ", " << a_point.y << ")";
+}
+
+enum Colour
+{
+    COLOUR_RED,
+    COLOUR_GREEN
+};
+
+std::ostream& operator<<(std::ostream &a_stream, Colour a_colour)
+{
+    return a_stream << ((a_colour == COLOUR_RED) ? "red" : "green");
+}
+
+// no operator<< of its own
+enum Offset
+{
+    OFFSET_BEFORE = -1,
+    OFFSET_MASK   = 255
+};
+
+class DummyLoggerTest
+{
+public:
+    DummyLoggerTest():
+        m_output(),
+        m_coutBuffer(std::cout.rdbuf())
+    {}
+
+    ~DummyLoggerTest()
+    {
+        std::cout.rdbuf(m_coutBuffer);
+    }
+
+    int runSync();
+    int runAsync();
+    int runSyncThreads();
+    int runAsyncThreads();
+    int runAsyncDrop();
+    int runBinary();
+    int runLevels();
+    int runSampling();
+    int runFormatting();
+    int runSyncThreadExit();
+    int runAsyncThreadExit();
+
+private:
+    std::ostringstream m_output;
+    std::streambuf* m_coutBuffer;
+
+    void captureOutput()
+    {
+        m_output.str("");
+        std::cout.rdbuf(m_output.rdbuf());
+    }
+
+    std::string releaseOutput()
+    {
+        std::cout.rdbuf(m_coutBuffer);
+        return m_output.str();
+    }
+
+    // every thread logs TEST_LINES lines built out of several arguments
+    static void logFromThreads()
+    {
+        std::vector<std::thread> threads;
+        for (int i = 0; i < TEST_THREADS; i++)
+        {
+            threads.push_back(std::thread([i]() {
+                for (int j = 0; j < TEST_LINES; j++)
+                {
+                    DummyLogger::Instance() << "thread " << i << " line " << j
+                                            << " end" << std::endl;
+                }
+            }));
+        }
+        for (int i = 0; i < TEST_THREADS; i++)
+        {
+            threads[i].join();
+        }
+    }
+
+    // checks every line logged by logFromThreads is whole and in order
+    static long checkThreadLines(const std::string &a_output)
+    {
+        std::vector<int> nextLine(TEST_THREADS, 0);
+        std::istringstream lines(a_output);
+        std::string line;
+        long count = 0;
+        while (std::getline(lines, line))
+        {
+            int thread;
+            int index;
+            char end[4] = {0};
+            int fields = sscanf(line.c_str(), "thread %d line %d %3s", &thread, &index, end);
+            assert(fields == 3);
+            assert(std::string(end) == "end");
+            assert(line.size() == std::to_string(thread).size() +
+                                  std::to_string(index).size() + 17);
+            assert(index == nextLine[thread]);
+            nextLine[thread]++;
+            count++;
+            (void) fields;
+        }
+        return count;
+    }
+
+    // counts how many times the arguments of a statement are evaluated
+    static int evaluated(int &a_count)
+    {
+        return ++a_count;
+    }
+
+    static void logEverything()
+    {
+        Point point = {1, 2};
+        std::string text(100, 'x');
+
+        DummyLogger::Instance() << "int " << -42 << " unsigned " << 42u
+                                << " double " << 1.5 << " char " << 'c'
+                                << " bool " << true << std::endl;
+        DummyLogger::Instance() << "hex " << std::hex << 255 << std::dec
+                                << " point " << point << std::endl;
+        DummyLogger::Instance() << text << std::endl;
+    }
+};
+
+int DummyLoggerTest::runSync()
+{
+    captureOutput();
+    logEverything();
+    std::string output = releaseOutput();
+
+    std::string expected =
+        "int -42 unsigned 42 double 1.5 char c bool 1\n"
+        "hex ff point (1, 2)\n" +
+        std::string(100, 'x') + "\n";
+    assert(output == expected);
+    (void) expected;
+
+    std::cout << "sync: OK" << std::endl;
+    return 0;
+}
+
+int DummyLoggerTest::runAsync()
+{
+    // the same output as in synchronous mode
+    captureOutput();
+    logEverything();
+    std::string syncOutput = releaseOutput();
+
+    captureOutput();
+    DummyLogger::Instance().startAsync();
+    assert(DummyLogger::Instance().isAsync());
+    logEverything();
+    DummyLogger::Instance().flush();
+    std::string asyncOutput = releaseOutput();
+    assert(asyncOutput == syncOutput);
+
+    // flush waits for everything logged before it
+    captureOutput();
+    DummyLogger::Instance() << "after flush" << std::endl;
+    DummyLogger::Instance().stopAsync();
+    assert(!DummyLogger::Instance().isAsync());
+    assert(releaseOutput() == "after flush\n");
+
+    std::cout << "async: OK" << std::endl;
+    return 0;
+}
+
+int DummyLoggerTest::runSyncThreads()
+{
+    // lines go straight to std::cout in synchronous mode. A string stream
+    // can't be written by several threads at the same time, so the file
+    // descriptor of the standard output is redirected into a file instead
+    char path[] = "/tmp/dummylogger_test_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    std::cout.flush();
+    fflush(stdout);
+    int savedStdout = dup(1);
+    dup2(fd, 1);
+
+    logFromThreads();
+
+    std::cout.flush();
+    fflush(stdout);
+    dup2(savedStdout, 1);
+    close(savedStdout);
+    close(fd);
+
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    unlink(path);
+
+    long lines = checkThreadLines(contents.str());
+    assert(lines == (TEST_THREADS * TEST_LINES));
+
+    std::cout << "sync, " << TEST_THREADS << " threads: "
+              << lines << " whole lines" << std::endl;
+    return 0;
+}
+
+int DummyLoggerTest::runAsyncThreads()
+{
+    captureOutput();
+    DummyLogger::Instance().startAsync();
+    logFromThreads();
+    DummyLogger::Instance().stopAsync();
+    std::string output = releaseOutput();
+
+    // nothing is lost with the (default) block policy
+    long lines = checkThreadLines(output);
+    assert(lines == (TEST_THREADS * TEST_LINES));
+    assert(DummyLogger::Instance().droppedRecords() == 0);
+
+    std::cout << "async, " << TEST_THREADS << " threads: "
+              << lines << " whole lines" << std::endl;
+    return 0;
+}
+
+int DummyLoggerTest::runAsyncDrop()
+{
+    captureOutput();
+    DummyLogger::Instance().startAsync(DUMMYLOGGER_FULL_RING_DROP);
+
+    // the calling thread never blocks, so it logs faster than the output
+    for (int j = 0; j < (TEST_THREADS * TEST_LINES); j++)
+    {
+        DummyLogger::Instance() << "line " << j << std::endl;
+    }
+
+    DummyLogger::Instance().stopAsync();
+    std::string output = releaseOutput();
+
+    long lines = std::count(output.begin(), output.end(), '\n');
+    assert(lines <= (TEST_THREADS * TEST_LINES));
+
+    std::cout << "async, drop policy: " << (TEST_THREADS * TEST_LINES)
+              << " lines logged, " << lines << " written, "
+              << DummyLogger::Instance().droppedRecords()
+              << " records dropped" << std::endl;
+    return 0;
+}
+
+int DummyLoggerTest::runBinary()
+{
+    std::ostringstream binary(std::ios::out | std::ios::binary);
+    DummyLogger::Instance().setBinaryStream(binary);
+
+    // synchronous
+    std::string name("orders");
+    const char* literal = "literal";
+    DUMMYLOG_BINARY("{} {} {} {} {} {} {}", -42, 42u, 1.5, 'c', true, name, literal);
+    DUMMYLOG_BINARY("no arguments");
+
+    // synchronous, several threads writing to the same stream
+    std::vector<std::thread> threads;
+    for (int i = 0; i < TEST_THREADS; i++)
+    {
+        threads.push_back(std::thread([i]() {
+            for (int j = 0; j < 200; j++)
+            {
+                DUMMYLOG_BINARY("sync thread {} entry {} of {}", i, j, 200);
+            }
+        }));
+    }
+    for (int i = 0; i < TEST_THREADS; i++)
+    {
+        threads[i].join();
+    }
+    threads.clear();
+
+    // asynchronous, several threads sharing a call site
+    DummyLogger::Instance().startAsync();
+    for (int i = 0; i < TEST_THREADS; i++)
+    {
+        threads.push_back(std::thread([i]() {
+            for (int j = 0; j < 500; j++)
+            {
+                DUMMYLOG_BINARY("thread {} entry {} of {}", i, j, 500);
+            }
+        }));
+    }
+    for (int i = 0; i < TEST_THREADS; i++)
+    {
+        threads[i].join();
+    }
+    std::string longText(1000, 'y');
+    DUMMYLOG_BINARY("long {}", longText);
+    DummyLogger::Instance().stopAsync();
+
+    std::ostringstream text;
+    DummyLogBinaryDecoder decoder;
+    long entries = decoder.Decode(binary.str().data(), binary.str().size(), text);
+    assert(entries == (2 + (TEST_THREADS * 200) + (TEST_THREADS * 500) + 1));
+
+    // timestamp, file:line, then the message
+    std::istringstream lines(text.str());
+    std::string line;
+    std::getline(lines, line);
+    assert(line.substr(line.find(' ', line.find(' ') + 1) + 1) ==
+           "-42 42 1.5 c true orders literal");
+    std::getline(lines, line);
+    assert(line.substr(line.find(' ', line.find(' ') + 1) + 1) == "no arguments");
+
+    long syncEntries = 0;
+    long threadEntries = 0;
+    while (std::getline(lines, line))
+    {
+        if (line.find("sync thread ") != std::string::npos)
+        {
+            assert(line.find(" of 200") != std::string::npos);
+            syncEntries++;
+        }
+        else if (line.find("thread ") != std::string::npos)
+        {
+            assert(line.find(" of 500") != std::string::npos);
+            threadEntries++;
+        }
+        else
+        {
+            // strings are truncated to DUMMYLOG_BINARY_MAX_STRING bytes
+            assert(line.substr(line.find("long ")) ==
+                   "long " + std::string(DUMMYLOG_BINARY_MAX_STRING, 'y'));
+        }
+    }
+    assert(syncEntries == (TEST_THREADS * 200));
+    assert(threadEntries == (TEST_THREADS * 500));
+
+    std::cout << "binary: " << entries << " entries decoded" << std::endl;
+    return 0;
+}
+
+int DummyLoggerTest::runLevels()
+{
+    int count = 0;
+    DummyLogger::Instance().setLevel(DUMMYLOG_LEVEL_INFO);
+    assert(DummyLogger::Instance().getLevel() == DUMMYLOG_LEVEL_INFO);
+
+    captureOutput();
+    DLOG(TRACE) << "trace " << evaluated(count) << std::endl;
+    DLOG(DEBUG) << "debug " << evaluated(count) << std::endl;
+    DLOG(INFO) << "info " << evaluated(count) << std::endl;
+    DLOG(WARNING) << "warning " << evaluated(count) << std::endl;
+    DLOG(ERROR) << "error " << evaluated(count) << std::endl;
+    assert(releaseOutput() == "info 1\nwarning 2\nerror 3\n");
+    assert(count == 3);
+
+    // TRACE is under DUMMYLOG_MIN_LEVEL, so it is off whatever the threshold
+    DummyLogger::Instance().setLevel(DUMMYLOG_LEVEL_TRACE);
+    assert(!DLOG_IS_ON(TRACE));
+    assert(DLOG_IS_ON(DEBUG));
+
+    captureOutput();
+    DLOG(TRACE) << "trace " << evaluated(count) << std::endl;
+    DLOG(DEBUG) << "debug " << evaluated(count) << std::endl;
+    assert(releaseOutput() == "debug 4\n");
+
+    // it must behave as a single statement
+    DummyLogger::Instance().setLevel(DUMMYLOG_LEVEL_OFF);
+    captureOutput();
+    if (count > 0)
+        DLOG(ERROR) << "not logged" << std::endl;
+    else
+        assert(false);
+    assert(releaseOutput().empty());
+    assert(count == 4);
+
+    // the same works for the binary log. The logger keeps writing to the
+    // stream after this test is over
+    static std::ostringstream binary(std::ios::out | std::ios::binary);
+    DummyLogger::Instance().setBinaryStream(binary);
+    DummyLogger::Instance().setLevel(DUMMYLOG_LEVEL_WARNING);
+    DLOG_BINARY(TRACE, "trace {}", evaluated(count));
+    DLOG_BINARY(INFO, "info {}", evaluated(count));
+    DLOG_BINARY(ERROR, "error {}", evaluated(count));
+    assert(count == 5);
+
+    std::ostringstream text;
+    DummyLogBinaryDecoder decoder;
+    long entries = decoder.Decode(binary.str().data(), binary.str().size(), text);
+    assert(entries == 1);
+    (void) entries;
+    assert(text.str().find("error 5") != std::string::npos);
+
+    DummyLogger::Instance().setLevel(DUMMYLOG_LEVEL_TRACE);
+    std::cout << "levels: OK" << std::endl;
+    return 0;
+}
+
+int DummyLoggerTest::runSampling()
+{
+    int count = 0;
+    long logged = 0;
+    captureOutput();
+    for (int i = 0; i < 100; i++)
+    {
+        DLOG_SAMPLED(INFO, 3, 10) << "sampled " << evaluated(count) << std::endl;
+        DLOG_FIRST_N(INFO, 2) << "first " << i << std::endl;
+        DLOG_EVERY_N(INFO, 25) << "every " << i << std::endl;
+    }
+    for (int i = 0; i < 1000; i++)
+    {
+        DLOG_RATE_LIMITED(INFO, 5) << "limited " << i << std::endl;
+    }
+    // flushing reports the lines suppressed until now
+    DummyLogger::Instance().flush();
+    std::string output = releaseOutput();
+
+    // hits 0, 1, 2 then 3, 13, 23... 93. Nothing else is evaluated
+    assert(count == 13);
+
+    std::istringstream lines(output);
+    std::string line;
+    std::vector<int> everyLines;
+    long limitedLines = 0;
+    long suppressed = 0;
+    while (std::getline(lines, line))
+    {
+        std::size_t report = line.find(" lines suppressed");
+        if (report != std::string::npos)
+        {
+            // <file>:<line>: <count> lines suppressed
+            std::size_t start = line.rfind(' ', report - 1) + 1;
+            suppressed += std::stol(line.substr(start, report - start));
+            continue;
+        }
+
+        logged++;
+        if (line.compare(0, 6, "every ") == 0)
+        {
+            everyLines.push_back(std::stoi(line.substr(6)));
+        }
+        else if (line.compare(0, 8, "limited ") == 0)
+        {
+            limitedLines++;
+        }
+    }
+    assert((everyLines.size() == 4) && (everyLines[3] == 75));
+
+    // 5 per second (a new second might have started in the middle)
+    assert((limitedLines >= 5) && (limitedLines <= 10));
+    assert(logged == (13 + 2 + 4 + limitedLines));
+
+    // everything which wasn't logged was reported
+    assert(suppressed == ((3 * 100) + 1000 - logged));
+
+    std::cout << "sampling: OK" << std::endl;
+    return 0;
+}
+
+// logs enums and the manipulators of <iomanip>, leaving the format of the
+// thread as it was
+static void logFormatting()
+{
+    DummyLogger::Instance() << "colour " << COLOUR_GREEN << " offset " << OFFSET_BEFORE
+                            << " hex " << std::hex << OFFSET_MASK << std::dec << std::endl;
+    DummyLogger::Instance() << std::setw(6) << 42 << '|'
+                            << std::setfill('*') << std::setw(5) << "ab" << '|'
+                            << std::setw(4) << "" << '|'
+                            << std::setprecision(3) << 3.14159 << '|'
+                            << std::setbase(16) << 255 << std::setbase(10) << '|'
+                            << std::setiosflags(std::ios_base::showpos) << 7
+                            << std::resetiosflags(std::ios_base::showpos) << '|'
+                            << std::left << std::setw(70) << std::string(60, 'y') << '|'
+                            << std::setfill(' ') << std::right << std::setprecision(6)
+                            << std::endl;
+}
+
+int DummyLoggerTest::runFormatting()
+{
+    captureOutput();
+    logFormatting();
+    std::string syncOutput = releaseOutput();
+    assert(syncOutput ==
+        "colour green offset -1 hex ff\n"
+        "    42|***ab|****|3.14|ff|+7|" + std::string(60, 'y') + std::string(10, '*') + "|\n");
+
+    // the same output in asynchronous mode
+    captureOutput();
+    DummyLogger::Instance().startAsync();
+    logFormatting();
+    DummyLogger::Instance().stopAsync();
+    std::string asyncOutput = releaseOutput();
+    assert(asyncOutput == syncOutput);
+
+    std::cout << "formatting: OK" << std::endl;
+    return 0;
+}
+
+int DummyLoggerTest::runSyncThreadExit()
+{
+    captureOutput();
+
+    // a line ending in '\n' is written straight away, and what is left of
+    // the line of a thread is written when it finishes
+    std::thread first([this]() {
+        DummyLogger::Instance() << "first\n";
+        assert(m_output.str() == "first\n");
+        DummyLogger::Instance() << std::hex << std::setfill('*') << "partial";
+    });
+    first.join();
+    assert(m_output.str() == "first\npartial");
+
+    // the next thread gets the replica of the previous one, but neither its
+    // text nor its format
+    m_output.str("");
+    std::thread second([]() {
+        DummyLogger::Instance() << std::setw(4) << 255 << std::endl;
+    });
+    second.join();
+    assert(releaseOutput() == " 255\n");
+
+    std::cout << "sync, thread exit: OK" << std::endl;
+    return 0;
+}
+
+int DummyLoggerTest::runAsyncThreadExit()
+{
+    // the same as in synchronous mode, written by the background thread
+    captureOutput();
+    DummyLogger::Instance().startAsync();
+    std::thread first([]() {
+        DummyLogger::Instance() << "first\n";
+        DummyLogger::Instance() << std::hex << std::setfill('*') << "partial";
+    });
+    first.join();
+    DummyLogger::Instance().flush();
+    assert(m_output.str() == "first\npartial");
+
+    m_output.str("");
+    std::thread second([]() {
+        DummyLogger::Instance() << std::setw(4) << 255 << std::endl;
+    });
+    second.join();
+    DummyLogger::Instance().stopAsync();
+    assert(releaseOutput() == " 255\n");
+
+    std::cout << "async, thread exit: OK" << std::endl;
+    return 0;
+}
+
+int main()
+{
+    DummyLoggerTest theTest;
+    int theDummyLoggerTestResult = 0;
+
+    theDummyLoggerTestResult |= theTest.runSync();
+    theDummyLoggerTestResult |= theTest.runAsync();
+    theDummyLoggerTestResult |= theTest.runFormatting();
+    theDummyLoggerTestResult |= theTest.runSyncThreadExit();
+    theDummyLoggerTestResult |= theTest.runAsyncThreadExit();
+    theDummyLoggerTestResult |= theTest.runSyncThreads();
+    theDummyLoggerTestResult |= theTest.runAsyncThreads();
+    theDummyLoggerTestResult |= theTest.runAsyncDrop();
+    theDummyLoggerTestResult |= theTest.runBinary();
+    theDummyLoggerTestResult |= theTest.runLevels();
+    theDummyLoggerTestResult |= theTest.runSampling();
+
+    return theDummyLoggerTestResult;
+}
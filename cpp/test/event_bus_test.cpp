@@ -0,0 +1,201 @@
+// ============================================================================
+/// @file  event_bus_test.cpp
+/// @brief Testing the event bus (type ids, synchronous and queued handlers)
+/// Compiling procedure:
+///   $ g++ -g -O0 -Wall -std=c++11 -D_REENTRANT -c event_bus_test.cpp
+///   $ g++ event_bus_test.o -o event_bus_test -pthread -std=c++11
+///
+/// Expected output:
+/// type ids: OK
+/// synchronous: OK
+/// queued: OK
+// ============================================================================
+
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <assert.h>
+#include "event_bus.h"
+
+struct PriceUpdate
+{
+    uint32_t instrument;
+    double price;
+};
+
+struct OrderFilled
+{
+    uint64_t orderId;
+    uint32_t quantity;
+};
+
+class Strategy
+{
+public:
+    Strategy():
+        m_prices(0),
+        m_lastPrice(0),
+        m_filled(0),
+        m_threadId()
+    {}
+
+    void OnPrice(const PriceUpdate &a_update)
+    {
+        m_lastPrice = a_update.price;
+        m_threadId = std::this_thread::get_id();
+        m_prices++;
+    }
+
+    void OnFill(const OrderFilled &a_fill)
+    {
+        m_filled += a_fill.quantity;
+    }
+
+    int Prices() const
+    {
+        return m_prices.load();
+    }
+
+    double LastPrice() const
+    {
+        return m_lastPrice;
+    }
+
+    uint32_t Filled() const
+    {
+        return m_filled;
+    }
+
+    std::thread::id ThreadId() const
+    {
+        return m_threadId;
+    }
+
+private:
+    std::atomic<int> m_prices;
+    double m_lastPrice;
+    uint32_t m_filled;
+    std::thread::id m_threadId;
+};
+
+class EventBusTest
+{
+public:
+    int runTypeIds();
+    int runSynchronous();
+    int runQueued();
+
+private:
+    /// @brief waits for a queued handler to be called a_prices times
+    static void waitForPrices(const Strategy &a_strategy, int a_prices)
+    {
+        for (int i = 0; (i < 5000) && (a_strategy.Prices() < a_prices); i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        assert(a_strategy.Prices() == a_prices);
+    }
+};
+
+int EventBusTest::runTypeIds()
+{
+    uint32_t priceId = EventBus::TypeId<PriceUpdate>();
+    uint32_t fillId = EventBus::TypeId<OrderFilled>();
+    assert(priceId != fillId);
+    assert(EventBus::TypeId<PriceUpdate>() == priceId);
+    assert(EventBus::TypeId<OrderFilled>() == fillId);
+    (void) priceId;
+    (void) fillId;
+
+    std::cout << "type ids: OK" << std::endl;
+    return 0;
+}
+
+int EventBusTest::runSynchronous()
+{
+    EventBus bus;
+    Strategy a;
+    Strategy b;
+
+    // no handlers yet
+    PriceUpdate update = {7, 101.5};
+    bus.Publish(update);
+    assert(bus.Subscribers<PriceUpdate>() == 0);
+
+    bus.Subscribe(MakeDelegate(&a, &Strategy::OnPrice));
+    bus.Subscribe(MakeDelegate(&b, &Strategy::OnPrice));
+    bus.Subscribe(MakeDelegate(&a, &Strategy::OnFill));
+    assert(bus.Subscribers<PriceUpdate>() == 2);
+    assert(bus.Subscribers<OrderFilled>() == 1);
+
+    bus.Publish(update);
+    assert((a.Prices() == 1) && (b.Prices() == 1));
+    assert(a.LastPrice() == 101.5);
+    assert(a.ThreadId() == std::this_thread::get_id());
+
+    OrderFilled fill = {1, 300};
+    bus.Publish(fill);
+    assert((a.Filled() == 300) && (a.Prices() == 1));
+
+    bool removed = bus.Unsubscribe(MakeDelegate(&b, &Strategy::OnPrice));
+    assert(removed);
+    removed = bus.Unsubscribe(MakeDelegate(&b, &Strategy::OnPrice));
+    assert(!removed);
+    (void) removed;
+
+    update.price = 99.0;
+    bus.Publish(update);
+    assert((a.Prices() == 2) && (b.Prices() == 1));
+
+    std::cout << "synchronous: OK" << std::endl;
+    return 0;
+}
+
+int EventBusTest::runQueued()
+{
+    EventBus bus;
+    EventBus::DispatchThread_t worker(&EventBus::RunTask);
+    Strategy strategy;
+
+    bus.Subscribe(MakeDelegate(&strategy, &Strategy::OnPrice), worker);
+    assert(bus.Subscribers<PriceUpdate>() == 1);
+
+    PriceUpdate update = {7, 101.5};
+    bus.Publish(update);
+    // the event was copied: changing it doesn't change what the handler gets
+    update.price = 0.0;
+    waitForPrices(strategy, 1);
+    assert(strategy.LastPrice() == 101.5);
+    assert(strategy.ThreadId() != std::this_thread::get_id());
+
+    // a synchronous handler is a different subscription
+    bool removed = bus.Unsubscribe(MakeDelegate(&strategy, &Strategy::OnPrice));
+    assert(!removed);
+    removed = bus.Unsubscribe(MakeDelegate(&strategy, &Strategy::OnPrice), worker);
+    assert(removed);
+    removed = bus.Unsubscribe(MakeDelegate(&strategy, &Strategy::OnPrice), worker);
+    assert(!removed);
+    (void) removed;
+
+    bus.Publish(update);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    assert(strategy.Prices() == 1);
+
+    worker.Join();
+
+    std::cout << "queued: OK" << std::endl;
+    return 0;
+}
+
+int main()
+{
+    EventBusTest theTest;
+    int theEventBusTestResult = 0;
+
+    theEventBusTestResult |= theTest.runTypeIds();
+    theEventBusTestResult |= theTest.runSynchronous();
+    theEventBusTestResult |= theTest.runQueued();
+
+    return theEventBusTestResult;
+}
@@ -0,0 +1,192 @@
+// ============================================================================
+/// @file  inplace_delegate_test.cpp
+/// @brief Testing InplaceDelegate (free functions, methods and lambdas)
+/// Compiling procedure:
+///   $ g++ -g -O0 -Wall -std=c++11 -D_REENTRANT -c inplace_delegate_test.cpp
+///   $ g++ inplace_delegate_test.o -o inplace_delegate_test -std=c++11
+///
+/// Expected output:
+/// functions: OK
+/// lambdas: OK
+/// copies: OK
+// ============================================================================
+
+#include <iostream>
+#include <memory>  // std::shared_ptr
+#include <string>
+#include <assert.h>
+#include "delegate/InplaceDelegate.h"
+
+static int add(int a_a, int a_b)
+{
+    return a_a + a_b;
+}
+
+class Accumulator
+{
+public:
+    Accumulator():
+        m_total(0)
+    {}
+
+    int Add(int a_a, int a_b)
+    {
+        m_total += a_a + a_b;
+        return m_total;
+    }
+
+    int Total(int a_a, int a_b) const
+    {
+        return m_total + a_a - a_b;
+    }
+
+private:
+    int m_total;
+};
+
+class InplaceDelegateTest
+{
+public:
+    int runFunctions();
+    int runLambdas();
+    int runCopies();
+};
+
+int InplaceDelegateTest::runFunctions()
+{
+    InplaceDelegate<int(int, int)> delegate;
+    assert(!delegate);
+
+    delegate = &add;
+    assert(delegate);
+    assert(delegate(2, 3) == 5);
+
+    Accumulator accumulator;
+    delegate = MakeInplaceDelegate(&accumulator, &Accumulator::Add);
+    assert(delegate(1, 2) == 3);
+    assert(delegate(1, 2) == 6);
+
+    const Accumulator &constAccumulator = accumulator;
+    delegate = MakeInplaceDelegate(&constAccumulator, &Accumulator::Total);
+    assert(delegate(10, 4) == 12);
+
+    // methods known at compile time
+    Accumulator bound;
+    delegate = InplaceDelegate<int(int, int)>::Bind<Accumulator, &Accumulator::Add>(&bound);
+    assert(delegate(2, 2) == 4);
+    assert(delegate(1, 0) == 5);
+    delegate = InplaceDelegate<int(int, int)>::Bind<Accumulator, &Accumulator::Total>(
+        static_cast<const Accumulator*>(&bound));
+    assert(delegate(10, 4) == 11);
+    InplaceDelegate<int(int, int)> boundCopy(delegate);
+    assert(boundCopy(0, 0) == 5);
+
+    InplaceDelegate<int(int, int)> fromFunction(MakeInplaceDelegate(&add));
+    assert(fromFunction(4, 4) == 8);
+
+    delegate.Reset();
+    assert(!delegate);
+
+    // arguments by reference are not copied
+    std::string text;
+    InplaceDelegate<void(std::string&, const std::string&)> append =
+        [](std::string &a_out, const std::string &a_tail) { a_out += a_tail; };
+    append(text, "hello");
+    append(text, " world");
+    assert(text == "hello world");
+
+    std::cout << "functions: OK" << std::endl;
+    return 0;
+}
+
+int InplaceDelegateTest::runLambdas()
+{
+    int counter = 0;
+    InplaceDelegate<void(int)> increment = [&counter](int a_value) { counter += a_value; };
+    increment(3);
+    increment(4);
+    assert(counter == 7);
+
+    // 4 captures by value fit in the default 32 bytes
+    long a = 1, b = 2, c = 3, d = 4;
+    InplaceDelegate<long()> sum = [a, b, c, d]() { return a + b + c + d; };
+    assert(sum() == 10);
+
+    // 8 need 64
+    long e = 5, f = 6, g = 7, h = 8;
+    InplaceDelegate<long(), 64> bigSum = [a, b, c, d, e, f, g, h]() {
+        return a + b + c + d + e + f + g + h; };
+    assert(bigSum() == 36);
+
+    // mutable lambdas keep their state inside the delegate
+    InplaceDelegate<int()> sequence = [counter]() mutable { return counter++; };
+    assert(sequence() == 7);
+    assert(sequence() == 8);
+
+    // functors
+    struct Multiplier
+    {
+        int factor;
+        int operator()(int a_value) const { return a_value * factor; }
+    };
+    Multiplier triple = {3};
+    InplaceDelegate<int(int)> multiply(triple);
+    assert(multiply(5) == 15);
+
+    std::cout << "lambdas: OK" << std::endl;
+    return 0;
+}
+
+int InplaceDelegateTest::runCopies()
+{
+    std::shared_ptr<int> value(new int(42));
+    {
+        InplaceDelegate<int()> delegate = [value]() { return *value; };
+        assert(value.use_count() == 2);
+
+        InplaceDelegate<int()> copy(delegate);
+        assert(value.use_count() == 3);
+        assert(copy() == 42);
+
+        InplaceDelegate<int()> assigned;
+        assigned = copy;
+        assert(value.use_count() == 4);
+
+        // assigning destroys the previous target
+        assigned = []() { return 0; };
+        assert(value.use_count() == 3);
+        assert(assigned() == 0);
+
+        copy.Reset();
+        assert(value.use_count() == 2);
+
+        // a delegate assigned from a copy of itself
+        delegate = InplaceDelegate<int()>(delegate);
+        assert(value.use_count() == 2);
+        assert(delegate() == 42);
+    }
+    assert(value.use_count() == 1);
+
+    // captured strings are copied, not shared
+    std::string greeting("hello");
+    InplaceDelegate<std::string(const std::string&)> greet =
+        [greeting](const std::string &a_name) { return greeting + " " + a_name; };
+    InplaceDelegate<std::string(const std::string&)> greetCopy(greet);
+    greet.Reset();
+    assert(greetCopy("world") == "hello world");
+
+    std::cout << "copies: OK" << std::endl;
+    return 0;
+}
+
+int main()
+{
+    InplaceDelegateTest theTest;
+    int theInplaceDelegateTestResult = 0;
+
+    theInplaceDelegateTestResult |= theTest.runFunctions();
+    theInplaceDelegateTestResult |= theTest.runLambdas();
+    theInplaceDelegateTestResult |= theTest.runCopies();
+
+    return theInplaceDelegateTestResult;
+}
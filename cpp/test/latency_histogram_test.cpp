@@ -0,0 +1,271 @@
+// ============================================================================
+/// @file  latency_histogram_test.cpp
+/// @brief Testing the histograms in latency_histogram.h and the one of
+///        ConsumerThread
+/// Compiling procedure:
+///   $ g++ -g -O0 -Wall -std=c++11 -D_REENTRANT -c latency_histogram_test.cpp
+///   $ g++ latency_histogram_test.o -o latency_histogram_test -pthread -std=c++11
+///
+/// Expected output:
+/// buckets: OK
+/// percentiles: OK
+/// percentile distribution: OK
+/// sharded: 400003 values
+/// consumer thread: OK
+// ============================================================================
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <assert.h>
+#include "latency_histogram.h"
+#include "consumer_thread.h"
+
+#define TEST_THREADS 4
+#define TEST_VALUES  100000
+
+/// @brief records a value from its destructor, once the thread has given
+/// its index back
+struct LateRecorder
+{
+    ShardedLatencyHistogram* histogram;
+
+    ~LateRecorder()
+    {
+        histogram->Record(1);
+    }
+};
+
+class LatencyHistogramTest
+{
+public:
+    int runBuckets();
+    int runPercentiles();
+    int runPercentileDistribution();
+    int runSharded();
+    int runConsumerThread();
+};
+
+int LatencyHistogramTest::runBuckets()
+{
+    // one bucket per value up to 2047
+    for (uint64_t value = 0; value < 2048; value++)
+    {
+        uint32_t index = LatencyHistogram::CountsIndex(value);
+        assert(LatencyHistogram::LowestEquivalentValue(index) == value);
+        assert(LatencyHistogram::HighestEquivalentValue(index) == value);
+    }
+
+    // from there on every value lands in a bucket which contains it, and
+    // buckets are never wider than 1/1024 of their values
+    for (uint64_t value = 2048; value < LATENCY_HISTOGRAM_MAX_VALUE; value = (value * 3) / 2 + 7)
+    {
+        uint32_t index = LatencyHistogram::CountsIndex(value);
+        uint64_t lowest = LatencyHistogram::LowestEquivalentValue(index);
+        uint64_t highest = LatencyHistogram::HighestEquivalentValue(index);
+        assert((lowest <= value) && (value <= highest));
+        assert((highest - lowest) < (lowest / 1000));
+        assert(LatencyHistogram::CountsIndex(highest + 1) == (index + 1));
+        (void) lowest;
+        (void) highest;
+    }
+
+    // the biggest value goes in the last counter, and bigger ones with it
+    uint32_t last = LatencyHistogram::CountsIndex(LATENCY_HISTOGRAM_MAX_VALUE);
+    assert(last == (LATENCY_HISTOGRAM_COUNTS_SIZE - 1));
+    assert(LatencyHistogram::CountsIndex(~0ULL) == last);
+    assert(LatencyHistogram::HighestEquivalentValue(last) == LATENCY_HISTOGRAM_MAX_VALUE);
+    (void) last;
+
+    std::cout << "buckets: OK" << std::endl;
+    return 0;
+}
+
+int LatencyHistogramTest::runPercentiles()
+{
+    LatencyHistogram histogram;
+    assert(histogram.TotalCount() == 0);
+    assert(histogram.Percentile(50.0) == 0);
+    assert(histogram.Max() == 0);
+
+    // 1 to 10000 nanoseconds, plus an hour
+    for (uint64_t value = 1; value <= 10000; value++)
+    {
+        histogram.Record(value);
+    }
+    histogram.Record(3600ULL * 1000000000ULL);
+
+    assert(histogram.TotalCount() == 10001);
+    assert(histogram.Min() == 1);
+    assert(histogram.Percentile(0.0) == 1);
+
+    // 3 significant digits
+    uint64_t p50 = histogram.Percentile(50.0);
+    assert((p50 >= 5000) && (p50 <= 5005));
+    uint64_t p99 = histogram.Percentile(99.0);
+    assert((p99 >= 9900) && (p99 <= 9910));
+    (void) p50;
+    (void) p99;
+
+    uint64_t max = histogram.Max();
+    assert((max >= 3600ULL * 1000000000ULL) && (max <= 3602ULL * 1000000000ULL));
+    assert(histogram.Percentile(100.0) == max);
+    (void) max;
+
+    // merging doubles every count
+    LatencyHistogram merged;
+    merged.Add(histogram);
+    merged.Add(histogram);
+    assert(merged.TotalCount() == 20002);
+    assert(merged.Percentile(50.0) == histogram.Percentile(50.0));
+    merged.Reset();
+    assert(merged.TotalCount() == 0);
+
+    std::cout << "percentiles: OK" << std::endl;
+    return 0;
+}
+
+int LatencyHistogramTest::runPercentileDistribution()
+{
+    LatencyHistogram histogram;
+    for (uint64_t value = 1000; value <= 2000; value++)
+    {
+        histogram.RecordConcurrent(value);
+    }
+
+    std::ostringstream out;
+    histogram.PrintPercentileDistribution(out, 1000.0);
+    std::string text = out.str();
+
+    // the header and footer of HdrHistogram's .hgrm files
+    assert(text.find("Value     Percentile TotalCount 1/(1-Percentile)") != std::string::npos);
+    assert(text.find("       1.000 0.000000000000          1           1.00") != std::string::npos);
+    assert(text.find(" 1.000000000000       1001\n") != std::string::npos);
+    assert(text.find("#[Max     =        2.000, Total count    =         1001]") != std::string::npos);
+    assert(text.find("#[Buckets =           34, SubBuckets     =         2048]") != std::string::npos);
+
+    std::ostringstream summary;
+    histogram.Print(summary);
+    assert(summary.str().find("count=1001 min=1000") == 0);
+
+    std::cout << "percentile distribution: OK" << std::endl;
+    return 0;
+}
+
+int LatencyHistogramTest::runSharded()
+{
+    ShardedLatencyHistogram histogram;
+    LatencyHistogram snapshot;
+
+    // every thread records values of its own
+    std::vector<std::thread> threads;
+    for (int i = 0; i < TEST_THREADS; i++)
+    {
+        threads.push_back(std::thread([&histogram, i]() {
+            for (int j = 0; j < TEST_VALUES; j++)
+            {
+                histogram.Record((i + 1) * 100);
+            }
+        }));
+    }
+
+    // snapshots can be taken while they record
+    histogram.Snapshot(snapshot);
+    assert(snapshot.TotalCount() <= (TEST_THREADS * TEST_VALUES));
+
+    for (int i = 0; i < TEST_THREADS; i++)
+    {
+        threads[i].join();
+    }
+
+    histogram.Snapshot(snapshot);
+    assert(snapshot.TotalCount() == (TEST_THREADS * TEST_VALUES));
+    assert(snapshot.Min() == 100);
+    assert(snapshot.Max() == (TEST_THREADS * 100));
+    assert(snapshot.Percentile(25.0) == 100);
+
+    // a thread which records after giving its index back (from a
+    // thread_local destructor) doesn't touch a shard someone else may own
+    std::thread exiting([&histogram]() {
+        static thread_local LateRecorder t_lateRecorder = {&histogram};
+        histogram.Record(100);
+        (void) t_lateRecorder;
+    });
+    exiting.join();
+    std::thread next([&histogram]() {
+        histogram.Record(100);
+    });
+    next.join();
+    histogram.Snapshot(snapshot);
+    assert(snapshot.TotalCount() == (TEST_THREADS * TEST_VALUES) + 3);
+    assert(snapshot.Min() == 1);
+
+    std::cout << "sharded: " << snapshot.TotalCount() << " values" << std::endl;
+    return 0;
+}
+
+int LatencyHistogramTest::runConsumerThread()
+{
+    LatencyHistogram histogram;
+    std::atomic<int> consumed(0);
+    ConsumerThread<int> consumer([&consumed](int a_value) {
+        std::this_thread::sleep_for(std::chrono::microseconds(a_value));
+        consumed++;
+    });
+    consumer.SetLatencyHistogram(&histogram);
+
+    for (int i = 0; i < 10; i++)
+    {
+        consumer.ProduceOrBlock(100);
+    }
+    for (int i = 0; (i < 5000) && (consumed.load() < 10); i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    assert(consumed.load() == 10);
+
+    // the thread records right after the delegate returns
+    for (int i = 0; (i < 5000) && (histogram.TotalCount() < 10); i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    assert(histogram.TotalCount() == 10);
+    assert(histogram.Min() >= 100000);
+
+    // the old histogram can be freed as soon as it has been replaced
+    consumed.store(0);
+    for (int i = 0; i < 1000; i++)
+    {
+        consumer.ProduceOrBlock(0);
+    }
+    while (consumed.load() < 1000)
+    {
+        LatencyHistogram* swapped = new LatencyHistogram();
+        consumer.SetLatencyHistogram(swapped);
+        consumer.SetLatencyHistogram(&histogram);
+        delete swapped;
+    }
+
+    consumer.SetLatencyHistogram(0);
+    consumer.Join();
+
+    std::cout << "consumer thread: OK" << std::endl;
+    return 0;
+}
+
+int main()
+{
+    LatencyHistogramTest theTest;
+    int theLatencyHistogramTestResult = 0;
+
+    theLatencyHistogramTestResult |= theTest.runBuckets();
+    theLatencyHistogramTestResult |= theTest.runPercentiles();
+    theLatencyHistogramTestResult |= theTest.runPercentileDistribution();
+    theLatencyHistogramTestResult |= theTest.runSharded();
+    theLatencyHistogramTestResult |= theTest.runConsumerThread();
+
+    return theLatencyHistogramTestResult;
+}
@@ -0,0 +1,123 @@
+// ============================================================================
+/// @file  lock_free_atomic_ops_test.cpp
+/// @brief Testing the atomic operations in lock_free_atomic_ops.h
+/// Compiling procedure:
+///   $ g++ -g -O0 -Wall -std=c++11 -D_REENTRANT -c lock_free_atomic_ops_test.cpp
+///   $ g++ lock_free_atomic_ops_test.o -o lock_free_atomic_ops_test -pthread -std=c++11
+///
+/// Expected output:
+/// CAS: OK
+/// double-width CAS (lock-free): OK
+/// double-width CAS under contention: 400000 swaps
+// ============================================================================
+
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <assert.h>
+#include "lock_free_atomic_ops.h"
+
+#define TEST_THREADS 4
+#define TEST_SWAPS   100000
+
+class AtomicOpsTest
+{
+public:
+    int runCAS();
+    int runDoubleWidthCAS();
+    int runDoubleWidthContention();
+};
+
+int AtomicOpsTest::runCAS()
+{
+    std::atomic<uint32_t> value(5);
+    assert(AtomicAdd(value, 3u, std::memory_order_relaxed) == 5);
+    assert(AtomicSub(value, 1u) == 8);
+    assert(AtomicLoad(value, std::memory_order_acquire) == 7);
+
+    // a failed CAS leaves the expected value alone
+    uint32_t expected = 6;
+    assert(!CAS(value, expected, 10u, std::memory_order_acq_rel));
+    assert(expected == 6);
+    assert(CAS(value, 7u, 10u, std::memory_order_release));
+    assert(CASVal(value, 3u, 11u) == 10);
+    assert(CASVal(value, 10u, 11u, std::memory_order_acquire) == 10);
+
+    AtomicStore(value, 1u, std::memory_order_release);
+    assert(AtomicLoad(value) == 1);
+
+    std::cout << "CAS: OK" << std::endl;
+    return 0;
+}
+
+int AtomicOpsTest::runDoubleWidthCAS()
+{
+    AtomicPair pair = {1, 2};
+
+    AtomicPair expected = {1, 3};
+    AtomicPair desired = {4, 5};
+    bool swapped = DoubleWidthCAS(pair, expected, desired);
+    assert(!swapped);
+    // the current value is returned when they differ
+    assert((expected.low == 1) && (expected.high == 2));
+
+    swapped = DoubleWidthCAS(pair, expected, desired);
+    assert(swapped);
+    (void) swapped;
+
+    AtomicPair current = DoubleWidthLoad(pair);
+    assert((current.low == 4) && (current.high == 5));
+
+    std::cout << "double-width CAS ("
+              << (ATOMIC_OPS_DWCAS_LOCK_FREE ? "lock-free" : "spin locks")
+              << "): OK" << std::endl;
+    return 0;
+}
+
+int AtomicOpsTest::runDoubleWidthContention()
+{
+    // both halves are incremented together. If the swap weren't atomic they
+    // would end up out of step
+    AtomicPair pair = {0, 1000};
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < TEST_THREADS; i++)
+    {
+        threads.push_back(std::thread([&pair]() {
+            for (int j = 0; j < TEST_SWAPS; j++)
+            {
+                AtomicPair expected = DoubleWidthLoad(pair);
+                AtomicPair desired;
+                do
+                {
+                    assert(expected.high == (expected.low + 1000));
+                    desired.low = expected.low + 1;
+                    desired.high = expected.high + 1;
+                } while (!DoubleWidthCAS(pair, expected, desired));
+            }
+        }));
+    }
+    for (int i = 0; i < TEST_THREADS; i++)
+    {
+        threads[i].join();
+    }
+
+    AtomicPair result = DoubleWidthLoad(pair);
+    assert(result.low == (TEST_THREADS * TEST_SWAPS));
+    assert(result.high == (result.low + 1000));
+
+    std::cout << "double-width CAS under contention: " << result.low << " swaps" << std::endl;
+    return 0;
+}
+
+int main()
+{
+    AtomicOpsTest theTest;
+    int theAtomicOpsTestResult = 0;
+
+    theAtomicOpsTestResult |= theTest.runCAS();
+    theAtomicOpsTestResult |= theTest.runDoubleWidthCAS();
+    theAtomicOpsTestResult |= theTest.runDoubleWidthContention();
+
+    return theAtomicOpsTestResult;
+}
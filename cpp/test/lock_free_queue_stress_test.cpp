@@ -0,0 +1,139 @@
+// ============================================================================
+/// @file  lock_free_queue_stress_test.cpp
+/// @brief Stress test of the memory ordering of ArrayLockFreeQueue
+/// Producers push numbered elements through a small queue (so indexes wrap
+/// around all the time) to several consumers. Every element carries a
+/// checksum of its contents, so an element read before it was published, or
+/// after it was overwritten, is caught. The test checks every element is
+/// popped exactly once, intact, and in the order its producer pushed it.
+///
+/// x86 doesn't reorder loads with other loads, so the acquire/release
+/// mistakes this test is meant to catch only show on weakly ordered CPUs
+/// (ARM, POWER), or when it is built with -fsanitize=thread
+/// Compiling procedure:
+///   $ g++ -g -O0 -Wall -std=c++11 -D_REENTRANT -c lock_free_queue_stress_test.cpp
+///   $ g++ lock_free_queue_stress_test.o -o lock_free_queue_stress_test -pthread -std=c++11
+///
+/// Expected output:
+/// single producer, 3 consumers: 600000 elements OK
+/// 3 producers, 3 consumers: 600000 elements OK
+// ============================================================================
+
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <assert.h>
+#include "lock_free_queue.h"
+
+#define TEST_Q_SIZE    64
+#define TEST_CONSUMERS 3
+#define TEST_ELEMENTS  600000
+
+struct TestElement
+{
+    uint32_t producer;
+    uint32_t sequence;
+    uint64_t checksum;
+
+    static uint64_t Checksum(uint32_t a_producer, uint32_t a_sequence)
+    {
+        uint64_t value = (static_cast<uint64_t>(a_producer) << 32) | a_sequence;
+        return (value * 0x9e3779b97f4a7c15ULL) ^ (value >> 7);
+    }
+};
+
+class LockFreeQueueStressTest
+{
+public:
+    template <template <typename T, uint32_t S> class Q_TYPE>
+    int run(const char* a_name, uint32_t a_producers);
+};
+
+template <template <typename T, uint32_t S> class Q_TYPE>
+int LockFreeQueueStressTest::run(const char* a_name, uint32_t a_producers)
+{
+    ArrayLockFreeQueue<TestElement, TEST_Q_SIZE, Q_TYPE> queue;
+    uint32_t perProducer = TEST_ELEMENTS / a_producers;
+
+    // one flag per element, to find the ones popped twice or never
+    std::vector< std::atomic<uint8_t> > popped(a_producers * perProducer);
+    for (std::size_t i = 0; i < popped.size(); i++)
+    {
+        popped[i].store(0, std::memory_order_relaxed);
+    }
+    std::atomic<uint32_t> consumed(0);
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < a_producers; i++)
+    {
+        threads.push_back(std::thread([&queue, i, perProducer]() {
+            for (uint32_t j = 0; j < perProducer; j++)
+            {
+                TestElement element = {i, j, TestElement::Checksum(i, j)};
+                while (!queue.push(element))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }));
+    }
+
+    for (int i = 0; i < TEST_CONSUMERS; i++)
+    {
+        threads.push_back(std::thread(
+            [&queue, &popped, &consumed, a_producers, perProducer]() {
+            // a single consumer can't see the elements of a producer out of
+            // order, even though other consumers take some of them
+            std::vector<int64_t> lastSequence(a_producers, -1);
+            TestElement element;
+            while (consumed.load(std::memory_order_relaxed) < (a_producers * perProducer))
+            {
+                if (!queue.pop(element))
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                assert(element.producer < a_producers);
+                assert(element.sequence < perProducer);
+                assert(element.checksum == TestElement::Checksum(element.producer, element.sequence));
+                assert(static_cast<int64_t>(element.sequence) > lastSequence[element.producer]);
+                lastSequence[element.producer] = element.sequence;
+
+                uint8_t previous = popped[(element.producer * perProducer) + element.sequence].exchange(1);
+                assert(previous == 0);
+                (void) previous;
+
+                consumed.fetch_add(1, std::memory_order_relaxed);
+            }
+        }));
+    }
+
+    for (std::size_t i = 0; i < threads.size(); i++)
+    {
+        threads[i].join();
+    }
+
+    for (std::size_t i = 0; i < popped.size(); i++)
+    {
+        assert(popped[i].load() == 1);
+    }
+    assert(queue.size() == 0);
+
+    std::cout << a_name << ": " << consumed.load() << " elements OK" << std::endl;
+    return 0;
+}
+
+int main()
+{
+    LockFreeQueueStressTest theTest;
+    int theLockFreeQueueStressTestResult = 0;
+
+    theLockFreeQueueStressTestResult |= theTest.run<ArrayLockFreeQueueSingleProducer>(
+        "single producer, 3 consumers", 1);
+    theLockFreeQueueStressTestResult |= theTest.run<ArrayLockFreeQueueMultipleProducers>(
+        "3 producers, 3 consumers", 3);
+
+    return theLockFreeQueueStressTestResult;
+}
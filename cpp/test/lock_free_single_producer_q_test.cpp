@@ -49,6 +49,7 @@
 #include <iostream>
 #include <chrono>
 #include <memory>
+#include <functional> // std::bind
 #include <thread>
 #include <mutex>
 #include <string>
@@ -0,0 +1,211 @@
+// ============================================================================
+/// @file  multicast_delegate_test.cpp
+/// @brief Testing MulticastDelegate, with subscribers changing while events
+///        are dispatched
+/// Compiling procedure:
+///   $ g++ -g -O0 -Wall -std=c++11 -D_REENTRANT -c multicast_delegate_test.cpp
+///   $ g++ multicast_delegate_test.o -o multicast_delegate_test -pthread -std=c++11
+///
+/// Expected output:
+/// subscribers: OK
+/// unsubscribe while dispatching: OK
+/// churn: N events dispatched while subscribers changed M times
+// ============================================================================
+
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <assert.h>
+#include "delegate/MulticastDelegate.h"
+
+#define TEST_DISPATCH_THREADS 3
+#define TEST_EVENTS           200000
+#define TEST_CHURN_SUBSCRIBERS 8
+
+class Listener
+{
+public:
+    Listener():
+        m_total(0)
+    {}
+
+    void OnValue(int a_value)
+    {
+        m_total += a_value;
+    }
+
+    long Total() const
+    {
+        return m_total;
+    }
+
+private:
+    std::atomic<long> m_total;
+};
+
+static long g_freeTotal = 0;
+
+static void onValue(int a_value)
+{
+    g_freeTotal += a_value;
+}
+
+class MulticastDelegateTest
+{
+public:
+    int runSubscribers();
+    int runUnsubscribeWhileDispatching();
+    int runChurn();
+
+private:
+    /// @brief unsubscribes itself the first time it is called
+    class OneShot
+    {
+    public:
+        OneShot(MulticastDelegate<void(int)> &a_event):
+            m_event(a_event),
+            m_calls(0)
+        {}
+
+        void OnValue(int /*a_value*/)
+        {
+            m_calls++;
+            bool removed = m_event.Unsubscribe(MakeDelegate(this, &OneShot::OnValue));
+            assert(removed);
+            (void) removed;
+        }
+
+        int Calls() const
+        {
+            return m_calls;
+        }
+
+    private:
+        MulticastDelegate<void(int)> &m_event;
+        int m_calls;
+    };
+};
+
+int MulticastDelegateTest::runSubscribers()
+{
+    MulticastDelegate<void(int)> event;
+    assert(event.Size() == 0);
+    event(1);
+
+    Listener a;
+    Listener b;
+    event.Subscribe(MakeDelegate(&a, &Listener::OnValue));
+    event.Subscribe(MakeDelegate(&b, &Listener::OnValue));
+    event.Subscribe(MakeDelegate(&onValue));
+    assert(event.Size() == 3);
+
+    event(2);
+    assert((a.Total() == 2) && (b.Total() == 2) && (g_freeTotal == 2));
+
+    bool removed = event.Unsubscribe(MakeDelegate(&a, &Listener::OnValue));
+    assert(removed);
+    removed = event.Unsubscribe(MakeDelegate(&a, &Listener::OnValue));
+    assert(!removed);
+    (void) removed;
+
+    event(3);
+    assert((a.Total() == 2) && (b.Total() == 5) && (g_freeTotal == 5));
+
+    event.Clear();
+    event(4);
+    assert(event.Size() == 0);
+    assert((b.Total() == 5) && (g_freeTotal == 5));
+
+    // with no dispatch in progress the replaced snapshots are deleted
+    // within two updates
+    assert(event.RetiredSnapshots() <= 1);
+
+    std::cout << "subscribers: OK" << std::endl;
+    return 0;
+}
+
+int MulticastDelegateTest::runUnsubscribeWhileDispatching()
+{
+    MulticastDelegate<void(int)> event;
+    OneShot oneShot(event);
+    Listener listener;
+    event.Subscribe(MakeDelegate(&oneShot, &OneShot::OnValue));
+    event.Subscribe(MakeDelegate(&listener, &Listener::OnValue));
+
+    // the dispatch that removes oneShot still calls listener
+    event(1);
+    event(1);
+    assert(oneShot.Calls() == 1);
+    assert(listener.Total() == 2);
+    assert(event.Size() == 1);
+
+    std::cout << "unsubscribe while dispatching: OK" << std::endl;
+    return 0;
+}
+
+int MulticastDelegateTest::runChurn()
+{
+    MulticastDelegate<void(int)> event;
+    Listener permanent;
+    event.Subscribe(MakeDelegate(&permanent, &Listener::OnValue));
+
+    std::atomic<bool> done(false);
+    long changes = 0;
+    std::thread churn([&event, &done, &changes]() {
+        Listener listeners[TEST_CHURN_SUBSCRIBERS];
+        while (!done.load())
+        {
+            for (int i = 0; i < TEST_CHURN_SUBSCRIBERS; i++)
+            {
+                event.Subscribe(MakeDelegate(&listeners[i], &Listener::OnValue));
+                changes++;
+            }
+            for (int i = 0; i < TEST_CHURN_SUBSCRIBERS; i++)
+            {
+                bool removed = event.Unsubscribe(MakeDelegate(&listeners[i], &Listener::OnValue));
+                assert(removed);
+                (void) removed;
+                changes++;
+            }
+        }
+    });
+
+    std::vector<std::thread> dispatchers;
+    for (int i = 0; i < TEST_DISPATCH_THREADS; i++)
+    {
+        dispatchers.push_back(std::thread([&event]() {
+            for (int j = 0; j < TEST_EVENTS; j++)
+            {
+                event(1);
+            }
+        }));
+    }
+    for (int i = 0; i < TEST_DISPATCH_THREADS; i++)
+    {
+        dispatchers[i].join();
+    }
+    done.store(true);
+    churn.join();
+
+    // the permanent subscriber saw every event, however the list changed
+    assert(permanent.Total() == (TEST_DISPATCH_THREADS * TEST_EVENTS));
+    assert(event.Size() == 1);
+
+    std::cout << "churn: " << permanent.Total()
+              << " events dispatched while subscribers changed "
+              << changes << " times" << std::endl;
+    return 0;
+}
+
+int main()
+{
+    MulticastDelegateTest theTest;
+    int theMulticastDelegateTestResult = 0;
+
+    theMulticastDelegateTestResult |= theTest.runSubscribers();
+    theMulticastDelegateTestResult |= theTest.runUnsubscribeWhileDispatching();
+    theMulticastDelegateTestResult |= theTest.runChurn();
+
+    return theMulticastDelegateTestResult;
+}
@@ -0,0 +1,164 @@
+// ============================================================================
+/// @file  perf_counters_test.cpp
+/// @brief Testing the performance counters in perf_counters.h
+/// Which counters are available depends on the CPU and the kernel (virtual
+/// machines usually have no hardware counters). The test checks whatever
+/// could be opened, and passes if nothing could
+/// Compiling procedure:
+///   $ g++ -g -O0 -Wall -std=c++11 -D_REENTRANT -c perf_counters_test.cpp
+///   $ g++ perf_counters_test.o -o perf_counters_test -pthread -std=c++11
+///
+/// Expected output (the counters of this machine follow the first line):
+/// available: ...
+/// samples: OK
+/// scopes: OK
+/// threads: OK
+// ============================================================================
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <assert.h>
+#include "perf_counters.h"
+
+#define TEST_OPERATIONS 1000000
+
+/// @brief something for the counters to count
+static uint64_t work(uint32_t a_operations)
+{
+    volatile uint64_t total = 0;
+    for (uint32_t i = 0; i < a_operations; i++)
+    {
+        total = total + (i * 7);
+    }
+    return total;
+}
+
+class PerfCountersTest
+{
+public:
+    int runSamples();
+    int runScopes();
+    int runThreads();
+};
+
+int PerfCountersTest::runSamples()
+{
+    PerfCounterSample start;
+    start.Set(PERF_EVENT_CYCLES, 100);
+    start.Set(PERF_EVENT_INSTRUCTIONS, 1000);
+    start.Set(PERF_EVENT_TASK_CLOCK, 10);
+
+    PerfCounterSample end;
+    end.Set(PERF_EVENT_CYCLES, 300);
+    end.Set(PERF_EVENT_INSTRUCTIONS, 1600);
+
+    // only what both samples counted is added up
+    PerfCounterSample total;
+    total.AddDelta(start, end);
+    assert(total.Value(PERF_EVENT_CYCLES) == 200);
+    assert(total.Value(PERF_EVENT_INSTRUCTIONS) == 600);
+    assert(!total.IsAvailable(PERF_EVENT_TASK_CLOCK));
+    assert(!total.IsAvailable(PERF_EVENT_LLC_MISSES));
+    assert(total.PerOperation(PERF_EVENT_CYCLES, 100) == 2.0);
+    assert(total.PerOperation(PERF_EVENT_LLC_MISSES, 100) < 0.0);
+
+    std::ostringstream out;
+    total.Print(out, 100);
+    assert(out.str() == "cycles/op=2.000 instructions/op=6.000 ipc=3.00\n");
+
+    std::ostringstream empty;
+    PerfCounterSample().Print(empty, 100);
+    assert(empty.str() == "perf-counters=unavailable\n");
+
+    std::cout << "samples: OK" << std::endl;
+    return 0;
+}
+
+int PerfCountersTest::runScopes()
+{
+    PerfCounterGroup &group = PerfCounterGroup::ThisThread();
+    assert(&group == &PerfCounterGroup::ThisThread());
+
+    PerfCounterSample total;
+    {
+        PERF_SCOPE(total);
+        work(TEST_OPERATIONS);
+    }
+
+    PerfCounterSample sample;
+    bool read = group.Read(sample);
+    assert(read == group.IsAvailable());
+    (void) read;
+
+    if (group.IsAvailable(PERF_EVENT_TASK_CLOCK))
+    {
+        assert(total.Value(PERF_EVENT_TASK_CLOCK) > 0);
+    }
+    if (group.IsAvailable(PERF_EVENT_INSTRUCTIONS))
+    {
+        // there is more than an instruction per loop
+        assert(total.Value(PERF_EVENT_INSTRUCTIONS) > TEST_OPERATIONS);
+    }
+
+    // a second scope adds to the same total
+    PerfCounterSample previous = total;
+    {
+        PerfScope scope(total, group);
+        work(TEST_OPERATIONS);
+    }
+    if (group.IsAvailable(PERF_EVENT_TASK_CLOCK))
+    {
+        assert(total.Value(PERF_EVENT_TASK_CLOCK) > previous.Value(PERF_EVENT_TASK_CLOCK));
+    }
+
+    std::cout << "scopes: OK" << std::endl;
+    return 0;
+}
+
+int PerfCountersTest::runThreads()
+{
+    // a busy thread doesn't show in the counters of a sleeping one
+    PerfCounterSample busy;
+    PerfCounterSample idle;
+    std::thread busyThread([&busy]() {
+        PerfScope scope(busy);
+        work(TEST_OPERATIONS * 10);
+    });
+    {
+        PerfScope scope(idle);
+        busyThread.join();
+    }
+
+    if (PerfCounterGroup::ThisThread().IsAvailable(PERF_EVENT_TASK_CLOCK))
+    {
+        assert(busy.Value(PERF_EVENT_TASK_CLOCK) > idle.Value(PERF_EVENT_TASK_CLOCK));
+    }
+
+    std::cout << "threads: OK" << std::endl;
+    return 0;
+}
+
+int main()
+{
+    PerfCountersTest theTest;
+    int thePerfCountersTestResult = 0;
+
+    std::cout << "available:";
+    for (int i = 0; i < PERF_EVENT_COUNT; i++)
+    {
+        PerfEvent_t event = static_cast<PerfEvent_t>(i);
+        if (PerfCounterGroup::ThisThread().IsAvailable(event))
+        {
+            std::cout << " " << PerfCounterSample::EventName(event);
+        }
+    }
+    std::cout << std::endl;
+
+    thePerfCountersTestResult |= theTest.runSamples();
+    thePerfCountersTestResult |= theTest.runScopes();
+    thePerfCountersTestResult |= theTest.runThreads();
+
+    return thePerfCountersTestResult;
+}
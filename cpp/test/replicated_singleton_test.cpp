@@ -0,0 +1,212 @@
+// ============================================================================
+/// @file  replicated_singleton_test.cpp
+/// @brief Testing the singletons replicated per thread and per NUMA node
+/// Compiling procedure:
+///   $ g++ -g -O0 -Wall -std=c++11 -D_REENTRANT -c replicated_singleton_test.cpp
+///   $ g++ replicated_singleton_test.o -o replicated_singleton_test -pthread -std=c++11
+///
+/// Expected output (replicas per NUMA node depend on the machine):
+/// per thread: 8 threads, 8 replicas, 800000 increments
+/// per thread: 8 more threads, 8 replicas (reused), 1600000 increments
+/// per NUMA node: 1 node(s), 1 replica(s), 800000 increments
+// ============================================================================
+
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <assert.h>
+#include <stdint.h>
+#include "replicated_singleton.h"
+
+#define TEST_THREADS    8
+#define TEST_INCREMENTS 100000
+
+class ThreadCounters :
+    public PerThreadSingleton<ThreadCounters>
+{
+public:
+    // read by Aggregate from other threads
+    std::atomic<uint64_t> increments;
+    // threads which have given this replica back
+    std::atomic<uint64_t> exits;
+
+private:
+    friend class PerThreadSingleton<ThreadCounters>;
+
+    ThreadCounters(): increments(0), exits(0)
+    {}
+    virtual ~ThreadCounters() {}
+
+    virtual void OnThreadExit()
+    {
+        exits.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+class NodeCounters :
+    public PerNumaNodeSingleton<NodeCounters>
+{
+public:
+    // shared by the threads of a node
+    std::atomic<uint64_t> increments;
+
+private:
+    friend class PerNumaNodeSingleton<NodeCounters>;
+
+    NodeCounters(): increments(0)
+    {}
+    virtual ~NodeCounters() {}
+};
+
+class ReplicatedSingletonTest
+{
+public:
+    int runPerThread();
+    int runPerNumaNode();
+
+private:
+    static uint64_t SumThreadCounters()
+    {
+        return ThreadCounters::Aggregate(static_cast<uint64_t>(0),
+            [](uint64_t a_sum, const ThreadCounters &a_counters) {
+                return a_sum + a_counters.increments.load(std::memory_order_relaxed); });
+    }
+
+    static uint64_t SumThreadExits()
+    {
+        return ThreadCounters::Aggregate(static_cast<uint64_t>(0),
+            [](uint64_t a_sum, const ThreadCounters &a_counters) {
+                return a_sum + a_counters.exits.load(std::memory_order_relaxed); });
+    }
+
+    static uint64_t SumNodeCounters()
+    {
+        return NodeCounters::Aggregate(static_cast<uint64_t>(0),
+            [](uint64_t a_sum, const NodeCounters &a_counters) {
+                return a_sum + a_counters.increments.load(std::memory_order_relaxed); });
+    }
+};
+
+int ReplicatedSingletonTest::runPerThread()
+{
+    std::vector<ThreadCounters*> instances(TEST_THREADS, 0);
+    std::vector<std::thread> threads;
+    std::atomic<int> ready(0);
+
+    for (int i = 0; i < TEST_THREADS; i++)
+    {
+        threads.push_back(std::thread([&instances, &ready, i]() {
+            instances[i] = &(ThreadCounters::Instance());
+
+            // same instance on every call from the same thread
+            assert(instances[i] == ThreadCounters::GetPtr());
+            // no false sharing between replicas
+            assert((reinterpret_cast<uintptr_t>(instances[i]) %
+                REPLICATED_SINGLETON_CACHE_LINE_SIZE) == 0);
+
+            for (int j = 0; j < TEST_INCREMENTS; j++)
+            {
+                ThreadCounters::Instance().increments.fetch_add(
+                    1, std::memory_order_relaxed);
+            }
+
+            // don't finish until every thread has its replica, so no replica
+            // is reused in this round
+            ready++;
+            while (ready.load() < TEST_THREADS)
+            {
+                std::this_thread::yield();
+            }
+        }));
+    }
+    for (int i = 0; i < TEST_THREADS; i++)
+    {
+        threads[i].join();
+    }
+
+    // every thread had its own
+    for (int i = 0; i < TEST_THREADS; i++)
+    {
+        for (int j = i + 1; j < TEST_THREADS; j++)
+        {
+            assert(instances[i] != instances[j]);
+        }
+    }
+    assert(ThreadCounters::InstanceCount() == TEST_THREADS);
+    assert(SumThreadCounters() == (TEST_THREADS * TEST_INCREMENTS));
+    assert(SumThreadExits() == TEST_THREADS);
+
+    std::cout << "per thread: " << TEST_THREADS << " threads, "
+              << ThreadCounters::InstanceCount() << " replicas, "
+              << SumThreadCounters() << " increments" << std::endl;
+
+    // replicas of finished threads are reused and their counts aren't lost
+    threads.clear();
+    for (int i = 0; i < TEST_THREADS; i++)
+    {
+        threads.push_back(std::thread([]() {
+            for (int j = 0; j < TEST_INCREMENTS; j++)
+            {
+                ThreadCounters::Instance().increments.fetch_add(
+                    1, std::memory_order_relaxed);
+            }
+        }));
+        threads.back().join();
+    }
+    assert(ThreadCounters::InstanceCount() == TEST_THREADS);
+    assert(SumThreadCounters() == (2 * TEST_THREADS * TEST_INCREMENTS));
+    assert(SumThreadExits() == (2 * TEST_THREADS));
+
+    int visited = 0;
+    ThreadCounters::ForEachInstance([&visited](ThreadCounters &) { visited++; });
+    assert(visited == TEST_THREADS);
+
+    std::cout << "per thread: " << TEST_THREADS << " more threads, "
+              << ThreadCounters::InstanceCount() << " replicas (reused), "
+              << SumThreadCounters() << " increments" << std::endl;
+
+    return 0;
+}
+
+int ReplicatedSingletonTest::runPerNumaNode()
+{
+    NodeCounters::CreateInstances();
+    int nodes = ReplicatedSingletonUtils::NumaNodeCount();
+    assert(NodeCounters::InstanceCount() == static_cast<std::size_t>(nodes));
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < TEST_THREADS; i++)
+    {
+        threads.push_back(std::thread([]() {
+            for (int j = 0; j < TEST_INCREMENTS; j++)
+            {
+                NodeCounters::Instance().increments.fetch_add(
+                    1, std::memory_order_relaxed);
+            }
+        }));
+    }
+    for (int i = 0; i < TEST_THREADS; i++)
+    {
+        threads[i].join();
+    }
+
+    assert(SumNodeCounters() == (TEST_THREADS * TEST_INCREMENTS));
+
+    std::cout << "per NUMA node: " << nodes << " node(s), "
+              << NodeCounters::InstanceCount() << " replica(s), "
+              << SumNodeCounters() << " increments" << std::endl;
+
+    return 0;
+}
+
+int main()
+{
+    ReplicatedSingletonTest theTest;
+    int theReplicatedSingletonTestResult = 0;
+
+    theReplicatedSingletonTestResult |= theTest.runPerThread();
+    theReplicatedSingletonTestResult |= theTest.runPerNumaNode();
+
+    return theReplicatedSingletonTestResult;
+}
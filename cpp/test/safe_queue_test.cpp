@@ -50,6 +50,7 @@
 #include <iostream>
 #include <chrono>
 #include <memory>
+#include <functional> // std::bind
 #include <thread>
 #include <string>
 #include <assert.h>
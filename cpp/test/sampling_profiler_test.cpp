@@ -0,0 +1,301 @@
+// ============================================================================
+/// @file  sampling_profiler_test.cpp
+/// @brief Testing the sampling profiler in sampling_profiler.h
+/// Two threads burn CPU in different functions while the profiler samples
+/// them. Both functions must show up in the stacks counted, called from
+/// where they were called. Then (x86_64 only) a thread burns CPU with a frame
+/// pointer which passes the checks of the unwinder but points to memory
+/// which can't be read: samples must end the stack there, not crash
+/// Compiling procedure (frame pointers are kept at -O0):
+///   $ g++ -g -O0 -Wall -std=c++11 -D_REENTRANT -c sampling_profiler_test.cpp
+///   $ g++ sampling_profiler_test.o -o sampling_profiler_test -pthread -std=c++11
+///
+/// Expected output:
+/// symbols: OK
+/// samples: OK
+/// folded: OK
+/// bad frame pointer: OK
+/// one sample per second: OK
+// ============================================================================
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <assert.h>
+#include <pthread.h>
+#include <sys/mman.h>  // mmap, mprotect
+#include "sampling_profiler.h"
+#include "clock.h"
+
+#define TEST_HZ          1000
+#define TEST_BURN_NSECS  400000000ULL
+
+// functions are compared by address: names of the executable need -rdynamic
+#define TEST_FUNCTION_SIZE 512
+
+// stack of the thread with a bad frame pointer. It is followed by
+// TEST_GUARD_SIZE bytes which can't be read
+#define TEST_STACK_SIZE  (256 * 1024)
+#define TEST_GUARD_SIZE  (1024 * 1024)
+#define TEST_BAD_FP_LOOPS 400000000ULL
+
+static std::atomic<uint64_t> g_sink(0);
+
+__attribute__((noinline)) void burnFirst(uint64_t a_nsecs)
+{
+    uint64_t end = RealClock::Now() + a_nsecs;
+    uint64_t total = 0;
+    while (RealClock::Now() < end)
+    {
+        for (int i = 0; i < 1000; i++)
+        {
+            total += i;
+        }
+    }
+    g_sink += total;
+}
+
+__attribute__((noinline)) void burnSecond(uint64_t a_nsecs)
+{
+    uint64_t end = RealClock::Now() + a_nsecs;
+    uint64_t total = 1;
+    while (RealClock::Now() < end)
+    {
+        for (int i = 0; i < 1000; i++)
+        {
+            total *= 3;
+        }
+    }
+    g_sink += total;
+}
+
+__attribute__((noinline)) void callBurnSecond(uint64_t a_nsecs)
+{
+    burnSecond(a_nsecs);
+}
+
+/// @brief spins with the frame pointer register pointing to a_badFp
+static void* spinWithBadFramePointer(void* a_badFp)
+{
+#if defined(__x86_64__)
+    uint64_t loops = TEST_BAD_FP_LOOPS;
+    __asm__ __volatile__(
+        "push %%rbp\n\t"
+        "mov  %1, %%rbp\n\t"
+        "1:\n\t"
+        "dec  %0\n\t"
+        "jnz  1b\n\t"
+        "pop  %%rbp\n\t"
+        : "+r"(loops)
+        : "r"(a_badFp)
+        : "cc", "memory");
+#else
+    (void) a_badFp;
+#endif
+    return 0;
+}
+
+static bool inFunction(uintptr_t a_address, void (*a_function)(uint64_t))
+{
+    uintptr_t start = reinterpret_cast<uintptr_t>(a_function);
+    return (a_address >= start) && (a_address < (start + TEST_FUNCTION_SIZE));
+}
+
+class SamplingProfilerTest
+{
+public:
+    int runSymbols();
+    int runSamples();
+    int runFolded();
+    int runBadFramePointer();
+    int runOneHz();
+};
+
+int SamplingProfilerTest::runSymbols()
+{
+    // exported by the C library
+    std::string name = SamplingProfiler::Symbolise(reinterpret_cast<uintptr_t>(&snprintf));
+    assert(name.find("printf") != std::string::npos);
+
+    // no name without -rdynamic, but always the module
+    name = SamplingProfiler::Symbolise(reinterpret_cast<uintptr_t>(&burnFirst));
+    assert(!name.empty());
+    assert(name.find(' ') == std::string::npos);
+
+    std::cout << "symbols: OK" << std::endl;
+    return 0;
+}
+
+int SamplingProfilerTest::runSamples()
+{
+    SamplingProfiler::Reset();
+    bool started = SamplingProfiler::Start(TEST_HZ);
+    assert(started);
+    assert(SamplingProfiler::IsRunning());
+    (void) started;
+
+    std::thread second([]() { callBurnSecond(TEST_BURN_NSECS); });
+    burnFirst(TEST_BURN_NSECS);
+    second.join();
+
+    SamplingProfiler::Stop();
+    assert(!SamplingProfiler::IsRunning());
+    uint64_t samples = SamplingProfiler::Samples();
+    assert(samples > 0);
+    assert(SamplingProfiler::Dropped() == 0);
+
+    // stopped: nothing else is counted
+    burnFirst(TEST_BURN_NSECS / 10);
+    assert(SamplingProfiler::Samples() == samples);
+    (void) samples;
+
+    uint64_t firstCount = 0;
+    uint64_t secondCount = 0;
+    uint64_t counted = 0;
+    SamplingProfiler::ForEachStack(
+        [&firstCount, &secondCount, &counted](const uintptr_t* a_frames, uint32_t a_depth, uint64_t a_count) {
+        counted += a_count;
+        for (uint32_t i = 0; i < a_depth; i++)
+        {
+            if (inFunction(a_frames[i], &burnFirst))
+            {
+                firstCount += a_count;
+            }
+            // burnSecond is called by callBurnSecond
+            if (inFunction(a_frames[i], &burnSecond) && ((i + 1) < a_depth) &&
+                inFunction(a_frames[i + 1], &callBurnSecond))
+            {
+                secondCount += a_count;
+            }
+        }
+    });
+
+    assert(counted == SamplingProfiler::Samples());
+    assert(firstCount > 0);
+    assert(secondCount > 0);
+
+    std::cout << "samples: OK" << std::endl;
+    return 0;
+}
+
+int SamplingProfilerTest::runFolded()
+{
+    std::ostringstream out;
+    SamplingProfiler::WriteFolded(out);
+    std::string folded = out.str();
+    assert(!folded.empty());
+
+    // "frame;frame;frame count" per line, counts adding up to the samples
+    uint64_t total = 0;
+    std::istringstream lines(folded);
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        std::size_t space = line.rfind(' ');
+        assert((space != std::string::npos) && (space > 0));
+        assert(line.find(' ') == space);
+        total += std::stoull(line.substr(space + 1));
+    }
+    assert(total == SamplingProfiler::Samples());
+    (void) total;
+
+    SamplingProfiler::Reset();
+    assert(SamplingProfiler::Samples() == 0);
+    std::ostringstream empty;
+    SamplingProfiler::WriteFolded(empty);
+    assert(empty.str().empty());
+
+    std::cout << "folded: OK" << std::endl;
+    return 0;
+}
+
+int SamplingProfilerTest::runBadFramePointer()
+{
+#if defined(__x86_64__)
+    // the stack of the thread, right below memory which can't be read
+    char* memory = static_cast<char*>(mmap(0, TEST_STACK_SIZE + TEST_GUARD_SIZE,
+        PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    assert(memory != MAP_FAILED);
+    int rv = mprotect(memory + TEST_STACK_SIZE, TEST_GUARD_SIZE, PROT_NONE);
+    assert(rv == 0);
+    (void) rv;
+
+    // above the stack pointer and not too far from it: the unwinder
+    // believes it, but it can't be read
+    void* badFp = memory + TEST_STACK_SIZE + 4096;
+
+    SamplingProfiler::Reset();
+    bool started = SamplingProfiler::Start(TEST_HZ);
+    assert(started);
+    (void) started;
+
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setstack(&attributes, memory, TEST_STACK_SIZE);
+    pthread_t thread;
+    rv = pthread_create(&thread, &attributes, &spinWithBadFramePointer, badFp);
+    assert(rv == 0);
+    pthread_join(thread, 0);
+    pthread_attr_destroy(&attributes);
+
+    SamplingProfiler::Stop();
+    munmap(memory, TEST_STACK_SIZE + TEST_GUARD_SIZE);
+
+    // the thread was sampled (the process is still alive), and its stacks
+    // ended at the interrupted address
+    uint64_t oneFrame = 0;
+    uintptr_t spin = reinterpret_cast<uintptr_t>(&spinWithBadFramePointer);
+    SamplingProfiler::ForEachStack(
+        [&oneFrame, spin](const uintptr_t* a_frames, uint32_t a_depth, uint64_t a_count) {
+        if ((a_frames[0] >= spin) && (a_frames[0] < (spin + TEST_FUNCTION_SIZE)))
+        {
+            assert(a_depth == 1);
+            oneFrame += a_count;
+        }
+    });
+    assert(oneFrame > 0);
+    (void) oneFrame;
+    SamplingProfiler::Reset();
+#endif
+
+    std::cout << "bad frame pointer: OK" << std::endl;
+    return 0;
+}
+
+int SamplingProfilerTest::runOneHz()
+{
+    // the period doesn't fit in tv_usec
+    bool started = SamplingProfiler::Start(1);
+    assert(started);
+    assert(SamplingProfiler::IsRunning());
+    (void) started;
+
+    struct itimerval timer;
+    int rv = getitimer(ITIMER_PROF, &timer);
+    assert(rv == 0);
+    assert(timer.it_interval.tv_sec == 1);
+    assert(timer.it_interval.tv_usec == 0);
+    (void) rv;
+
+    SamplingProfiler::Stop();
+    assert(!SamplingProfiler::IsRunning());
+
+    std::cout << "one sample per second: OK" << std::endl;
+    return 0;
+}
+
+int main()
+{
+    SamplingProfilerTest theTest;
+    int theSamplingProfilerTestResult = 0;
+
+    theSamplingProfilerTestResult |= theTest.runSymbols();
+    theSamplingProfilerTestResult |= theTest.runSamples();
+    theSamplingProfilerTestResult |= theTest.runFolded();
+    theSamplingProfilerTestResult |= theTest.runBadFramePointer();
+    theSamplingProfilerTestResult |= theTest.runOneHz();
+
+    return theSamplingProfilerTestResult;
+}
@@ -1,9 +1,15 @@
 #include <iostream>
 #include <assert.h>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <vector>
 #include "singleton.h"
 
 // compilation: 
-// $ g++ -g -O0 -Wall -std=c++11 -D_REENTRANT singleton_test.cpp -o singleton_test
+// $ g++ -g -O0 -Wall -std=c++11 -D_REENTRANT singleton_test.cpp -o singleton_test -pthread
+
+#define SINGLETON_TEST_THREADS 8
 
 class MySingleton :
     public Singleton<MySingleton>
@@ -20,11 +26,46 @@ private:
     virtual ~MySingleton() {}
 };
 
+// counts how many times it is built. Building it takes a while so threads
+// calling Instance() at the same time race for it
+class SlowSingleton :
+    public Singleton<SlowSingleton>
+{
+public:
+    static std::atomic<int> s_constructions;
+
+private:
+    friend class Singleton<SlowSingleton>;
+
+    SlowSingleton()
+    {
+        s_constructions++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    virtual ~SlowSingleton() {}
+};
+std::atomic<int> SlowSingleton::s_constructions(0);
+
+// built eagerly
+class EagerSingleton :
+    public Singleton<EagerSingleton>
+{
+public:
+    int a;
+
+private:
+    friend class Singleton<EagerSingleton>;
+
+    EagerSingleton(): a(3)
+    {}
+    virtual ~EagerSingleton() {}
+};
+
 class SingletonTest
 {
 public:
-    // TODO check thread safety of initialisation
     int run(); 
+    int runThreads();
     
 private:
 };
@@ -53,16 +94,50 @@ int SingletonTest::run()
     std::cout << "B: " << MySingleton::GetPtr()->b << std::endl;
     
     assert(MySingleton::GetPtr() == &(MySingleton::Instance()));
+
+    EagerSingleton &eager = EagerSingleton::CreateInstance();
+    assert(&eager == &(EagerSingleton::Instance()));
+    assert(&eager == &(EagerSingleton::CreateInstance()));
+    std::cout << "Eager: " << EagerSingleton::Instance().a << std::endl;
     
     return 0;
 }
 
+int SingletonTest::runThreads()
+{
+    std::vector<SlowSingleton*> instances(SINGLETON_TEST_THREADS, 0);
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < SINGLETON_TEST_THREADS; i++)
+    {
+        threads.push_back(std::thread([&instances, i]() {
+            instances[i] = &(SlowSingleton::Instance()); }));
+    }
+    for (int i = 0; i < SINGLETON_TEST_THREADS; i++)
+    {
+        threads[i].join();
+    }
+
+    assert(SlowSingleton::s_constructions.load() == 1);
+    for (int i = 0; i < SINGLETON_TEST_THREADS; i++)
+    {
+        assert(instances[i] == SlowSingleton::GetPtr());
+    }
+
+    std::cout << "Threads: " << SINGLETON_TEST_THREADS
+              << ", constructions: " << SlowSingleton::s_constructions.load()
+              << std::endl;
+
+    return 0;
+}
+
 int main()
 {
     SingletonTest theTest;
     int theSingletonTestResult;
     
     theSingletonTestResult = theTest.run();
+    theSingletonTestResult |= theTest.runThreads();
  
     return theSingletonTestResult;
 }
\ No newline at end of file
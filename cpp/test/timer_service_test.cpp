@@ -0,0 +1,288 @@
+// ============================================================================
+/// @file  timer_service_test.cpp
+/// @brief file to test the timer service class
+/// Compiling procedure:
+///   $ g++ -g -O0 -Wall -std=c++11 -D_REENTRANT -c timer_service_test.cpp
+///   $ g++ timer_service_test.o -o timer_service_test -pthread -std=c++11
+///
+/// Expected output (the thread doing the call is printed in brackets):
+///     0ms: main: Scheduling a periodic timer (10ms) and 2 one-shot timers
+///    10ms: periodic [service]: 1 call(s)
+///    15ms: one-shot [service]: called
+///    20ms: periodic [service]: 2 call(s)
+///   (...)
+///   100ms: periodic [service]: 10 call(s)
+///   105ms: main: cancelling the periodic timer
+///   205ms: main: Testing the consumer thread dispatch mode
+///   215ms: periodic [consumer]: 1 call(s)
+///   (...)
+///   305ms: main: Testing requests from the dispatch thread
+///   330ms: main: Testing slack. 20 timers, periods between 20 and 22ms
+///   530ms: main: slack  0ms: 180 expirations, 180 wake ups (0 saved)
+///   730ms: main: slack  5ms: 180 expirations, 20 wake ups (160 saved)
+///   730ms: main: Done!
+// ============================================================================
+
+// a small dispatch queue, so it fills up
+#define TIMER_SERVICE_DISPATCH_Q_SIZE 4
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional> // std::bind
+#include <assert.h>
+#include <iomanip> // std::setw
+#include <sstream> // std::stringstream
+#include <vector>
+#include "timer_service.h"
+
+#define MILLISECS_TO_NANOSECS(x) ((x) * 1000000ULL)
+
+class TimerServiceTest
+{
+public:
+    TimerServiceTest():
+        m_startTestTime(std::chrono::seconds(0)),
+        m_printMutex(),
+        m_periodicCount(0),
+        m_oneShotCount(0)
+    {}
+
+    virtual ~TimerServiceTest()
+    {}
+
+    void Periodic(const uint64_t& /*a_currentTime*/, const char* a_who)
+    {
+        int count = ++m_periodicCount;
+
+        std::unique_lock<std::mutex> lk(m_printMutex);
+        printElapsed();
+        std::cout << "periodic [" << a_who << "]: " << count << " call(s)" << std::endl;
+    }
+
+    void Nothing(const uint64_t& /*a_currentTime*/)
+    {}
+
+    void OneShot(const uint64_t& /*a_currentTime*/)
+    {
+        m_oneShotCount++;
+        timedPrint("one-shot [service]", "called");
+    }
+
+    int run();
+
+private:
+    TimerService::Statistics_t runSlack(uint64_t a_slack);
+
+    std::chrono::system_clock::time_point m_startTestTime;
+    std::mutex m_printMutex;
+    std::atomic<int> m_periodicCount;
+    std::atomic<int> m_oneShotCount;
+
+    void printElapsed()
+    {
+        auto elapsed = std::chrono::system_clock::now() - m_startTestTime;
+        std::cout << std::setw(5)
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()
+                  << "ms: ";
+    }
+
+    void timedPrint(const char* a_who, const char* a_msg)
+    {
+        std::unique_lock<std::mutex> lk(m_printMutex);
+        printElapsed();
+        std::cout << a_who << ": " << a_msg << std::endl;
+        std::cout.flush();
+    }
+};
+
+int main()
+{
+    TimerServiceTest theTimerServiceTest;
+    int theTimerServiceTestResult;
+
+    theTimerServiceTestResult = theTimerServiceTest.run();
+
+    return theTimerServiceTestResult;
+}
+
+int TimerServiceTest::run()
+{
+    m_startTestTime = std::chrono::system_clock::now();
+
+    TimerService service;
+
+    timedPrint("main", "Scheduling a periodic timer (10ms) and 2 one-shot timers");
+    TimerService::TimerId_t periodicId = service.Schedule(
+        std::bind(&TimerServiceTest::Periodic, this, std::placeholders::_1, "service"),
+        MILLISECS_TO_NANOSECS(10),
+        MILLISECS_TO_NANOSECS(10));
+    service.Schedule(
+        std::bind(&TimerServiceTest::OneShot, this, std::placeholders::_1),
+        MILLISECS_TO_NANOSECS(15));
+    // this one will be cancelled before it expires
+    TimerService::TimerId_t cancelledId = service.Schedule(
+        std::bind(&TimerServiceTest::OneShot, this, std::placeholders::_1),
+        MILLISECS_TO_NANOSECS(50));
+    service.Cancel(cancelledId);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(105));
+
+    timedPrint("main", "cancelling the periodic timer");
+    service.Cancel(periodicId);
+    int periodicCount = m_periodicCount.load();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // 10 expirations are expected. Leave some room for a loaded system
+    assert((periodicCount >= 8) && (periodicCount <= 11));
+    // no expirations after the cancellation
+    assert(m_periodicCount.load() == periodicCount);
+    // only the first one-shot timer expired
+    assert(m_oneShotCount.load() == 1);
+
+    // two timers expiring in the same wake up (thanks to their slack). The
+    // first one cancels the second, which must not be called
+    std::atomic<TimerService::TimerId_t> secondId(0);
+    std::atomic<int> secondCount(0);
+    service.Schedule(
+        [&service, &secondId](const uint64_t&) { service.Cancel(secondId.load()); },
+        MILLISECS_TO_NANOSECS(10), 0, MILLISECS_TO_NANOSECS(5));
+    secondId.store(service.Schedule(
+        [&secondCount](const uint64_t&) { secondCount++; },
+        MILLISECS_TO_NANOSECS(10), 0, MILLISECS_TO_NANOSECS(5)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    assert(secondCount.load() == 0);
+
+    // a callback can make more requests than the command queue can hold:
+    // they are applied straight away
+    std::atomic<int> scheduled(0);
+    service.Schedule(
+        [&service, &scheduled](const uint64_t&) {
+            for (int i = 0; i < TIMER_SERVICE_COMMAND_Q_SIZE; i++)
+            {
+                TimerService::TimerId_t id = service.Schedule(
+                    [](const uint64_t&) {}, MILLISECS_TO_NANOSECS(1000));
+                if (id != TimerService::INVALID_TIMER_ID)
+                {
+                    service.Cancel(id);
+                    scheduled++;
+                }
+            }
+        },
+        MILLISECS_TO_NANOSECS(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    assert(scheduled.load() == TIMER_SERVICE_COMMAND_Q_SIZE);
+
+    // no more than TIMER_SERVICE_MAX_TIMERS timers at the same time
+    std::vector<TimerService::TimerId_t> ids;
+    TimerService::TimerId_t id;
+    while ((id = service.Schedule([](const uint64_t&) {}, MILLISECS_TO_NANOSECS(1000))) !=
+           TimerService::INVALID_TIMER_ID)
+    {
+        ids.push_back(id);
+    }
+    assert(ids.size() == TIMER_SERVICE_MAX_TIMERS);
+    for (std::size_t i = 0; i < ids.size(); i++)
+    {
+        service.Cancel(ids[i]);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    // records of cancelled timers are used again
+    assert(service.Schedule([](const uint64_t&) {}, MILLISECS_TO_NANOSECS(1000)) !=
+           TimerService::INVALID_TIMER_ID);
+
+    service.Join();
+
+    timedPrint("main", "Testing the consumer thread dispatch mode");
+    m_periodicCount.store(0);
+    TimerService consumerService(TimerService::DISPATCH_CONSUMER_THREAD);
+    consumerService.Schedule(
+        std::bind(&TimerServiceTest::Periodic, this, std::placeholders::_1, "consumer"),
+        MILLISECS_TO_NANOSECS(10),
+        MILLISECS_TO_NANOSECS(10));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    consumerService.Join();
+
+    periodicCount = m_periodicCount.load();
+    assert((periodicCount >= 8) && (periodicCount <= 11));
+    (void) periodicCount;
+
+    // a callback on the dispatch thread fills up the command queue while
+    // the service thread waits for room in the (full) dispatch queue
+    timedPrint("main", "Testing requests from the dispatch thread");
+    TimerService busyService(TimerService::DISPATCH_CONSUMER_THREAD);
+    std::atomic<bool> requested(false);
+    for (int i = 0; i < 5; i++)
+    {
+        busyService.Schedule(
+            std::bind(&TimerServiceTest::Nothing, this, std::placeholders::_1),
+            MILLISECS_TO_NANOSECS(1), MILLISECS_TO_NANOSECS(1));
+    }
+    busyService.Schedule(
+        [&busyService, &requested](const uint64_t&) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            for (int i = 0; i < TIMER_SERVICE_COMMAND_Q_SIZE; i++)
+            {
+                TimerService::TimerId_t id = busyService.Schedule(
+                    [](const uint64_t&) {}, MILLISECS_TO_NANOSECS(1000));
+                if (id != TimerService::INVALID_TIMER_ID)
+                {
+                    busyService.Cancel(id);
+                }
+            }
+            requested.store(true);
+        },
+        MILLISECS_TO_NANOSECS(1));
+    for (int i = 0; (i < 5000) && !requested.load(); i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    assert(requested.load());
+    busyService.Join();
+
+    timedPrint("main", "Testing slack. 20 timers, periods between 20 and 22ms");
+    TimerService::Statistics_t noSlack   = runSlack(0);
+    TimerService::Statistics_t withSlack = runSlack(MILLISECS_TO_NANOSECS(5));
+
+    // overlapping timers must have been processed together. Without slack
+    // late wake ups may still process several timers, but nothing is saved
+    assert(noSlack.savedWakeUps == 0);
+    assert(withSlack.savedWakeUps > noSlack.savedWakeUps);
+    assert(withSlack.expiryWakeUps < (withSlack.expirations / 2));
+
+    timedPrint("main", "Done!");
+
+    return 0;
+}
+
+TimerService::Statistics_t TimerServiceTest::runSlack(uint64_t a_slack)
+{
+    TimerService service;
+    for (int i = 0; i < 20; i++)
+    {
+        // periods 100us apart, so without slack each timer would
+        // expire on its own
+        uint64_t period = MILLISECS_TO_NANOSECS(20) + (i * 100000);
+        service.Schedule(
+            std::bind(&TimerServiceTest::Nothing, this, std::placeholders::_1),
+            period, period, a_slack);
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    service.Join();
+
+    TimerService::Statistics_t statistics = service.GetStatistics();
+
+    std::stringstream strStream;
+    strStream << "slack " << std::setw(2) << (a_slack / 1000000) << "ms: "
+              << statistics.expirations << " expirations, "
+              << statistics.expiryWakeUps << " wake ups ("
+              << statistics.savedWakeUps << " saved)";
+    timedPrint("main", strStream.str().c_str());
+
+    return statistics;
+}
@@ -0,0 +1,247 @@
+// ============================================================================
+/// @file  tracer_test.cpp
+/// @brief Testing the trace events of tracer.h and the ones ConsumerThread
+///        records
+/// Buffers are made small (TRACER_BUFFER_SIZE) so they can be filled up
+/// Compiling procedure:
+///   $ g++ -g -O0 -Wall -std=c++11 -D_REENTRANT -c tracer_test.cpp
+///   $ g++ tracer_test.o -o tracer_test -pthread -std=c++11
+///
+/// Expected output:
+/// disabled: OK
+/// events: OK
+/// dropped: OK
+/// consumer thread: OK
+/// thread exit: OK
+// ============================================================================
+
+#define TRACER_BUFFER_SIZE 1024
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <assert.h>
+#include "tracer.h"
+#include "consumer_thread.h"
+
+#define TEST_CONSUMED 5
+
+/// @return how many times a_pattern is in a_text
+static int countOf(const std::string &a_text, const std::string &a_pattern)
+{
+    int count = 0;
+    for (std::size_t pos = a_text.find(a_pattern); pos != std::string::npos;
+         pos = a_text.find(a_pattern, pos + 1))
+    {
+        count++;
+    }
+    return count;
+}
+
+/// @brief records an event from its destructor, once the buffer of its
+/// thread has been given back and another thread has taken it over
+struct LateRecorder
+{
+    ~LateRecorder()
+    {
+        std::atomic<bool> taken(false);
+        std::atomic<bool> recorded(false);
+        std::thread other([&taken, &recorded]() {
+            TRACE_INSTANT("taken over");
+            taken.store(true);
+            while (!recorded.load())
+            {
+                std::this_thread::yield();
+            }
+            TRACE_INSTANT("still taken over");
+        });
+        while (!taken.load())
+        {
+            std::this_thread::yield();
+        }
+        TRACE_INSTANT("late");
+        recorded.store(true);
+        other.join();
+    }
+};
+
+class TracerTest
+{
+public:
+    int runDisabled();
+    int runEvents();
+    int runDropped();
+    int runConsumerThread();
+    int runThreadExit();
+};
+
+int TracerTest::runDisabled()
+{
+    assert(!Tracer::IsEnabled());
+
+    // nothing is recorded, and arguments aren't even evaluated
+    int evaluated = 0;
+    {
+        TRACE_SCOPE("scope");
+        TRACE_COUNTER("counter", 0, ++evaluated);
+        TRACE_FLOW_BEGIN("flow", ++evaluated);
+    }
+    assert(evaluated == 0);
+    (void) evaluated;
+
+    std::ostringstream out;
+    uint64_t written = Tracer::Write(out);
+    assert(written == 0);
+    assert(out.str() == "{\"traceEvents\":[\n],\"displayTimeUnit\":\"ns\"}\n");
+    (void) written;
+
+    std::cout << "disabled: OK" << std::endl;
+    return 0;
+}
+
+int TracerTest::runEvents()
+{
+    Tracer::Enable();
+    assert(Tracer::IsEnabled());
+
+    // the producer thread begins a flow the main thread ends
+    std::thread producer([]() {
+        TRACE_THREAD_NAME("producer \"one\"");
+        TRACE_SCOPE("produce");
+        TRACE_FLOW_BEGIN("element", 42);
+    });
+    producer.join();
+    {
+        TRACE_SCOPE("consume");
+        TRACE_FLOW_END("element", 42);
+        TRACE_COUNTER("depth", 7, -3);
+        TRACE_INSTANT("done");
+    }
+
+    std::ostringstream out;
+    // the name of the producer is an event too
+    uint64_t written = Tracer::Write(out);
+    assert(written == 9);
+    (void) written;
+
+    std::string trace = out.str();
+    assert(trace.find("{\"traceEvents\":[\n{") == 0);
+    assert(countOf(trace, "\"ph\":\"B\"") == 2);
+    assert(countOf(trace, "\"ph\":\"E\"") == 2);
+    assert(trace.find("{\"name\":\"produce\",\"ph\":\"B\",\"ts\":") != std::string::npos);
+    assert(trace.find("\"ph\":\"s\"") != std::string::npos);
+    assert(trace.find("\"cat\":\"flow\",\"id\":\"0x2a\",\"bp\":\"e\"}") != std::string::npos);
+    assert(trace.find("\"id\":\"0x7\",\"args\":{\"value\":-3}}") != std::string::npos);
+    assert(trace.find("{\"name\":\"done\",\"ph\":\"i\"") != std::string::npos);
+    assert(trace.find("\"args\":{\"name\":\"producer \\\"one\\\"\"}}") != std::string::npos);
+    assert(trace.find("\n],\"displayTimeUnit\":\"ns\"}\n") != std::string::npos);
+
+    // on the same thread begin comes before end
+    assert(trace.find("\"name\":\"consume\",\"ph\":\"B\"") <
+           trace.find("\"name\":\"consume\",\"ph\":\"E\""));
+
+    // everything was taken out of the buffers
+    std::ostringstream again;
+    assert(Tracer::Write(again) == 0);
+
+    std::cout << "events: OK" << std::endl;
+    return 0;
+}
+
+int TracerTest::runDropped()
+{
+    uint64_t dropped = Tracer::Dropped();
+    for (int i = 0; i < (2 * TRACER_BUFFER_SIZE); i++)
+    {
+        TRACE_INSTANT("instant");
+    }
+
+    // the buffer holds TRACER_BUFFER_SIZE - 1 events
+    std::ostringstream out;
+    uint64_t written = Tracer::Write(out);
+    assert(written == (TRACER_BUFFER_SIZE - 1));
+    assert(Tracer::Dropped() == (dropped + TRACER_BUFFER_SIZE + 1));
+    (void) written;
+    (void) dropped;
+
+    std::cout << "dropped: OK" << std::endl;
+    return 0;
+}
+
+int TracerTest::runConsumerThread()
+{
+    std::atomic<int> consumed(0);
+    ConsumerThread<int> consumer([&consumed](int a_value) {
+        TRACE_FLOW_END("element", a_value);
+        consumed++;
+    });
+
+    for (int i = 1; i <= TEST_CONSUMED; i++)
+    {
+        TRACE_SCOPE("produce");
+        TRACE_FLOW_BEGIN("element", i);
+        consumer.ProduceOrBlock(i);
+    }
+    for (int i = 0; (i < 5000) && (consumed.load() < TEST_CONSUMED); i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    assert(consumed.load() == TEST_CONSUMED);
+    consumer.Join();
+    Tracer::Disable();
+
+    std::ostringstream out;
+    Tracer::Write(out);
+    std::string trace = out.str();
+    assert(countOf(trace, "{\"name\":\"consume\",\"ph\":\"B\"") == TEST_CONSUMED);
+    assert(countOf(trace, "{\"name\":\"consume\",\"ph\":\"E\"") == TEST_CONSUMED);
+    assert(countOf(trace, "{\"name\":\"consumer queue\",\"ph\":\"C\"") == TEST_CONSUMED);
+    assert(countOf(trace, "\"ph\":\"f\"") == TEST_CONSUMED);
+    assert(trace.find("\"args\":{\"name\":\"ConsumerThread\"}}") != std::string::npos);
+
+    std::cout << "consumer thread: OK" << std::endl;
+    return 0;
+}
+
+int TracerTest::runThreadExit()
+{
+    Tracer::Enable();
+
+    std::thread exiting([]() {
+        // built before the first event, so destroyed after the buffer is
+        // given back
+        static thread_local LateRecorder t_lateRecorder;
+        (void) t_lateRecorder;
+        TRACE_INSTANT("early");
+    });
+    exiting.join();
+    Tracer::Disable();
+
+    std::ostringstream out;
+    Tracer::Write(out);
+    std::string trace = out.str();
+    assert(countOf(trace, "{\"name\":\"early\"") == 1);
+    assert(countOf(trace, "{\"name\":\"late\"") == 0);
+    assert(countOf(trace, "{\"name\":\"taken over\"") == 1);
+    assert(countOf(trace, "{\"name\":\"still taken over\"") == 1);
+
+    std::cout << "thread exit: OK" << std::endl;
+    return 0;
+}
+
+int main()
+{
+    TracerTest theTest;
+    int theTracerTestResult = 0;
+
+    theTracerTestResult |= theTest.runDisabled();
+    theTracerTestResult |= theTest.runEvents();
+    theTracerTestResult |= theTest.runDropped();
+    theTracerTestResult |= theTest.runConsumerThread();
+    theTracerTestResult |= theTest.runThreadExit();
+
+    return theTracerTestResult;
+}
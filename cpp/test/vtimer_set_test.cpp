@@ -0,0 +1,171 @@
+// ============================================================================
+/// @file  vtimer_set_test.cpp
+/// @brief Testing the set of virtual timers
+/// The set is driven with the same sequence of times as a vector of VTimer
+/// objects. Both must call the same callbacks at the same times, no matter
+/// the scan implementation used by the set
+/// Compiling procedure:
+///   $ g++ -g -O0 -Wall -std=c++11 -D_REENTRANT -c vtimer_set_test.cpp
+///   $ g++ vtimer_set_test.o -o vtimer_set_test
+///
+/// Expected output:
+/// scalar: 1000 timers, 5000 updates, 1034498 expirations
+/// sse4.2: 1000 timers, 5000 updates, 1034498 expirations
+/// avx2: 1000 timers, 5000 updates, 1034498 expirations
+/// (a scan not supported by the CPU is reported and skipped)
+// ============================================================================
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <functional> // std::bind
+#include <stdlib.h>   // rand
+#include <assert.h>
+#include "vtimer.h"
+#include "vtimer_set.h"
+
+#define TEST_TIMER_COUNT  1000
+#define TEST_UPDATE_COUNT 5000
+#define TEST_MAX_PERIOD   50
+
+class VTimerSetTest
+{
+public:
+    VTimerSetTest():
+        m_vtimerCalls(TEST_TIMER_COUNT, 0),
+        m_vtimerSetCalls(TEST_TIMER_COUNT, 0),
+        m_lastVTimerCall(TEST_TIMER_COUNT, 0),
+        m_lastVTimerSetCall(TEST_TIMER_COUNT, 0)
+    {}
+
+    ~VTimerSetTest()
+    {}
+
+    void VTimerCallback(const uint64_t &a_currentTime, int a_index)
+    {
+        m_vtimerCalls[a_index]++;
+        m_lastVTimerCall[a_index] = a_currentTime;
+    }
+
+    void VTimerSetCallback(const uint64_t &a_currentTime, int a_index)
+    {
+        m_vtimerSetCalls[a_index]++;
+        m_lastVTimerSetCall[a_index] = a_currentTime;
+    }
+
+    int run(VTimerSet::ScanType_t a_scanType, const char* a_scanName);
+
+private:
+    std::vector<int> m_vtimerCalls;
+    std::vector<int> m_vtimerSetCalls;
+    std::vector<uint64_t> m_lastVTimerCall;
+    std::vector<uint64_t> m_lastVTimerSetCall;
+};
+
+int VTimerSetTest::run(VTimerSet::ScanType_t a_scanType, const char* a_scanName)
+{
+    VTimerSet timerSet;
+    if (!timerSet.SetScanType(a_scanType))
+    {
+        std::cout << a_scanName << ": not supported by this CPU" << std::endl;
+        return 0;
+    }
+
+    std::vector< std::unique_ptr< VTimer<uint64_t> > > timers;
+
+    srand(1);
+    for (int i = 0; i < TEST_TIMER_COUNT; i++)
+    {
+        // period 0 included (called on every update)
+        uint64_t period = rand() % TEST_MAX_PERIOD;
+
+        timers.push_back(std::unique_ptr< VTimer<uint64_t> >(new VTimer<uint64_t>(
+            std::bind(&VTimerSetTest::VTimerCallback, this, std::placeholders::_1, i),
+            period)));
+        VTimerSet::TimerHandle_t handle = timerSet.Add(
+            std::bind(&VTimerSetTest::VTimerSetCallback, this, std::placeholders::_1, i),
+            period);
+        assert(handle == static_cast<VTimerSet::TimerHandle_t>(i));
+        (void) handle;
+    }
+    assert(timerSet.Size() == TEST_TIMER_COUNT);
+
+    // time starts at 0 and mostly goes forward. It sometimes stays put or
+    // goes backwards
+    uint64_t currentTime = 0;
+    for (int i = 0; i < TEST_UPDATE_COUNT; i++)
+    {
+        for (std::size_t j = 0; j < timers.size(); j++)
+        {
+            timers[j]->Update(currentTime);
+        }
+        timerSet.Update(currentTime);
+
+        int step = (rand() % 10) - 1;
+        if ((step >= 0) || (currentTime > 0))
+        {
+            currentTime += step;
+        }
+    }
+
+    int expirations = 0;
+    for (int i = 0; i < TEST_TIMER_COUNT; i++)
+    {
+        assert(m_vtimerCalls[i] == m_vtimerSetCalls[i]);
+        assert(m_lastVTimerCall[i] == m_lastVTimerSetCall[i]);
+        expirations += m_vtimerSetCalls[i];
+
+        m_vtimerCalls[i] = m_vtimerSetCalls[i] = 0;
+    }
+
+    // removed timers are not called anymore
+    timerSet.Remove(0);
+    timerSet.Update(currentTime + TEST_MAX_PERIOD);
+    assert(m_vtimerSetCalls[0] == 0);
+    assert(timerSet.Size() == (TEST_TIMER_COUNT - 1));
+
+    // removing twice (also from inside a callback) frees the handle once
+    timerSet.Remove(0);
+    assert(timerSet.Size() == (TEST_TIMER_COUNT - 1));
+    VTimerSet::TimerHandle_t selfRemoved = 0;
+    selfRemoved = timerSet.Add([&timerSet, &selfRemoved](uint64_t) {
+        timerSet.Remove(selfRemoved);
+        timerSet.Remove(selfRemoved);
+    }, 0);
+    timerSet.Update(currentTime + TEST_MAX_PERIOD);
+    timerSet.Update(currentTime + TEST_MAX_PERIOD);
+    assert(timerSet.Size() == (TEST_TIMER_COUNT - 1));
+    VTimerSet::TimerHandle_t first = timerSet.Add(VTimerSet::VTimerCallback_t([](uint64_t) {}), 0);
+    VTimerSet::TimerHandle_t second = timerSet.Add(VTimerSet::VTimerCallback_t([](uint64_t) {}), 0);
+    assert(first != second);
+    (void) first;
+    (void) second;
+    timerSet.Remove(first);
+    timerSet.Remove(second);
+
+    std::cout << a_scanName << ": " << TEST_TIMER_COUNT << " timers, "
+              << TEST_UPDATE_COUNT << " updates, "
+              << expirations << " expirations" << std::endl;
+
+    return 0;
+}
+
+int main()
+{
+    int theVTimerSetTestResult = 0;
+
+    {
+        VTimerSetTest theTest;
+        theVTimerSetTestResult |= theTest.run(VTimerSet::SCAN_SCALAR, "scalar");
+    }
+    {
+        VTimerSetTest theTest;
+        theVTimerSetTestResult |= theTest.run(VTimerSet::SCAN_SSE42, "sse4.2");
+    }
+    {
+        VTimerSetTest theTest;
+        theVTimerSetTestResult |= theTest.run(VTimerSet::SCAN_AVX2, "avx2");
+    }
+
+    return theVTimerSetTestResult;
+}
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <assert.h>
 #include "vtimer.h"
 
 // compilation: 
@@ -89,6 +90,23 @@ int VTimerTest::run()
     // call!
     virtual_timer2.Update(2); 
     
+    // a timer with some slack. It is still called when its expiration time
+    // is hit, but the driver could wait until the latest expiry time
+    VTimer<uint32_t> virtual_timer3(
+        std::bind(&GlobalCallback, std::placeholders::_1), 
+        10,  // period
+        5);  // slack
+    // not initialised yet
+    assert(virtual_timer3.GetLatestExpiryTime() == 0);
+    // init at 1. Callback should get called on 11 or bigger, 16 at the latest
+    virtual_timer3.Update(1);
+    assert(virtual_timer3.GetNextExpiryTime() == 11);
+    assert(virtual_timer3.GetLatestExpiryTime() == 16);
+    // call! Next expiration window is [24, 29]
+    virtual_timer3.Update(14);
+    assert(virtual_timer3.GetNextExpiryTime() == 24);
+    assert(virtual_timer3.GetLatestExpiryTime() == 29);
+    
     return 0;
 }
 
@@ -0,0 +1,379 @@
+// ============================================================================
+// Copyright (c) 2026 Faustino Frechilla
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+/// @file  timer_service.h
+/// @brief This file contains a timer service which owns its own thread
+///
+/// Unlike VTimer, which relies on someone else calling Update, the timer
+/// service runs a thread that sleeps on a timerfd until the next deadline is
+/// hit. Timers are kept in a container ordered by deadline so the service
+/// only wakes up when there is something to be done.
+///
+/// Timers can be scheduled and cancelled from any thread. Those requests are
+/// pushed into a lock-free queue (multiple producers) which is drained by the
+/// service thread, so no lock is ever taken by the calling thread. It doesn't
+/// allocate memory either: timers are taken from a pool of
+/// TIMER_SERVICE_MAX_TIMERS records built with the service, and callbacks are
+/// stored inside the record (InplaceDelegate). Requests made by callbacks
+/// running on the service thread are applied straight away.
+///
+/// Callbacks are either called from the context of the service thread or
+/// handed over to a ConsumerThread owned by the service.
+///
+/// Timers can be scheduled with some slack, which is how late they are
+/// allowed to expire. The service sleeps until the earliest deadline plus
+/// slack of all its timers, and when it wakes up it processes every timer
+/// whose deadline has passed. That way timers whose windows
+/// [deadline, deadline + slack] overlap are processed in a single wake up.
+/// GetStatistics reports how many wake ups the slack saved.
+///
+/// The clock is a template parameter (see clock.h). TimerService uses
+/// RealClock (CLOCK_MONOTONIC). BasicTimerService<VirtualClock> doesn't touch
+/// the timerfd at all: timers expire when the virtual time is moved forward,
+/// and VirtualClock::AdvanceTo only returns once every timer due has been
+/// processed, so replays and benchmarks are deterministic (as long as
+/// callbacks are dispatched inline). Example of usage:
+///
+/// void MyCallback(const uint64_t &a_currentTime);
+/// /* ... */
+///
+/// TimerService service;
+/// // first call in 15ms, then every 10ms
+/// TimerService::TimerId_t id = service.Schedule(
+///     std::bind(&MyCallback, std::placeholders::_1), 15000000, 10000000);
+/// // every second, but it can be up to 100ms late
+/// service.Schedule(
+///     std::bind(&MyCallback, std::placeholders::_1),
+///     1000000000, 1000000000, 100000000);
+/// /* ... */
+/// service.Cancel(id);
+///
+/// Your compiler must have support for c++11 and the target must be Linux
+/// (timerfd and eventfd are needed)
+///
+/// @author Faustino Frechilla
+/// @history
+/// Ref        Who                When        What
+///            Faustino Frechilla 17-Oct-2026 Original development
+///            Faustino Frechilla 17-Oct-2026 Slack to coalesce expirations
+///            Faustino Frechilla 17-Oct-2026 Saved wake ups counted per distinct deadline
+///            Faustino Frechilla 17-Oct-2026 Pluggable clock (virtual time)
+///            Faustino Frechilla 17-Oct-2026 Pool of records, inline callbacks
+/// @endhistory
+///
+// ============================================================================
+
+#ifndef _TIMERSERVICE_H_
+#define _TIMERSERVICE_H_
+
+#include <stdint.h>      // types (uint64_t...)
+#include <functional>    // std::bind
+#include <memory>        // std::unique_ptr
+#include <thread>
+#include <atomic>
+#include <map>
+#include <unordered_map>
+#include "lock_free_queue.h"
+#include "consumer_thread.h"
+#include "clock.h"
+#include "delegate/InplaceDelegate.h"
+
+// maximum number of schedule/cancel requests that can be pending to be
+// processed by the service thread. Producers will retry when it is full
+#define TIMER_SERVICE_COMMAND_Q_SIZE 4096 // (2^12)
+
+// maximum number of timers a service can have at the same time. Records are
+// allocated when the service is built. Power of 2
+#ifndef TIMER_SERVICE_MAX_TIMERS
+#define TIMER_SERVICE_MAX_TIMERS 4096 // (2^12)
+#endif
+
+// expirations that can be waiting for the dispatch thread
+// (DISPATCH_CONSUMER_THREAD). Unbounded by default
+#ifndef TIMER_SERVICE_DISPATCH_Q_SIZE
+#define TIMER_SERVICE_DISPATCH_Q_SIZE SAFE_QUEUE_DEFAULT_MAX_SIZE
+#endif
+
+// bytes a callback can take (captures, bound arguments...). Big enough for
+// a std::bind of a method, its object and two more arguments
+#ifndef TIMER_SERVICE_CALLBACK_STORAGE
+#define TIMER_SERVICE_CALLBACK_STORAGE 48
+#endif
+
+/// @brief a timer service
+/// Manages many timers from a single thread. Deadlines and periods are
+/// expressed in nanoseconds, and times passed to callbacks are nanoseconds
+/// read from CLOCK_T (see clock.h)
+template <typename CLOCK_T>
+class BasicTimerService : public VirtualClockListener
+{
+public:
+    typedef uint64_t TimerId_t;
+    typedef InplaceDelegate<void(const uint64_t&), TIMER_SERVICE_CALLBACK_STORAGE> TimerCallback_t;
+
+    /// @brief the context where callbacks will be run
+    enum DispatchMode_t
+    {
+        /// callbacks are run by the service thread. They should be short
+        /// since they delay any other expiration
+        DISPATCH_INLINE,
+        /// callbacks are handed over to a ConsumerThread owned by the service.
+        /// While its queue is full the service thread waits, processing
+        /// schedule/cancel requests meanwhile, so callbacks can make them
+        DISPATCH_CONSUMER_THREAD
+    };
+
+    /// @brief counters of the work done by the service thread
+    struct Statistics_t
+    {
+        /// number of callbacks called (or handed over to the consumer thread)
+        uint64_t expirations;
+        /// number of times the service thread processed expirations. Each one
+        /// of them was a wake up of the service thread
+        uint64_t expiryWakeUps;
+        /// wake ups saved thanks to slack: expirations processed in the
+        /// same wake up as an earlier deadline, which only waited for them
+        /// because of the slack (their deadline is later than that earlier
+        /// one but not later than the time the service slept until).
+        /// Timers sharing a deadline are counted once, since they would have
+        /// been processed together without slack too
+        uint64_t savedWakeUps;
+    };
+
+    /// id that will never be returned by Schedule
+    static const TimerId_t INVALID_TIMER_ID = 0;
+
+    /// @brief constructor of the timer service. It spawns the service thread
+    /// @param a_dispatchMode where the callbacks will be run
+    /// @param a_cpu CPU the service thread will be bound to. -1 (the default)
+    ///        leaves it unbound. Use one service per CPU to build a per-core
+    ///        set of timer services
+    BasicTimerService(DispatchMode_t a_dispatchMode = DISPATCH_INLINE, int a_cpu = -1);
+
+    /// @brief destructor. It joins the service thread if still running
+    virtual ~BasicTimerService();
+
+    /// @brief schedules a new timer. It can be called from any thread
+    /// @param a_callback function to be called on expiration. It receives the
+    ///        time when the expiration is processed. It is destroyed once the
+    ///        timer expires (one-shot) or is cancelled
+    /// @param a_delay nanoseconds from now until the first expiration
+    /// @param a_period nanoseconds between expirations after the first one.
+    ///        0 (the default) creates a one-shot timer
+    /// @param a_slack nanoseconds each expiration is allowed to be late so it
+    ///        can be processed together with other timers. 0 by default
+    /// @return the id of the new timer, to be used to cancel it.
+    ///         INVALID_TIMER_ID if the service has TIMER_SERVICE_MAX_TIMERS
+    ///         timers already
+    TimerId_t Schedule(
+        TimerCallback_t a_callback,
+        uint64_t a_delay,
+        uint64_t a_period = 0,
+        uint64_t a_slack = 0);
+
+    /// @brief cancels a timer. It can be called from any thread
+    /// The cancellation is processed asynchronously by the service thread, but
+    /// always before any callback the service thread calls after this call
+    /// returns (it looks for commands before every expiration). A callback
+    /// which is running already finishes.
+    /// Note that with DISPATCH_CONSUMER_THREAD an expiration might have been
+    /// already handed over to the consumer thread
+    /// @param a_id the id returned by Schedule
+    void Cancel(TimerId_t a_id);
+
+    /// @brief counters of the service. It can be called from any thread
+    /// @return a snapshot of the counters
+    Statistics_t GetStatistics() const;
+
+    /// @brief Tell the service thread to finish and wait until it does so
+    /// Timers that haven't expired yet are discarded
+    void Join();
+
+    /// @brief current time as used by the service (CLOCK_T::Now())
+    /// @return nanoseconds
+    static inline uint64_t Now();
+
+private:
+    /// @brief everything the service knows about a timer
+    struct TimerRecord
+    {
+        TimerId_t id;
+        TimerCallback_t callback;
+        uint64_t deadline;
+        uint64_t period;
+        uint64_t slack;
+        /// position in the ordered container of deadlines
+        typename std::multimap<uint64_t, TimerRecord*>::iterator position;
+        /// position in the ordered container of deadlines plus slack
+        typename std::multimap<uint64_t, TimerRecord*>::iterator latestPosition;
+        /// the service thread holds one while the timer is active, plus one
+        /// per expiration being dispatched. The record goes back to the pool
+        /// when the last one is released
+        std::atomic<uint32_t> references;
+    };
+
+    /// @brief an expiration being dispatched
+    struct TimerExpiry
+    {
+        TimerRecord* record;
+        uint64_t time;
+    };
+
+    /// @brief a request sent to the service thread through the lock-free queue
+    struct TimerCommand
+    {
+        enum {CMD_SCHEDULE, CMD_CANCEL} type;
+        TimerId_t id;
+        TimerRecord* record;
+    };
+
+    typedef ArrayLockFreeQueue<
+        TimerCommand,
+        TIMER_SERVICE_COMMAND_Q_SIZE,
+        ArrayLockFreeQueueMultipleProducers> CommandQueue_t;
+
+    /// records not in use. The service and dispatch threads push (give them
+    /// back) and the threads calling Schedule pop. It holds Q_SIZE - 1
+    typedef ArrayLockFreeQueue<
+        TimerRecord*,
+        TIMER_SERVICE_MAX_TIMERS * 2,
+        ArrayLockFreeQueueMultipleProducers> RecordPool_t;
+
+    /// the service thread
+    std::unique_ptr<std::thread> m_serviceThread;
+
+    /// thread callbacks are handed over to (DISPATCH_CONSUMER_THREAD only)
+    std::unique_ptr< ConsumerThread<TimerExpiry> > m_dispatchThread;
+
+    /// flag to control if the execution of the thread must terminate
+    std::atomic<bool> m_terminate;
+
+    /// the CPU the service thread is bound to (-1 if unbound)
+    int m_cpu;
+
+    /// id of the latest timer scheduled
+    std::atomic<TimerId_t> m_lastTimerId;
+
+    /// number of callbacks called
+    std::atomic<uint64_t> m_expirations;
+
+    /// number of times expirations were processed
+    std::atomic<uint64_t> m_expiryWakeUps;
+
+    /// see Statistics_t::savedWakeUps
+    std::atomic<uint64_t> m_savedWakeUps;
+
+    /// earliest deadline plus slack the service thread slept until. 0 if it
+    /// didn't sleep. Only the service thread uses it
+    uint64_t m_wokenUpFor;
+
+    /// deadline the service thread is sleeping until. 0 while it is awake
+    /// Producers only need to wake up the thread if their timer expires
+    /// earlier than this
+    std::atomic<uint64_t> m_sleepingUntil;
+
+    /// number of times the virtual time moved forward (virtual clocks only)
+    std::atomic<uint64_t> m_clockGeneration;
+
+    /// latest m_clockGeneration the service thread is done with
+    std::atomic<uint64_t> m_processedGeneration;
+
+    /// schedule/cancel requests pending to be processed
+    CommandQueue_t m_commandQueue;
+
+    /// every record of the service (TIMER_SERVICE_MAX_TIMERS)
+    std::unique_ptr<TimerRecord[]> m_recordStorage;
+
+    /// records ready to be used by Schedule
+    RecordPool_t m_freeRecords;
+
+    /// file descriptor of the timerfd the service thread sleeps on
+    int m_timerFd;
+
+    /// file descriptor of the eventfd used to wake up the service thread
+    int m_wakeUpFd;
+
+    /// timers ordered by deadline. Only accessed by the service thread
+    std::multimap<uint64_t, TimerRecord*> m_deadlines;
+
+    /// timers ordered by deadline plus slack, which is what the service
+    /// thread sleeps on. Only accessed by the service thread
+    std::multimap<uint64_t, TimerRecord*> m_latestDeadlines;
+
+    /// timers indexed by id. Only accessed by the service thread
+    std::unordered_map<TimerId_t, TimerRecord*> m_records;
+
+    /// @brief the routine that will be run by the service thread
+    void ThreadRoutine();
+
+    /// @brief pushes a command into the command queue. Retries until success
+    /// Called from the service thread (by a callback) it applies the command
+    /// instead, since nobody else would drain a full queue. The dispatch
+    /// thread can retry: the service thread drains the queue even while it
+    /// waits for room in the queue of the dispatch thread
+    /// @return true if the command was queued, false if it was applied
+    bool PushCommand(const TimerCommand &a_command);
+
+    /// @brief processes every pending command in the command queue
+    /// @return the number of commands processed
+    uint32_t ProcessCommands();
+
+    /// @brief applies a schedule/cancel request (service thread only)
+    inline void ApplyCommand(const TimerCommand &a_command);
+
+    /// @brief releases a reference to a_record. The last one gives it back
+    ///        to the pool. Called by the service and dispatch threads
+    inline void ReleaseRecord(TimerRecord* a_record);
+
+    /// @brief runs the callbacks of every timer whose deadline is <= a_now
+    void ProcessExpirations(uint64_t a_now);
+
+    /// @brief inserts a_record into m_deadlines and m_latestDeadlines
+    inline void InsertDeadline(TimerRecord* a_record);
+
+    /// @brief removes a_record from m_deadlines and m_latestDeadlines
+    inline void RemoveDeadline(TimerRecord* a_record);
+
+    /// @brief sets the timerfd to expire at a_deadline (0 disarms it)
+    void ArmTimerFd(uint64_t a_deadline);
+
+    /// @brief wakes up the service thread
+    void WakeUp();
+
+    /// @brief called by the dispatch thread per expiration
+    void Dispatch(TimerExpiry a_expiry);
+
+    /// @brief called by VirtualClock::AdvanceTo (virtual clocks only)
+    /// Wakes up the service thread and waits until it has processed every
+    /// timer due by a_now
+    virtual void OnVirtualTimeAdvanced(uint64_t a_now);
+
+    // prevent copying of the service
+    BasicTimerService(const BasicTimerService &a_src);
+    BasicTimerService& operator=(const BasicTimerService &a_src);
+};
+
+/// the timer service driven by CLOCK_MONOTONIC
+typedef BasicTimerService<RealClock> TimerService;
+
+#include "timer_service_impl.h"
+
+#endif /* _TIMERSERVICE_H_ */
@@ -0,0 +1,566 @@
+// ============================================================================
+// Copyright (c) 2026 Faustino Frechilla
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+/// @file  timer_service_impl.h
+/// @brief This file contains the timer service implementation.
+///
+/// @author Faustino Frechilla
+/// @history
+/// Ref        Who                When        What
+///            Faustino Frechilla 17-Oct-2026 Original development
+///            Faustino Frechilla 17-Oct-2026 Slack to coalesce expirations
+///            Faustino Frechilla 17-Oct-2026 Saved wake ups counted per distinct deadline
+///            Faustino Frechilla 17-Oct-2026 Pluggable clock (virtual time)
+///            Faustino Frechilla 17-Oct-2026 Fences around the wake up handshake
+///            Faustino Frechilla 17-Oct-2026 Pool of records, inline callbacks
+///            Faustino Frechilla 17-Oct-2026 Commands processed while the dispatch queue is full
+/// @endhistory
+///
+// ============================================================================
+
+#ifndef _TIMERSERVICEIMPL_H_
+#define _TIMERSERVICEIMPL_H_
+
+#include <assert.h>
+#include <poll.h>          // poll
+#include <unistd.h>        // read, write, close
+#include <pthread.h>       // pthread_setaffinity_np
+#include <sched.h>         // cpu_set_t
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <limits>          // std::numeric_limits<>::max
+
+// deadline used when there are no timers to wait for
+#define TIMER_SERVICE_NO_DEADLINE std::numeric_limits<uint64_t>::max()
+
+template <typename CLOCK_T>
+inline BasicTimerService<CLOCK_T>::BasicTimerService(DispatchMode_t a_dispatchMode, int a_cpu):
+    m_serviceThread(),
+    m_dispatchThread(),
+    m_terminate(false),
+    m_cpu(a_cpu),
+    m_lastTimerId(0),
+    m_expirations(0),
+    m_expiryWakeUps(0),
+    m_savedWakeUps(0),
+    m_wokenUpFor(0),
+    m_sleepingUntil(0),
+    m_clockGeneration(0),
+    m_processedGeneration(0),
+    m_commandQueue(),
+    m_recordStorage(new TimerRecord[TIMER_SERVICE_MAX_TIMERS]),
+    m_freeRecords(),
+    m_timerFd(-1),
+    m_wakeUpFd(-1),
+    m_deadlines(),
+    m_latestDeadlines(),
+    m_records()
+{
+    for (uint32_t i = 0; i < TIMER_SERVICE_MAX_TIMERS; i++)
+    {
+        m_recordStorage[i].references.store(0, std::memory_order_relaxed);
+        m_freeRecords.push(&m_recordStorage[i]);
+    }
+
+    if (!CLOCK_T::IS_VIRTUAL)
+    {
+        // the timerfd is meaningless when time is virtual. poll ignores
+        // negative file descriptors so it is left as -1
+        m_timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+        assert(m_timerFd >= 0);
+    }
+
+    m_wakeUpFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    assert(m_wakeUpFd >= 0);
+
+    if (a_dispatchMode == DISPATCH_CONSUMER_THREAD)
+    {
+        m_dispatchThread.reset(new ConsumerThread<TimerExpiry>(
+            TIMER_SERVICE_DISPATCH_Q_SIZE,
+            std::bind(&BasicTimerService::Dispatch, this, std::placeholders::_1)));
+    }
+
+    m_serviceThread.reset(
+        new std::thread(std::bind(&BasicTimerService::ThreadRoutine, this)));
+
+    if (CLOCK_T::IS_VIRTUAL)
+    {
+        VirtualClock::AddListener(this);
+    }
+}
+
+template <typename CLOCK_T>
+inline BasicTimerService<CLOCK_T>::~BasicTimerService()
+{
+    if (m_serviceThread.get())
+    {
+        Join();
+    }
+
+    if (m_timerFd >= 0)
+    {
+        close(m_timerFd);
+    }
+    close(m_wakeUpFd);
+}
+
+template <typename CLOCK_T>
+inline uint64_t BasicTimerService<CLOCK_T>::Now()
+{
+    return CLOCK_T::Now();
+}
+
+template <typename CLOCK_T>
+inline typename BasicTimerService<CLOCK_T>::TimerId_t BasicTimerService<CLOCK_T>::Schedule(
+    TimerCallback_t a_callback,
+    uint64_t a_delay,
+    uint64_t a_period,
+    uint64_t a_slack)
+{
+    assert(m_serviceThread.get() != 0);
+
+    TimerRecord* record;
+    if (!m_freeRecords.pop(record))
+    {
+        // TIMER_SERVICE_MAX_TIMERS timers already
+        return INVALID_TIMER_ID;
+    }
+
+    // the record was given back with a release push, and nobody else
+    // touches it until it is pushed into the command queue
+    record->id       = m_lastTimerId.fetch_add(1) + 1;
+    record->callback = a_callback;
+    record->deadline = Now() + a_delay;
+    record->period   = a_period;
+    record->slack    = a_slack;
+    record->references.store(1, std::memory_order_relaxed);
+
+    // the record belongs to the service thread as soon as it is pushed
+    // into the command queue. Keep a copy of what is needed afterwards
+    TimerId_t id             = record->id;
+    uint64_t  latestDeadline = record->deadline + record->slack;
+
+    TimerCommand command;
+    command.type   = TimerCommand::CMD_SCHEDULE;
+    command.id     = id;
+    command.record = record;
+    if (!PushCommand(command))
+    {
+        // applied by the service thread itself, which is awake
+        return id;
+    }
+
+    // the service thread only needs to be woken up if it is sleeping until
+    // a later time than this new deadline (plus slack). If it is awake
+    // (m_sleepingUntil is 0) it will find the command before going back to
+    // sleep.
+    // The queue publishes the command with a release store, which the load
+    // below could be reordered before. The fence (paired with the one in
+    // ThreadRoutine) makes sure either this thread reads the new
+    // m_sleepingUntil or the service thread sees the command
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (latestDeadline < m_sleepingUntil.load())
+    {
+        WakeUp();
+    }
+
+    return id;
+}
+
+template <typename CLOCK_T>
+inline void BasicTimerService<CLOCK_T>::Cancel(TimerId_t a_id)
+{
+    assert(m_serviceThread.get() != 0);
+
+    // no need to wake up the service thread. Pending commands are processed
+    // before every expiration, so the cancellation will be effective before
+    // this timer can expire
+    TimerCommand command;
+    command.type   = TimerCommand::CMD_CANCEL;
+    command.id     = a_id;
+    command.record = 0;
+    PushCommand(command);
+}
+
+template <typename CLOCK_T>
+inline void BasicTimerService<CLOCK_T>::Join()
+{
+    if (CLOCK_T::IS_VIRTUAL)
+    {
+        // it won't be able to tell anyone it is done with the virtual time
+        // once the service thread is gone
+        VirtualClock::RemoveListener(this);
+    }
+
+    m_terminate.store(true);
+    WakeUp();
+
+    m_serviceThread->join();
+    m_serviceThread.reset();
+
+    if (m_dispatchThread.get())
+    {
+        m_dispatchThread->Join();
+        m_dispatchThread.reset();
+    }
+
+    // give back whatever is left (the service thread is gone now)
+    ProcessCommands();
+    for (auto it = m_records.begin(); it != m_records.end(); ++it)
+    {
+        ReleaseRecord(it->second);
+    }
+    m_records.clear();
+    m_deadlines.clear();
+    m_latestDeadlines.clear();
+}
+
+template <typename CLOCK_T>
+inline typename BasicTimerService<CLOCK_T>::Statistics_t BasicTimerService<CLOCK_T>::GetStatistics() const
+{
+    Statistics_t statistics;
+    statistics.expiryWakeUps = m_expiryWakeUps.load(std::memory_order_relaxed);
+    statistics.expirations   = m_expirations.load(std::memory_order_relaxed);
+    statistics.savedWakeUps  = m_savedWakeUps.load(std::memory_order_relaxed);
+
+    return statistics;
+}
+
+template <typename CLOCK_T>
+inline bool BasicTimerService<CLOCK_T>::PushCommand(const TimerCommand &a_command)
+{
+    if (std::this_thread::get_id() == m_serviceThread->get_id())
+    {
+        // a callback run inline. The service thread would spin forever if
+        // the queue was full. Commands queued before this one (a Schedule
+        // this callback knows the id of, for instance) go first
+        ProcessCommands();
+        ApplyCommand(a_command);
+        return false;
+    }
+
+    Backoff backoff;
+    while (!m_commandQueue.push(a_command))
+    {
+        // the command queue is full. Make sure the service thread is awake
+        // so it drains it and try again
+        WakeUp();
+        backoff.Wait();
+    }
+    return true;
+}
+
+template <typename CLOCK_T>
+inline void BasicTimerService<CLOCK_T>::WakeUp()
+{
+    uint64_t one = 1;
+    ssize_t rv = write(m_wakeUpFd, &one, sizeof(one));
+    // EAGAIN means the counter is about to overflow, which means the service
+    // thread will be woken up anyway
+    (void) rv;
+}
+
+template <typename CLOCK_T>
+inline void BasicTimerService<CLOCK_T>::InsertDeadline(TimerRecord* a_record)
+{
+    a_record->position = m_deadlines.insert(
+        std::make_pair(a_record->deadline, a_record));
+    a_record->latestPosition = m_latestDeadlines.insert(
+        std::make_pair(a_record->deadline + a_record->slack, a_record));
+}
+
+template <typename CLOCK_T>
+inline void BasicTimerService<CLOCK_T>::RemoveDeadline(TimerRecord* a_record)
+{
+    m_deadlines.erase(a_record->position);
+    m_latestDeadlines.erase(a_record->latestPosition);
+}
+
+template <typename CLOCK_T>
+inline uint32_t BasicTimerService<CLOCK_T>::ProcessCommands()
+{
+    uint32_t count = 0;
+    TimerCommand command;
+
+    while (m_commandQueue.pop(command))
+    {
+        count++;
+        ApplyCommand(command);
+    }
+
+    return count;
+}
+
+template <typename CLOCK_T>
+inline void BasicTimerService<CLOCK_T>::ApplyCommand(const TimerCommand &a_command)
+{
+    if (a_command.type == TimerCommand::CMD_SCHEDULE)
+    {
+        m_records[a_command.id] = a_command.record;
+        InsertDeadline(a_command.record);
+    }
+    else
+    {
+        auto it = m_records.find(a_command.id);
+        if (it != m_records.end())
+        {
+            TimerRecord* record = it->second;
+            RemoveDeadline(record);
+            m_records.erase(it);
+            ReleaseRecord(record);
+        }
+        // else the timer was a one-shot that already expired
+    }
+}
+
+template <typename CLOCK_T>
+inline void BasicTimerService<CLOCK_T>::ReleaseRecord(TimerRecord* a_record)
+{
+    if (a_record->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        // the callback is destroyed now, not when the record is reused
+        a_record->callback.Reset();
+
+        // it can't be full: it has room for every record
+        bool pushed = m_freeRecords.push(a_record);
+        assert(pushed);
+        (void) pushed;
+    }
+}
+
+template <typename CLOCK_T>
+inline void BasicTimerService<CLOCK_T>::ProcessExpirations(uint64_t a_now)
+{
+    // every timer whose deadline has passed is processed, even if its
+    // deadline plus slack hasn't been reached yet. That is how timers are
+    // coalesced into the same wake up
+    uint64_t expirations = 0;
+    uint64_t saved = 0;
+    uint64_t previousDeadline = 0;
+    while (true)
+    {
+        // commands pushed meanwhile (by other threads or by the callbacks
+        // themselves) are applied before the next callback. A Cancel that
+        // returned before it can't be missed
+        ProcessCommands();
+        if (m_deadlines.empty() || (m_deadlines.begin()->first > a_now))
+        {
+            break;
+        }
+
+        TimerRecord* record = m_deadlines.begin()->second;
+        RemoveDeadline(record);
+
+        // without slack the thread would have woken up at the earlier
+        // deadline and again for this one
+        if ((expirations > 0) &&
+            (record->deadline > previousDeadline) &&
+            (record->deadline <= m_wokenUpFor))
+        {
+            saved++;
+        }
+        previousDeadline = record->deadline;
+        expirations++;
+
+        // the expiration holds a reference of its own, so a callback which
+        // cancels its own timer isn't destroyed while it runs
+        record->references.fetch_add(1, std::memory_order_relaxed);
+        if (record->period == 0)
+        {
+            m_records.erase(record->id);
+            ReleaseRecord(record);
+        }
+        else
+        {
+            // next expiration is calculated from the previous deadline so
+            // periodic timers don't drift. If the service fell behind by more
+            // than a period, expirations are skipped rather than bursted
+            record->deadline += record->period;
+            if (record->deadline <= a_now)
+            {
+                record->deadline = a_now + record->period;
+            }
+            InsertDeadline(record);
+        }
+
+        TimerExpiry expiry;
+        expiry.record = record;
+        expiry.time   = a_now;
+        if (m_dispatchThread.get())
+        {
+            // the dispatch thread releases the reference. While its queue
+            // is full commands keep being processed: a callback on the
+            // dispatch thread might be waiting for room in the command
+            // queue, and it won't drain its own queue until it gets it
+            Backoff backoff;
+            while (!m_dispatchThread->Produce(expiry))
+            {
+                ProcessCommands();
+                backoff.Wait();
+            }
+        }
+        else
+        {
+            Dispatch(expiry);
+        }
+    }
+
+    if (expirations > 0)
+    {
+        // only the service thread writes these counters
+        m_expirations.store(
+            m_expirations.load(std::memory_order_relaxed) + expirations,
+            std::memory_order_relaxed);
+        m_expiryWakeUps.store(
+            m_expiryWakeUps.load(std::memory_order_relaxed) + 1,
+            std::memory_order_relaxed);
+        m_savedWakeUps.store(
+            m_savedWakeUps.load(std::memory_order_relaxed) + saved,
+            std::memory_order_relaxed);
+    }
+}
+
+template <typename CLOCK_T>
+inline void BasicTimerService<CLOCK_T>::ArmTimerFd(uint64_t a_deadline)
+{
+    struct itimerspec spec;
+    spec.it_interval.tv_sec  = 0;
+    spec.it_interval.tv_nsec = 0;
+    // a 0 it_value disarms the timer
+    spec.it_value.tv_sec     = a_deadline / 1000000000ULL;
+    spec.it_value.tv_nsec    = a_deadline % 1000000000ULL;
+
+    int rv = timerfd_settime(m_timerFd, TFD_TIMER_ABSTIME, &spec, 0);
+    assert(rv == 0);
+    (void) rv;
+}
+
+template <typename CLOCK_T>
+inline void BasicTimerService<CLOCK_T>::Dispatch(TimerExpiry a_expiry)
+{
+    a_expiry.record->callback(a_expiry.time);
+    ReleaseRecord(a_expiry.record);
+}
+
+template <typename CLOCK_T>
+inline void BasicTimerService<CLOCK_T>::OnVirtualTimeAdvanced(uint64_t /*a_now*/)
+{
+    uint64_t generation = m_clockGeneration.fetch_add(1) + 1;
+    WakeUp();
+
+    // the service thread publishes the generation it read before processing
+    // expirations right before going to sleep, which means every timer due
+    // by the new virtual time (including those scheduled by the callbacks
+    // themselves) has been processed
+    Backoff backoff;
+    while (m_processedGeneration.load() < generation)
+    {
+        backoff.Wait();
+    }
+}
+
+template <typename CLOCK_T>
+inline void BasicTimerService<CLOCK_T>::ThreadRoutine()
+{
+    if (m_cpu >= 0)
+    {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(m_cpu, &cpuSet);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+    }
+
+    // deadline the timerfd is currently armed with (0 if disarmed)
+    uint64_t armedDeadline = 0;
+
+    while (m_terminate.load() == false)
+    {
+        // read before the clock. The virtual time is updated before the
+        // generation is increased (see OnVirtualTimeAdvanced)
+        uint64_t generation = m_clockGeneration.load();
+
+        ProcessCommands();
+        ProcessExpirations(Now());
+        m_wokenUpFor = 0;
+
+        // sleep until the earliest deadline plus slack
+        uint64_t nextDeadline = m_latestDeadlines.empty() ?
+            TIMER_SERVICE_NO_DEADLINE : m_latestDeadlines.begin()->first;
+
+        // let producers know when this thread will wake up, then check the
+        // command queue once more. A producer either pushed its command
+        // before this check (it will be processed now) or it will read the
+        // new m_sleepingUntil and wake this thread up if needed
+        m_sleepingUntil.store(nextDeadline);
+        // the queue is read with acquire loads. See Schedule
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if ((ProcessCommands() > 0) || m_terminate.load())
+        {
+            m_sleepingUntil.store(0);
+            continue;
+        }
+
+        if (CLOCK_T::IS_VIRTUAL)
+        {
+            // nothing else can be due until the virtual time moves again
+            m_processedGeneration.store(generation);
+        }
+        else if (nextDeadline != armedDeadline)
+        {
+            ArmTimerFd(
+                (nextDeadline == TIMER_SERVICE_NO_DEADLINE) ? 0 : nextDeadline);
+            armedDeadline = nextDeadline;
+        }
+
+        m_wokenUpFor = nextDeadline;
+
+        struct pollfd fds[2];
+        fds[0].fd      = m_timerFd;
+        fds[0].events  = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd      = m_wakeUpFd;
+        fds[1].events  = POLLIN;
+        fds[1].revents = 0;
+
+        // EINTR is handled as any other wake up
+        if (poll(fds, 2, -1) > 0)
+        {
+            uint64_t counter;
+            if (fds[0].revents & POLLIN)
+            {
+                // the timerfd is disarmed by the kernel once it expires
+                if (read(m_timerFd, &counter, sizeof(counter)) > 0)
+                {
+                    armedDeadline = 0;
+                }
+            }
+            if (fds[1].revents & POLLIN)
+            {
+                ssize_t rv = read(m_wakeUpFd, &counter, sizeof(counter));
+                (void) rv;
+            }
+        }
+
+        m_sleepingUntil.store(0);
+    }
+}
+
+#endif /* _TIMERSERVICEIMPL_H_ */
@@ -0,0 +1,55 @@
+// ============================================================================
+/// @file  dummylog_decoder.cpp
+/// @brief Turns a binary log written by DummyLogger (DUMMYLOG_BINARY) into
+///        text
+/// Compiling procedure:
+///   $ g++ -g -O2 -Wall -DNDEBUG -std=c++11 -I.. -c dummylog_decoder.cpp
+///   $ g++ dummylog_decoder.o -o dummylog_decoder
+///
+/// Usage:
+///   $ dummylog_decoder <binary log> [<binary log>...]
+/// One line per log entry is written to the standard output:
+///   <seconds>.<nanoseconds> <file>:<line> <formatted message>
+/// Entries are printed in the order they were written, which is not strictly
+/// chronological when several threads log at the same time
+// ============================================================================
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "dummylogger_binary.h"
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <binary log> [<binary log>...]" << std::endl;
+        return 1;
+    }
+
+    int result = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        std::ifstream file(argv[i], std::ios::in | std::ios::binary);
+        if (!file)
+        {
+            std::cerr << argv[i] << ": can't be opened" << std::endl;
+            result = 1;
+            continue;
+        }
+
+        std::stringstream contents;
+        contents << file.rdbuf();
+        std::string data = contents.str();
+
+        DummyLogBinaryDecoder decoder;
+        if (decoder.Decode(data.data(), data.size(), std::cout) < 0)
+        {
+            std::cerr << argv[i] << ": not a binary log" << std::endl;
+            result = 1;
+        }
+    }
+
+    return result;
+}
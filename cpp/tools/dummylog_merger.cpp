@@ -0,0 +1,117 @@
+// ============================================================================
+/// @file  dummylog_merger.cpp
+/// @brief Merges timestamped logs (text or binary logs written by
+///        DummyLogger) into one, in chronological order
+/// A native replacement for scripts/log_merger.py. See dummylog_merger.h for
+/// the timestamps it understands
+/// Compiling procedure:
+///   $ g++ -g -O2 -Wall -DNDEBUG -std=c++11 -I.. -c dummylog_merger.cpp
+///   $ g++ dummylog_merger.o -o dummylog_merger
+///
+/// Usage:
+///   $ dummylog_merger [-v] [-o <output>] <log> [<log>...]
+/// The merged log goes to the standard output unless -o is used. Lines are
+/// written as they are. Binary log entries are written as text, the same way
+/// dummylog_decoder does. -v prints the throughput to the standard error
+// ============================================================================
+
+#include <iostream>
+#include <iomanip>  // std::setprecision
+#include <string>
+#include <string.h> // strcmp
+#include <fcntl.h>  // open
+#include <unistd.h> // close
+#include "clock.h"
+#include "dummylog_merger.h"
+
+static void usage(const char* a_program)
+{
+    std::cerr << "Usage: " << a_program
+              << " [-v] [-o <output>] <log> [<log>...]" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    bool verbose = false;
+    const char* outputPath = 0;
+    DummyLogMerger merger;
+    uint64_t inputBytes = 0;
+    int inputs = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-v") == 0)
+        {
+            verbose = true;
+        }
+        else if (strcmp(argv[i], "-o") == 0)
+        {
+            if (++i == argc)
+            {
+                usage(argv[0]);
+                return 1;
+            }
+            outputPath = argv[i];
+        }
+        else
+        {
+            if (!merger.AddFile(argv[i]))
+            {
+                std::cerr << argv[i] << ": can't be opened" << std::endl;
+                return 1;
+            }
+
+            struct stat info;
+            if (stat(argv[i], &info) == 0)
+            {
+                inputBytes += info.st_size;
+            }
+            inputs++;
+        }
+    }
+
+    if (inputs == 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    int fd = 1;
+    if (outputPath != 0)
+    {
+        fd = open(outputPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            std::cerr << outputPath << ": can't be opened for writing" << std::endl;
+            return 1;
+        }
+    }
+
+    uint64_t start = RealClock::Now();
+    DummyLogMergerOutput output(fd);
+    uint64_t entries = merger.Merge(output);
+    uint64_t elapsed = RealClock::Now() - start;
+
+    if (fd != 1)
+    {
+        close(fd);
+    }
+
+    if (output.Failed())
+    {
+        std::cerr << "the merged log couldn't be written" << std::endl;
+        return 1;
+    }
+
+    if (verbose)
+    {
+        double secs = static_cast<double>(elapsed) / 1000000000.0;
+        std::cerr << inputs << " logs, " << inputBytes << " bytes, "
+                  << entries << " entries merged in " << std::fixed
+                  << std::setprecision(3) << secs << "s ("
+                  << std::setprecision(1)
+                  << (static_cast<double>(inputBytes) / (1024.0 * 1024.0) / secs)
+                  << " MB/s)" << std::endl;
+    }
+    return 0;
+}
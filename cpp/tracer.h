@@ -0,0 +1,527 @@
+// ============================================================================
+// Copyright (c) 2026 Faustino Frechilla
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+/// @file  tracer.h
+/// @brief Timeline tracing: events recorded per thread and written as
+///        Chrome trace JSON (chrome://tracing, ui.perfetto.dev)
+///
+/// Counters and histograms say how much time was spent, a timeline says
+/// when and where: which ConsumerThread was busy while another one waited,
+/// how long an element sat in a queue before it was consumed, how deep the
+/// queue got meanwhile. The events are:
+///   - TRACE_SCOPE(name): a slice from here to the end of the block
+///   - TRACE_INSTANT(name): a point in time
+///   - TRACE_COUNTER(name, id, value): a sample of a counter track (a queue
+///     depth...). Tracks with the same name are told apart by their id
+///   - TRACE_FLOW_BEGIN(name, id) and TRACE_FLOW_END(name, id): an arrow
+///     from the slice of a thread (where an element was produced) to the
+///     slice of another one (where the element with the same id was
+///     consumed). Flows attach to the enclosing TRACE_SCOPE, so they need one
+///   - TRACE_THREAD_NAME(name): what the thread is called in the timeline.
+///     Unlike the others it is recorded even if tracing is disabled
+/// Names are not copied: they must be string literals (or live as long as
+/// the program).
+///
+/// Each thread records into a buffer of its own, an ArrayLockFreeQueue
+/// with a single producer (TRACER_BUFFER_SIZE - 1 events), so recording an
+/// event is a clock read and a push, with no lock and no shared cache line.
+/// If the buffer is full the event is counted as dropped. The buffer is
+/// claimed the first time the thread records an event, and handed over to
+/// the next new thread when the thread exits. Events a thread records
+/// after that (from thread_local destructors) are discarded. Tracer::Write takes the
+/// events out of every buffer and writes them as a JSON trace. Call it
+/// often enough not to drop events:
+///
+/// Tracer::Enable();
+/// {
+///     TRACE_SCOPE("produce");
+///     TRACE_FLOW_BEGIN("request", request.id);
+///     queue.Push(request);
+///     TRACE_COUNTER("queue depth", 0, queue.Size());
+/// }
+/// /* ... */
+/// std::ofstream out("trace.json");
+/// Tracer::Write(out);
+///
+/// Tracing is off until Tracer::Enable is called. Every macro checks it
+/// first (a relaxed load) and evaluates nothing else when it is off.
+/// Defining TRACER_DISABLE removes the macros from the code altogether.
+///
+/// Your compiler must have support for c++11 and the target must be Linux
+///
+/// @author Faustino Frechilla
+/// @history
+/// Ref        Who                When        What
+///            Faustino Frechilla 17-Oct-2026 Original development
+///            Faustino Frechilla 17-Oct-2026 No events after the buffer is handed over
+/// @endhistory
+///
+// ============================================================================
+
+#ifndef _TRACER_H_
+#define _TRACER_H_
+
+#include <stdint.h>       // types (uint64_t...)
+#include <stdio.h>        // snprintf
+#include <unistd.h>       // getpid, syscall
+#include <sys/syscall.h>  // SYS_gettid
+#include <atomic>
+#include <mutex>
+#include <ostream>
+#include "tsc_clock.h"
+#include "backoff.h"
+#include "lock_free_queue.h"
+
+#ifndef TRACER_BUFFER_SIZE
+/// events each thread holds until they are written (a power of 2)
+#define TRACER_BUFFER_SIZE 16384
+#endif
+
+enum TraceEventType_t
+{
+    TRACE_EVENT_BEGIN = 0,
+    TRACE_EVENT_END,
+    TRACE_EVENT_INSTANT,
+    TRACE_EVENT_COUNTER,
+    TRACE_EVENT_FLOW_BEGIN,
+    TRACE_EVENT_FLOW_END,
+    /// the name of the thread (the name of the event)
+    TRACE_EVENT_THREAD_NAME,
+
+    TRACE_EVENT_COUNT
+};
+
+/// @brief an event as it is kept in the buffer of a thread
+struct TraceEvent
+{
+    /// nanoseconds since the first Tracer::Enable
+    uint64_t timestamp;
+    const char* name;
+    /// id of a flow or a counter track (0 is no id)
+    uint64_t id;
+    /// value of a counter
+    int64_t value;
+    uint32_t tid;
+    uint32_t type;
+};
+
+#define TRACER_CONCAT_(a_x, a_y) a_x##a_y
+#define TRACER_CONCAT(a_x, a_y)  TRACER_CONCAT_(a_x, a_y)
+
+#ifdef TRACER_DISABLE
+#define TRACE_SCOPE(a_name)
+#define TRACE_INSTANT(a_name)
+#define TRACE_COUNTER(a_name, a_id, a_value)
+#define TRACE_FLOW_BEGIN(a_name, a_id)
+#define TRACE_FLOW_END(a_name, a_id)
+#define TRACE_THREAD_NAME(a_name)
+#else
+/// @brief a slice from here to the end of the enclosing block
+#define TRACE_SCOPE(a_name) \
+    TraceScope TRACER_CONCAT(traceScope, __LINE__)(a_name)
+
+#define TRACE_RECORD_(a_type, a_name, a_id, a_value)                  \
+    do                                                                \
+    {                                                                 \
+        if (Tracer::IsEnabled())                                      \
+        {                                                             \
+            Tracer::Record((a_type), (a_name), (a_id), (a_value));    \
+        }                                                             \
+    } while (0)
+
+#define TRACE_INSTANT(a_name) \
+    TRACE_RECORD_(TRACE_EVENT_INSTANT, a_name, 0, 0)
+#define TRACE_COUNTER(a_name, a_id, a_value) \
+    TRACE_RECORD_(TRACE_EVENT_COUNTER, a_name, a_id, static_cast<int64_t>(a_value))
+#define TRACE_FLOW_BEGIN(a_name, a_id) \
+    TRACE_RECORD_(TRACE_EVENT_FLOW_BEGIN, a_name, a_id, 0)
+#define TRACE_FLOW_END(a_name, a_id) \
+    TRACE_RECORD_(TRACE_EVENT_FLOW_END, a_name, a_id, 0)
+#define TRACE_THREAD_NAME(a_name) \
+    Tracer::SetThreadName(a_name)
+#endif
+
+/// @brief records the events and writes them. Everything is static: there
+/// is one tracer per process
+class Tracer
+{
+public:
+    /// @brief starts recording the events of every thread
+    static void Enable()
+    {
+        // timestamps start at the first Enable, which keeps them small
+        // enough for the microseconds (a double) of the JSON format
+        uint64_t base = 0;
+        Base().compare_exchange_strong(base, TscClock::Now(), std::memory_order_relaxed);
+        Enabled().store(true, std::memory_order_relaxed);
+    }
+
+    /// @brief stops recording. Slices already begun still record their end
+    static void Disable()
+    {
+        Enabled().store(false, std::memory_order_relaxed);
+    }
+
+    static inline bool IsEnabled()
+    {
+        return Enabled().load(std::memory_order_relaxed);
+    }
+
+    /// @brief records an event in the buffer of the calling thread, even
+    /// if tracing is disabled (the macros check it)
+    /// @param a_name a string which lives as long as the program
+    static inline void Record(TraceEventType_t a_type, const char* a_name, uint64_t a_id, int64_t a_value)
+    {
+        ThreadState &state = ThisThread();
+        if (state.buffer == 0)
+        {
+            if (state.exited)
+            {
+                // the buffer of this thread may belong to another one now
+                return;
+            }
+            state.buffer = ClaimBuffer();
+            if ((state.name != 0) && (a_type != TRACE_EVENT_THREAD_NAME))
+            {
+                // the buffer may have been someone else's, so the name
+                // travels with the events
+                Record(TRACE_EVENT_THREAD_NAME, state.name, 0, 0);
+            }
+        }
+
+        TraceEvent event;
+        uint64_t now  = TscClock::Now();
+        uint64_t base = Base().load(std::memory_order_relaxed);
+        event.timestamp = (now > base) ? (now - base) : 0;
+        event.name  = a_name;
+        event.id    = a_id;
+        event.value = a_value;
+        event.tid   = state.buffer->tid.load(std::memory_order_relaxed);
+        event.type  = a_type;
+
+        if (!state.buffer->events.push(event))
+        {
+            // only this thread writes it
+            state.buffer->dropped.store(
+                state.buffer->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    }
+
+    /// @brief names the calling thread in the traces. It can be called
+    /// before Enable: the name is recorded when the thread records its
+    /// first event
+    /// @param a_name a string which lives as long as the program
+    static void SetThreadName(const char* a_name)
+    {
+        ThreadState &state = ThisThread();
+        state.name = a_name;
+        if (state.buffer != 0)
+        {
+            state.buffer->name.store(a_name, std::memory_order_release);
+            Record(TRACE_EVENT_THREAD_NAME, a_name, 0, 0);
+        }
+    }
+
+    /// @brief takes the events out of the buffer of every thread and writes
+    /// them as a Chrome trace JSON document (one event per line). Threads
+    /// can keep recording meanwhile: what they record after their buffer
+    /// was written is left for the next call
+    /// @return the number of events written
+    static uint64_t Write(std::ostream &a_out)
+    {
+        // function-local static so this class can live in a header file.
+        // The buffers have a single consumer
+        static std::mutex s_writeMutex;
+        std::lock_guard<std::mutex> lock(s_writeMutex);
+
+        uint32_t pid = static_cast<uint32_t>(getpid());
+        uint64_t written = 0;
+        const char* separator = "\n";
+
+        a_out << "{\"traceEvents\":[";
+        for (TraceBuffer* buffer = Buffers().load(std::memory_order_acquire);
+             buffer != 0;
+             buffer = buffer->next)
+        {
+            // the owner of the buffer is named in every trace, not only in
+            // the one with its first events
+            TraceEvent threadName;
+            threadName.name = buffer->name.load(std::memory_order_acquire);
+            threadName.tid  = buffer->tid.load(std::memory_order_relaxed);
+            threadName.type = TRACE_EVENT_THREAD_NAME;
+            if (threadName.name != 0)
+            {
+                a_out << separator;
+                WriteEvent(a_out, pid, threadName);
+                separator = ",\n";
+            }
+
+            TraceEvent event;
+            while (buffer->events.pop(event))
+            {
+                a_out << separator;
+                WriteEvent(a_out, pid, event);
+                separator = ",\n";
+                written++;
+            }
+        }
+        a_out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+
+        return written;
+    }
+
+    /// @return events which didn't fit in the buffer of their thread
+    static uint64_t Dropped()
+    {
+        uint64_t dropped = 0;
+        for (TraceBuffer* buffer = Buffers().load(std::memory_order_acquire);
+             buffer != 0;
+             buffer = buffer->next)
+        {
+            dropped += buffer->dropped.load(std::memory_order_relaxed);
+        }
+        return dropped;
+    }
+
+private:
+    /// @brief the events of a thread. Buffers are never freed: a thread
+    /// which exits hands its buffer over to the next new one
+    struct TraceBuffer
+    {
+        /// the thread is the only producer, Write the only consumer
+        ArrayLockFreeQueue<TraceEvent, TRACER_BUFFER_SIZE> events;
+        /// set while a thread owns the buffer
+        std::atomic<bool> owned;
+        /// system-wide id of the owner (what perf and gdb show)
+        std::atomic<uint32_t> tid;
+        std::atomic<const char*> name;
+        std::atomic<uint64_t> dropped;
+        /// next buffer in the list. It doesn't change once published
+        TraceBuffer* next;
+    };
+
+    /// @brief what the calling thread knows without a guard (trivial type)
+    struct ThreadState
+    {
+        TraceBuffer* buffer;
+        const char* name;
+        /// set once the buffer has been given back (the thread is exiting)
+        bool exited;
+    };
+
+    /// @brief gives the buffer back when the thread exits
+    struct BufferSlot
+    {
+        TraceBuffer* buffer;
+
+        BufferSlot():
+            buffer(0)
+        {}
+
+        ~BufferSlot()
+        {
+            if (buffer != 0)
+            {
+                // thread_local destructors which run after this one must
+                // not push into the buffer once someone else owns it
+                ThisThread().buffer = 0;
+                ThisThread().exited = true;
+                // release: whatever the thread pushed is seen by the next owner
+                buffer->owned.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    static inline ThreadState& ThisThread()
+    {
+        static thread_local ThreadState t_state = {0, 0, false};
+        return t_state;
+    }
+
+    /// @brief takes a buffer no thread owns, or creates a new one. The
+    /// BufferSlot of the calling thread gives it back when the thread exits
+    static TraceBuffer* ClaimBuffer()
+    {
+        static thread_local BufferSlot t_slot;
+
+        TraceBuffer* buffer = Buffers().load(std::memory_order_acquire);
+        for (; buffer != 0; buffer = buffer->next)
+        {
+            bool owned = false;
+            if (!buffer->owned.load(std::memory_order_relaxed) &&
+                buffer->owned.compare_exchange_strong(owned, true, std::memory_order_acquire))
+            {
+                break;
+            }
+        }
+
+        if (buffer == 0)
+        {
+            buffer = new TraceBuffer();
+            buffer->owned.store(true, std::memory_order_relaxed);
+            buffer->dropped.store(0, std::memory_order_relaxed);
+            buffer->next = Buffers().load(std::memory_order_relaxed);
+            Backoff backoff;
+            while (!Buffers().compare_exchange_weak(
+                buffer->next, buffer, std::memory_order_release, std::memory_order_relaxed))
+            {
+                backoff.Wait();
+            }
+        }
+
+        buffer->tid.store(static_cast<uint32_t>(syscall(SYS_gettid)), std::memory_order_relaxed);
+        buffer->name.store(ThisThread().name, std::memory_order_release);
+        t_slot.buffer = buffer;
+        return buffer;
+    }
+
+    static void WriteEvent(std::ostream &a_out, uint32_t a_pid, const TraceEvent &a_event)
+    {
+        static const char* s_phases[TRACE_EVENT_COUNT] = {"B", "E", "i", "C", "s", "f", "M"};
+
+        if (a_event.type == TRACE_EVENT_THREAD_NAME)
+        {
+            a_out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << a_pid
+                  << ",\"tid\":" << a_event.tid << ",\"args\":{\"name\":";
+            WriteString(a_out, a_event.name);
+            a_out << "}}";
+            return;
+        }
+
+        // the JSON format counts microseconds
+        char number[64];
+        snprintf(number, sizeof(number), "%llu.%03u",
+                 static_cast<unsigned long long>(a_event.timestamp / 1000),
+                 static_cast<uint32_t>(a_event.timestamp % 1000));
+
+        a_out << "{\"name\":";
+        WriteString(a_out, a_event.name);
+        a_out << ",\"ph\":\"" << s_phases[a_event.type] << "\",\"ts\":" << number
+              << ",\"pid\":" << a_pid << ",\"tid\":" << a_event.tid;
+
+        snprintf(number, sizeof(number), "\"0x%llx\"", static_cast<unsigned long long>(a_event.id));
+        switch (a_event.type)
+        {
+        case TRACE_EVENT_INSTANT:
+            // scoped to the thread
+            a_out << ",\"s\":\"t\"";
+            break;
+
+        case TRACE_EVENT_COUNTER:
+            if (a_event.id != 0)
+            {
+                a_out << ",\"id\":" << number;
+            }
+            a_out << ",\"args\":{\"value\":" << a_event.value << "}";
+            break;
+
+        case TRACE_EVENT_FLOW_BEGIN:
+            a_out << ",\"cat\":\"flow\",\"id\":" << number;
+            break;
+
+        case TRACE_EVENT_FLOW_END:
+            // bound to the enclosing slice, not to the next one
+            a_out << ",\"cat\":\"flow\",\"id\":" << number << ",\"bp\":\"e\"";
+            break;
+
+        default:
+            break;
+        }
+        a_out << "}";
+    }
+
+    /// @brief writes a_string as a quoted JSON string
+    static void WriteString(std::ostream &a_out, const char* a_string)
+    {
+        a_out << '"';
+        for (const char* c = (a_string != 0) ? a_string : ""; *c != '\0'; c++)
+        {
+            if ((*c == '"') || (*c == '\\'))
+            {
+                a_out << '\\' << *c;
+            }
+            else if (static_cast<unsigned char>(*c) < 0x20)
+            {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<uint32_t>(*c));
+                a_out << escaped;
+            }
+            else
+            {
+                a_out << *c;
+            }
+        }
+        a_out << '"';
+    }
+
+    // function-local statics so this class can live in a header file
+    static inline std::atomic<bool>& Enabled()
+    {
+        static std::atomic<bool> s_enabled(false);
+        return s_enabled;
+    }
+
+    static inline std::atomic<uint64_t>& Base()
+    {
+        static std::atomic<uint64_t> s_base(0);
+        return s_base;
+    }
+
+    /// @brief every buffer ever created, the newest first
+    static inline std::atomic<TraceBuffer*>& Buffers()
+    {
+        static std::atomic<TraceBuffer*> s_buffers(0);
+        return s_buffers;
+    }
+};
+
+/// @brief records a slice from its construction to its destruction. Its end
+/// is recorded if its beginning was, even if tracing is disabled meanwhile
+class TraceScope
+{
+public:
+    explicit TraceScope(const char* a_name):
+        m_name(Tracer::IsEnabled() ? a_name : 0)
+    {
+        if (m_name != 0)
+        {
+            Tracer::Record(TRACE_EVENT_BEGIN, m_name, 0, 0);
+        }
+    }
+
+    ~TraceScope()
+    {
+        if (m_name != 0)
+        {
+            Tracer::Record(TRACE_EVENT_END, m_name, 0, 0);
+        }
+    }
+
+private:
+    /// 0 if the beginning wasn't recorded
+    const char* m_name;
+
+    // prevent copying
+    TraceScope(const TraceScope &a_src);
+    TraceScope& operator=(const TraceScope &a_src);
+};
+
+#endif /* _TRACER_H_ */
@@ -0,0 +1,472 @@
+// ============================================================================
+// Copyright (c) 2026 Faustino Frechilla
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+/// @file  tsc_clock.h
+/// @brief This file contains a clock based on the CPU time stamp counter
+///
+/// Reading the TSC costs a few nanoseconds, against the 20-30ns of
+/// clock_gettime through the vDSO, which makes this clock suitable for
+/// timestamping on hot paths. See clock.h for the interface every clock
+/// follows.
+///
+/// Ticks are converted into nanoseconds with a fixed-point multiplier:
+///   nsecs = baseNsecs + (((ticks - baseTicks) * mult) >> TSC_CLOCK_SHIFT)
+/// The multiplier is calibrated against CLOCK_MONOTONIC when the clock is
+/// initialised, so TscClock::Now() and RealClock::Now() share the same
+/// starting point, and then again every TSC_CLOCK_RECALIBRATION_NSECS. The
+/// thread whose Now() call finds the calibration too old recalibrates it
+/// (which costs a clock_gettime call) and slews the multiplier so the clock
+/// converges back to CLOCK_MONOTONIC without jumping. Readers get the
+/// conversion parameters through a seqlock so they never block.
+///
+/// The TSC is considered unstable, and the clock falls back to RealClock for
+/// good, if the CPU doesn't report an invariant TSC, if it goes backwards or
+/// if it drifts more than TSC_CLOCK_MAX_DRIFT_PPM between calibrations. On
+/// non-x86 targets TscClock is always RealClock. The fallback never returns
+/// less than the TSC time when the switch happened, so the clock doesn't go
+/// backwards if the TSC was ahead of CLOCK_MONOTONIC: it stands still until
+/// CLOCK_MONOTONIC catches up.
+///
+/// Init() busy waits for TSC_CLOCK_CALIBRATION_NSECS, so it should be called
+/// at startup. Otherwise the first call to Now() pays for it. Example:
+///
+/// TscClock::Init();
+/// /* ... */
+/// uint64_t start = TscClock::Now();
+/// DoSomething();
+/// uint64_t elapsed = TscClock::Now() - start;
+///
+/// Your compiler must have support for c++11 and __int128 (gcc, clang)
+///
+/// @author Faustino Frechilla
+/// @history
+/// Ref        Who                When        What
+///            Faustino Frechilla 17-Oct-2026 Original development
+///            Faustino Frechilla 17-Oct-2026 Fixed-point conversion, periodic
+///                                           recalibration, unstable TSC check
+///            Faustino Frechilla 17-Oct-2026 TicksToNsecs converts ticks older than
+///                                           the latest calibration
+///            Faustino Frechilla 17-Oct-2026 The RealClock fallback doesn't go back
+///                                           in time (MarkUnstable)
+/// @endhistory
+///
+// ============================================================================
+
+#ifndef _TSCCLOCK_H_
+#define _TSCCLOCK_H_
+
+#include <stdint.h>   // types (uint64_t...)
+#include <atomic>
+#include "clock.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h> // __rdtsc, __rdtscp
+#include <cpuid.h>     // __get_cpuid
+#define _TSC_CLOCK_X86
+#endif
+
+// time spent measuring the TSC frequency when the clock is initialised
+#define TSC_CLOCK_CALIBRATION_NSECS   10000000   // (10ms)
+// how often the multiplier is calibrated again
+#define TSC_CLOCK_RECALIBRATION_NSECS 1000000000 // (1s)
+// maximum difference with CLOCK_MONOTONIC found when recalibrating, in parts
+// per million of the time elapsed since the previous calibration, before the
+// TSC is considered unstable
+#define TSC_CLOCK_MAX_DRIFT_PPM       1000
+// attempts to read both clocks without being interrupted in between
+#define TSC_CLOCK_READ_ATTEMPTS       5
+// fractional bits of the fixed-point multiplier
+#define TSC_CLOCK_SHIFT               32
+
+/// @brief a clock based on the CPU time stamp counter
+class TscClock
+{
+public:
+    static const bool IS_VIRTUAL = false;
+
+    /// @brief calibrates the clock. It is only done once, no matter how
+    /// many times it is called. It takes TSC_CLOCK_CALIBRATION_NSECS
+    static inline void Init()
+    {
+        GetState();
+    }
+
+    /// @return nanoseconds since the same starting point as RealClock
+    static inline uint64_t Now()
+    {
+#ifdef _TSC_CLOCK_X86
+        State_t &state = GetState();
+        if (state.unstable.load(std::memory_order_acquire))
+        {
+            return FallbackNow(state);
+        }
+        return TicksToNsecs(__rdtsc());
+#else
+        return RealClock::Now();
+#endif
+    }
+
+    /// @brief same as Now(), but the TSC is not read until every previous
+    /// instruction has finished (rdtscp). Meant for the end of a measured
+    /// section
+    static inline uint64_t NowSerialized()
+    {
+#ifdef _TSC_CLOCK_X86
+        State_t &state = GetState();
+        if (state.unstable.load(std::memory_order_acquire))
+        {
+            return FallbackNow(state);
+        }
+        unsigned int aux;
+        return TicksToNsecs(__rdtscp(&aux));
+#else
+        return RealClock::Now();
+#endif
+    }
+
+    /// @return raw TSC ticks (0 if the TSC is not available).
+    /// Cheaper than Now() when the conversion can be done later, out of the
+    /// hot path, by TicksToNsecs
+    static inline uint64_t ReadTicks()
+    {
+#ifdef _TSC_CLOCK_X86
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    /// @brief converts TSC ticks into nanoseconds
+    /// Ticks read before or after the latest calibration are converted with
+    /// it, so ticks read a long time ago might be a few microseconds off.
+    /// Once the TSC is found unstable the latest calibration is kept to
+    /// convert the ticks stored until then (ticks read afterwards can't be
+    /// trusted). If the TSC was never calibrated the result is 0
+    static inline uint64_t TicksToNsecs(uint64_t a_ticks)
+    {
+        State_t &state = GetState();
+
+        uint64_t baseTicks;
+        uint64_t baseNsecs;
+        uint64_t mult;
+        uint64_t recalibrationTicks;
+        uint32_t sequence;
+        do
+        {
+            sequence           = state.sequence.load(std::memory_order_acquire);
+            baseTicks          = state.baseTicks.load(std::memory_order_relaxed);
+            baseNsecs          = state.baseNsecs.load(std::memory_order_relaxed);
+            mult               = state.mult.load(std::memory_order_relaxed);
+            recalibrationTicks = state.recalibrationTicks.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((sequence & 1) ||
+                 (sequence != state.sequence.load(std::memory_order_relaxed)));
+
+        if (mult == 0)
+        {
+            return 0;
+        }
+
+        if (a_ticks < baseTicks)
+        {
+            // read before the latest calibration (or a few ticks apart on
+            // another core)
+            uint64_t earlierNsecs = Scale(baseTicks - a_ticks, mult);
+            return (earlierNsecs < baseNsecs) ? (baseNsecs - earlierNsecs) : 0;
+        }
+
+        uint64_t elapsedTicks = a_ticks - baseTicks;
+        if ((elapsedTicks > recalibrationTicks) &&
+            !state.unstable.load(std::memory_order_relaxed))
+        {
+            Recalibrate(state);
+        }
+
+        return baseNsecs + Scale(elapsedTicks, mult);
+    }
+
+    /// @brief falls back to RealClock for good, as if the TSC had been found
+    /// unstable. Meant for callers that know better than the checks done by
+    /// this clock (a virtual machine about to migrate...)
+    static inline void MarkUnstable()
+    {
+#ifdef _TSC_CLOCK_X86
+        State_t &state = GetState();
+        if (!state.unstable.load(std::memory_order_relaxed))
+        {
+            FallBack(state, TicksToNsecs(__rdtsc()));
+        }
+#endif
+    }
+
+    /// @return false if the clock fell back to RealClock
+    static inline bool IsStable()
+    {
+        return !GetState().unstable.load(std::memory_order_relaxed);
+    }
+
+    /// @return TSC ticks per second as measured by the latest calibration
+    static inline uint64_t GetFrequency()
+    {
+        uint64_t mult = GetState().mult.load(std::memory_order_relaxed);
+        return (mult == 0) ? 0 :
+            static_cast<uint64_t>(
+                (static_cast<unsigned __int128>(1000000000ULL) << TSC_CLOCK_SHIFT) / mult);
+    }
+
+private:
+    TscClock();
+
+    /// @brief calibration shared by every thread
+    struct State_t
+    {
+        /// seqlock protecting the conversion parameters. Odd while written
+        std::atomic<uint32_t> sequence;
+        /// conversion parameters
+        std::atomic<uint64_t> baseTicks;
+        std::atomic<uint64_t> baseNsecs;
+        std::atomic<uint64_t> mult;
+        /// ticks after baseTicks when the calibration is considered too old
+        std::atomic<uint64_t> recalibrationTicks;
+        /// set once the TSC is found unstable. It is never cleared
+        std::atomic<bool> unstable;
+        /// TSC time when the TSC was found unstable. The fallback to
+        /// RealClock never returns less than this
+        std::atomic<uint64_t> fallbackNsecs;
+        /// only one thread recalibrates at a time
+        std::atomic<bool> recalibrating;
+        /// the latest point where both clocks were read. Only accessed by
+        /// the thread that owns the recalibrating flag
+        uint64_t anchorTicks;
+        uint64_t anchorNsecs;
+
+        State_t();
+    };
+
+    static inline State_t& GetState()
+    {
+        // thread-safe initialisation of function-local statics (c++11)
+        static State_t s_state;
+        return s_state;
+    }
+
+    static inline uint64_t Scale(uint64_t a_ticks, uint64_t a_mult)
+    {
+        return static_cast<uint64_t>(
+            (static_cast<unsigned __int128>(a_ticks) * a_mult) >> TSC_CLOCK_SHIFT);
+    }
+
+    /// @brief reads both clocks as close to each other as possible
+    static inline void ReadBoth(uint64_t &out_ticks, uint64_t &out_nsecs);
+
+    /// @return true if the CPU says its TSC runs at a constant rate in
+    ///         every power state (invariant TSC)
+    static inline bool HasInvariantTsc();
+
+    /// @brief checks the drift since the latest calibration and publishes
+    ///        new conversion parameters
+    static void Recalibrate(State_t &a_state);
+
+    /// @brief switches to RealClock. a_nsecs is the latest TSC time handed
+    ///        out (as far as the caller knows)
+    static inline void FallBack(State_t &a_state, uint64_t a_nsecs)
+    {
+        a_state.fallbackNsecs.store(a_nsecs, std::memory_order_relaxed);
+        a_state.unstable.store(true, std::memory_order_release);
+    }
+
+    /// @return RealClock::Now(), but not less than the TSC time when the
+    ///         TSC was found unstable
+    static inline uint64_t FallbackNow(State_t &a_state)
+    {
+        uint64_t nsecs    = RealClock::Now();
+        uint64_t minNsecs = a_state.fallbackNsecs.load(std::memory_order_relaxed);
+        return (nsecs > minNsecs) ? nsecs : minNsecs;
+    }
+};
+
+inline TscClock::State_t::State_t():
+    sequence(0),
+    baseTicks(0),
+    baseNsecs(0),
+    mult(0),
+    recalibrationTicks(0),
+    unstable(true),
+    fallbackNsecs(0),
+    recalibrating(false),
+    anchorTicks(0),
+    anchorNsecs(0)
+{
+#ifdef _TSC_CLOCK_X86
+    if (!HasInvariantTsc())
+    {
+        return;
+    }
+
+    uint64_t startTicks;
+    uint64_t startNsecs;
+    ReadBoth(startTicks, startNsecs);
+
+    uint64_t endTicks;
+    uint64_t endNsecs;
+    do
+    {
+        ReadBoth(endTicks, endNsecs);
+    } while ((endNsecs - startNsecs) < TSC_CLOCK_CALIBRATION_NSECS);
+
+    if (endTicks <= startTicks)
+    {
+        return;
+    }
+
+    uint64_t calibratedMult = static_cast<uint64_t>(
+        (static_cast<unsigned __int128>(endNsecs - startNsecs) << TSC_CLOCK_SHIFT) /
+        (endTicks - startTicks));
+
+    baseTicks.store(endTicks);
+    baseNsecs.store(endNsecs);
+    mult.store(calibratedMult);
+    recalibrationTicks.store(
+        (static_cast<unsigned __int128>(TSC_CLOCK_RECALIBRATION_NSECS) << TSC_CLOCK_SHIFT) /
+        calibratedMult);
+    anchorTicks = endTicks;
+    anchorNsecs = endNsecs;
+    unstable.store(false);
+#endif
+}
+
+inline void TscClock::ReadBoth(uint64_t &out_ticks, uint64_t &out_nsecs)
+{
+#ifdef _TSC_CLOCK_X86
+    // the TSC is read on both sides of clock_gettime. The midpoint is the
+    // best guess of the TSC when clock_gettime read the time. The narrowest
+    // window out of a few attempts is kept in case the thread was
+    // interrupted in the middle of one of them
+    out_ticks = 0;
+    out_nsecs = 0;
+    uint64_t narrowest = ~static_cast<uint64_t>(0);
+    for (int i = 0; i < TSC_CLOCK_READ_ATTEMPTS; i++)
+    {
+        uint64_t before = __rdtsc();
+        uint64_t nsecs  = RealClock::Now();
+        uint64_t after  = __rdtsc();
+
+        if ((after >= before) && ((after - before) < narrowest))
+        {
+            narrowest = after - before;
+            out_ticks = before + ((after - before) / 2);
+            out_nsecs = nsecs;
+        }
+    }
+#else
+    out_nsecs = RealClock::Now();
+    out_ticks = 0;
+#endif
+}
+
+inline bool TscClock::HasInvariantTsc()
+{
+#ifdef _TSC_CLOCK_X86
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0x80000000, 0) < 0x80000007)
+    {
+        return false;
+    }
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+    {
+        return false;
+    }
+    // CPUID.80000007H:EDX[8] is the invariant TSC bit
+    return (edx & (1 << 8)) != 0;
+#else
+    return false;
+#endif
+}
+
+inline void TscClock::Recalibrate(State_t &a_state)
+{
+    if (a_state.recalibrating.exchange(true, std::memory_order_acquire))
+    {
+        // someone else is at it. Keep on using the current parameters
+        return;
+    }
+
+    uint64_t ticks;
+    uint64_t nsecs;
+    ReadBoth(ticks, nsecs);
+
+    uint64_t baseTicks = a_state.baseTicks.load(std::memory_order_relaxed);
+    uint64_t baseNsecs = a_state.baseNsecs.load(std::memory_order_relaxed);
+    uint64_t mult      = a_state.mult.load(std::memory_order_relaxed);
+
+    if ((ticks <= a_state.anchorTicks) || (ticks <= baseTicks) ||
+        (nsecs <= a_state.anchorNsecs))
+    {
+        // the TSC went backwards (or stood still). The current TSC time
+        // can't be worked out, but it was at least baseNsecs
+        FallBack(a_state, baseNsecs);
+        a_state.recalibrating.store(false, std::memory_order_release);
+        return;
+    }
+
+    // TSC time right now with the current parameters. The new parameters
+    // start from here so the clock doesn't jump
+    uint64_t tscNsecs = baseNsecs + Scale(ticks - baseTicks, mult);
+    int64_t  drift    = static_cast<int64_t>(nsecs - tscNsecs);
+
+    uint64_t elapsedTicks = ticks - a_state.anchorTicks;
+    uint64_t elapsedNsecs = nsecs - a_state.anchorNsecs;
+    int64_t  maxDrift     = static_cast<int64_t>(
+        (elapsedNsecs / 1000000) * TSC_CLOCK_MAX_DRIFT_PPM);
+    if ((drift > maxDrift) || (drift < -maxDrift))
+    {
+        FallBack(a_state, tscNsecs);
+        a_state.recalibrating.store(false, std::memory_order_release);
+        return;
+    }
+
+    // the frequency measured since the latest calibration, slewed so the
+    // drift is corrected by the next calibration. Since the drift is small
+    // threads still using the old multiplier are never noticeably ahead of
+    // those already using the new one
+    uint64_t newMult = static_cast<uint64_t>(
+        (static_cast<unsigned __int128>(elapsedNsecs + drift) << TSC_CLOCK_SHIFT) /
+        elapsedTicks);
+
+    uint32_t sequence = a_state.sequence.load(std::memory_order_relaxed);
+    a_state.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    a_state.baseTicks.store(ticks, std::memory_order_relaxed);
+    a_state.baseNsecs.store(tscNsecs, std::memory_order_relaxed);
+    a_state.mult.store(newMult, std::memory_order_relaxed);
+    a_state.recalibrationTicks.store(
+        (static_cast<unsigned __int128>(TSC_CLOCK_RECALIBRATION_NSECS) << TSC_CLOCK_SHIFT) /
+        newMult, std::memory_order_relaxed);
+
+    a_state.sequence.store(sequence + 2, std::memory_order_release);
+
+    a_state.anchorTicks = ticks;
+    a_state.anchorNsecs = nsecs;
+    a_state.recalibrating.store(false, std::memory_order_release);
+}
+
+#endif /* _TSCCLOCK_H_ */
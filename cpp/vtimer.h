@@ -40,11 +40,19 @@
 ///  virtual_timer.Update(30);
 /// /* ... */
 ///
+/// Timers can be given some slack: they are allowed to expire up to "slack"
+/// units of time later than their period says. Whoever drives many timers can
+/// then wake up at the earliest GetLatestExpiryTime() of the lot and Update
+/// all of them: every timer whose window [GetNextExpiryTime(),
+/// GetLatestExpiryTime()] overlaps the earliest one will expire in that same
+/// wake up
+///
 /// @author Faustino Frechilla
 /// @history
 /// Ref        Who                When        What
 ///            Faustino Frechilla 12-Jun-2009 Original development
 ///            Faustino Frechilla 06-Jul-2013 Ported to c++11. Templates
+///            Faustino Frechilla 17-Oct-2026 Slack to coalesce expirations
 /// @endhistory
 ///
 // ============================================================================
@@ -75,12 +83,18 @@ public:
     /// @brief constructor of a virtual timer
     /// @param a_callback Callback function that will get called on expiration
     /// @param period of time between calls. It must be greater or equal to 0
-    VTimer(VTimerCallback_t a_callback, TIME_TYPE a_period):
+    /// @param a_slack how late the callback is allowed to be called. It does
+    ///        not change when Update calls the callback, but it tells whoever
+    ///        drives the timer how long it can wait to call Update (see
+    ///        GetLatestExpiryTime). It must be greater or equal to 0
+    VTimer(VTimerCallback_t a_callback, TIME_TYPE a_period, TIME_TYPE a_slack = 0):
         m_callback(a_callback),
         m_nextExpiryTime(0),
-        m_period(a_period)
+        m_period(a_period),
+        m_slack(a_slack)
     {
         assert(a_period >= 0);
+        assert(a_slack >= 0);
     }
 
     /// @brief destructor
@@ -124,6 +138,33 @@ public:
         }
     }
 
+    /// @brief earliest time the callback will get called
+    /// @return the next expiration time. 0 if Update hasn't been called yet
+    inline TIME_TYPE GetNextExpiryTime() const
+    {
+        return m_nextExpiryTime;
+    }
+
+    /// @brief latest time Update should be called for the callback to be
+    ///        called within its slack
+    /// @return the next expiration time plus the slack. 0 if Update hasn't
+    ///         been called yet
+    inline TIME_TYPE GetLatestExpiryTime() const
+    {
+        if (m_nextExpiryTime == 0)
+        {
+            return m_nextExpiryTime;
+        }
+
+        return m_nextExpiryTime + m_slack;
+    }
+
+    /// @return the slack of this timer
+    inline TIME_TYPE GetSlack() const
+    {
+        return m_slack;
+    }
+
 private:
     /// a pointer to the callback function
     VTimerCallback_t m_callback;
@@ -133,6 +174,9 @@ private:
     
     /// the timeout period
     TIME_TYPE m_period;
+
+    /// how late the expiration is allowed to be processed
+    TIME_TYPE m_slack;
 };
 
 #endif /* _VTIMER_H_ */
@@ -0,0 +1,460 @@
+// ============================================================================
+// Copyright (c) 2026 Faustino Frechilla
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+/// @file  vtimer_set.h
+/// @brief This file contains a set of virtual timers with 64 bit deadlines
+///
+/// It behaves as a collection of VTimer<uint64_t> objects updated all at once,
+/// but deadlines and periods are stored in contiguous arrays (structure of
+/// arrays) so expired timers can be found comparing 4 deadlines per
+/// instruction (AVX2) or 2 (SSE4.2). Only the callbacks of expired timers are
+/// touched. The instruction set is chosen at runtime, so there is no need to
+/// build with -mavx2.
+///
+/// An object of this class is not thead-safe by itself. If used in a
+/// multi-thread system it will need to be protected from outside
+///
+/// Your compiler must have support for c++11. Example of usage:
+///
+/// void MyCallback(const uint64_t &a_currentTime);
+/// /* ... */
+///
+/// VTimerSet timers;
+/// VTimerSet::TimerHandle_t handle = timers.Add(
+///     std::bind(&MyCallback, std::placeholders::_1), 15);
+/// timers.Update(0);
+/// timers.Update(30);
+/// timers.Remove(handle);
+///
+/// @author Faustino Frechilla
+/// @history
+/// Ref        Who                When        What
+///            Faustino Frechilla 17-Oct-2026 Original development
+///            Faustino Frechilla 17-Oct-2026 Removing a free handle does nothing
+///            Faustino Frechilla 17-Oct-2026 Empty callbacks can't be added
+/// @endhistory
+///
+// ============================================================================
+
+#ifndef _VTIMERSET_H_
+#define _VTIMERSET_H_
+
+#include <stdint.h>   // types (uint64_t...)
+#include <vector>
+#include <deque>
+#include <algorithm>  // std::find
+#include <limits>     // std::numeric_limits<>::max
+#include <assert.h>
+#include "vtimer.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define _VTIMER_SET_X86_SIMD
+#endif
+
+// deadline of unused slots and of timers waiting for their first Update.
+// "a_currentTime" can't ever be this value
+#define VTIMER_SET_NO_DEADLINE std::numeric_limits<uint64_t>::max()
+
+/// @brief a set of Virtual Timers with uint64_t time
+/// Each timer follows the same rules as VTimer<uint64_t>:
+///   - The first time Update is called after a timer is added the expiration
+///     time is initialised to a_currentTime + period (the callback is not
+///     called)
+///   - When "a_currentTime" is set to 0 the callback won't ever get called
+///   - If "a_currentTime" goes backwards in time the callback is not called
+///   - Expiration times are calculated from the time passed to Update
+class VTimerSet
+{
+public:
+    typedef VTimer<uint64_t>::VTimerCallback_t VTimerCallback_t;
+    typedef uint32_t TimerHandle_t;
+
+    /// @brief the implementation used to look for expired timers
+    enum ScanType_t
+    {
+        SCAN_SCALAR,
+        SCAN_SSE42,
+        SCAN_AVX2
+    };
+
+    /// @brief constructor. It picks the best scan the CPU supports
+    VTimerSet();
+
+    /// @brief destructor
+    virtual ~VTimerSet()
+    {}
+
+    /// @brief adds a new timer to the set
+    /// It must not be called from inside a callback
+    /// @param a_callback Callback function that will get called on expiration
+    ///        It can't be empty: slots with no callback are free slots
+    /// @param a_period of time between calls
+    /// @return handle to remove the timer later on
+    TimerHandle_t Add(VTimerCallback_t a_callback, uint64_t a_period);
+
+    /// @brief removes a timer from the set. Its handle might be reused by
+    /// future calls to Add. It can be called from inside a callback.
+    /// Removing a handle which is already free does nothing
+    /// @param a_handle returned by Add
+    void Remove(TimerHandle_t a_handle);
+
+    /// @brief update the current time
+    /// Callbacks of expired timers are called from this thread in order of
+    /// handle
+    /// @param a_currentTime
+    void Update(uint64_t a_currentTime);
+
+    /// @return the number of timers in the set
+    inline std::size_t Size() const
+    {
+        return m_slotsInUse - m_freeHandles.size();
+    }
+
+    /// @brief forces a particular scan implementation. It is only meant
+    /// to be used for testing and benchmarking
+    /// @return false if the CPU does not support it
+    bool SetScanType(ScanType_t a_scanType);
+
+    /// @return the scan implementation currently in use
+    inline ScanType_t GetScanType() const
+    {
+        return m_scanType;
+    }
+
+private:
+    typedef void (*ScanFunction_t)(
+        const uint64_t*, std::size_t, uint64_t, std::vector<TimerHandle_t>&);
+
+    /// expiration time of each timer. Its size is always a multiple of 4 so
+    /// the scan never needs to deal with a remainder. Unused slots are set
+    /// to VTIMER_SET_NO_DEADLINE
+    std::vector<uint64_t> m_deadlines;
+
+    /// the period of each timer
+    std::vector<uint64_t> m_periods;
+
+    /// callback of each timer. A deque never moves its elements when it
+    /// grows so callbacks stay put while they are being called
+    std::deque<VTimerCallback_t> m_callbacks;
+
+    /// number of slots ever used (m_deadlines might be bigger due to padding)
+    std::size_t m_slotsInUse;
+
+    /// handles removed which can be reused
+    std::vector<TimerHandle_t> m_freeHandles;
+
+    /// handles removed while the callbacks were being called. They can't be
+    /// reused until Update is done
+    std::vector<TimerHandle_t> m_removedHandles;
+
+    /// timers added since the latest Update
+    std::vector<TimerHandle_t> m_pendingInit;
+
+    /// scratch space to save the expired timers found by the scan
+    std::vector<TimerHandle_t> m_expired;
+
+    /// true while Update is calling the callbacks
+    bool m_dispatching;
+
+    /// the scan implementation in use
+    ScanType_t m_scanType;
+    ScanFunction_t m_scan;
+
+    static void ScanScalar(
+        const uint64_t* a_deadlines,
+        std::size_t a_count,
+        uint64_t a_currentTime,
+        std::vector<TimerHandle_t> &out_expired);
+
+#ifdef _VTIMER_SET_X86_SIMD
+    static void ScanSse42(
+        const uint64_t* a_deadlines,
+        std::size_t a_count,
+        uint64_t a_currentTime,
+        std::vector<TimerHandle_t> &out_expired) __attribute__((target("sse4.2")));
+
+    static void ScanAvx2(
+        const uint64_t* a_deadlines,
+        std::size_t a_count,
+        uint64_t a_currentTime,
+        std::vector<TimerHandle_t> &out_expired) __attribute__((target("avx2")));
+#endif
+};
+
+inline VTimerSet::VTimerSet():
+    m_deadlines(),
+    m_periods(),
+    m_callbacks(),
+    m_slotsInUse(0),
+    m_freeHandles(),
+    m_removedHandles(),
+    m_pendingInit(),
+    m_expired(),
+    m_dispatching(false),
+    m_scanType(SCAN_SCALAR),
+    m_scan(&VTimerSet::ScanScalar)
+{
+    if (!SetScanType(SCAN_AVX2))
+    {
+        SetScanType(SCAN_SSE42);
+    }
+}
+
+inline bool VTimerSet::SetScanType(ScanType_t a_scanType)
+{
+    switch (a_scanType)
+    {
+    case SCAN_SCALAR:
+        m_scan = &VTimerSet::ScanScalar;
+        break;
+
+#ifdef _VTIMER_SET_X86_SIMD
+    case SCAN_SSE42:
+        if (!__builtin_cpu_supports("sse4.2"))
+        {
+            return false;
+        }
+        m_scan = &VTimerSet::ScanSse42;
+        break;
+
+    case SCAN_AVX2:
+        if (!__builtin_cpu_supports("avx2"))
+        {
+            return false;
+        }
+        m_scan = &VTimerSet::ScanAvx2;
+        break;
+#endif
+
+    default:
+        return false;
+    }
+
+    m_scanType = a_scanType;
+    return true;
+}
+
+inline VTimerSet::TimerHandle_t VTimerSet::Add(
+    VTimerCallback_t a_callback, uint64_t a_period)
+{
+    assert(!m_dispatching);
+    // an empty callback would make the slot look free, so it could never
+    // be removed
+    assert(a_callback);
+
+    TimerHandle_t handle;
+    if (!m_freeHandles.empty())
+    {
+        handle = m_freeHandles.back();
+        m_freeHandles.pop_back();
+        m_callbacks[handle] = a_callback;
+    }
+    else
+    {
+        handle = static_cast<TimerHandle_t>(m_slotsInUse++);
+        if (m_slotsInUse > m_deadlines.size())
+        {
+            // grow 4 slots at a time. New slots will never expire
+            m_deadlines.resize(m_deadlines.size() + 4, VTIMER_SET_NO_DEADLINE);
+            m_periods.resize(m_deadlines.size(), 0);
+        }
+        m_callbacks.push_back(a_callback);
+    }
+
+    m_deadlines[handle] = VTIMER_SET_NO_DEADLINE;
+    m_periods[handle]   = a_period;
+    m_pendingInit.push_back(handle);
+
+    return handle;
+}
+
+inline void VTimerSet::Remove(TimerHandle_t a_handle)
+{
+    assert(a_handle < m_slotsInUse);
+
+    // a handle removed twice would be handed out twice by Add. Free slots
+    // have no callback. The callback of a slot removed while dispatching is
+    // still there (it might be the one running) until Update is done
+    if (!m_callbacks[a_handle] ||
+        (m_dispatching &&
+         (std::find(m_removedHandles.begin(), m_removedHandles.end(), a_handle) !=
+          m_removedHandles.end())))
+    {
+        return;
+    }
+
+    m_deadlines[a_handle] = VTIMER_SET_NO_DEADLINE;
+    m_periods[a_handle]   = 0;
+
+    if (m_dispatching)
+    {
+        m_removedHandles.push_back(a_handle);
+    }
+    else
+    {
+        m_callbacks[a_handle] = VTimerCallback_t();
+        m_freeHandles.push_back(a_handle);
+    }
+    // if the timer was waiting for its first Update it is discarded there
+    // (its period is 0 and its deadline VTIMER_SET_NO_DEADLINE)
+}
+
+inline void VTimerSet::Update(uint64_t a_currentTime)
+{
+    assert(a_currentTime != VTIMER_SET_NO_DEADLINE);
+
+    // timers waiting for their first Update have VTIMER_SET_NO_DEADLINE as
+    // deadline, so they won't be found by the scan
+    m_expired.clear();
+    if (!m_deadlines.empty())
+    {
+        m_scan(&m_deadlines[0], m_deadlines.size(), a_currentTime, m_expired);
+    }
+
+    m_dispatching = true;
+    for (std::size_t i = 0; i < m_expired.size(); i++)
+    {
+        TimerHandle_t handle = m_expired[i];
+
+        // a previous callback could have removed this timer
+        if (m_deadlines[handle] > a_currentTime)
+        {
+            continue;
+        }
+
+        m_deadlines[handle] = a_currentTime + m_periods[handle];
+        m_callbacks[handle](a_currentTime);
+    }
+    m_dispatching = false;
+
+    for (std::size_t i = 0; i < m_removedHandles.size(); i++)
+    {
+        m_callbacks[m_removedHandles[i]] = VTimerCallback_t();
+        m_freeHandles.push_back(m_removedHandles[i]);
+    }
+    m_removedHandles.clear();
+
+    // initialise the timers added since the last Update
+    for (std::size_t i = 0; i < m_pendingInit.size(); i++)
+    {
+        TimerHandle_t handle = m_pendingInit[i];
+        if (!m_callbacks[handle])
+        {
+            // removed before its first Update
+            continue;
+        }
+
+        if ((a_currentTime + m_periods[handle]) == 0)
+        {
+            // corner case. Period is "0" and Update is initialised with
+            // time 0 (see VTimer::Update)
+            m_deadlines[handle] = 1;
+        }
+        else
+        {
+            m_deadlines[handle] = a_currentTime + m_periods[handle];
+        }
+    }
+    m_pendingInit.clear();
+}
+
+inline void VTimerSet::ScanScalar(
+    const uint64_t* a_deadlines,
+    std::size_t a_count,
+    uint64_t a_currentTime,
+    std::vector<TimerHandle_t> &out_expired)
+{
+    for (std::size_t i = 0; i < a_count; i++)
+    {
+        if (a_currentTime >= a_deadlines[i])
+        {
+            out_expired.push_back(static_cast<TimerHandle_t>(i));
+        }
+    }
+}
+
+#ifdef _VTIMER_SET_X86_SIMD
+
+// There is no unsigned 64 bit comparison in SSE/AVX. Flipping the sign bit of
+// both sides turns an unsigned comparison into a signed one
+
+inline void VTimerSet::ScanSse42(
+    const uint64_t* a_deadlines,
+    std::size_t a_count,
+    uint64_t a_currentTime,
+    std::vector<TimerHandle_t> &out_expired)
+{
+    const __m128i signBit = _mm_set1_epi64x(static_cast<long long>(0x8000000000000000ULL));
+    const __m128i now     = _mm_xor_si128(
+        _mm_set1_epi64x(static_cast<long long>(a_currentTime)), signBit);
+
+    for (std::size_t i = 0; i < a_count; i += 2)
+    {
+        __m128i deadlines = _mm_xor_si128(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(a_deadlines + i)),
+            signBit);
+        // a lane is all 1s if the timer has not expired (deadline > now)
+        int mask = _mm_movemask_pd(
+            _mm_castsi128_pd(_mm_cmpgt_epi64(deadlines, now)));
+
+        mask = (~mask) & 0x3;
+        while (mask)
+        {
+            out_expired.push_back(
+                static_cast<TimerHandle_t>(i + __builtin_ctz(mask)));
+            mask &= (mask - 1);
+        }
+    }
+}
+
+inline void VTimerSet::ScanAvx2(
+    const uint64_t* a_deadlines,
+    std::size_t a_count,
+    uint64_t a_currentTime,
+    std::vector<TimerHandle_t> &out_expired)
+{
+    const __m256i signBit = _mm256_set1_epi64x(static_cast<long long>(0x8000000000000000ULL));
+    const __m256i now     = _mm256_xor_si256(
+        _mm256_set1_epi64x(static_cast<long long>(a_currentTime)), signBit);
+
+    for (std::size_t i = 0; i < a_count; i += 4)
+    {
+        __m256i deadlines = _mm256_xor_si256(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a_deadlines + i)),
+            signBit);
+        // a lane is all 1s if the timer has not expired (deadline > now)
+        int mask = _mm256_movemask_pd(
+            _mm256_castsi256_pd(_mm256_cmpgt_epi64(deadlines, now)));
+
+        mask = (~mask) & 0xF;
+        while (mask)
+        {
+            out_expired.push_back(
+                static_cast<TimerHandle_t>(i + __builtin_ctz(mask)));
+            mask &= (mask - 1);
+        }
+    }
+}
+
+#endif // _VTIMER_SET_X86_SIMD
+
+#endif /* _VTIMERSET_H_ */
@@ -21,6 +21,10 @@ There are two parameters that tell this script how to merge log messages:
     using the format described by this parameter to generete a datetime 
     python object using strftime. For more info on date formats see 
     https://docs.python.org/2/library/datetime.html#strftime-and-strptime-behavior
+
+cpp/tools/dummylog_merger is a native version of this script, orders of 
+magnitude faster, for big logs. It understands the default date format of this
+script (and a few others) but it can't be configured with --regex/--date-fmt
 """
 
 # Copyright (C) 2014 Faustino Frechilla (frechilla@gmail.com)
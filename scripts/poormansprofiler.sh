@@ -1,5 +1,7 @@
 # The poor man's profiler...
 # all credit goes to poormansprofiler.org
+# programs which can be rebuilt can sample themselves with no debugger
+# attached: see cpp/sampling_profiler.h
 #
 
 #!/bin/bash